@@ -34,8 +34,12 @@ add_library(
     "core/convar/convar.h"
     "core/convar/cvar.cpp"
     "core/convar/cvar.h"
+    "core/convar/cvarindex.cpp"
+    "core/convar/cvarindex.h"
     "core/filesystem/filesystem.cpp"
     "core/filesystem/filesystem.h"
+    "core/filesystem/pakprefetch.cpp"
+    "core/filesystem/pakprefetch.h"
     "core/filesystem/rpakfilesystem.cpp"
     "core/filesystem/rpakfilesystem.h"
     "core/math/bitbuf.h"
@@ -51,6 +55,8 @@ add_library(
     "core/macros.h"
     "core/memalloc.cpp"
     "core/memalloc.h"
+    "core/profiler.cpp"
+    "core/profiler.h"
     "core/sourceinterface.cpp"
     "core/tier0.cpp"
     "core/tier0.h"
@@ -61,6 +67,8 @@ add_library(
     "dedicated/dedicatedlogtoclient.cpp"
     "dedicated/dedicatedlogtoclient.h"
     "dedicated/dedicatedmaterialsystem.cpp"
+    "dedicated/framepacer.cpp"
+    "dedicated/framepacer.h"
     "engine/gl_matsysiface.cpp"
     "engine/host.cpp"
     "engine/hoststate.cpp"
@@ -80,6 +88,10 @@ add_library(
     "logging/sourceconsole.h"
     "masterserver/masterserver.cpp"
     "masterserver/masterserver.h"
+    "masterserver/persistencequeue.cpp"
+    "masterserver/persistencequeue.h"
+    "masterserver/serverlistsnapshot.cpp"
+    "masterserver/serverlistsnapshot.h"
     "mods/autodownload/moddownloader.h"
     "mods/autodownload/moddownloader.cpp"
     "mods/compiled/kb_act.cpp"
@@ -90,6 +102,8 @@ add_library(
     "mods/mod.h"
     "mods/modmanager.cpp"
     "mods/modmanager.h"
+    "mods/modregistry.cpp"
+    "mods/modregistry.h"
     "mods/modsavefiles.cpp"
     "mods/modsavefiles.h"
     "plugins/interfaces/interface.h"
@@ -116,6 +130,8 @@ add_library(
     "scripts/scriptdatatables.cpp"
     "scripts/scripthttprequesthandler.cpp"
     "scripts/scripthttprequesthandler.h"
+    "scripts/scripthttprequestutils.cpp"
+    "scripts/scripthttprequestutils.h"
     "scripts/scriptjson.cpp"
     "scripts/scriptjson.h"
     "scripts/scriptutility.cpp"
@@ -128,6 +144,8 @@ add_library(
     "server/ai_helper.h"
     "server/ai_navmesh.cpp"
     "server/ai_navmesh.h"
+    "server/ainfile.cpp"
+    "server/ainfile.h"
     "server/buildainfile.cpp"
     "server/r2server.cpp"
     "server/r2server.h"
@@ -139,10 +157,14 @@ add_library(
     "shared/exploit_fixes/exploitfixes.cpp"
     "shared/exploit_fixes/exploitfixes_lzss.cpp"
     "shared/exploit_fixes/exploitfixes_utf8parser.cpp"
+    "shared/exploit_fixes/exploitfixes_utf8scan.cpp"
+    "shared/exploit_fixes/exploitfixes_utf8scan.h"
     "shared/exploit_fixes/ns_limits.cpp"
     "shared/exploit_fixes/ns_limits.h"
     "shared/keyvalues.cpp"
     "shared/keyvalues.h"
+    "shared/keyvaluestree.cpp"
+    "shared/keyvaluestree.h"
     "shared/maxplayers.cpp"
     "shared/maxplayers.h"
     "shared/misccommands.cpp"
@@ -154,6 +176,9 @@ add_library(
     "squirrel/squirrelautobind.cpp"
     "squirrel/squirrelautobind.h"
     "squirrel/squirrelclasstypes.h"
+    "util/fnv1a.h"
+    "util/lzss.cpp"
+    "util/lzss.h"
     "util/printcommands.cpp"
     "util/printcommands.h"
     "util/printmaps.cpp"
@@ -7,20 +7,11 @@ static void* __fastcall h_BinkOpen(const char* path, uint32_t flags)
 	spdlog::info("BinkOpen {}", filename);
 
 	// figure out which mod is handling the bink
-	Mod* fileOwner = nullptr;
-	for (Mod& mod : g_pModManager->m_LoadedMods)
-	{
-		if (!mod.m_bEnabled)
-			continue;
-
-		if (std::find(mod.BinkVideos.begin(), mod.BinkVideos.end(), filename) != mod.BinkVideos.end())
-			fileOwner = &mod;
-	}
-
-	if (fileOwner)
+	auto fileOwner = g_pModManager->m_Registry.binkVideos.find(filename);
+	if (fileOwner != g_pModManager->m_Registry.binkVideos.end())
 	{
 		// create new path
-		fs::path binkPath(fileOwner->m_ModDirectory / "media" / filename);
+		fs::path binkPath(fileOwner->second->m_ModDirectory / "media" / filename);
 		return o_pBinkOpen(binkPath.string().c_str(), flags);
 	}
 	else
@@ -261,7 +261,7 @@ static void __fastcall h_DrawAllOverlays(bool bRender)
 		}
 	}
 
-	if (bRender && Cvar_enable_debug_overlays->GetBool())
+	if (bRender && Cvar_enable_debug_overlays->GetBool() && g_pAIHelper)
 	{
 		g_pAIHelper->DrawNavmeshPolys();
 	}
@@ -30,8 +30,6 @@ public:
 	M_VMETHOD(ConVar*, FindVar, 16, (const char* pszVarName), (this, pszVarName));
 	M_VMETHOD(ConCommand*, FindCommand, 18, (const char* pszCommandName), (this, pszCommandName));
 	M_VMETHOD(CCVarIteratorInternal*, FactoryInternalIterator, 41, (), (this));
-
-	std::unordered_map<std::string, ConCommandBase*> DumpToMap();
 };
 
 extern CCvar* g_pCVar;
@@ -0,0 +1,358 @@
+#include "cvarindex.h"
+#include "cvar.h"
+#include "convar.h"
+#include "concommand.h"
+
+#include <algorithm>
+
+CCvarIndex* g_pCvarIndex;
+
+static std::string ToLowerName(const char* pszName)
+{
+	std::string svLower(pszName);
+	std::transform(svLower.begin(), svLower.end(), svLower.begin(), [](unsigned char c) { return (char)tolower(c); });
+	return svLower;
+}
+
+static inline uint32_t PackTrigram(const char* pszChars)
+{
+	const unsigned char* pszBytes = (const unsigned char*)pszChars;
+	return ((uint32_t)pszBytes[0] << 16) | ((uint32_t)pszBytes[1] << 8) | (uint32_t)pszBytes[2];
+}
+
+// gets the unique trigrams in a lowercase string
+static void GetTrigrams(const std::string& svLower, std::vector<uint32_t>& vOut)
+{
+	vOut.clear();
+	for (size_t i = 0; i + 3 <= svLower.size(); i++)
+		vOut.push_back(PackTrigram(svLower.c_str() + i));
+
+	std::sort(vOut.begin(), vOut.end());
+	vOut.erase(std::unique(vOut.begin(), vOut.end()), vOut.end());
+}
+
+void CCvarIndex::Add(ConCommandBase* pCommand)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	// a dirty index picks this up when it's rebuilt
+	if (!m_bDirty)
+		AddLocked(pCommand);
+}
+
+void CCvarIndex::Remove(ConCommandBase* pCommand)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	if (m_bDirty)
+		return;
+
+	auto iter = m_mEntryLookup.find(pCommand);
+	if (iter != m_mEntryLookup.end())
+		RemoveLocked(iter->second);
+}
+
+void CCvarIndex::Invalidate()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	m_bDirty = true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Rebuilds the index from the cvar list, only done once unless something invalidates us
+//-----------------------------------------------------------------------------
+void CCvarIndex::RebuildIfDirty()
+{
+	if (!m_bDirty)
+		return;
+
+	m_bDirty = false;
+	m_vTrie.clear();
+	m_vTrie.emplace_back();
+	m_vEntries.clear();
+	m_vFreeEntries.clear();
+	m_mEntryLookup.clear();
+	m_mTrigrams.clear();
+
+	CCVarIteratorInternal* itint = g_pCVar->FactoryInternalIterator();
+	for (itint->SetFirst(); itint->IsValid(); itint->Next())
+		AddLocked(itint->Get());
+	delete itint;
+
+	spdlog::info("Indexed {} convars/concommands", m_mEntryLookup.size());
+}
+
+void CCvarIndex::AddLocked(ConCommandBase* pCommand)
+{
+	if (!pCommand || !pCommand->m_pszName || m_mEntryLookup.find(pCommand) != m_mEntryLookup.end())
+		return;
+
+	std::string svLowerName = ToLowerName(pCommand->m_pszName);
+
+	// walk the trie, creating nodes as we go
+	uint32_t iNode = 0;
+	for (char c : svLowerName)
+	{
+		std::vector<std::pair<char, uint32_t>>& vChildren = m_vTrie[iNode].vChildren;
+		auto child = std::lower_bound(
+			vChildren.begin(), vChildren.end(), c, [](const std::pair<char, uint32_t>& pair, char c) { return pair.first < c; });
+
+		if (child != vChildren.end() && child->first == c)
+		{
+			iNode = child->second;
+			continue;
+		}
+
+		// careful, this invalidates vChildren
+		const uint32_t iNewNode = (uint32_t)m_vTrie.size();
+		vChildren.insert(child, {c, iNewNode});
+		m_vTrie.emplace_back();
+		iNode = iNewNode;
+	}
+
+	// names are case insensitive, so a command with the same name replaces whatever we had before
+	if (m_vTrie[iNode].iEntry != -1)
+		RemoveLocked(m_vTrie[iNode].iEntry);
+
+	uint32_t iEntry;
+	if (!m_vFreeEntries.empty())
+	{
+		iEntry = m_vFreeEntries.back();
+		m_vFreeEntries.pop_back();
+	}
+	else
+	{
+		iEntry = (uint32_t)m_vEntries.size();
+		m_vEntries.emplace_back();
+	}
+
+	std::vector<uint32_t> vTrigrams;
+	GetTrigrams(svLowerName, vTrigrams);
+	for (uint32_t iTrigram : vTrigrams)
+		m_mTrigrams[iTrigram].push_back(iEntry);
+
+	m_vEntries[iEntry] = {pCommand, std::move(svLowerName)};
+	m_vTrie[iNode].iEntry = iEntry;
+	m_mEntryLookup[pCommand] = iEntry;
+}
+
+void CCvarIndex::RemoveLocked(uint32_t iEntry)
+{
+	Entry_t& entry = m_vEntries[iEntry];
+
+	std::vector<uint32_t> vTrigrams;
+	GetTrigrams(entry.svLowerName, vTrigrams);
+	for (uint32_t iTrigram : vTrigrams)
+	{
+		auto iter = m_mTrigrams.find(iTrigram);
+		if (iter == m_mTrigrams.end())
+			continue;
+
+		std::vector<uint32_t>& vPostings = iter->second;
+		auto posting = std::find(vPostings.begin(), vPostings.end(), iEntry);
+		if (posting != vPostings.end())
+		{
+			*posting = vPostings.back();
+			vPostings.pop_back();
+		}
+
+		if (vPostings.empty())
+			m_mTrigrams.erase(iter);
+	}
+
+	const int32_t iNode = FindNodeLocked(entry.svLowerName);
+	if (iNode != -1 && m_vTrie[iNode].iEntry == (int32_t)iEntry)
+		m_vTrie[iNode].iEntry = -1;
+
+	m_mEntryLookup.erase(entry.pCommand);
+	entry.pCommand = nullptr;
+	entry.svLowerName.clear();
+	m_vFreeEntries.push_back(iEntry);
+}
+
+int32_t CCvarIndex::FindNodeLocked(const std::string& svLowerName) const
+{
+	uint32_t iNode = 0;
+	for (char c : svLowerName)
+	{
+		const std::vector<std::pair<char, uint32_t>>& vChildren = m_vTrie[iNode].vChildren;
+		auto child = std::lower_bound(
+			vChildren.begin(), vChildren.end(), c, [](const std::pair<char, uint32_t>& pair, char c) { return pair.first < c; });
+
+		if (child == vChildren.end() || child->first != c)
+			return -1;
+
+		iNode = child->second;
+	}
+
+	return iNode;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Collects every command under a trie node, depth first so results come out sorted
+// Input  : iMaxResults - Counted after iExcludeFlags is applied
+//          iExcludeFlags - Commands with any of these flags are skipped
+//-----------------------------------------------------------------------------
+void CCvarIndex::CollectLocked(uint32_t iNode, std::vector<ConCommandBase*>& vOut, size_t iMaxResults, int iExcludeFlags) const
+{
+	std::vector<uint32_t> vStack {iNode};
+	while (!vStack.empty() && vOut.size() < iMaxResults)
+	{
+		const TrieNode_t& node = m_vTrie[vStack.back()];
+		vStack.pop_back();
+
+		if (node.iEntry != -1)
+		{
+			ConCommandBase* pCommand = m_vEntries[node.iEntry].pCommand;
+			if (!iExcludeFlags || !pCommand->IsFlagSet(iExcludeFlags))
+				vOut.push_back(pCommand);
+		}
+
+		for (auto child = node.vChildren.rbegin(); child != node.vChildren.rend(); child++)
+			vStack.push_back(child->second);
+	}
+}
+
+ConCommandBase* CCvarIndex::Find(const char* pszName)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	RebuildIfDirty();
+
+	const int32_t iNode = FindNodeLocked(ToLowerName(pszName));
+	if (iNode == -1 || m_vTrie[iNode].iEntry == -1)
+		return nullptr;
+
+	return m_vEntries[m_vTrie[iNode].iEntry].pCommand;
+}
+
+std::vector<ConCommandBase*> CCvarIndex::FindPrefix(const char* pszPrefix, size_t iMaxResults, int iExcludeFlags)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	RebuildIfDirty();
+
+	std::vector<ConCommandBase*> vResults;
+	const int32_t iNode = FindNodeLocked(ToLowerName(pszPrefix));
+	if (iNode != -1)
+		CollectLocked(iNode, vResults, iMaxResults, iExcludeFlags);
+
+	return vResults;
+}
+
+std::vector<ConCommandBase*> CCvarIndex::FindSubstrings(const std::vector<std::string>& vTerms)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	RebuildIfDirty();
+
+	std::vector<std::string> vLowerTerms;
+	for (const std::string& svTerm : vTerms)
+		vLowerTerms.push_back(ToLowerName(svTerm.c_str()));
+
+	// narrow down candidates with the rarest trigram out of all the terms, terms shorter than a trigram can't be narrowed
+	const std::vector<uint32_t>* pCandidates = nullptr;
+	std::vector<uint32_t> vTrigrams;
+	for (const std::string& svTerm : vLowerTerms)
+	{
+		GetTrigrams(svTerm, vTrigrams);
+		for (uint32_t iTrigram : vTrigrams)
+		{
+			auto iter = m_mTrigrams.find(iTrigram);
+			if (iter == m_mTrigrams.end())
+				return {};
+
+			if (!pCandidates || iter->second.size() < pCandidates->size())
+				pCandidates = &iter->second;
+		}
+	}
+
+	std::vector<uint32_t> vAllEntries;
+	if (!pCandidates)
+	{
+		for (auto& pair : m_mEntryLookup)
+			vAllEntries.push_back(pair.second);
+
+		pCandidates = &vAllEntries;
+	}
+
+	std::vector<uint32_t> vMatches;
+	for (uint32_t iEntry : *pCandidates)
+	{
+		const std::string& svName = m_vEntries[iEntry].svLowerName;
+		if (std::all_of(
+				vLowerTerms.begin(),
+				vLowerTerms.end(),
+				[&svName](const std::string& svTerm) { return svName.find(svTerm) != std::string::npos; }))
+			vMatches.push_back(iEntry);
+	}
+
+	std::sort(
+		vMatches.begin(),
+		vMatches.end(),
+		[this](uint32_t iLeft, uint32_t iRight) { return m_vEntries[iLeft].svLowerName < m_vEntries[iRight].svLowerName; });
+
+	std::vector<ConCommandBase*> vResults;
+	vResults.reserve(vMatches.size());
+	for (uint32_t iEntry : vMatches)
+		vResults.push_back(m_vEntries[iEntry].pCommand);
+
+	return vResults;
+}
+
+std::vector<ConCommandBase*> CCvarIndex::GetAll()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	RebuildIfDirty();
+
+	std::vector<ConCommandBase*> vResults;
+	vResults.reserve(m_mEntryLookup.size());
+	CollectLocked(0, vResults, SIZE_MAX);
+	return vResults;
+}
+
+size_t CCvarIndex::GetCount()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	RebuildIfDirty();
+
+	return m_mEntryLookup.size();
+}
+
+static void(__fastcall* o_pCCvar__RegisterConCommand)(CCvar* self, ConCommandBase* pCommandBase) = nullptr;
+static void __fastcall h_CCvar__RegisterConCommand(CCvar* self, ConCommandBase* pCommandBase)
+{
+	o_pCCvar__RegisterConCommand(self, pCommandBase);
+
+	// registration fails silently for duplicate names, so only index what actually made it into the list
+	if (pCommandBase->m_pszName && self->FindCommandBase(pCommandBase->m_pszName) == pCommandBase)
+		g_pCvarIndex->Add(pCommandBase);
+}
+
+static void(__fastcall* o_pCCvar__UnregisterConCommand)(CCvar* self, ConCommandBase* pCommandBase) = nullptr;
+static void __fastcall h_CCvar__UnregisterConCommand(CCvar* self, ConCommandBase* pCommandBase)
+{
+	g_pCvarIndex->Remove(pCommandBase);
+	o_pCCvar__UnregisterConCommand(self, pCommandBase);
+}
+
+static void(__fastcall* o_pCCvar__UnregisterConCommands)(CCvar* self, int id) = nullptr;
+static void __fastcall h_CCvar__UnregisterConCommands(CCvar* self, int id)
+{
+	// we don't know which dll registered what, so just rebuild next time we're queried
+	o_pCCvar__UnregisterConCommands(self, id);
+	g_pCvarIndex->Invalidate();
+}
+
+ON_DLL_LOAD_RELIESON("engine.dll", CvarIndex, ConVar, (CModule module))
+{
+	NOTE_UNUSED(module);
+	g_pCvarIndex = new CCvarIndex;
+
+	void** pVTable = *reinterpret_cast<void***>(g_pCVar);
+
+	o_pCCvar__RegisterConCommand = reinterpret_cast<decltype(o_pCCvar__RegisterConCommand)>(pVTable[10]);
+	HookAttach(&(PVOID&)o_pCCvar__RegisterConCommand, (PVOID)h_CCvar__RegisterConCommand);
+
+	o_pCCvar__UnregisterConCommand = reinterpret_cast<decltype(o_pCCvar__UnregisterConCommand)>(pVTable[11]);
+	HookAttach(&(PVOID&)o_pCCvar__UnregisterConCommand, (PVOID)h_CCvar__UnregisterConCommand);
+
+	o_pCCvar__UnregisterConCommands = reinterpret_cast<decltype(o_pCCvar__UnregisterConCommands)>(pVTable[12]);
+	HookAttach(&(PVOID&)o_pCCvar__UnregisterConCommands, (PVOID)h_CCvar__UnregisterConCommands);
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class ConCommandBase;
+
+//-----------------------------------------------------------------------------
+// Purpose: Persistent search index over every registered ConCommandBase
+//          a case insensitive prefix trie for exact/prefix lookups, and a trigram index for substring lookups
+//          kept up to date by hooking CCvar::RegisterConCommand/UnregisterConCommand, so queries never walk the cvar list
+//-----------------------------------------------------------------------------
+class CCvarIndex
+{
+private:
+	struct TrieNode_t
+	{
+		std::vector<std::pair<char, uint32_t>> vChildren; // sorted by character
+		int32_t iEntry = -1;
+	};
+
+	struct Entry_t
+	{
+		ConCommandBase* pCommand; // nullptr if this slot is free
+		std::string svLowerName;
+	};
+
+	std::mutex m_Mutex;
+
+	// when dirty, the whole index is rebuilt from the cvar list on the next query
+	// used before our hooks are installed, and for bulk unregistrations we can't track individually
+	bool m_bDirty = true;
+
+	// node 0 is the root, nodes are never freed since names tend to be reregistered (e.g. on mod reload)
+	std::vector<TrieNode_t> m_vTrie;
+	std::vector<Entry_t> m_vEntries;
+	std::vector<uint32_t> m_vFreeEntries;
+	std::unordered_map<ConCommandBase*, uint32_t> m_mEntryLookup;
+	std::unordered_map<uint32_t, std::vector<uint32_t>> m_mTrigrams;
+
+public:
+	void Add(ConCommandBase* pCommand);
+	void Remove(ConCommandBase* pCommand);
+	void Invalidate();
+
+	// all lookups are case insensitive, results are sorted by lowercase name
+	ConCommandBase* Find(const char* pszName);
+	// commands with any of iExcludeFlags set are skipped before iMaxResults is applied
+	std::vector<ConCommandBase*> FindPrefix(const char* pszPrefix, size_t iMaxResults = SIZE_MAX, int iExcludeFlags = 0);
+	// returns commands whose names contain every one of the given terms
+	std::vector<ConCommandBase*> FindSubstrings(const std::vector<std::string>& vTerms);
+	std::vector<ConCommandBase*> GetAll();
+	size_t GetCount();
+
+private:
+	void RebuildIfDirty();
+	void AddLocked(ConCommandBase* pCommand);
+	void RemoveLocked(uint32_t iEntry);
+	int32_t FindNodeLocked(const std::string& svLowerName) const;
+	void CollectLocked(uint32_t iNode, std::vector<ConCommandBase*>& vOut, size_t iMaxResults, int iExcludeFlags) const;
+};
+
+extern CCvarIndex* g_pCvarIndex;
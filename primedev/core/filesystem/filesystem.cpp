@@ -1,6 +1,7 @@
 #include "filesystem.h"
 #include "core/tier1.h"
 #include "mods/modmanager.h"
+#include "core/profiler.h"
 
 #include <iostream>
 #include <sstream>
@@ -49,6 +50,8 @@ static void(__fastcall* o_pAddSearchPath)(IFileSystem* fileSystem, const char* p
 	nullptr;
 static void __fastcall h_AddSearchPath(IFileSystem* fileSystem, const char* pPath, const char* pathID, SearchPathAdd_t addType)
 {
+	NS_PROFILE_SCOPE("IFileSystem::AddSearchPath");
+
 	o_pAddSearchPath(fileSystem, pPath, pathID, addType);
 
 	// make sure current mod paths are at head
@@ -115,6 +118,8 @@ bool TryReplaceFile(const char* pPath, bool shouldCompile)
 static bool(__fastcall* o_pReadFromCache)(IFileSystem* filesystem, char* pPath, void* result) = nullptr;
 static bool __fastcall h_ReadFromCache(IFileSystem* filesystem, char* pPath, void* result)
 {
+	NS_PROFILE_SCOPE("IFileSystem::ReadFromCache");
+
 	if (TryReplaceFile(pPath, true))
 		return false;
 
@@ -124,6 +129,8 @@ static bool __fastcall h_ReadFromCache(IFileSystem* filesystem, char* pPath, voi
 static FileHandle_t(__fastcall* o_pReadFileFromVPK)(VPKData* vpkInfo, uint64_t* b, char* filename) = nullptr;
 static FileHandle_t __fastcall h_ReadFileFromVPK(VPKData* vpkInfo, uint64_t* b, char* filename)
 {
+	NS_PROFILE_SCOPE("ReadFileFromVPK");
+
 	// don't compile here because this is only ever called from OpenEx, which already compiles
 	if (TryReplaceFile(filename, false))
 	{
@@ -140,6 +147,8 @@ static FileHandle_t(__fastcall* o_pCBaseFileSystem__OpenEx)(
 static FileHandle_t __fastcall h_CBaseFileSystem__OpenEx(
 	IFileSystem* filesystem, const char* pPath, const char* pOptions, uint32_t flags, const char* pPathID, char** ppszResolvedFilename)
 {
+	NS_PROFILE_SCOPE("CBaseFileSystem::OpenEx");
+
 	TryReplaceFile(pPath, true);
 	return o_pCBaseFileSystem__OpenEx(filesystem, pPath, pOptions, flags, pPathID, ppszResolvedFilename);
 }
@@ -147,6 +156,8 @@ static FileHandle_t __fastcall h_CBaseFileSystem__OpenEx(
 static VPKData* (*o_pMountVPK)(IFileSystem* fileSystem, const char* pVpkPath) = nullptr;
 static VPKData* h_MountVPK(IFileSystem* fileSystem, const char* pVpkPath)
 {
+	NS_PROFILE_SCOPE("IFileSystem::MountVPK");
+
 	NS::log::fs->info("MountVPK {}", pVpkPath);
 	VPKData* ret = o_pMountVPK(fileSystem, pVpkPath);
 
@@ -0,0 +1,248 @@
+#include "pakprefetch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+void PrefetchIoBudget::SetRate(size_t iBytesPerSecond, size_t iBurstBytes, double flTime)
+{
+	m_flBytesPerSecond = (double)iBytesPerSecond;
+	m_flBurstBytes = (double)iBurstBytes;
+	m_flAvailable = m_flBurstBytes;
+	m_flLastTime = flTime;
+}
+
+void PrefetchIoBudget::Refill(double flTime)
+{
+	if (flTime <= m_flLastTime)
+		return;
+
+	m_flAvailable = std::min(m_flBurstBytes, m_flAvailable + (flTime - m_flLastTime) * m_flBytesPerSecond);
+	m_flLastTime = flTime;
+}
+
+size_t PrefetchIoBudget::Acquire(size_t iWanted, double flTime)
+{
+	if (m_flBytesPerSecond <= 0.0)
+		return iWanted;
+
+	Refill(flTime);
+
+	const size_t iTaken = std::min(iWanted, (size_t)m_flAvailable);
+	m_flAvailable -= (double)iTaken;
+	return iTaken;
+}
+
+double PrefetchIoBudget::GetWaitTime(size_t iBytes, double flTime) const
+{
+	if (m_flBytesPerSecond <= 0.0)
+		return 0.0;
+
+	// we can never have more than a burst's worth, so don't wait for more than that
+	const double flWanted = std::min((double)iBytes, m_flBurstBytes);
+	const double flAvailable = std::min(m_flBurstBytes, m_flAvailable + std::max(0.0, flTime - m_flLastTime) * m_flBytesPerSecond);
+	if (flAvailable >= flWanted)
+		return 0.0;
+
+	return (flWanted - flAvailable) / m_flBytesPerSecond;
+}
+
+// what the game puts after a map's name in its navmesh (per hull) and .ent files
+static const char* const MAP_FILE_SUFFIXES[] = {"small", "med_short", "medium", "large", "extra_large", "script", "snd", "spawn", "fx"};
+
+bool IsMapFileStem(const std::string& svStem, const std::string& svMapName)
+{
+	if (svStem.compare(0, svMapName.length(), svMapName))
+		return false;
+
+	// exact match, or something like mp_box.bsp.0000 for bsp lumps
+	if (svStem.length() == svMapName.length() || svStem[svMapName.length()] == '.')
+		return true;
+
+	// maps can have underscores in their names, so anything after an underscore has to be one of the game's own suffixes
+	if (svStem[svMapName.length()] != '_')
+		return false;
+
+	const std::string svSuffix = svStem.substr(svMapName.length() + 1);
+	return std::any_of(
+		std::begin(MAP_FILE_SUFFIXES), std::end(MAP_FILE_SUFFIXES), [&svSuffix](const char* pSuffix) { return svSuffix == pSuffix; });
+}
+
+// plain buffered reads, which is all it takes for the os to cache the file
+static PakPrefetcher::FileIo_t GetDefaultFileIo()
+{
+	PakPrefetcher::FileIo_t io;
+
+	io.fnOpen = [](const std::string& svPath) -> void*
+	{
+		std::ifstream* pStream = new std::ifstream(svPath, std::ios::binary);
+		if (!pStream->is_open())
+		{
+			delete pStream;
+			return nullptr;
+		}
+
+		return pStream;
+	};
+	io.fnRead = [](void* pHandle, char* pBuffer, size_t iSize) -> size_t
+	{
+		std::ifstream* pStream = (std::ifstream*)pHandle;
+		pStream->read(pBuffer, iSize);
+		return (size_t)pStream->gcount();
+	};
+	io.fnClose = [](void* pHandle) { delete (std::ifstream*)pHandle; };
+	io.fnTime = []() -> double
+	{ return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); };
+	io.fnSleep = [](double flSeconds) { std::this_thread::sleep_for(std::chrono::duration<double>(flSeconds)); };
+
+	return io;
+}
+
+PakPrefetcher::PakPrefetcher()
+	: m_Io(GetDefaultFileIo())
+{
+}
+
+PakPrefetcher::PakPrefetcher(FileIo_t io)
+	: m_Io(std::move(io))
+{
+}
+
+PakPrefetcher::~PakPrefetcher()
+{
+	Shutdown();
+}
+
+void PakPrefetcher::Prefetch(std::vector<std::string> vPaths, size_t iBytesPerSecond)
+{
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		if (m_bStopping)
+			return;
+
+		m_vQueue = std::move(vPaths);
+		m_iNextFile = 0;
+		m_iBytesPerSecond = iBytesPerSecond;
+		m_iGeneration++;
+
+		// only start the thread once there's something for it to do
+		if (!m_Worker.joinable())
+			m_Worker = std::thread(&PakPrefetcher::RunWorker, this);
+	}
+
+	m_WorkAvailable.notify_one();
+}
+
+void PakPrefetcher::Cancel()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	m_vQueue.clear();
+	m_iNextFile = 0;
+	m_iGeneration++;
+}
+
+void PakPrefetcher::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		m_bStopping = true;
+		m_iGeneration++;
+	}
+
+	m_WorkAvailable.notify_one();
+	if (m_Worker.joinable())
+		m_Worker.join();
+}
+
+bool PakPrefetcher::IsIdle()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	return !m_bReading && m_iNextFile >= m_vQueue.size();
+}
+
+size_t PakPrefetcher::GetBytesRead()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	return m_iBytesRead;
+}
+
+size_t PakPrefetcher::GetFilesRead()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	return m_iFilesRead;
+}
+
+bool PakPrefetcher::ReadFile(const std::string& svPath, uint64_t iGeneration, PrefetchIoBudget& budget, std::vector<char>& vBuffer)
+{
+	void* pHandle = m_Io.fnOpen(svPath);
+	if (!pHandle)
+		return false;
+
+	bool bFinished = false;
+	while (m_iGeneration == iGeneration)
+	{
+		// sleep in small steps, so replacing the queue doesn't have to wait for the budget
+		const double flWait = budget.GetWaitTime(vBuffer.size(), m_Io.fnTime());
+		if (flWait > 0.0)
+		{
+			m_Io.fnSleep(std::min(flWait, 0.1));
+			continue;
+		}
+
+		const size_t iRead = m_Io.fnRead(pHandle, vBuffer.data(), vBuffer.size());
+		budget.Acquire(iRead, m_Io.fnTime());
+
+		if (iRead)
+		{
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			m_iBytesRead += iRead;
+		}
+
+		if (iRead < vBuffer.size())
+		{
+			bFinished = true;
+			break;
+		}
+	}
+
+	m_Io.fnClose(pHandle);
+	return bFinished;
+}
+
+void PakPrefetcher::RunWorker()
+{
+#ifdef _WIN32
+	// lowers io priority as well as cpu priority, so this never gets in the way of actually loading things
+	SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#endif
+
+	std::vector<char> vBuffer(READ_CHUNK_SIZE);
+	PrefetchIoBudget budget;
+	uint64_t iBudgetGeneration = 0;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	for (;;)
+	{
+		m_WorkAvailable.wait(lock, [this] { return m_bStopping || m_iNextFile < m_vQueue.size(); });
+		if (m_bStopping)
+			return;
+
+		const uint64_t iGeneration = m_iGeneration;
+		if (iBudgetGeneration != iGeneration)
+		{
+			budget.SetRate(m_iBytesPerSecond, READ_CHUNK_SIZE, m_Io.fnTime());
+			iBudgetGeneration = iGeneration;
+		}
+
+		const std::string svPath = m_vQueue[m_iNextFile++];
+		m_bReading = true;
+		lock.unlock();
+
+		const bool bFinished = ReadFile(svPath, iGeneration, budget, vBuffer);
+
+		lock.lock();
+		m_bReading = false;
+		if (bFinished)
+			m_iFilesRead++;
+	}
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Purpose: Token bucket limiting how many bytes per second the prefetcher reads
+//          time is always passed in, so this doesn't care where it comes from
+//-----------------------------------------------------------------------------
+class PrefetchIoBudget
+{
+private:
+	double m_flBytesPerSecond = 0.0;
+	double m_flBurstBytes = 0.0;
+	double m_flAvailable = 0.0;
+	double m_flLastTime = 0.0;
+
+public:
+	// a rate of 0 means unlimited
+	void SetRate(size_t iBytesPerSecond, size_t iBurstBytes, double flTime);
+
+	// takes up to iWanted bytes from the budget, returns how many were taken
+	size_t Acquire(size_t iWanted, double flTime);
+	// seconds until iBytes can be acquired, 0 if they can be acquired now
+	double GetWaitTime(size_t iBytes, double flTime) const;
+
+private:
+	void Refill(double flTime);
+};
+
+// true if a lowercase file stem under maps/ belongs to svMapName, e.g. mp_box, mp_box_large or mp_box.bsp.0000 for mp_box
+// but not mp_box_xyz, which is a different map
+bool IsMapFileStem(const std::string& svStem, const std::string& svMapName);
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads files on a low priority background thread so they're in the os page cache by the time they're loaded
+//          the data itself is thrown away, we only care that the os has it cached
+//-----------------------------------------------------------------------------
+class PakPrefetcher
+{
+public:
+	// read in chunks this big, and never let the budget burst past a chunk
+	static constexpr size_t READ_CHUNK_SIZE = 1024 * 1024;
+
+	// reads a chunk of a file into pBuffer, returning the number of bytes read, 0 at the end of the file or on error
+	// pHandle is whatever fnOpen returned for the file
+	struct FileIo_t
+	{
+		std::function<void*(const std::string& svPath)> fnOpen;
+		std::function<size_t(void* pHandle, char* pBuffer, size_t iSize)> fnRead;
+		std::function<void(void* pHandle)> fnClose;
+		// seconds since some fixed point, used for the budget
+		std::function<double()> fnTime;
+		std::function<void(double flSeconds)> fnSleep;
+	};
+
+private:
+	FileIo_t m_Io;
+
+	std::thread m_Worker;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+
+	std::vector<std::string> m_vQueue;
+	size_t m_iNextFile = 0;
+	// bumped every time the queue is replaced, so the worker can give up on a file it's part way through
+	std::atomic<uint64_t> m_iGeneration = 0;
+	size_t m_iBytesPerSecond = 0;
+	bool m_bStopping = false;
+
+	bool m_bReading = false;
+	size_t m_iBytesRead = 0;
+	size_t m_iFilesRead = 0;
+
+public:
+	PakPrefetcher();
+	PakPrefetcher(FileIo_t io);
+	~PakPrefetcher();
+
+	PakPrefetcher(const PakPrefetcher&) = delete;
+	PakPrefetcher& operator=(const PakPrefetcher&) = delete;
+
+	// replaces anything still queued with these files, read at no more than iBytesPerSecond (0 for unlimited)
+	void Prefetch(std::vector<std::string> vPaths, size_t iBytesPerSecond);
+	void Cancel();
+
+	// stops the worker thread, anything left in the queue is dropped
+	void Shutdown();
+
+	bool IsIdle();
+	size_t GetBytesRead();
+	size_t GetFilesRead();
+
+private:
+	void RunWorker();
+	// reads a whole file, returns false if it couldn't be opened or the queue was replaced before we finished
+	bool ReadFile(const std::string& svPath, uint64_t iGeneration, PrefetchIoBudget& budget, std::vector<char>& vBuffer);
+};
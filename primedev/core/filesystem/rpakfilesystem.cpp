@@ -3,6 +3,8 @@
 #include "dedicated/dedicated.h"
 #include "core/tier0.h"
 #include "util/utils.h"
+#include "core/convar/convar.h"
+#include "squirrel/squirrel.h"
 
 #pragma pack(push, 1)
 struct PakLoadFuncs
@@ -48,6 +50,8 @@ static_assert(sizeof(PakLoadFuncs) == 0x110);
 PakLoadFuncs* g_pakLoadApi;
 PakLoadManager* g_pPakLoadManager;
 
+static ConVar* Cvar_ns_pak_prefetch_rate;
+
 static char* pszCurrentMapRpakPath = nullptr;
 static PakHandle* piCurrentMapRpakHandle = nullptr;
 static PakHandle* piCurrentMapPatchRpakHandle = nullptr;
@@ -69,6 +73,7 @@ void PakLoadManager::UnloadAllModPaks()
 	{
 		modPak.m_markedForDelete = true;
 	}
+	m_mapPakTable.clear();
 	// clean up any paks that are both marked for unload and already unloaded
 	CleanUpUnloadedPaks();
 	SetForceReloadOnMapLoad(true);
@@ -89,9 +94,12 @@ void PakLoadManager::TrackModPaks(Mod& mod)
 		pak.m_preload = modRpakEntry.m_preload;
 		pak.m_dependentPakHash = modRpakEntry.m_dependentPakHash;
 		pak.m_mapRegex = modRpakEntry.m_loadRegex;
+		pak.m_starpakPaths = modRpakEntry.m_starpakPaths;
 
 		m_modPaks.push_back(pak);
 	}
+
+	m_mapPakTable.clear();
 }
 
 // Untracks all paks that aren't currently loaded and are marked for unload.
@@ -99,7 +107,12 @@ void PakLoadManager::CleanUpUnloadedPaks()
 {
 	auto fnRemovePredicate = [](ModPak_t& pak) -> bool { return pak.m_markedForDelete && pak.m_handle == PakHandle::INVALID; };
 
-	m_modPaks.erase(std::remove_if(m_modPaks.begin(), m_modPaks.end(), fnRemovePredicate), m_modPaks.end());
+	auto it = std::remove_if(m_modPaks.begin(), m_modPaks.end(), fnRemovePredicate);
+	if (it == m_modPaks.end())
+		return;
+
+	m_modPaks.erase(it, m_modPaks.end());
+	m_mapPakTable.clear();
 }
 
 // Unloads all paks that are marked for unload.
@@ -121,52 +134,134 @@ void PakLoadManager::UnloadMarkedPaks()
 	}
 }
 
-// Loads all modded paks for the given map.
-void PakLoadManager::LoadModPaksForMap(const char* mapName)
+// Gets the indices of the mod paks that should be loaded for a map.
+// Each pak's regex is only matched the first time a map is loaded, so map rotations don't keep matching them.
+const std::vector<size_t>& PakLoadManager::GetModPaksForMap(const std::string& mapName)
 {
-	++m_reentranceCounter;
-	const ScopeGuard guard([&]() { --m_reentranceCounter; });
+	auto it = m_mapPakTable.find(mapName);
+	if (it != m_mapPakTable.end())
+		return it->second;
 
-	for (auto& modPak : m_modPaks)
+	std::vector<size_t> paks;
+	for (size_t i = 0; i < m_modPaks.size(); i++)
 	{
-		// don't load paks that are already loaded
-		if (modPak.m_handle != PakHandle::INVALID)
-			continue;
-		std::cmatch matches;
-		if (!std::regex_match(mapName, matches, modPak.m_mapRegex))
-			continue;
-
-		modPak.m_handle = g_pakLoadApi->LoadRpakFileAsync(modPak.m_path.c_str(), *rpakMemoryAllocator, 7);
-		m_mapPaks.push_back(modPak.m_pathHash);
+		if (!m_modPaks[i].m_markedForDelete && std::regex_match(mapName, m_modPaks[i].m_mapRegex))
+			paks.push_back(i);
 	}
+
+	return m_mapPakTable.emplace(mapName, std::move(paks)).first->second;
 }
 
-// Unloads all modded map paks.
-void PakLoadManager::UnloadModPaks()
+// Loads all modded paks for the given map, and unloads the ones from the last map that it doesn't use.
+// Paks that both maps use stay loaded, rather than being unloaded and immediately loaded again.
+void PakLoadManager::UpdateModPaksForMap(const std::string& mapName)
 {
 	++m_reentranceCounter;
 	const ScopeGuard guard([&]() { --m_reentranceCounter; });
 
-	(*o_pCModelLoader_UnreferenceAllModels)(*ppModelLoader);
-	(*o_pCleanMaterialSystemStuff)();
+	const std::vector<size_t>& desiredPaks = GetModPaksForMap(mapName);
+	auto fnIsDesired = [&](size_t pathHash) -> bool
+	{
+		return std::any_of(desiredPaks.begin(), desiredPaks.end(), [&](size_t i) { return m_modPaks[i].m_pathHash == pathHash; });
+	};
 
-	for (auto& modPak : m_modPaks)
+	// unload old map paks that the new map doesn't use
+	bool bUnreferencedModels = false;
+	for (auto it = m_mapPaks.begin(); it != m_mapPaks.end();)
 	{
-		for (auto it = m_mapPaks.begin(); it != m_mapPaks.end(); ++it)
+		if (fnIsDesired(*it))
+		{
+			++it;
+			continue;
+		}
+
+		for (auto& modPak : m_modPaks)
 		{
-			if (*it != modPak.m_pathHash)
+			if (modPak.m_pathHash != *it || modPak.m_handle == PakHandle::INVALID)
 				continue;
 
-			m_mapPaks.erase(it, it + 1);
+			// only needs doing once, and not at all if we're keeping everything
+			if (!bUnreferencedModels)
+			{
+				(*o_pCModelLoader_UnreferenceAllModels)(*ppModelLoader);
+				(*o_pCleanMaterialSystemStuff)();
+				bUnreferencedModels = true;
+			}
+
 			g_pakLoadApi->UnloadPak(modPak.m_handle, *o_pCleanMaterialSystemStuff);
 			modPak.m_handle = PakHandle::INVALID;
 			break;
 		}
+
+		it = m_mapPaks.erase(it);
+	}
+
+	// load the new map's paks that aren't already loaded
+	for (size_t i : desiredPaks)
+	{
+		ModPak_t& modPak = m_modPaks[i];
+		if (modPak.m_handle != PakHandle::INVALID)
+			continue;
+
+		modPak.m_handle = g_pakLoadApi->LoadRpakFileAsync(modPak.m_path.c_str(), *rpakMemoryAllocator, 7);
+
+		// may already be here if something else unloaded it behind our back
+		if (std::find(m_mapPaks.begin(), m_mapPaks.end(), modPak.m_pathHash) == m_mapPaks.end())
+			m_mapPaks.push_back(modPak.m_pathHash);
 	}
+}
+
+// Reads everything from mods that a map is going to load, so it's in the os file cache by the time we load the map.
+// This is its mod paks that aren't already loaded, their starpaks, and any mod overrides of the map's own files.
+void PakLoadManager::PrefetchMap(const std::string& mapName)
+{
+	const int rateKB = Cvar_ns_pak_prefetch_rate->GetInt();
+	if (rateKB <= 0)
+		return;
+
+	std::vector<std::string> paths;
+	for (size_t i : GetModPaksForMap(mapName))
+	{
+		const ModPak_t& modPak = m_modPaks[i];
+		if (modPak.m_handle != PakHandle::INVALID)
+			continue;
+
+		paths.push_back(modPak.m_path);
+
+		// dedicated servers never open starpaks (see OpenFileHook), so there's no point caching them
+		if (!IsDedicatedServer())
+			paths.insert(paths.end(), modPak.m_starpakPaths.begin(), modPak.m_starpakPaths.end());
+	}
+
+	// override paths are lowercase, and a map's files are all named after it, e.g. maps/graphs/mp_glitch.ain or
+	// maps/navmesh/mp_glitch_large.nm
+	std::string lowerMapName = mapName;
+	std::transform(lowerMapName.begin(), lowerMapName.end(), lowerMapName.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+	for (const auto& [overridePath, modFile] : g_pModManager->m_ModFiles)
+	{
+		const fs::path path(overridePath);
+		if (path.empty() || *path.begin() != "maps")
+			continue;
 
-	// If this has happened, we may have leaked a pak?
-	// It basically means that none of the entries in m_modPaks matched the hash in m_mapPaks so we didn't end up unloading it
-	assert_msg(m_mapPaks.size() == 0, "Not all map paks were unloaded?");
+		if (!IsMapFileStem(path.stem().string(), lowerMapName))
+			continue;
+
+		// same goes for stbsps
+		if (IsDedicatedServer() && path.extension() == ".stbsp")
+			continue;
+
+		paths.push_back((modFile.m_pOwningMod->m_ModDirectory / MOD_OVERRIDE_DIR / modFile.m_Path).string());
+	}
+
+	NS::log::rpak->info("Prefetching {} mod files for {}", paths.size(), mapName);
+	m_prefetcher.Prefetch(std::move(paths), (size_t)rateKB * 1024);
+}
+
+// Stops reading anything we haven't read yet, e.g. because we're loading a map right now.
+void PakLoadManager::CancelPrefetch()
+{
+	m_prefetcher.Cancel();
 }
 
 // Called after a Pak was loaded.
@@ -361,6 +456,9 @@ static void HandlePakAliases(std::string& originalPath)
 static bool (*o_pLoadMapRpaks)(char* mapPath) = nullptr;
 static bool h_LoadMapRpaks(char* mapPath)
 {
+	// we're loading for real now, don't compete with it
+	g_pPakLoadManager->CancelPrefetch();
+
 	// unload all mod rpaks that are marked for unload
 	g_pPakLoadManager->UnloadMarkedPaks();
 	g_pPakLoadManager->CleanUpUnloadedPaks();
@@ -371,10 +469,8 @@ static bool h_LoadMapRpaks(char* mapPath)
 	// load mp_common, sp_common etc.
 	o_pLoadGametypeSpecificRpaks(mapName.c_str());
 
-	// unload old modded map paks
-	g_pPakLoadManager->UnloadModPaks();
-	// load modded map paks
-	g_pPakLoadManager->LoadModPaksForMap(mapName.c_str());
+	// swap the old map's modded paks for the new map's
+	g_pPakLoadManager->UpdateModPaksForMap(mapName);
 
 	// don't load/unload anything when going to the lobby, presumably to save load times when going back to the same map
 	if (!g_pPakLoadManager->GetForceReloadOnMapLoad() && !strcmp("mp_lobby", mapName.c_str()))
@@ -564,6 +660,17 @@ void*, __fastcall, (const char* pPath, void* pCallback))
 	return o_pOpenFile(pPath, pCallback);
 }
 
+ADD_SQFUNC(
+	"void",
+	NSPrefetchMapFiles,
+	"string mapName",
+	"Reads the mod files a map loads in the background, call this once the next map is known so loading it is quicker",
+	ScriptContext::SERVER | ScriptContext::CLIENT | ScriptContext::UI)
+{
+	g_pPakLoadManager->PrefetchMap(g_pSquirrel[context]->getstring(sqvm, 1));
+	return SQRESULT_NULL;
+}
+
 ON_DLL_LOAD("engine.dll", RpakFilesystem, (CModule module))
 {
 	g_pPakLoadManager = new PakLoadManager;
@@ -592,3 +699,13 @@ ON_DLL_LOAD("engine.dll", RpakFilesystem, (CModule module))
 	CModule rtechModule(GetModuleHandleA("rtech_game.dll"));
 	o_pGetPakPatchNumber = rtechModule.Offset(0x9A00).RCast<decltype(o_pGetPakPatchNumber)>();
 }
+
+// separate from the above so creating the pak load manager doesn't have to wait on convars
+ON_DLL_LOAD_RELIESON("engine.dll", RpakPrefetch, ConVar, (CModule module))
+{
+	Cvar_ns_pak_prefetch_rate = new ConVar(
+		"ns_pak_prefetch_rate",
+		"32768",
+		FCVAR_NONE,
+		"Max KB/s to read when prefetching the next map's mod files, 0 disables prefetching");
+}
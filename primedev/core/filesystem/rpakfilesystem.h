@@ -1,6 +1,9 @@
 #pragma once
 
+#include "core/filesystem/pakprefetch.h"
+
 #include <regex>
+#include <unordered_map>
 
 enum PakHandle : int
 {
@@ -20,6 +23,8 @@ struct ModPak_t
 	size_t m_dependentPakHash = 0;
 	// If this is set, this pak will be loaded whenever any other pak is loaded.
 	bool m_preload = false;
+	// Starpaks this pak references, only used for prefetching.
+	std::vector<std::string> m_starpakPaths;
 
 	// If this is set, the Pak will be unloaded on next map load
 	bool m_markedForDelete = false;
@@ -36,8 +41,10 @@ public:
 	void CleanUpUnloadedPaks();
 	void UnloadMarkedPaks();
 
-	void LoadModPaksForMap(const char* mapName);
-	void UnloadModPaks();
+	void UpdateModPaksForMap(const std::string& mapName);
+	// Reads the mod files a map will load in the background, so they're already cached when it does.
+	void PrefetchMap(const std::string& mapName);
+	void CancelPrefetch();
 
 	// Whether the current context is a vanilla call to a function, or a modded one
 	bool IsVanillaCall() const { return m_reentranceCounter == 0; }
@@ -56,6 +63,8 @@ public:
 	void* OpenFile(const char* path);
 
 private:
+	const std::vector<size_t>& GetModPaksForMap(const std::string& mapName);
+
 	void LoadDependentPaks(std::string& path, PakHandle handle);
 	void UnloadDependentPaks(PakHandle handle);
 
@@ -67,6 +76,11 @@ private:
 	std::vector<ModPak_t> m_modPaks;
 	// Hashes of the currently loaded map mod paks
 	std::vector<size_t> m_mapPaks;
+	// Indices into m_modPaks of the paks each map loads, filled in the first time a map is loaded.
+	// Cleared whenever m_modPaks changes, so the indices are always valid.
+	std::unordered_map<std::string, std::vector<size_t>> m_mapPakTable;
+	// Reads files for the map we expect to load next.
+	PakPrefetcher m_prefetcher;
 	// Currently loaded Pak path hashes that depend on a handle to remain loaded (Postload)
 	std::vector<std::pair<PakHandle, size_t>> m_dependentPaks;
 
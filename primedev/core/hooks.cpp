@@ -1,6 +1,9 @@
 #include "dedicated/dedicated.h"
 #include "plugins/pluginmanager.h"
+#include "core/convar/convar.h"
 
+#include <chrono>
+#include <unordered_map>
 #include <iostream>
 #include <wchar.h>
 #include <iostream>
@@ -12,6 +15,109 @@
 
 namespace fs = std::filesystem;
 
+// hook batching and startup timing
+static int s_iHookBatchDepth = 0;
+static double s_flTotalHookTime = 0.0;
+
+// hooks waiting for the current batch to end, names are only used for logging once they're actually enabled
+struct QueuedHook_t
+{
+	LPVOID pTarget;
+	std::string svName;
+};
+
+static std::vector<QueuedHook_t> s_vQueuedHooks;
+
+struct DllLoadCallbackTiming_t
+{
+	std::string svDll;
+	std::string svTag;
+	double flTime;
+};
+
+static std::vector<DllLoadCallbackTiming_t> s_vDllLoadCallbackTimings;
+
+static double HookSys_GetTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+MH_STATUS HookSys_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID* ppOriginal)
+{
+	const double flStart = HookSys_GetTime();
+	MH_STATUS status = MH_CreateHook(pTarget, pDetour, ppOriginal);
+	s_flTotalHookTime += HookSys_GetTime() - flStart;
+
+	return status;
+}
+
+MH_STATUS HookSys_EnableHook(LPVOID pTarget, const char* pszName)
+{
+	const double flStart = HookSys_GetTime();
+
+	MH_STATUS status;
+	if (s_iHookBatchDepth)
+	{
+		status = MH_QueueEnableHook(pTarget);
+		if (status == MH_OK)
+			s_vQueuedHooks.push_back({pTarget, pszName ? pszName : ""});
+	}
+	else
+	{
+		status = MH_EnableHook(pTarget);
+		if (status == MH_OK && pszName)
+			spdlog::info("Enabling hook {}", pszName);
+	}
+
+	s_flTotalHookTime += HookSys_GetTime() - flStart;
+
+	return status;
+}
+
+void HookSys_BeginBatch()
+{
+	s_iHookBatchDepth++;
+}
+
+void HookSys_EndBatch()
+{
+	assert_msg(s_iHookBatchDepth > 0, "HookSys_EndBatch called without a matching HookSys_BeginBatch");
+	s_iHookBatchDepth--;
+
+	// always apply, even in a nested batch, since the dll that was loaded in the middle of a batch may be used straight away
+	if (s_vQueuedHooks.empty())
+		return;
+
+	const double flStart = HookSys_GetTime();
+	const MH_STATUS status = MH_ApplyQueued();
+	if (status == MH_OK)
+	{
+		for (const QueuedHook_t& hook : s_vQueuedHooks)
+			if (!hook.svName.empty())
+				spdlog::info("Enabling hook {}", hook.svName);
+	}
+	else
+	{
+		// applying can fail partway through, so enable what's left one at a time to find out which hooks actually failed
+		spdlog::error("MH_ApplyQueued failed for {} queued hooks with {}, enabling them individually", s_vQueuedHooks.size(), (int)status);
+
+		for (const QueuedHook_t& hook : s_vQueuedHooks)
+		{
+			const MH_STATUS hookStatus = MH_EnableHook(hook.pTarget);
+			if (hookStatus == MH_OK || hookStatus == MH_ERROR_ENABLED)
+			{
+				if (!hook.svName.empty())
+					spdlog::info("Enabling hook {}", hook.svName);
+			}
+			else
+				spdlog::error("MH_EnableHook failed for function {}", hook.svName.empty() ? "(unnamed)" : hook.svName);
+		}
+	}
+	s_flTotalHookTime += HookSys_GetTime() - flStart;
+
+	s_vQueuedHooks.clear();
+}
+
 // called from the ON_DLL_LOAD macros
 __dllLoadCallback::__dllLoadCallback(
 	eDllLoadCallbackSide side, const std::string dllName, DllLoadCallbackFuncType callback, std::string uniqueStr, std::string reliesOn)
@@ -104,13 +210,10 @@ bool ManualHook::Dispatch(LPVOID addr, LPVOID* orig)
 
 	if (!addr)
 		spdlog::error("Address for hook {} is invalid", svFuncName);
-	else if (MH_CreateHook(addr, pHookFunc, ppOrigFunc) == MH_OK)
+	else if (HookSys_CreateHook(addr, pHookFunc, ppOrigFunc) == MH_OK)
 	{
-		if (MH_EnableHook(addr) == MH_OK)
-		{
-			spdlog::info("Enabling hook {}", svFuncName);
+		if (HookSys_EnableHook(addr, svFuncName.c_str()) == MH_OK)
 			return true;
-		}
 		else
 			spdlog::error("MH_EnableHook failed for function {}", svFuncName);
 	}
@@ -157,30 +260,170 @@ uintptr_t ParseDLLOffsetString(const char* pAddrString)
 // this allows for code to register callbacks to be run as soon as a dll is loaded, mainly to allow for patches to be made on dll load
 struct DllLoadCallback
 {
-	std::string dll;
+	std::string dll; // normalised with NormaliseDllName
 	DllLoadCallbackFuncType callback;
 	std::string tag;
 	std::vector<std::string> reliesOn;
+	std::vector<size_t> dependencies; // indices of the callbacks providing reliesOn, resolved when scheduling
 	bool called;
+	bool valid; // false if the callback can never run due to a missing or cyclic dependency
 };
 
-// HACK: declaring and initialising this vector at file scope crashes on debug builds due to static initialisation order
-// using a static var like this ensures that the vector is initialised lazily when it's used
-std::vector<DllLoadCallback>& GetDllLoadCallbacks()
+struct DllLoadCallbackSchedule
 {
-	static std::vector<DllLoadCallback> vec = std::vector<DllLoadCallback>();
-	return vec;
+	std::vector<DllLoadCallback> callbacks;
+
+	// callbacks for each dll, in dependency order
+	std::unordered_map<std::string, std::vector<size_t>> dllCallbacks;
+	bool dirty = true;
+
+	// callbacks whose dll has loaded, but that rely on callbacks for a dll that hasn't yet
+	std::vector<std::pair<size_t, HMODULE>> deferred;
+};
+
+// HACK: declaring and initialising this at file scope crashes on debug builds due to static initialisation order
+// using a static var like this ensures that the schedule is initialised lazily when it's used
+DllLoadCallbackSchedule& GetDllLoadCallbackSchedule()
+{
+	static DllLoadCallbackSchedule schedule;
+	return schedule;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Reduces a dll path to a lowercase filename, so lookups don't depend on how the dll was loaded
+//-----------------------------------------------------------------------------
+template <typename CharType> std::string NormaliseDllName(const CharType* pPath)
+{
+	const CharType* pFilename = pPath;
+	for (const CharType* pCur = pPath; *pCur; pCur++)
+		if (*pCur == '\\' || *pCur == '/')
+			pFilename = pCur + 1;
+
+	// we only register ascii names, so anything else can never match and is fine to mangle
+	std::string svName;
+	for (const CharType* pCur = pFilename; *pCur; pCur++)
+		svName += *pCur >= 0 && *pCur < 0x80 ? static_cast<char>(tolower(static_cast<int>(*pCur))) : '?';
+
+	return svName;
 }
 
 void AddDllLoadCallback(std::string dll, DllLoadCallbackFuncType callback, std::string tag, std::vector<std::string> reliesOn)
 {
-	DllLoadCallback& callbackStruct = GetDllLoadCallbacks().emplace_back();
+	DllLoadCallbackSchedule& schedule = GetDllLoadCallbackSchedule();
+	DllLoadCallback& callbackStruct = schedule.callbacks.emplace_back();
 
-	callbackStruct.dll = dll;
+	callbackStruct.dll = NormaliseDllName(dll.c_str());
 	callbackStruct.callback = callback;
 	callbackStruct.tag = tag;
 	callbackStruct.reliesOn = reliesOn;
 	callbackStruct.called = false;
+	callbackStruct.valid = true;
+
+	schedule.dirty = true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Resolves reliesOn tags and topologically sorts every registered callback into per dll lists
+//-----------------------------------------------------------------------------
+void BuildDllLoadCallbackSchedule(DllLoadCallbackSchedule& schedule)
+{
+	std::vector<DllLoadCallback>& callbacks = schedule.callbacks;
+
+	std::unordered_map<std::string, std::vector<size_t>> tagCallbacks;
+	for (size_t i = 0; i < callbacks.size(); i++)
+		if (!callbacks[i].tag.empty())
+			tagCallbacks[callbacks[i].tag].push_back(i);
+
+	// resolve dependencies, and build the reverse edges for the sort
+	std::vector<std::vector<size_t>> dependents(callbacks.size());
+	std::vector<size_t> unresolvedCount(callbacks.size(), 0);
+	for (size_t i = 0; i < callbacks.size(); i++)
+	{
+		DllLoadCallback& callbackStruct = callbacks[i];
+		callbackStruct.dependencies.clear();
+
+		for (const std::string& tag : callbackStruct.reliesOn)
+		{
+			auto providers = tagCallbacks.find(tag);
+			if (providers == tagCallbacks.end())
+			{
+				spdlog::error(
+					"Dll load callback {} ({}) relies on {}, which is not registered, it will not be run",
+					callbackStruct.tag,
+					callbackStruct.dll,
+					tag);
+				callbackStruct.valid = false;
+				continue;
+			}
+
+			for (size_t iProvider : providers->second)
+			{
+				callbackStruct.dependencies.push_back(iProvider);
+				dependents[iProvider].push_back(i);
+			}
+		}
+
+		unresolvedCount[i] = callbackStruct.dependencies.size();
+	}
+
+	// kahn's algorithm, starting from callbacks in registration order so independent callbacks keep their original order
+	std::vector<size_t> order;
+	order.reserve(callbacks.size());
+	for (size_t i = 0; i < callbacks.size(); i++)
+		if (!unresolvedCount[i])
+			order.push_back(i);
+
+	for (size_t iHead = 0; iHead < order.size(); iHead++)
+	{
+		for (size_t iDependent : dependents[order[iHead]])
+			if (!--unresolvedCount[iDependent])
+				order.push_back(iDependent);
+	}
+
+	// anything left over is either part of a cycle or relies on one
+	if (order.size() != callbacks.size())
+	{
+		std::string svCycle;
+		for (size_t i = 0; i < callbacks.size(); i++)
+		{
+			if (!unresolvedCount[i])
+				continue;
+
+			callbacks[i].valid = false;
+			svCycle += fmt::format("{}{} ({})", svCycle.empty() ? "" : ", ", callbacks[i].tag, callbacks[i].dll);
+		}
+
+		spdlog::error("Dll load callbacks are part of or rely on a circular dependency and will not be run: {}", svCycle);
+	}
+
+	// callbacks relying on one that can't run can't run either, dependencies always come first in order so one pass is enough
+	for (size_t i : order)
+	{
+		DllLoadCallback& callbackStruct = callbacks[i];
+		if (!callbackStruct.valid)
+			continue;
+
+		for (size_t iDependency : callbackStruct.dependencies)
+		{
+			if (!callbacks[iDependency].valid)
+			{
+				spdlog::error(
+					"Dll load callback {} ({}) relies on {}, which cannot be run, it will not be run either",
+					callbackStruct.tag,
+					callbackStruct.dll,
+					callbacks[iDependency].tag);
+				callbackStruct.valid = false;
+				break;
+			}
+		}
+	}
+
+	schedule.dllCallbacks.clear();
+	for (size_t i : order)
+		if (callbacks[i].valid)
+			schedule.dllCallbacks[callbacks[i].dll].push_back(i);
+
+	schedule.dirty = false;
 }
 
 void AddDllLoadCallbackForDedicatedServer(
@@ -207,11 +450,9 @@ void MakeHook(LPVOID pTarget, LPVOID pDetour, void* ppOriginal, const char* pFun
 	if (*pStrippedFuncName == '&')
 		pStrippedFuncName++;
 
-	if (MH_CreateHook(pTarget, pDetour, (LPVOID*)ppOriginal) == MH_OK)
+	if (HookSys_CreateHook(pTarget, pDetour, (LPVOID*)ppOriginal) == MH_OK)
 	{
-		if (MH_EnableHook(pTarget) == MH_OK)
-			spdlog::info("Enabling hook {}", pStrippedFuncName);
-		else
+		if (HookSys_EnableHook(pTarget, pStrippedFuncName) != MH_OK)
 			spdlog::error("MH_EnableHook failed for function {}", pStrippedFuncName);
 	}
 	else
@@ -280,85 +521,148 @@ static LPSTR WINAPI h_GetCommandLineA()
 	return cmdlineModified;
 }
 
-std::vector<std::string> calledTags;
-void CallLoadLibraryACallbacks(LPCSTR lpLibFileName, HMODULE moduleAddress)
+//-----------------------------------------------------------------------------
+// Purpose: Runs a single dll load callback and records how long it took
+//-----------------------------------------------------------------------------
+void RunDllLoadCallback(DllLoadCallback& callbackStruct, HMODULE moduleAddress)
 {
-	CModule cModule(moduleAddress);
+	const double flStart = HookSys_GetTime();
+	callbackStruct.callback(moduleAddress);
+	s_vDllLoadCallbackTimings.push_back({callbackStruct.dll, callbackStruct.tag, HookSys_GetTime() - flStart});
 
-	while (true)
-	{
-		bool bDoneCalling = true;
+	callbackStruct.called = true;
+}
+
+bool AreDllLoadCallbackDependenciesCalled(const DllLoadCallbackSchedule& schedule, const DllLoadCallback& callbackStruct)
+{
+	for (size_t iDependency : callbackStruct.dependencies)
+		if (!schedule.callbacks[iDependency].called)
+			return false;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Runs every callback registered for a dll in a single pass over its sorted list
+// Input  : svDllName - dll name normalised with NormaliseDllName
+//-----------------------------------------------------------------------------
+void CallDllLoadCallbacks(const std::string& svDllName, HMODULE moduleAddress)
+{
+	DllLoadCallbackSchedule& schedule = GetDllLoadCallbackSchedule();
+	if (schedule.dirty)
+		BuildDllLoadCallbackSchedule(schedule);
 
-		for (auto& callbackStruct : GetDllLoadCallbacks())
+	HookSys_BeginBatch();
+
+	auto dllCallbacks = schedule.dllCallbacks.find(svDllName);
+	if (dllCallbacks != schedule.dllCallbacks.end())
+	{
+		for (size_t i : dllCallbacks->second)
 		{
-			if (!callbackStruct.called && fs::path(lpLibFileName).filename() == fs::path(callbackStruct.dll).filename())
-			{
-				bool bShouldContinue = false;
+			DllLoadCallback& callbackStruct = schedule.callbacks[i];
+			if (callbackStruct.called)
+				continue;
 
-				if (!callbackStruct.reliesOn.empty())
+			// dependencies on this dll are sorted before us, so this can only fail on dependencies from another dll
+			if (!AreDllLoadCallbackDependenciesCalled(schedule, callbackStruct))
+			{
+				// several modules can normalise to the same dll name, only the first load's module is kept
+				const bool bAlreadyDeferred = std::any_of(
+					schedule.deferred.begin(),
+					schedule.deferred.end(),
+					[i](const std::pair<size_t, HMODULE>& deferred) { return deferred.first == i; });
+				if (!bAlreadyDeferred)
 				{
-					for (std::string tag : callbackStruct.reliesOn)
-					{
-						if (std::find(calledTags.begin(), calledTags.end(), tag) == calledTags.end())
-						{
-							bDoneCalling = false;
-							bShouldContinue = true;
-							break;
-						}
-					}
+					spdlog::warn(
+						"Deferring dll load callback {} ({}) until the dlls it relies on are loaded", callbackStruct.tag, svDllName);
+					schedule.deferred.push_back({i, moduleAddress});
 				}
 
-				if (bShouldContinue)
-					continue;
-
-				callbackStruct.callback(moduleAddress);
-				calledTags.push_back(callbackStruct.tag);
-				callbackStruct.called = true;
+				continue;
 			}
+
+			RunDllLoadCallback(callbackStruct, moduleAddress);
 		}
+	}
+
+	// this dll may have been the last dependency of deferred callbacks, which may in turn be relied on by other deferred callbacks
+	bool bCalledDeferred = true;
+	while (bCalledDeferred)
+	{
+		bCalledDeferred = false;
+		for (auto it = schedule.deferred.begin(); it != schedule.deferred.end();)
+		{
+			DllLoadCallback& callbackStruct = schedule.callbacks[it->first];
+
+			// never run a callback twice, that would install its hooks twice
+			if (callbackStruct.called)
+			{
+				it = schedule.deferred.erase(it);
+				continue;
+			}
 
-		if (bDoneCalling)
-			break;
+			if (!AreDllLoadCallbackDependenciesCalled(schedule, callbackStruct))
+			{
+				++it;
+				continue;
+			}
+
+			RunDllLoadCallback(callbackStruct, it->second);
+			it = schedule.deferred.erase(it);
+			bCalledDeferred = true;
+		}
 	}
+
+	HookSys_EndBatch();
+}
+
+void CallLoadLibraryACallbacks(LPCSTR lpLibFileName, HMODULE moduleAddress)
+{
+	CallDllLoadCallbacks(NormaliseDllName(lpLibFileName), moduleAddress);
 }
 
 void CallLoadLibraryWCallbacks(LPCWSTR lpLibFileName, HMODULE moduleAddress)
 {
-	while (true)
-	{
-		bool bDoneCalling = true;
+	CallDllLoadCallbacks(NormaliseDllName(lpLibFileName), moduleAddress);
+}
 
-		for (auto& callbackStruct : GetDllLoadCallbacks())
-		{
-			if (!callbackStruct.called && fs::path(lpLibFileName).filename() == fs::path(callbackStruct.dll).filename())
-			{
-				bool bShouldContinue = false;
+//-----------------------------------------------------------------------------
+// Purpose: Logs the slowest dll load callbacks, per dll totals and the total cost of hooking
+// Input  : iCount - amount of callbacks to list
+//-----------------------------------------------------------------------------
+void PrintDllLoadCallbackTimings(int iCount)
+{
+	std::vector<DllLoadCallbackTiming_t> vSorted = s_vDllLoadCallbackTimings;
+	std::sort(
+		vSorted.begin(),
+		vSorted.end(),
+		[](const DllLoadCallbackTiming_t& a, const DllLoadCallbackTiming_t& b) { return a.flTime > b.flTime; });
+
+	double flTotalCallbackTime = 0.0;
+	std::map<std::string, double> mDllTimes;
+	for (const DllLoadCallbackTiming_t& timing : vSorted)
+	{
+		flTotalCallbackTime += timing.flTime;
+		mDllTimes[timing.svDll] += timing.flTime;
+	}
 
-				if (!callbackStruct.reliesOn.empty())
-				{
-					for (std::string tag : callbackStruct.reliesOn)
-					{
-						if (std::find(calledTags.begin(), calledTags.end(), tag) == calledTags.end())
-						{
-							bDoneCalling = false;
-							bShouldContinue = true;
-							break;
-						}
-					}
-				}
+	spdlog::info(
+		"{} dll load callbacks took {:.2f}ms, {:.2f}ms of which was spent creating and enabling hooks",
+		vSorted.size(),
+		flTotalCallbackTime * 1000.0,
+		s_flTotalHookTime * 1000.0);
 
-				if (bShouldContinue)
-					continue;
+	for (const auto& [svDll, flTime] : mDllTimes)
+		spdlog::info("    {:<32} {:>8.2f}ms", svDll, flTime * 1000.0);
 
-				callbackStruct.callback(moduleAddress);
-				calledTags.push_back(callbackStruct.tag);
-				callbackStruct.called = true;
-			}
-		}
+	spdlog::info("slowest dll load callbacks:");
+	for (size_t i = 0; i < (size_t)std::max(iCount, 0) && i < vSorted.size(); i++)
+		spdlog::info("    {:<32} {:<24} {:>8.2f}ms", vSorted[i].svTag, vSorted[i].svDll, vSorted[i].flTime * 1000.0);
+}
 
-		if (bDoneCalling)
-			break;
-	}
+void ConCommand_ns_print_dll_load_timings(const CCommand& args)
+{
+	PrintDllLoadCallbackTimings(args.ArgC() > 1 ? atoi(args.Arg(1)) : 10);
 }
 
 void CallAllPendingDLLLoadCallbacks()
@@ -394,3 +698,14 @@ void HookSys_Init()
 	o_pGetCommandLineA = GetCommandLineA;
 	HookAttach(&(PVOID&)o_pGetCommandLineA, (PVOID)h_GetCommandLineA);
 }
+
+ON_DLL_LOAD_RELIESON("engine.dll", DllLoadTimings, ConCommand, (CModule module))
+{
+	NOTE_UNUSED(module);
+
+	RegisterConCommand(
+		"ns_print_dll_load_timings",
+		ConCommand_ns_print_dll_load_timings,
+		"Prints how long dll load callbacks and hooking took, optionally with the amount of slowest callbacks to list",
+		FCVAR_NONE);
+}
@@ -8,6 +8,25 @@
 //-----------------------------------------------------------------------------
 void HookSys_Init();
 
+//-----------------------------------------------------------------------------
+// Purpose: MH_CreateHook wrapper that accounts for time spent hooking
+//-----------------------------------------------------------------------------
+MH_STATUS HookSys_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID* ppOriginal);
+
+//-----------------------------------------------------------------------------
+// Purpose: MH_EnableHook wrapper, queues the enable instead while a batch is open
+// Input  : pTarget - Function to enable the hook for
+//          *pszName - Optional, logged once the hook is actually enabled
+//-----------------------------------------------------------------------------
+MH_STATUS HookSys_EnableHook(LPVOID pTarget, const char* pszName = nullptr);
+
+//-----------------------------------------------------------------------------
+// Purpose: Batches hook enables until the matching HookSys_EndBatch
+//          enabling a hook suspends every thread in the process, so doing it once for a whole dll is much cheaper
+//-----------------------------------------------------------------------------
+void HookSys_BeginBatch();
+void HookSys_EndBatch();
+
 //-----------------------------------------------------------------------------
 // Purpose: MH_MakeHook wrapper
 // Input  : *ppOriginal - Original function being detoured
@@ -16,9 +35,9 @@ void HookSys_Init();
 inline void HookAttach(PVOID* ppOriginal, PVOID pDetour)
 {
 	PVOID pAddr = *ppOriginal;
-	if (MH_CreateHook(pAddr, pDetour, ppOriginal) == MH_OK)
+	if (HookSys_CreateHook(pAddr, pDetour, ppOriginal) == MH_OK)
 	{
-		if (MH_EnableHook(pAddr) != MH_OK)
+		if (HookSys_EnableHook(pAddr) != MH_OK)
 		{
 			spdlog::error("Failed enabling a function hook!");
 		}
@@ -39,6 +58,7 @@ void AddDllLoadCallbackForClient(
 	std::string dll, DllLoadCallbackFuncType callback, std::string tag = "", std::vector<std::string> reliesOn = {});
 
 void CallAllPendingDLLLoadCallbacks();
+void PrintDllLoadCallbackTimings(int iCount);
 
 // new dll load callback stuff
 enum class eDllLoadCallbackSide
@@ -233,11 +253,9 @@ public:
 
 		if (!targetAddr)
 			spdlog::error("Address for hook {} is invalid", pFuncName);
-		else if (MH_CreateHook(targetAddr, pHookFunc, ppOrigFunc) == MH_OK)
+		else if (HookSys_CreateHook(targetAddr, pHookFunc, ppOrigFunc) == MH_OK)
 		{
-			if (MH_EnableHook(targetAddr) == MH_OK)
-				spdlog::info("Enabling hook {}", pFuncName);
-			else
+			if (HookSys_EnableHook(targetAddr, pFuncName) != MH_OK)
 				spdlog::error("MH_EnableHook failed for function {}", pFuncName);
 		}
 		else
@@ -43,6 +43,7 @@ static INLINE u32 LoadLittleDWord(u32* base, size_t dwordIndex)
 }
 
 #include <algorithm>
+#include <cstring>
 
 static inline const u32 s_nMaskTable[33] = {
 	0,
@@ -134,7 +135,7 @@ public:
 
 	INLINE void GrabNextDWord(bool overflow = false)
 	{
-		if (m_Data == m_DataEnd)
+		if (m_DataIn == m_DataEnd)
 		{
 			m_CachedBitsLeft = 1;
 			m_CachedBufWord = 0;
@@ -153,7 +154,10 @@ public:
 			}
 			else
 			{
-				m_CachedBufWord = LittleDWord(*(m_DataIn++));
+				// Seek can leave m_DataIn unaligned to read the last few bytes of a buffer
+				u32 dword;
+				memcpy(&dword, m_DataIn++, sizeof(u32));
+				m_CachedBufWord = LittleDWord(dword);
 			}
 		}
 	}
@@ -480,11 +484,51 @@ public:
 		return result;
 	}
 
+	// reads count fields of numBits each, same result as calling ReadUBitLong count times
+	INLINE void ReadUBitLongArray(u32* out, size_t count, i32 numBits)
+	{
+		BulkReadState_t state = BeginBulkRead();
+		for (size_t i = 0; i < count; i++)
+			out[i] = ReadBulkUBitLong(state, numBits);
+
+		EndBulkRead(state);
+	}
+
 	INLINE void ReadBits(uptr outData, u32 bitLength)
 	{
 		u8* out = reinterpret_cast<u8*>(outData);
 		int bitsLeft = bitLength;
 
+		// byte aligned: drain the cached word, then copy whole dwords straight out of the buffer
+		// only when the read fits, reads that overflow have to zero out exactly what the slow path zeroes out
+		if ((m_CachedBitsLeft & 7) == 0 && !IsOverflowed() && size_t(bitsLeft) <= GetNumBitsLeft())
+		{
+			while (m_CachedBitsLeft != 32 && bitsLeft >= 8)
+			{
+				*out = (unsigned char)ReadUBitLong(8);
+				++out;
+				bitsLeft -= 8;
+			}
+
+			if (m_CachedBitsLeft == 32 && bitsLeft >= 32)
+			{
+				// the cached word is the dword before m_DataIn, so it's always the first one we copy
+				size_t bufferDwords = 1 + (m_DataIn < m_DataEnd ? m_DataEnd - m_DataIn : 0);
+				size_t dwords = std::min(size_t(bitsLeft / 32), bufferDwords);
+
+				u32 cachedWord = LittleDWord(m_CachedBufWord);
+				memcpy(out, &cachedWord, sizeof(u32));
+				memcpy(out + sizeof(u32), m_DataIn, (dwords - 1) * sizeof(u32));
+
+				m_DataIn += dwords - 1;
+				out += dwords * sizeof(u32);
+				bitsLeft -= int(dwords * 32);
+
+				// same eager fetch ReadUBitLong does when it empties the cached word
+				FetchNext();
+			}
+		}
+
 		// align output to dword boundary
 		while (((uptr)out & 3) != 0 && bitsLeft >= 8)
 		{
@@ -668,6 +712,64 @@ public:
 	INLINE size_t GetNumBytesLeft() { return GetNumBitsLeft() >> 3; }
 
 private:
+	// the cached word has to stay 32 bits to match the engine's layout, so bulk readers work on a local 64 bit view of
+	// the read state instead, and write it back once they're done
+	struct BulkReadState_t
+	{
+		u64 word;
+		u32 bitsLeft;
+		const u32* dataIn;
+	};
+
+	INLINE BulkReadState_t BeginBulkRead() { return {m_CachedBufWord, m_CachedBitsLeft, m_DataIn}; }
+
+	INLINE void EndBulkRead(const BulkReadState_t& state)
+	{
+		// nothing read, Seek can leave us with no cached bits and we don't want to fetch on its behalf
+		if (state.bitsLeft == m_CachedBitsLeft && state.dataIn == m_DataIn)
+			return;
+
+		m_CachedBufWord = u32(state.word);
+		m_CachedBitsLeft = state.bitsLeft;
+		m_DataIn = state.dataIn;
+
+		if (state.bitsLeft > 32)
+		{
+			// the last dword we loaded hasn't been touched, put it back so we're in the same state ReadUBitLong would leave us in
+			m_DataIn--;
+			m_CachedBitsLeft -= 32;
+			m_CachedBufWord &= s_nMaskTable[m_CachedBitsLeft];
+		}
+		else if (!state.bitsLeft)
+			FetchNext();
+	}
+
+	INLINE u32 ReadBulkUBitLong(BulkReadState_t& state, i32 numBits)
+	{
+		// once overflowed, reads that cross a dword always return 0, so leave those to ReadUBitLong
+		if (state.bitsLeft <= 32 && state.dataIn < m_DataEnd && !IsOverflowed())
+		{
+			u32 next;
+			memcpy(&next, state.dataIn++, sizeof(u32));
+			state.word |= u64(LittleDWord(next)) << state.bitsLeft;
+			state.bitsLeft += 32;
+		}
+
+		if (state.bitsLeft >= u32(numBits))
+		{
+			u32 ret = u32(state.word) & s_nMaskTable[numBits];
+			state.word >>= numBits;
+			state.bitsLeft -= numBits;
+			return ret;
+		}
+
+		// out of buffer, let ReadUBitLong deal with overflowing
+		EndBulkRead(state);
+		u32 ret = ReadUBitLong(numBits);
+		state = BeginBulkRead();
+		return ret;
+	}
+
 	size_t m_DataBits; // 0x0010
 	size_t m_DataBytes; // 0x0018
 
@@ -781,15 +883,16 @@ public:
 			Flush();
 	}
 
+	// data is always masked to numBits, bits above it would otherwise end up in the next field
+	// checkRange is only kept so call sites match the engine's signature
 	INLINE void WriteUBitLong(u32 data, i32 numBits, bool checkRange = true)
 	{
+		NOTE_UNUSED(checkRange);
+		data &= s_nMaskTable[numBits];
+
 		if (numBits <= m_OutBitsLeft)
 		{
-			if (checkRange)
-				m_OutBufWord |= (data) << (32 - m_OutBitsLeft);
-			else
-				m_OutBufWord |= (data & s_nMaskTable[numBits]) << (32 - m_OutBitsLeft);
-
+			m_OutBufWord |= data << (32 - m_OutBitsLeft);
 			m_OutBitsLeft -= numBits;
 
 			if (m_OutBitsLeft == 0)
@@ -808,6 +911,31 @@ public:
 
 	INLINE void WriteSBitLong(i32 data, i32 numBits) { WriteUBitLong((u32)data, numBits, false); }
 
+	// writes count fields of numBits each, same result as calling WriteUBitLong(data[i], numBits) count times
+	INLINE void WriteUBitLongArray(const u32* data, size_t count, i32 numBits)
+	{
+		u64 word = m_OutBufWord;
+		u32 bitsUsed = 32 - m_OutBitsLeft;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			word |= u64(data[i] & s_nMaskTable[numBits]) << bitsUsed;
+			bitsUsed += numBits;
+
+			if (bitsUsed >= 32)
+			{
+				m_OutBufWord = u32(word);
+				Flush();
+
+				word >>= 32;
+				bitsUsed -= 32;
+			}
+		}
+
+		m_OutBufWord = u32(word);
+		m_OutBitsLeft = 32 - bitsUsed;
+	}
+
 	INLINE void WriteUBitVar(u32 n)
 	{
 		if (n < 16)
@@ -847,7 +975,28 @@ public:
 			return false;
 		}
 
-		// !! speed!! need fast paths
+		// byte aligned: fill up the current word, then copy whole dwords straight into the buffer
+		if ((m_OutBitsLeft & 7) == 0)
+		{
+			while (m_OutBitsLeft != 32 && numBitsLeft >= 8)
+			{
+				WriteUBitLong(*out, 8, false);
+				++out;
+				numBitsLeft -= 8;
+			}
+
+			if (m_OutBitsLeft == 32 && numBitsLeft >= 32)
+			{
+				// the bounds check above guarantees these all fit
+				size_t dwords = numBitsLeft / 32;
+				memcpy(m_DataOut, out, dwords * sizeof(u32));
+
+				m_DataOut += dwords;
+				out += dwords * sizeof(u32);
+				numBitsLeft -= i32(dwords * 32);
+			}
+		}
+
 		// write remaining bytes
 		while (numBitsLeft >= 8)
 		{
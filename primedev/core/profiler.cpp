@@ -0,0 +1,367 @@
+#include "core/profiler.h"
+#include "core/convar/convar.h"
+#include "core/convar/concommand.h"
+#include "config/profile.h"
+
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <string_view>
+#include <unordered_map>
+
+CProfiler* g_pProfiler;
+
+ConVar* Cvar_ns_profiler_enable;
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns a steady timestamp in nanoseconds
+//-----------------------------------------------------------------------------
+int64_t Profiler_GetTime()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CProfileThreadBuffer::CProfileThreadBuffer(uint32_t iThreadId)
+	: m_iThreadId(iThreadId)
+{
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Records a sample, overwriting the oldest one if the buffer is full
+//          only ever called from the thread owning this buffer
+//-----------------------------------------------------------------------------
+void CProfileThreadBuffer::Push(const char* pszName, int64_t iStart, int64_t iEnd)
+{
+	const uint64_t iHead = m_iHead.load(std::memory_order_relaxed);
+
+	// release so a reader that sees any of these also sees the head from before we started overwriting the slot
+	ProfileSampleSlot_t& slot = m_Samples[iHead & (SAMPLE_COUNT - 1)];
+	slot.pszName.store(pszName, std::memory_order_release);
+	slot.iStart.store(iStart, std::memory_order_release);
+	slot.iEnd.store(iEnd, std::memory_order_release);
+
+	m_iHead.store(iHead + 1, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Copies every sample pushed since iFrom that is still in the buffer
+// Input  : iFrom - head value to start copying from, 0 for everything
+//          vOut - vector to append samples to
+//          *pDropped - optionally receives the number of samples that were lost to overwrites
+// Output : the head value at the time of copying, pass this as iFrom to continue later
+//-----------------------------------------------------------------------------
+uint64_t CProfileThreadBuffer::Copy(uint64_t iFrom, std::vector<ProfileSample_t>& vOut, uint64_t* pDropped) const
+{
+	const uint64_t iHead = m_iHead.load(std::memory_order_acquire);
+	uint64_t iStart = std::max(iFrom, iHead > SAMPLE_COUNT ? iHead - SAMPLE_COUNT : 0);
+
+	const size_t iOutStart = vOut.size();
+	for (uint64_t i = iStart; i < iHead; i++)
+	{
+		const ProfileSampleSlot_t& slot = m_Samples[i & (SAMPLE_COUNT - 1)];
+		vOut.push_back(
+			{slot.pszName.load(std::memory_order_relaxed),
+			 slot.iStart.load(std::memory_order_relaxed),
+			 slot.iEnd.load(std::memory_order_relaxed)});
+	}
+
+	// the owning thread may have lapped us while copying, anything it could have been writing to is unreliable
+	// the fence keeps the slot reads above from moving past the head read below
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const uint64_t iHeadAfter = m_iHead.load(std::memory_order_acquire);
+	if (iHeadAfter + 1 > SAMPLE_COUNT && iHeadAfter + 1 - SAMPLE_COUNT > iStart)
+	{
+		const uint64_t iTorn = std::min(iHeadAfter + 1 - SAMPLE_COUNT, iHead) - iStart;
+		vOut.erase(vOut.begin() + iOutStart, vOut.begin() + iOutStart + iTorn);
+		iStart += iTorn;
+	}
+
+	if (pDropped)
+		*pDropped = iStart - iFrom;
+
+	return iHead;
+}
+
+void CProfiler::SetEnabled(bool bEnabled)
+{
+	m_bEnabled.store(bEnabled, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Gets the calling thread's buffer, creating it on first use
+//-----------------------------------------------------------------------------
+CProfileThreadBuffer* CProfiler::GetThreadBuffer()
+{
+	// NOTE: buffers are intentionally never freed, so readers don't have to care about threads exiting
+	thread_local CProfileThreadBuffer* pBuffer = nullptr;
+	if (!pBuffer)
+	{
+		pBuffer = new CProfileThreadBuffer(GetCurrentThreadId());
+
+		std::lock_guard<std::mutex> guard(m_BufferMutex);
+		m_vBuffers.push_back(pBuffer);
+	}
+
+	return pBuffer;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Returns a pointer to a copy of svName that lives as long as the profiler
+//-----------------------------------------------------------------------------
+const char* CProfiler::InternName(const std::string& svName)
+{
+	std::lock_guard<std::mutex> guard(m_NameMutex);
+	return m_InternedNames.insert(svName).first->c_str();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Interns svName, only taking the profiler's lock the first time this cache sees it
+//-----------------------------------------------------------------------------
+const char* CProfileNameCache::Get(std::string_view svName)
+{
+	auto it = m_Names.find(svName);
+	if (it != m_Names.end())
+		return it->second;
+
+	std::string sName(svName);
+	const char* pszInterned = g_pProfiler->InternName(sName);
+	m_Names.emplace(std::move(sName), pszInterned);
+	return pszInterned;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Called at the end of every engine frame
+//-----------------------------------------------------------------------------
+void CProfiler::RunFrame()
+{
+	if (m_iCaptureFramesRemaining && !--m_iCaptureFramesRemaining)
+		WriteCapture();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Prints count, average, p50, p99 and max for every scope currently held in the buffers
+// Input  : *pszFilter - only print scopes containing this string, may be null
+//-----------------------------------------------------------------------------
+void CProfiler::PrintStats(const char* pszFilter)
+{
+	std::vector<ProfileSample_t> vSamples;
+	{
+		std::lock_guard<std::mutex> guard(m_BufferMutex);
+		for (CProfileThreadBuffer* pBuffer : m_vBuffers)
+			pBuffer->Copy(0, vSamples);
+	}
+
+	// the same literal can live at different addresses across translation units, so group by contents
+	std::unordered_map<std::string_view, std::vector<int64_t>> mDurations;
+	for (const ProfileSample_t& sample : vSamples)
+	{
+		if (pszFilter && !strstr(sample.pszName, pszFilter))
+			continue;
+
+		mDurations[sample.pszName].push_back(sample.iEnd - sample.iStart);
+	}
+
+	struct ScopeStats_t
+	{
+		std::string_view svName;
+		size_t iCount;
+		double flTotal;
+		double flP50;
+		double flP99;
+		double flMax;
+	};
+
+	std::vector<ScopeStats_t> vStats;
+	for (auto& [svName, vDurations] : mDurations)
+	{
+		std::sort(vDurations.begin(), vDurations.end());
+
+		int64_t iTotal = 0;
+		for (int64_t iDuration : vDurations)
+			iTotal += iDuration;
+
+		const size_t iCount = vDurations.size();
+		vStats.push_back(
+			{svName,
+			 iCount,
+			 iTotal / 1000000.0,
+			 vDurations[(iCount - 1) / 2] / 1000000.0,
+			 vDurations[(iCount - 1) * 99 / 100] / 1000000.0,
+			 vDurations.back() / 1000000.0});
+	}
+
+	std::sort(vStats.begin(), vStats.end(), [](const ScopeStats_t& a, const ScopeStats_t& b) { return a.flTotal > b.flTotal; });
+
+	spdlog::info("{:<48} {:>8} {:>10} {:>10} {:>10} {:>10}", "scope", "count", "avg ms", "p50 ms", "p99 ms", "max ms");
+	for (const ScopeStats_t& stats : vStats)
+	{
+		spdlog::info(
+			"{:<48} {:>8} {:>10.4f} {:>10.4f} {:>10.4f} {:>10.4f}",
+			stats.svName,
+			stats.iCount,
+			stats.flTotal / stats.iCount,
+			stats.flP50,
+			stats.flP99,
+			stats.flMax);
+	}
+
+	if (!IsEnabled())
+		spdlog::warn("profiler is not enabled, set ns_profiler_enable 1 to collect samples");
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Starts recording a trace that is written to disk after the given amount of frames
+//-----------------------------------------------------------------------------
+void CProfiler::StartCapture(int iFrames)
+{
+	if (m_iCaptureFramesRemaining)
+	{
+		spdlog::warn("a profiler capture is already running, {} frames remaining", m_iCaptureFramesRemaining);
+		return;
+	}
+
+	const std::time_t time = std::time(nullptr);
+	tm currentTime = *std::localtime(&time);
+	std::stringstream stream;
+	stream << std::put_time(&currentTime, (GetNorthstarPrefix() + "/logs/nsprofile%Y-%m-%d %H-%M-%S.json").c_str());
+	m_svCapturePath = stream.str();
+
+	m_vCaptureStartHeads.clear();
+	{
+		std::lock_guard<std::mutex> guard(m_BufferMutex);
+		for (CProfileThreadBuffer* pBuffer : m_vBuffers)
+			m_vCaptureStartHeads.push_back(pBuffer->m_iHead.load(std::memory_order_acquire));
+	}
+
+	// capturing should work without having to enable the profiler separately
+	m_bEnabledByCapture = !IsEnabled();
+	SetEnabled(true);
+
+	m_iCaptureStartTime = Profiler_GetTime();
+	m_iCaptureFramesRemaining = iFrames;
+
+	spdlog::info("started profiler capture of {} frames", iFrames);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Writes all samples recorded since the capture started in chrome trace event format
+//-----------------------------------------------------------------------------
+void CProfiler::WriteCapture()
+{
+	if (m_bEnabledByCapture)
+		SetEnabled(false);
+
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+	writer.StartObject();
+	writer.Key("displayTimeUnit");
+	writer.String("ms");
+	writer.Key("traceEvents");
+	writer.StartArray();
+
+	uint64_t iTotalDropped = 0;
+	size_t iTotalSamples = 0;
+
+	std::lock_guard<std::mutex> guard(m_BufferMutex);
+	for (size_t i = 0; i < m_vBuffers.size(); i++)
+	{
+		const CProfileThreadBuffer* pBuffer = m_vBuffers[i];
+
+		// buffers created after the capture started have everything we need from 0
+		uint64_t iDropped = 0;
+		std::vector<ProfileSample_t> vSamples;
+		pBuffer->Copy(i < m_vCaptureStartHeads.size() ? m_vCaptureStartHeads[i] : 0, vSamples, &iDropped);
+		iTotalDropped += iDropped;
+
+		for (const ProfileSample_t& sample : vSamples)
+		{
+			if (sample.iStart < m_iCaptureStartTime)
+				continue;
+
+			writer.StartObject();
+			writer.Key("name");
+			writer.String(sample.pszName);
+			writer.Key("ph");
+			writer.String("X");
+			writer.Key("ts");
+			writer.Double((sample.iStart - m_iCaptureStartTime) / 1000.0);
+			writer.Key("dur");
+			writer.Double((sample.iEnd - sample.iStart) / 1000.0);
+			writer.Key("pid");
+			writer.Uint(GetCurrentProcessId());
+			writer.Key("tid");
+			writer.Uint(pBuffer->m_iThreadId);
+			writer.EndObject();
+
+			iTotalSamples++;
+		}
+	}
+
+	writer.EndArray();
+	writer.EndObject();
+
+	std::ofstream captureStream(m_svCapturePath, std::ofstream::out | std::ofstream::binary);
+	if (!captureStream)
+	{
+		spdlog::error("failed to open {} for writing profiler capture", m_svCapturePath);
+		return;
+	}
+
+	captureStream.write(buffer.GetString(), buffer.GetSize());
+	captureStream.close();
+
+	spdlog::info("wrote {} samples to {}", iTotalSamples, m_svCapturePath);
+	if (iTotalDropped)
+		spdlog::warn("{} samples were overwritten before they could be captured, try capturing fewer frames", iTotalDropped);
+}
+
+void ConCommand_ns_profiler_stats(const CCommand& args)
+{
+	g_pProfiler->PrintStats(args.ArgC() > 1 ? args.Arg(1) : nullptr);
+}
+
+void ConCommand_ns_profiler_capture(const CCommand& args)
+{
+	int iFrames = 300;
+	if (args.ArgC() > 1)
+		iFrames = std::max(atoi(args.Arg(1)), 1);
+
+	g_pProfiler->StartCapture(iFrames);
+}
+
+ON_DLL_LOAD_RELIESON("engine.dll", Profiler, (ConVar, ConCommand), (CModule module))
+{
+	NOTE_UNUSED(module);
+
+	Cvar_ns_profiler_enable = new ConVar(
+		"ns_profiler_enable",
+		"0",
+		FCVAR_NONE,
+		"Whether Northstar's scoped timers should record samples",
+		false,
+		0,
+		false,
+		0,
+		[](ConVar* cvar, const char* pOldValue, float flOldValue)
+		{
+			NOTE_UNUSED(pOldValue);
+			NOTE_UNUSED(flOldValue);
+			g_pProfiler->SetEnabled(cvar->GetBool());
+		});
+
+	RegisterConCommand(
+		"ns_profiler_stats",
+		ConCommand_ns_profiler_stats,
+		"Prints per-scope timings recorded by the profiler, optionally filtered by scope name",
+		FCVAR_NONE);
+	RegisterConCommand(
+		"ns_profiler_capture",
+		ConCommand_ns_profiler_capture,
+		"Records a chrome trace event file of the given amount of frames (default 300) into the logs folder",
+		FCVAR_NONE);
+}
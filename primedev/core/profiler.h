@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// a single completed scope, timestamps are in nanoseconds from an arbitrary steady epoch
+struct ProfileSample_t
+{
+	const char* pszName;
+	int64_t iStart;
+	int64_t iEnd;
+};
+
+// a sample as stored in a ring buffer, other threads may be copying it while it's overwritten so every field is atomic
+struct ProfileSampleSlot_t
+{
+	std::atomic<const char*> pszName;
+	std::atomic<int64_t> iStart;
+	std::atomic<int64_t> iEnd;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Per-thread single producer ring buffer of completed scopes
+//-----------------------------------------------------------------------------
+class CProfileThreadBuffer
+{
+public:
+	static constexpr size_t SAMPLE_COUNT = 1 << 14; // must be a power of 2
+
+	uint32_t m_iThreadId;
+	std::atomic<uint64_t> m_iHead = 0;
+	ProfileSampleSlot_t m_Samples[SAMPLE_COUNT];
+
+public:
+	CProfileThreadBuffer(uint32_t iThreadId);
+
+	void Push(const char* pszName, int64_t iStart, int64_t iEnd);
+	uint64_t Copy(uint64_t iFrom, std::vector<ProfileSample_t>& vOut, uint64_t* pDropped = nullptr) const;
+};
+
+class CProfiler
+{
+private:
+	std::atomic<bool> m_bEnabled = false;
+	bool m_bEnabledByCapture = false;
+
+	std::mutex m_BufferMutex;
+	std::vector<CProfileThreadBuffer*> m_vBuffers;
+
+	std::mutex m_NameMutex;
+	std::unordered_set<std::string> m_InternedNames;
+
+	// capture state, only touched from the frame thread
+	int m_iCaptureFramesRemaining = 0;
+	int64_t m_iCaptureStartTime = 0;
+	std::string m_svCapturePath;
+	std::vector<uint64_t> m_vCaptureStartHeads;
+
+public:
+	inline bool IsEnabled() const
+	{
+		return m_bEnabled.load(std::memory_order_relaxed);
+	}
+	void SetEnabled(bool bEnabled);
+
+	CProfileThreadBuffer* GetThreadBuffer();
+	const char* InternName(const std::string& svName);
+
+	void RunFrame();
+	void PrintStats(const char* pszFilter);
+	void StartCapture(int iFrames);
+
+private:
+	void WriteCapture();
+};
+
+extern CProfiler* g_pProfiler;
+
+int64_t Profiler_GetTime();
+
+//-----------------------------------------------------------------------------
+// Purpose: RAII timer that records into the calling thread's ring buffer
+//-----------------------------------------------------------------------------
+class CProfileScope
+{
+private:
+	const char* m_pszName;
+	int64_t m_iStart;
+
+public:
+	inline CProfileScope(const char* pszName)
+		: m_pszName(g_pProfiler->IsEnabled() ? pszName : nullptr)
+		, m_iStart(m_pszName ? Profiler_GetTime() : 0)
+	{
+	}
+
+	inline ~CProfileScope()
+	{
+		if (m_pszName)
+			g_pProfiler->GetThreadBuffer()->Push(m_pszName, m_iStart, Profiler_GetTime());
+	}
+
+	CProfileScope(const CProfileScope&) = delete;
+	CProfileScope& operator=(const CProfileScope&) = delete;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Per call site and thread cache of interned names, so repeated names don't take the intern lock
+//-----------------------------------------------------------------------------
+class CProfileNameCache
+{
+private:
+	// lets us look up std::string keys with a string_view, so lookups don't allocate
+	struct NameHash_t
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view svName) const { return std::hash<std::string_view> {}(svName); }
+	};
+
+	std::unordered_map<std::string, const char*, NameHash_t, std::equal_to<>> m_Names;
+
+public:
+	const char* Get(std::string_view svName);
+};
+
+// times the enclosing scope, name must be a string literal or otherwise outlive the profiler
+#define NS_PROFILE_SCOPE(name) CProfileScope CONCAT2(__profileScope, __LINE__)(name)
+// times the enclosing scope under a runtime name, which is only interned while the profiler is enabled
+#define NS_PROFILE_SCOPE_DYNAMIC(name)                                                                                                     \
+	thread_local CProfileNameCache CONCAT2(__profileNameCache, __LINE__);                                                                  \
+	CProfileScope CONCAT2(__profileScope, __LINE__)(g_pProfiler->IsEnabled() ? CONCAT2(__profileNameCache, __LINE__).Get(name) : nullptr)
@@ -1,5 +1,6 @@
 #include "dedicated.h"
 #include "dedicatedlogtoclient.h"
+#include "dedicated/framepacer.h"
 #include "core/tier0.h"
 #include "shared/playlist.h"
 #include "engine/r2engine.h"
@@ -7,6 +8,14 @@
 #include "server/auth/serverauthentication.h"
 #include "masterserver/masterserver.h"
 #include "util/printcommands.h"
+#include "core/convar/convar.h"
+#include "core/convar/concommand.h"
+
+CFramePacer g_TickPacer;
+
+ConVar* Cvar_ns_tickpacer_enable;
+ConVar* Cvar_ns_tickpacer_min_spin_ms;
+ConVar* Cvar_ns_tickpacer_max_catchup_ticks;
 
 bool IsDedicatedServer()
 {
@@ -57,15 +66,94 @@ void RunServer(CDedicatedExports* dedicated)
 	Cbuf_Execute();
 
 	// main loop
-	double frameTitle = 0;
 	while (g_pEngine->m_nQuitting == EngineQuitState::QUIT_NOTQUITTING)
 	{
-		double frameStart = Plat_FloatTime();
+		if (!Cvar_ns_tickpacer_enable->GetBool())
+		{
+			double frameStart = Plat_FloatTime();
+			g_pEngine->Frame();
+
+			std::this_thread::sleep_for(
+				std::chrono::duration<double, std::ratio<1>>(g_pGlobals->m_flTickInterval - fmin(Plat_FloatTime() - frameStart, 0.25)));
+
+			// make sure the pacer doesn't try to catch up on everything we ran while it was disabled
+			g_TickPacer.Reset();
+			continue;
+		}
+
+		// negative catchup means we never run ticks back to back, always restart the schedule when late
+		const int iMaxCatchup = Cvar_ns_tickpacer_max_catchup_ticks->GetInt();
+		g_TickPacer.m_eCatchup = iMaxCatchup < 0 ? eFramePacerCatchup::RESYNC : eFramePacerCatchup::BOUNDED;
+		g_TickPacer.m_iMaxCatchupFrames = iMaxCatchup;
+		g_TickPacer.m_flMinSpinTime = Cvar_ns_tickpacer_min_spin_ms->GetFloat() / 1000.0;
+		g_TickPacer.SetInterval(g_pGlobals->m_flTickInterval);
+
+		g_TickPacer.WaitForNextFrame();
 		g_pEngine->Frame();
+	}
+}
 
-		std::this_thread::sleep_for(
-			std::chrono::duration<double, std::ratio<1>>(g_pGlobals->m_flTickInterval - fmin(Plat_FloatTime() - frameStart, 0.25)));
+//-----------------------------------------------------------------------------
+// Purpose: Prints a histogram with one line per non-empty bucket
+//-----------------------------------------------------------------------------
+void PrintPacerHistogram(const char* pName, const CPacerHistogram& histogram)
+{
+	spdlog::info(
+		"{}: {} samples, mean {:.3f}ms, min {:.3f}ms, p50 {:.3f}ms, p99 {:.3f}ms, max {:.3f}ms",
+		pName,
+		histogram.m_iCount,
+		histogram.GetMean() * 1000.0,
+		histogram.m_flMin * 1000.0,
+		histogram.GetPercentile(0.5) * 1000.0,
+		histogram.GetPercentile(0.99) * 1000.0,
+		histogram.m_flMax * 1000.0);
+
+	if (!histogram.m_iCount)
+		return;
+
+	uint64_t iLargestBucket = histogram.m_iOverflow;
+	for (uint64_t iBucket : histogram.m_Buckets)
+		iLargestBucket = std::max(iLargestBucket, iBucket);
+
+	constexpr int BAR_WIDTH = 40;
+	for (size_t i = 0; i < histogram.m_Buckets.size(); i++)
+	{
+		if (!histogram.m_Buckets[i])
+			continue;
+
+		spdlog::info(
+			"  {:>8.3f}-{:<8.3f}ms {:>8} {}",
+			i * histogram.m_flBucketWidth * 1000.0,
+			(i + 1) * histogram.m_flBucketWidth * 1000.0,
+			histogram.m_Buckets[i],
+			std::string(std::max<uint64_t>(1, histogram.m_Buckets[i] * BAR_WIDTH / iLargestBucket), '#'));
 	}
+
+	if (histogram.m_iOverflow)
+		spdlog::info(
+			"  {:>8.3f}+        ms {:>8} {}",
+			histogram.m_Buckets.size() * histogram.m_flBucketWidth * 1000.0,
+			histogram.m_iOverflow,
+			std::string(std::max<uint64_t>(1, histogram.m_iOverflow * BAR_WIDTH / iLargestBucket), '#'));
+}
+
+void ConCommand_ns_tickpacer_stats(const CCommand& args)
+{
+	if (args.ArgC() > 1 && !strcmp(args.Arg(1), "reset"))
+	{
+		g_TickPacer.ResetStats();
+		spdlog::info("reset tick pacer stats");
+		return;
+	}
+
+	spdlog::info(
+		"tick pacer: target interval {:.3f}ms, spin window {:.3f}ms, {} schedule resyncs",
+		g_TickPacer.GetInterval() * 1000.0,
+		g_TickPacer.GetSpinTime() * 1000.0,
+		g_TickPacer.m_iResyncs);
+
+	PrintPacerHistogram("tick interval", g_TickPacer.m_IntervalHistogram);
+	PrintPacerHistogram("tick overrun", g_TickPacer.m_OverrunHistogram);
 }
 
 // use server presence to update window title
@@ -118,6 +206,30 @@ static bool h_IsGameActiveWindow()
 	return true;
 }
 
+ON_DLL_LOAD_DEDI_RELIESON("engine.dll", DedicatedServerTickPacer, (ConVar, ConCommand), (CModule module))
+{
+	NOTE_UNUSED(module);
+
+	Cvar_ns_tickpacer_enable = new ConVar(
+		"ns_tickpacer_enable", "1", FCVAR_NONE, "Whether to pace server ticks to an absolute schedule instead of sleeping after each frame");
+	Cvar_ns_tickpacer_min_spin_ms = new ConVar(
+		"ns_tickpacer_min_spin_ms",
+		"1",
+		FCVAR_NONE,
+		"Minimum time before a tick is due that the tick pacer stops sleeping and spins instead, grows automatically if the os oversleeps");
+	Cvar_ns_tickpacer_max_catchup_ticks = new ConVar(
+		"ns_tickpacer_max_catchup_ticks",
+		"2",
+		FCVAR_NONE,
+		"How many ticks the server may fall behind and run back to back to catch up before the schedule restarts, -1 to never catch up");
+
+	RegisterConCommand(
+		"ns_tickpacer_stats",
+		ConCommand_ns_tickpacer_stats,
+		"Prints tick interval and overrun histograms, pass \"reset\" to clear them",
+		FCVAR_NONE);
+}
+
 ON_DLL_LOAD_DEDI_RELIESON("engine.dll", DedicatedServer, ServerPresence, (CModule module))
 {
 	spdlog::info("InitialiseDedicated");
@@ -228,7 +340,9 @@ ON_DLL_LOAD_DEDI_RELIESON("engine.dll", DedicatedServer, ServerPresence, (CModul
 	g_pServerPresence->AddPresenceReporter(presenceReporter);
 
 	// setup dedicated printing to client
-	RegisterCustomSink(std::make_shared<DedicatedServerLogToClientSink>());
+	std::shared_ptr<DedicatedServerLogToClientSink> pLogToClientSink = std::make_shared<DedicatedServerLogToClientSink>();
+	g_pDedicatedServerLogToClient = pLogToClientSink.get();
+	RegisterCustomSink(pLogToClientSink);
 
 	// Disable Quick Edit mode to reduce chance of user unintentionally hanging their server by selecting something.
 	if (!CommandLine()->CheckParm("-bringbackquickedit"))
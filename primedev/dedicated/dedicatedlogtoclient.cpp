@@ -3,31 +3,102 @@
 
 void (*CGameClient__ClientPrintf)(CBaseClient* pClient, const char* fmt, ...);
 
+DedicatedServerLogToClientSink* g_pDedicatedServerLogToClient;
+
+static ConVar* Cvar_dedi_sendPrintsBytesPerFrame;
+
+// lines that haven't been sent yet are dropped past this, so a log flood can't grow the queue forever
+constexpr size_t MAX_QUEUED_LOG_BYTES = 64 * 1024;
+// ClientPrintf formats into a fixed size buffer, keep each batched print comfortably under it
+constexpr size_t MAX_CLIENT_PRINT_LENGTH = 1000;
+
+enum class eSendPrintsToClient
+{
+	NONE = -1,
+	FIRST,
+	ALL
+};
+
+static eSendPrintsToClient GetSendPrintsToClient()
+{
+	static const ConVar* Cvar_dedi_sendPrintsToClient = g_pCVar->FindVar("dedi_sendPrintsToClient");
+	return static_cast<eSendPrintsToClient>(Cvar_dedi_sendPrintsToClient->GetInt());
+}
+
 void DedicatedServerLogToClientSink::custom_sink_it_(const custom_log_msg& msg)
 {
 	if (*g_pServerState == server_state_t::ss_dead)
 		return;
 
-	enum class eSendPrintsToClient
+	if (GetSendPrintsToClient() == eSendPrintsToClient::NONE)
+		return;
+
+	std::string sLogMessage = fmt::format("[DEDICATED SERVER] [{}] {}", level_names[msg.level], msg.payload);
+	if (m_iPendingBytes + sLogMessage.length() > MAX_QUEUED_LOG_BYTES)
 	{
-		NONE = -1,
-		FIRST,
-		ALL
-	};
+		m_iDroppedLines++;
+		return;
+	}
 
-	static const ConVar* Cvar_dedi_sendPrintsToClient = g_pCVar->FindVar("dedi_sendPrintsToClient");
-	eSendPrintsToClient eSendPrints = static_cast<eSendPrintsToClient>(Cvar_dedi_sendPrintsToClient->GetInt());
-	if (eSendPrints == eSendPrintsToClient::NONE)
+	m_iPendingBytes += sLogMessage.length();
+	m_PendingLines.push_back(std::move(sLogMessage));
+}
+
+void DedicatedServerLogToClientSink::RunFrame()
+{
+	// join as many lines as each client's budget allows this frame into as few prints as possible
+	std::vector<std::string> vPrints;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (*g_pServerState == server_state_t::ss_dead || GetSendPrintsToClient() == eSendPrintsToClient::NONE)
+		{
+			m_PendingLines.clear();
+			m_iPendingBytes = 0;
+			m_iDroppedLines = 0;
+			return;
+		}
+
+		if (m_iDroppedLines)
+		{
+			vPrints.push_back(fmt::format("[DEDICATED SERVER] {} log lines were dropped", m_iDroppedLines));
+			m_iDroppedLines = 0;
+		}
+
+		size_t iBudget = std::max(Cvar_dedi_sendPrintsBytesPerFrame->GetInt(), 0);
+		size_t iBatchBytes = 0;
+
+		// always send at least one line a frame, so a line bigger than the budget doesn't stall the queue
+		while (!m_PendingLines.empty() && (!iBatchBytes || iBatchBytes + m_PendingLines.front().length() <= iBudget))
+		{
+			std::string& sLine = m_PendingLines.front();
+			iBatchBytes += sLine.length();
+			m_iPendingBytes -= sLine.length();
+
+			if (!vPrints.empty() && vPrints.back().length() + 1 + sLine.length() <= MAX_CLIENT_PRINT_LENGTH)
+			{
+				vPrints.back() += '\n';
+				vPrints.back() += sLine;
+			}
+			else
+				vPrints.push_back(std::move(sLine));
+
+			m_PendingLines.pop_front();
+		}
+	}
+
+	if (vPrints.empty())
 		return;
 
-	std::string sLogMessage = fmt::format("[DEDICATED SERVER] [{}] {}", level_names[msg.level], msg.payload);
+	eSendPrintsToClient eSendPrints = GetSendPrintsToClient();
 	for (int i = 0; i < g_pGlobals->m_nMaxClients; i++)
 	{
 		CBaseClient* pClient = &g_pClientArray[i];
 
 		if (pClient->m_Signon >= eSignonState::CONNECTED)
 		{
-			CGameClient__ClientPrintf(pClient, sLogMessage.c_str());
+			for (const std::string& sPrint : vPrints)
+				CGameClient__ClientPrintf(pClient, "%s", sPrint.c_str());
 
 			if (eSendPrints == eSendPrintsToClient::FIRST)
 				break;
@@ -43,7 +114,13 @@ void DedicatedServerLogToClientSink::sink_it_(const spdlog::details::log_msg& ms
 
 void DedicatedServerLogToClientSink::flush_() {}
 
-ON_DLL_LOAD_DEDI("engine.dll", DedicatedServerLogToClient, (CModule module))
+ON_DLL_LOAD_DEDI_RELIESON("engine.dll", DedicatedServerLogToClient, ConVar, (CModule module))
 {
 	CGameClient__ClientPrintf = module.Offset(0x1016A0).RCast<void (*)(CBaseClient*, const char*, ...)>();
+
+	Cvar_dedi_sendPrintsBytesPerFrame = new ConVar(
+		"dedi_sendPrintsBytesPerFrame",
+		"4096",
+		FCVAR_GAMEDLL,
+		"Max bytes of server log sent to each client per frame when dedi_sendPrintsToClient is enabled, the rest is sent on later frames");
 }
@@ -2,10 +2,23 @@
 #include "logging/logging.h"
 #include "core/convar/convar.h"
 
+#include <deque>
+
 class DedicatedServerLogToClientSink : public CustomSink
 {
+public:
+	// lines are queued from whichever thread logged them, and sent in batches from the server frame
+	void RunFrame();
+
 protected:
 	void custom_sink_it_(const custom_log_msg& msg) override;
 	void sink_it_(const spdlog::details::log_msg& msg) override;
 	void flush_() override;
+
+private:
+	std::deque<std::string> m_PendingLines;
+	size_t m_iPendingBytes = 0;
+	size_t m_iDroppedLines = 0;
 };
+
+extern DedicatedServerLogToClientSink* g_pDedicatedServerLogToClient;
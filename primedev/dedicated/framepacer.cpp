@@ -0,0 +1,188 @@
+#include "dedicated/framepacer.h"
+
+#include <algorithm>
+#include <thread>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PACER_SPIN_PAUSE() _mm_pause()
+#else
+#define PACER_SPIN_PAUSE() std::this_thread::yield()
+#endif
+
+// the overshoot estimate moves a quarter of the way towards larger oversleeps, so one preempted wakeup doesn't blow it up,
+// and decays slowly otherwise so the spin window shrinks again once the os timer behaves
+constexpr double SLEEP_OVERSHOOT_RISE = 0.25;
+constexpr double SLEEP_OVERSHOOT_DECAY = 0.98;
+
+void CPacerHistogram::Setup(double flBucketWidth, size_t iBucketCount)
+{
+	m_flBucketWidth = flBucketWidth;
+	m_Buckets.assign(iBucketCount, 0);
+	Reset();
+}
+
+void CPacerHistogram::Reset()
+{
+	std::fill(m_Buckets.begin(), m_Buckets.end(), 0);
+	m_iOverflow = 0;
+	m_iCount = 0;
+	m_flSum = 0.0;
+	m_flMin = 0.0;
+	m_flMax = 0.0;
+}
+
+void CPacerHistogram::Add(double flValue)
+{
+	if (m_Buckets.empty())
+		return;
+
+	const size_t iBucket = flValue > 0.0 ? static_cast<size_t>(flValue / m_flBucketWidth) : 0;
+	if (iBucket < m_Buckets.size())
+		m_Buckets[iBucket]++;
+	else
+		m_iOverflow++;
+
+	m_flMin = m_iCount ? std::min(m_flMin, flValue) : flValue;
+	m_flMax = m_iCount ? std::max(m_flMax, flValue) : flValue;
+	m_flSum += flValue;
+	m_iCount++;
+}
+
+double CPacerHistogram::GetMean() const
+{
+	return m_iCount ? m_flSum / m_iCount : 0.0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Approximates a percentile as the upper edge of the bucket it falls in
+// Input  : flPercentile - percentile in the range 0-1
+//-----------------------------------------------------------------------------
+double CPacerHistogram::GetPercentile(double flPercentile) const
+{
+	if (!m_iCount)
+		return 0.0;
+
+	const uint64_t iTarget = std::max<uint64_t>(1, static_cast<uint64_t>(flPercentile * m_iCount + 0.5));
+	uint64_t iSeen = 0;
+	for (size_t i = 0; i < m_Buckets.size(); i++)
+	{
+		iSeen += m_Buckets[i];
+		if (iSeen >= iTarget)
+			return std::min((i + 1) * m_flBucketWidth, m_flMax);
+	}
+
+	return m_flMax;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Sets the target frame interval, in seconds
+//-----------------------------------------------------------------------------
+void CFramePacer::SetInterval(double flInterval)
+{
+	if (flInterval == m_flInterval)
+		return;
+
+	m_flInterval = flInterval;
+
+	// interval buckets cover up to 3 intervals at 1/16th of an interval each, overruns are tracked at 50us granularity up to 5ms
+	m_IntervalHistogram.Setup(flInterval / 16.0, 48);
+	m_OverrunHistogram.Setup(0.00005, 100);
+}
+
+double CFramePacer::GetInterval() const
+{
+	return m_flInterval;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Gets how long before a deadline we currently stop sleeping
+//          never more than half an interval, spinning whole frames away isn't worth it
+//-----------------------------------------------------------------------------
+double CFramePacer::GetSpinTime() const
+{
+	return std::min(std::max(m_flMinSpinTime, m_flSleepOvershoot), m_flInterval / 2.0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Restarts the schedule, the next WaitForNextFrame returns immediately
+//-----------------------------------------------------------------------------
+void CFramePacer::Reset()
+{
+	m_bStarted = false;
+}
+
+void CFramePacer::ResetStats()
+{
+	m_IntervalHistogram.Reset();
+	m_OverrunHistogram.Reset();
+	m_iResyncs = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Blocks until the next frame is due according to the schedule
+//-----------------------------------------------------------------------------
+void CFramePacer::WaitForNextFrame()
+{
+	Clock::time_point now = Clock::now();
+
+	if (!m_bStarted)
+	{
+		m_bStarted = true;
+		m_NextDeadline = now;
+		m_LastFrameStart = now;
+		return;
+	}
+
+	// deadlines are always relative to the previous deadline rather than the previous frame, so errors don't accumulate
+	const Clock::time_point deadline =
+		m_NextDeadline + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(m_flInterval));
+
+	const double flLateness = std::chrono::duration<double>(now - deadline).count();
+	const double flMaxLateness = m_eCatchup == eFramePacerCatchup::BOUNDED ? m_iMaxCatchupFrames * m_flInterval : 0.0;
+
+	if (flLateness > flMaxLateness)
+	{
+		// too far behind to catch up, start a fresh schedule from now
+		m_NextDeadline = now;
+		m_iResyncs++;
+	}
+	else
+	{
+		if (flLateness < 0.0)
+			SleepUntil(deadline);
+
+		m_NextDeadline = deadline;
+	}
+
+	const Clock::time_point frameStart = Clock::now();
+	m_OverrunHistogram.Add(std::max(0.0, std::chrono::duration<double>(frameStart - deadline).count()));
+	m_IntervalHistogram.Add(std::chrono::duration<double>(frameStart - m_LastFrameStart).count());
+	m_LastFrameStart = frameStart;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Sleeps until close to the deadline, then spins for the remainder
+//-----------------------------------------------------------------------------
+void CFramePacer::SleepUntil(Clock::time_point deadline)
+{
+	while (true)
+	{
+		const Clock::time_point now = Clock::now();
+		const double flRemaining = std::chrono::duration<double>(deadline - now).count();
+		const double flSleep = flRemaining - GetSpinTime();
+		if (flSleep <= 0.0)
+			break;
+
+		std::this_thread::sleep_for(std::chrono::duration<double>(flSleep));
+
+		const double flOvershoot = std::chrono::duration<double>(Clock::now() - now).count() - flSleep;
+		if (flOvershoot > m_flSleepOvershoot)
+			m_flSleepOvershoot += (flOvershoot - m_flSleepOvershoot) * SLEEP_OVERSHOOT_RISE;
+		else
+			m_flSleepOvershoot *= SLEEP_OVERSHOOT_DECAY;
+	}
+
+	while (Clock::now() < deadline)
+		PACER_SPIN_PAUSE();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// NOTE: nothing in here may depend on the engine or windows, so the pacer can be built and benchmarked standalone
+
+//-----------------------------------------------------------------------------
+// Purpose: Fixed width histogram of durations, in seconds
+//-----------------------------------------------------------------------------
+class CPacerHistogram
+{
+public:
+	double m_flBucketWidth = 0.0;
+	std::vector<uint64_t> m_Buckets;
+	uint64_t m_iOverflow = 0;
+
+	uint64_t m_iCount = 0;
+	double m_flSum = 0.0;
+	double m_flMin = 0.0;
+	double m_flMax = 0.0;
+
+public:
+	void Setup(double flBucketWidth, size_t iBucketCount);
+	void Reset();
+	void Add(double flValue);
+
+	double GetMean() const;
+	double GetPercentile(double flPercentile) const;
+};
+
+enum class eFramePacerCatchup
+{
+	// missed deadlines are dropped, the schedule restarts from the current time
+	RESYNC,
+	// frames run back to back until the schedule is met again, unless we're more than the max catchup behind
+	BOUNDED
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Paces frames to an absolute schedule by sleeping coarsely then spinning
+//-----------------------------------------------------------------------------
+class CFramePacer
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	eFramePacerCatchup m_eCatchup = eFramePacerCatchup::BOUNDED;
+	int m_iMaxCatchupFrames = 2;
+	// the minimum amount of time before a deadline we stop sleeping and spin instead
+	double m_flMinSpinTime = 0.001;
+
+	CPacerHistogram m_IntervalHistogram; // time between frame starts
+	CPacerHistogram m_OverrunHistogram; // how late frames started compared to their deadline
+	uint64_t m_iResyncs = 0;
+
+private:
+	double m_flInterval = 0.0;
+	Clock::time_point m_NextDeadline;
+	Clock::time_point m_LastFrameStart;
+	bool m_bStarted = false;
+
+	// largest recent oversleep, decays slowly so one bad wakeup doesn't make us spin forever
+	double m_flSleepOvershoot = 0.0;
+
+public:
+	void SetInterval(double flInterval);
+	double GetInterval() const;
+	double GetSpinTime() const;
+
+	void Reset();
+	void ResetStats();
+	void WaitForNextFrame();
+
+private:
+	void SleepUntil(Clock::time_point deadline);
+};
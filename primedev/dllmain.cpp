@@ -2,6 +2,7 @@
 #include "logging/crashhandler.h"
 #include "core/memalloc.h"
 #include "core/vanilla.h"
+#include "core/profiler.h"
 #include "config/profile.h"
 #include "plugins/plugins.h"
 #include "plugins/pluginmanager.h"
@@ -66,6 +67,9 @@ bool InitialiseNorthstar()
 	// Write launcher version to log
 	StartupLog();
 
+	// needs to exist before any hooks can run scoped timers
+	g_pProfiler = new CProfiler();
+
 	// Init minhook
 	HookSys_Init();
 
@@ -8,6 +8,7 @@
 #include "shared/exploit_fixes/ns_limits.h"
 #include "squirrel/squirrel.h"
 #include "plugins/pluginmanager.h"
+#include "dedicated/dedicatedlogtoclient.h"
 
 CHostState* g_pHostState;
 
@@ -126,6 +127,9 @@ static void __fastcall h_CHostState__State_GameShutdown(CHostState* self)
 
 	o_pCHostState__State_GameShutdown(self);
 
+	// overrides can be cleared during shutdown without going through anything we hook
+	g_PlaylistVarCache.Invalidate();
+
 	// run gamemode cleanup cfg now instead of when we start next map
 	if (sLastMode.length())
 	{
@@ -157,6 +161,16 @@ static void __fastcall h_CHostState__FrameUpdate(CHostState* self, double flCurr
 		g_pServerLimits->RunFrame(flCurrentTime, flFrameTime);
 	}
 
+	// upload and retry queued persistence writes
+	g_pMasterServerManager->RunFrame(flCurrentTime);
+
+	// time out auth data for players that never connected
+	g_pServerAuthentication->RunFrame();
+
+	// send batched log lines to clients, only exists on dedicated servers
+	if (g_pDedicatedServerLogToClient)
+		g_pDedicatedServerLogToClient->RunFrame();
+
 	// Run Squirrel message buffer
 	if (g_pSquirrel[ScriptContext::UI]->m_pSQVM != nullptr && g_pSquirrel[ScriptContext::UI]->m_pSQVM->sqvm != nullptr)
 		g_pSquirrel[ScriptContext::UI]->ProcessMessageBuffer();
@@ -2,15 +2,29 @@
 #include "server/r2server.h"
 #include "hoststate.h"
 #include "server/serverpresence.h"
+#include "core/profiler.h"
 
 static void(__fastcall* o_pCEngine__Frame)(CEngine* self) = nullptr;
 static void __fastcall h_CEngine__Frame(CEngine* self)
 {
-	o_pCEngine__Frame(self);
+	// by the first frame every dll we hook on startup has been loaded
+	static bool bPrintedStartupTimings = false;
+	if (!bPrintedStartupTimings)
+	{
+		PrintDllLoadCallbackTimings(10);
+		bPrintedStartupTimings = true;
+	}
+
+	{
+		NS_PROFILE_SCOPE("CEngine::Frame");
+		o_pCEngine__Frame(self);
+	}
+
+	g_pProfiler->RunFrame();
 }
 
 ON_DLL_LOAD("engine.dll", RunFrame, (CModule module))
 {
 	o_pCEngine__Frame = module.Offset(0x1C8650).RCast<decltype(o_pCEngine__Frame)>();
-	// HookAttach(&(PVOID&)o_pCEngine__Frame, (PVOID)h_CEngine__Frame);
+	HookAttach(&(PVOID&)o_pCEngine__Frame, (PVOID)h_CEngine__Frame);
 }
@@ -1,4 +1,6 @@
 #include "masterserver/masterserver.h"
+#include "masterserver/serverlistsnapshot.h"
+#include "config/profile.h"
 #include "core/convar/concommand.h"
 #include "shared/playlist.h"
 #include "server/auth/serverauthentication.h"
@@ -18,6 +20,7 @@
 #include "rapidjson/error/en.h"
 
 #include <cstring>
+#include <fstream>
 #include <regex>
 
 using namespace std::chrono_literals;
@@ -26,6 +29,7 @@ MasterServerManager* g_pMasterServerManager;
 
 ConVar* Cvar_ns_masterserver_hostname;
 ConVar* Cvar_ns_curl_log_enable;
+ConVar* Cvar_ns_server_presence_full_update_interval;
 
 RemoteServerInfo::RemoteServerInfo(
 	const char* newId,
@@ -74,6 +78,10 @@ void SetCommonHttpClientOptions(CURL* curl)
 
 void MasterServerManager::ClearServerList()
 {
+	// keep showing the snapshot until a fresh list replaces it, the next successful request drops anything that's gone
+	if (m_bServerListIsStale)
+		return;
+
 	// this doesn't really do anything lol, probably isn't threadsafe
 	m_bRequestingServerList = true;
 
@@ -82,6 +90,126 @@ void MasterServerManager::ClearServerList()
 	m_bRequestingServerList = false;
 }
 
+static std::string GetServerListSnapshotPath()
+{
+	return fmt::format("{}/runtime/serverlist.snapshot", GetNorthstarPrefix());
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Saves a server list to disk, taking the current time as when it was fetched
+// Output : true on success
+//-----------------------------------------------------------------------------
+static bool SaveServerListSnapshot(const std::vector<RemoteServerInfo>& vServers)
+{
+	const int64_t iTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	std::string sSnapshot;
+	WriteServerListSnapshot(vServers, iTime, sSnapshot);
+
+	std::error_code ec;
+	fs::path snapshotPath = GetServerListSnapshotPath();
+	fs::create_directories(snapshotPath.parent_path(), ec);
+
+	// write to a temp file first, so a crash mid-write can't leave a broken snapshot behind
+	fs::path tempPath = snapshotPath;
+	tempPath += ".tmp";
+	{
+		std::ofstream snapshotStream(tempPath, std::ios::binary | std::ios::trunc);
+		snapshotStream.write(sSnapshot.data(), sSnapshot.length());
+		if (!snapshotStream)
+		{
+			spdlog::error("failed to write server list snapshot to {}", tempPath.string());
+			return false;
+		}
+	}
+
+	fs::rename(tempPath, snapshotPath, ec);
+	if (ec)
+	{
+		spdlog::error("failed to write server list snapshot to {}: {}", snapshotPath.string(), ec.message());
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Loads the last saved server list, mapping the file rather than reading it
+// Input  : vServers - Replaced with the snapshot's servers
+//          iSavedTime - Set to the unix time the snapshot was taken
+// Output : true if there was a valid snapshot that isn't too old
+//-----------------------------------------------------------------------------
+static bool LoadServerListSnapshot(std::vector<RemoteServerInfo>& vServers, int64_t& iSavedTime)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	const std::string sPath = GetServerListSnapshotPath();
+
+	HANDLE hFile = CreateFileA(
+		sPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	HANDLE hMapping = nullptr;
+	const char* pData = nullptr;
+	ScopeGuard cleanup(
+		[&]
+		{
+			if (pData)
+				UnmapViewOfFile(pData);
+			if (hMapping)
+				CloseHandle(hMapping);
+			CloseHandle(hFile);
+		});
+
+	LARGE_INTEGER iFileSize;
+	if (!GetFileSizeEx(hFile, &iFileSize) || iFileSize.QuadPart <= 0 || (uint64_t)iFileSize.QuadPart > SERVER_LIST_SNAPSHOT_MAX_SIZE)
+	{
+		spdlog::warn("ignoring server list snapshot {} with a bad size", sPath);
+		return false;
+	}
+
+	hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (hMapping)
+		pData = (const char*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+
+	if (!pData)
+	{
+		spdlog::warn("failed to map server list snapshot {}", sPath);
+		return false;
+	}
+
+	std::string sError;
+	if (!ReadServerListSnapshot(pData, (size_t)iFileSize.QuadPart, vServers, iSavedTime, sError))
+	{
+		spdlog::warn("ignoring server list snapshot {}: {}", sPath, sError);
+		return false;
+	}
+
+	const int64_t iTime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	if (iTime - iSavedTime > SERVER_LIST_SNAPSHOT_MAX_AGE)
+	{
+		vServers.clear();
+		return false;
+	}
+
+	spdlog::info(
+		"loaded {} servers from server list snapshot in {:.2f}ms",
+		vServers.size(),
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+	return true;
+}
+
+void MasterServerManager::LoadServerListSnapshot()
+{
+	int64_t iSavedTime;
+	std::vector<RemoteServerInfo> vServers;
+	if (!::LoadServerListSnapshot(vServers, iSavedTime))
+		return;
+
+	m_vRemoteServers = std::move(vServers);
+	m_bServerListIsStale = true;
+}
+
 size_t CurlWriteToStringBufferCallback(char* contents, size_t size, size_t nmemb, void* userp)
 {
 	((std::string*)userp)->append((char*)contents, size * nmemb);
@@ -255,6 +383,10 @@ void MasterServerManager::RequestServerList()
 
 				spdlog::info("Got {} servers", serverArray.Size());
 
+				// servers from the snapshot that aren't in this list have gone away since
+				const bool bReplacingSnapshot = m_bServerListIsStale;
+				std::unordered_set<std::string> seenServerIds;
+
 				for (auto& serverObj : serverArray)
 				{
 					if (!serverObj.IsObject())
@@ -277,6 +409,8 @@ void MasterServerManager::RequestServerList()
 					};
 
 					const char* id = serverObj["id"].GetString();
+					if (bReplacingSnapshot)
+						seenServerIds.insert(id);
 
 					RemoteServerInfo* newServer = nullptr;
 
@@ -341,10 +475,20 @@ void MasterServerManager::RequestServerList()
 					//	serverObj["maxPlayers"].GetInt());
 				}
 
+				if (bReplacingSnapshot)
+				{
+					std::erase_if(
+						m_vRemoteServers, [&](const RemoteServerInfo& server) { return !seenServerIds.contains(server.id); });
+					m_bServerListIsStale = false;
+				}
+
 				std::sort(
 					m_vRemoteServers.begin(),
 					m_vRemoteServers.end(),
 					[](RemoteServerInfo& a, RemoteServerInfo& b) { return a.playerCount > b.playerCount; });
+
+				// we're already off the main thread, so save it for next time here
+				SaveServerListSnapshot(m_vRemoteServers);
 			}
 			else
 			{
@@ -558,14 +702,9 @@ void MasterServerManager::AuthenticateWithOwnServer(const char* uid, const char*
 					return;
 				}
 
-				RemoteAuthData newAuthData {};
-				strncpy_s(newAuthData.uid, sizeof(newAuthData.uid), authInfoJson["id"].GetString(), sizeof(newAuthData.uid) - 1);
-
-				newAuthData.pdataSize = authInfoJson["persistentData"].GetArray().Size();
-				newAuthData.pdata = new char[newAuthData.pdataSize];
-				// memcpy(newAuthData.pdata, authInfoJson["persistentData"].GetString(), newAuthData.pdataSize);
+				std::string pdata;
+				pdata.reserve(authInfoJson["persistentData"].GetArray().Size());
 
-				int i = 0;
 				// note: persistentData is a uint8array because i had problems getting strings to behave, it sucks but it's just how it be
 				// unfortunately potentially refactor later
 				for (auto& byte : authInfoJson["persistentData"].GetArray())
@@ -576,13 +715,15 @@ void MasterServerManager::AuthenticateWithOwnServer(const char* uid, const char*
 						return;
 					}
 
-					newAuthData.pdata[i++] = static_cast<char>(byte.GetUint());
+					pdata += static_cast<char>(byte.GetUint());
 				}
 
-				std::lock_guard<std::mutex> guard(g_pServerAuthentication->m_AuthDataMutex);
-				g_pServerAuthentication->m_RemoteAuthenticationData.clear();
-				g_pServerAuthentication->m_RemoteAuthenticationData.insert(
-					std::make_pair(authInfoJson["authToken"].GetString(), newAuthData));
+				if (!g_pServerAuthentication->SetOwnRemoteAuthData(
+						authInfoJson["authToken"].GetString(), authInfoJson["id"].GetString(), pdata))
+				{
+					spdlog::error("Failed reading masterserver authentication response: persistentData is too large");
+					return;
+				}
 
 				m_bSuccessfullyAuthenticatedWithGameServer = true;
 			}
@@ -738,60 +879,21 @@ void MasterServerManager::AuthenticateWithServer(const char* uid, const char* pl
 
 void MasterServerManager::WritePlayerPersistentData(const char* playerId, const char* pdata, size_t pdataSize)
 {
-	// still call this if we don't have a server id, since lobbies that aren't port forwarded need to be able to call it
-	m_bSavingPersistentData = true;
 	if (!pdataSize)
 	{
 		spdlog::warn("attempted to write pdata of size 0!");
 		return;
 	}
 
-	std::string strPlayerId(playerId);
-	std::string strPdata(pdata, pdataSize);
-
-	std::thread requestThread(
-		[this, strPlayerId, strPdata, pdataSize]
-		{
-			CURL* curl = curl_easy_init();
-			SetCommonHttpClientOptions(curl);
-
-			std::string readBuffer;
-			curl_easy_setopt(
-				curl,
-				CURLOPT_URL,
-				fmt::format(
-					"{}/accounts/write_persistence?id={}&serverId={}",
-					Cvar_ns_masterserver_hostname->GetString(),
-					strPlayerId,
-					m_sOwnServerId)
-					.c_str());
-			curl_easy_setopt(curl, CURLOPT_POST, 1L);
-			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWriteToStringBufferCallback);
-			curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
-
-			curl_mime* mime = curl_mime_init(curl);
-			curl_mimepart* part = curl_mime_addpart(mime);
-
-			curl_mime_data(part, strPdata.c_str(), pdataSize);
-			curl_mime_name(part, "pdata");
-			curl_mime_filename(part, "file.pdata");
-			curl_mime_type(part, "application/octet-stream");
-
-			curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
-
-			CURLcode result = curl_easy_perform(curl);
-
-			if (result == CURLcode::CURLE_OK)
-				m_bSuccessfullyConnected = true;
-			else
-				m_bSuccessfullyConnected = false;
-
-			curl_easy_cleanup(curl);
-
-			m_bSavingPersistentData = false;
-		});
+	// uploaded from RunFrame, any earlier write for this player that hasn't gone out yet is replaced
+	m_PersistenceWriteQueue.Enqueue(playerId, pdata, pdataSize);
+	m_bSavingPersistentData = true;
+}
 
-	requestThread.detach();
+void MasterServerManager::RunFrame(double flCurrentTime)
+{
+	m_PersistenceWriteQueue.RunFrame(flCurrentTime);
+	m_bSavingPersistentData = m_PersistenceWriteQueue.IsWriting();
 }
 
 void MasterServerManager::ProcessConnectionlessPacketSigreq1(std::string data)
@@ -909,14 +1011,29 @@ void MasterServerManager::ProcessConnectionlessPacketSigreq1(std::string data)
 			}
 		}
 
+		if (reject == "")
+		{
+			switch (g_pServerAuthentication->AddRemotePlayer(token, uid, username, pdata))
+			{
+			case RemoteAuthAddResult::Success:
+				break;
+
+			case RemoteAuthAddResult::PdataTooLarge:
+				reject = "Persistent data is too large.";
+				break;
+
+			// too much pdata held for connections that haven't finished joining yet
+			case RemoteAuthAddResult::TooMuchPendingPdata:
+				reject = "Server is busy, try again later.";
+				break;
+			}
+		}
+
 		if (reject == "")
 			spdlog::info("accepting connection {} (uid={} username={}) with {} bytes of pdata", token, uid, username, pdata.length());
 		else
 			spdlog::info("rejecting connection {} (uid={} username={}) with reason \"{}\"", token, uid, username, reject);
 
-		if (reject == "")
-			g_pServerAuthentication->AddRemotePlayer(token, uid, username, pdata);
-
 		{
 			CURL* curl = curl_easy_init();
 			SetCommonHttpClientOptions(curl);
@@ -1000,8 +1117,25 @@ ON_DLL_LOAD_RELIESON("engine.dll", MasterServer, (ConCommand, ServerPresence), (
 {
 	g_pMasterServerManager = new MasterServerManager;
 
+	// give the server browser something to show before the first request comes back
+	if (!IsDedicatedServer())
+		g_pMasterServerManager->LoadServerListSnapshot();
+
 	Cvar_ns_masterserver_hostname = new ConVar("ns_masterserver_hostname", "127.0.0.1", FCVAR_NONE, "");
 	Cvar_ns_curl_log_enable = new ConVar("ns_curl_log_enable", "0", FCVAR_NONE, "Whether curl should log to the console");
+	Cvar_ns_persistence_upload_encoding = new ConVar(
+		"ns_persistence_upload_encoding",
+		"0",
+		FCVAR_NONE,
+		"How pdata is uploaded to the masterserver, 0 = raw, 1 = lzss compressed, 2 = lzss compressed delta. only use 1 or 2 if the "
+		"masterserver supports them, it falls back to raw if it rejects them");
+
+	Cvar_ns_server_presence_full_update_interval = new ConVar(
+		"ns_server_presence_full_update_interval",
+		"60",
+		FCVAR_GAMEDLL,
+		"How often in seconds we send all of our server's info to the masterserver, rather than just what's changed, 0 to always send "
+		"everything");
 
 	RegisterConCommand("ns_fetchservers", ConCommand_ns_fetchservers, "Fetch all servers from the masterserver", FCVAR_CLIENTDLL);
 
@@ -1013,12 +1147,17 @@ void MasterServerPresenceReporter::CreatePresence(const ServerPresence* pServerP
 {
 	NOTE_UNUSED(pServerPresence);
 	m_nNumRegistrationAttempts = 0;
+
+	m_iPendingFields = PRESENCE_FIELD_ALL | PRESENCE_FIELD_MODINFO;
+	m_flNextFullUpdateTime = 0.0;
 }
 
 void MasterServerPresenceReporter::ReportPresence(const ServerPresence* pServerPresence)
 {
-	// make a copy of presence for multithreading purposes
-	ServerPresence threadedPresence(pServerPresence);
+	// keep track of what's changed even if we can't send it yet
+	m_iPendingFields |= pServerPresence->m_iDirtyFields;
+	if (g_pMasterServerManager->m_sOwnModInfoJson != m_sReportedModInfoJson)
+		m_iPendingFields |= PRESENCE_FIELD_MODINFO;
 
 	if (!*g_pMasterServerManager->m_sOwnServerId)
 	{
@@ -1159,6 +1298,10 @@ void MasterServerPresenceReporter::RunFrame(double flCurrentTime, const ServerPr
 		auto resultData = updateServerFuture.get();
 		if (resultData.result == MasterServerReportPresenceResult::Success)
 		{
+			// a new id means the masterserver re-registered us from this update, so make sure it gets everything next time
+			if (resultData.id && strcmp(resultData.id.value().c_str(), g_pMasterServerManager->m_sOwnServerId))
+				m_iPendingFields = PRESENCE_FIELD_ALL | PRESENCE_FIELD_MODINFO;
+
 			if (resultData.id)
 			{
 				strncpy_s(
@@ -1177,6 +1320,13 @@ void MasterServerPresenceReporter::RunFrame(double flCurrentTime, const ServerPr
 					sizeof(g_pMasterServerManager->m_sOwnServerAuthToken) - 1);
 			}
 		}
+		else
+		{
+			// send these again next time
+			m_iPendingFields |= m_iUpdatingFields;
+		}
+
+		m_iUpdatingFields = 0;
 	}
 }
 
@@ -1192,6 +1342,12 @@ void MasterServerPresenceReporter::InternalAddServer(const ServerPresence* pServ
 	std::string modInfo = g_pMasterServerManager->m_sOwnModInfoJson;
 	std::string hostname = Cvar_ns_masterserver_hostname->GetString();
 
+	// add_server sends everything but the player count, so that's all the first update needs
+	// if this fails, the next attempt sends everything again anyway
+	m_iPendingFields = PRESENCE_FIELD_PLAYER_COUNT;
+	m_sReportedModInfoJson = modInfo;
+	m_flNextFullUpdateTime = Plat_FloatTime() + Cvar_ns_server_presence_full_update_interval->GetFloat();
+
 	spdlog::info("Attempting to register the local server to the master server.");
 
 	addServerFuture = std::async(
@@ -1363,21 +1519,44 @@ void MasterServerPresenceReporter::InternalUpdateServer(const ServerPresence* pS
 	// Never call this with an ongoing InternalUpdateServer() call.
 	assert(!updateServerFuture.valid());
 
+	// every so often send everything, so the masterserver has all the info it needs to reregister our server if it goes down
+	const double flTime = Plat_FloatTime();
+	if (flTime >= m_flNextFullUpdateTime)
+	{
+		m_iPendingFields = PRESENCE_FIELD_ALL | PRESENCE_FIELD_MODINFO;
+		m_flNextFullUpdateTime = flTime + Cvar_ns_server_presence_full_update_interval->GetFloat();
+	}
+
+	// only send what's changed, if nothing has this is just a heartbeat
+	const uint32_t iFields = m_iPendingFields;
+	m_iUpdatingFields = iFields;
+	m_iPendingFields = 0;
+
 	const std::string serverId = g_pMasterServerManager->m_sOwnServerId;
 	const std::string hostname = Cvar_ns_masterserver_hostname->GetString();
-	const std::string modinfo = g_pMasterServerManager->m_sOwnModInfoJson;
+
+	std::string modinfo;
+	if (iFields & PRESENCE_FIELD_MODINFO)
+	{
+		modinfo = g_pMasterServerManager->m_sOwnModInfoJson;
+		m_sReportedModInfoJson = modinfo;
+	}
 
 	updateServerFuture = std::async(
 		std::launch::async,
-		[threadedPresence, serverId, hostname, modinfo]
+		[threadedPresence, iFields, serverId, hostname, modinfo]
 		{
 			CURL* curl = curl_easy_init();
 			SetCommonHttpClientOptions(curl);
 
+			curl_mime* mime = nullptr;
+
 			// Lambda to quickly cleanup resources and return a value.
-			auto ReturnCleanup = [curl](MasterServerReportPresenceResult result, const char* id = "", const char* serverAuthToken = "")
+			auto ReturnCleanup =
+				[curl, &mime](MasterServerReportPresenceResult result, const char* id = "", const char* serverAuthToken = "")
 			{
 				curl_easy_cleanup(curl);
+				curl_mime_free(mime);
 
 				MasterServerPresenceReporter::ReportPresenceResultData data;
 				data.result = result;
@@ -1401,50 +1580,55 @@ void MasterServerPresenceReporter::InternalUpdateServer(const ServerPresence* pS
 			curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
 			curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
 
-			// send all registration info so we have all necessary info to reregister our server if masterserver goes down,
-			// without a restart this isn't threadsafe :terror:
+			// only add the values that have changed, the masterserver keeps whatever it had for the rest
 			{
-				char* nameEscaped = curl_easy_escape(curl, threadedPresence.m_sServerName.c_str(), 0);
-				char* descEscaped = curl_easy_escape(curl, threadedPresence.m_sServerDesc.c_str(), 0);
-				char* mapEscaped = curl_easy_escape(curl, threadedPresence.m_MapName, 0);
-				char* playlistEscaped = curl_easy_escape(curl, threadedPresence.m_PlaylistName, 0);
-				char* passwordEscaped = curl_easy_escape(curl, threadedPresence.m_Password, 0);
-
-				curl_easy_setopt(
-					curl,
-					CURLOPT_URL,
-					fmt::format(
-						"{}/server/"
-						"update_values?id={}&port={}&authPort=udp&name={}&description={}&map={}&playlist={}&playerCount={}&"
-						"maxPlayers={}&password={}",
-						hostname.c_str(),
-						serverId.c_str(),
-						threadedPresence.m_iPort,
-						nameEscaped,
-						descEscaped,
-						mapEscaped,
-						playlistEscaped,
-						threadedPresence.m_iPlayerCount,
-						threadedPresence.m_iMaxPlayers,
-						passwordEscaped)
-						.c_str());
+				std::string url = fmt::format("{}/server/update_values?id={}", hostname.c_str(), serverId.c_str());
 
-				curl_free(nameEscaped);
-				curl_free(descEscaped);
-				curl_free(mapEscaped);
-				curl_free(playlistEscaped);
-				curl_free(passwordEscaped);
+				auto AppendEscaped = [curl, &url](const char* pName, const char* pValue)
+				{
+					char* valueEscaped = curl_easy_escape(curl, pValue, 0);
+					url += fmt::format("&{}={}", pName, valueEscaped);
+					curl_free(valueEscaped);
+				};
+
+				if (iFields & PRESENCE_FIELD_PORT)
+					url += fmt::format("&port={}&authPort=udp", threadedPresence.m_iPort);
+				if (iFields & PRESENCE_FIELD_NAME)
+					AppendEscaped("name", threadedPresence.m_sServerName.c_str());
+				if (iFields & PRESENCE_FIELD_DESC)
+					AppendEscaped("description", threadedPresence.m_sServerDesc.c_str());
+				if (iFields & PRESENCE_FIELD_MAP)
+					AppendEscaped("map", threadedPresence.m_MapName);
+				if (iFields & PRESENCE_FIELD_PLAYLIST)
+					AppendEscaped("playlist", threadedPresence.m_PlaylistName);
+				if (iFields & PRESENCE_FIELD_PLAYER_COUNT)
+					url += fmt::format("&playerCount={}", threadedPresence.m_iPlayerCount);
+				if (iFields & PRESENCE_FIELD_MAX_PLAYERS)
+					url += fmt::format("&maxPlayers={}", threadedPresence.m_iMaxPlayers);
+				if (iFields & PRESENCE_FIELD_PASSWORD)
+					AppendEscaped("password", threadedPresence.m_Password);
+
+				curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
 			}
 
-			curl_mime* mime = curl_mime_init(curl);
-			curl_mimepart* part = curl_mime_addpart(mime);
+			if (iFields & PRESENCE_FIELD_MODINFO)
+			{
+				mime = curl_mime_init(curl);
+				curl_mimepart* part = curl_mime_addpart(mime);
 
-			curl_mime_data(part, modinfo.c_str(), modinfo.size());
-			curl_mime_name(part, "modinfo");
-			curl_mime_filename(part, "modinfo.json");
-			curl_mime_type(part, "application/json");
+				curl_mime_data(part, modinfo.c_str(), modinfo.size());
+				curl_mime_name(part, "modinfo");
+				curl_mime_filename(part, "modinfo.json");
+				curl_mime_type(part, "application/json");
 
-			curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+				curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+			}
+			else
+			{
+				// empty body, rather than none at all
+				curl_easy_setopt(curl, CURLOPT_POSTFIELDS, "");
+				curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0L);
+			}
 
 			CURLcode result = curl_easy_perform(curl);
 
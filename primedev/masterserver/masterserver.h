@@ -2,7 +2,9 @@
 
 #include "core/convar/convar.h"
 #include "server/serverpresence.h"
+#include "masterserver/persistencequeue.h"
 #include <winsock2.h>
+#include <atomic>
 #include <string>
 #include <cstring>
 #include <future>
@@ -11,6 +13,9 @@
 extern ConVar* Cvar_ns_masterserver_hostname;
 extern ConVar* Cvar_ns_curl_log_enable;
 
+void SetCommonHttpClientOptions(CURL* curl);
+size_t CurlWriteToStringBufferCallback(char* contents, size_t size, size_t nmemb, void* userp);
+
 struct RemoteModInfo
 {
 public:
@@ -114,6 +119,9 @@ public:
 	RemoteServerConnectionInfo m_pendingConnectionInfo;
 
 	std::vector<RemoteServerInfo> m_vRemoteServers;
+	// whether m_vRemoteServers came from the snapshot saved last time, rather than the masterserver
+	// set on the main thread at startup, cleared by the request thread and read by scripts, so it needs to be atomic
+	std::atomic<bool> m_bServerListIsStale = false;
 
 	bool m_bHasMainMenuPromoData = false;
 	MainMenuPromoData m_sMainMenuPromoData;
@@ -123,16 +131,21 @@ public:
 
 	std::unordered_set<std::string> m_handledServerConnections;
 
+	PersistenceWriteQueue m_PersistenceWriteQueue;
+
 public:
 	MasterServerManager();
 
 	void ClearServerList();
 	void RequestServerList();
+	void LoadServerListSnapshot();
 	void RequestMainMenuPromos();
 	void AuthenticateOriginWithMasterServer(const char* uid, const char* originToken);
 	void AuthenticateWithOwnServer(const char* uid, const char* playerToken);
 	void AuthenticateWithServer(const char* uid, const char* playerToken, RemoteServerInfo server, const char* password);
 	void WritePlayerPersistentData(const char* playerId, const char* pdata, size_t pdataSize);
+	// uploads queued persistence writes and retries failed ones
+	void RunFrame(double flCurrentTime);
 	void ProcessConnectionlessPacketSigreq1(std::string req);
 };
 
@@ -168,6 +181,9 @@ public:
 
 	const int MAX_REGISTRATION_ATTEMPTS = 5;
 
+	// modinfo isn't part of ServerPresence, but we track whether it needs sending alongside its fields
+	static constexpr uint32_t PRESENCE_FIELD_MODINFO = 1u << 31;
+
 	// Called to initialise the master server presence reporter's state.
 	void CreatePresence(const ServerPresence* pServerPresence) override;
 
@@ -196,4 +212,13 @@ protected:
 	int m_nNumRegistrationAttempts;
 
 	double m_fNextAddServerAttemptTime;
+
+	// fields that have changed since they were last sent, updates only send these
+	uint32_t m_iPendingFields = PRESENCE_FIELD_ALL | PRESENCE_FIELD_MODINFO;
+	// fields sent by the running InternalUpdateServer() call, these become pending again if it fails
+	uint32_t m_iUpdatingFields = 0;
+	// the modinfo we last sent, so we can tell when mods have changed
+	std::string m_sReportedModInfoJson;
+	// every so often everything is sent regardless, in case the masterserver has lost track of us
+	double m_flNextFullUpdateTime = 0.0;
 };
@@ -0,0 +1,439 @@
+#include "masterserver/persistencequeue.h"
+#include "masterserver/masterserver.h"
+#include "config/profile.h"
+#include "engine/r2engine.h"
+#include "util/fnv1a.h"
+#include "util/lzss.h"
+
+#include <algorithm>
+#include <fstream>
+
+using namespace std::chrono_literals;
+
+ConVar* Cvar_ns_persistence_upload_encoding;
+
+// uids are only ever digits, anything else shouldn't end up in a file name
+static bool IsValidSpoolUid(const std::string& sUid)
+{
+	if (sUid.empty() || sUid.length() > 20)
+		return false;
+
+	for (char c : sUid)
+		if (c < '0' || c > '9')
+			return false;
+
+	return true;
+}
+
+static const char* GetEncodingName(PersistenceUploadEncoding encoding)
+{
+	switch (encoding)
+	{
+	case PersistenceUploadEncoding::LZSS:
+		return "lzss";
+	case PersistenceUploadEncoding::LZSS_DELTA:
+		return "lzss_delta";
+	default:
+		return "raw";
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Builds the body we actually upload, downgrading the encoding if it wouldn't help
+// Input  : &encoding - requested encoding, receives the one that was used
+//			&sPdata -
+//			&sBase - last acknowledged pdata, empty if we don't have one
+//-----------------------------------------------------------------------------
+static std::string EncodePdata(PersistenceUploadEncoding& encoding, const std::string& sPdata, const std::string& sBase)
+{
+	if (encoding == PersistenceUploadEncoding::RAW)
+		return sPdata;
+
+	// a delta only makes sense against a base of the same layout, pdef changes between versions can resize it
+	std::string sInput = sPdata;
+	if (encoding == PersistenceUploadEncoding::LZSS_DELTA)
+	{
+		if (sBase.length() == sPdata.length())
+		{
+			// unchanged bytes become runs of zeros, which lzss collapses into back references
+			for (size_t i = 0; i < sInput.length(); i++)
+				sInput[i] ^= sBase[i];
+		}
+		else
+			encoding = PersistenceUploadEncoding::LZSS;
+	}
+
+	std::string sCompressed(LZSS_GetMaxCompressedSize(sInput.length()), '\0');
+	size_t iCompressedSize = LZSS_Compress(
+		(const unsigned char*)sInput.data(), (unsigned int)sInput.length(), (unsigned char*)sCompressed.data(), sCompressed.length());
+
+	if (!iCompressedSize || iCompressedSize >= sPdata.length())
+	{
+		encoding = PersistenceUploadEncoding::RAW;
+		return sPdata;
+	}
+
+	sCompressed.resize(iCompressedSize);
+	return sCompressed;
+}
+
+void PersistenceWriteQueue::Enqueue(const char* pUid, const char* pPdata, size_t iPdataSize)
+{
+	PendingWrite_t& write = m_PendingWrites[pUid];
+	write.sPdata.assign(pPdata, iPdataSize);
+	write.iVersion++;
+	write.bFromSpool = false;
+
+	// the retry budget belongs to the pdata, newer pdata starts with a fresh one
+	write.iFailedAttempts = 0;
+
+	// newer pdata is worth trying straight away, even if the last attempt for this player failed
+	write.flNextAttemptTime = 0.0;
+}
+
+void PersistenceWriteQueue::SetDeltaBase(const char* pUid, const char* pPdata, size_t iPdataSize)
+{
+	if (Cvar_ns_persistence_upload_encoding->GetInt() != (int)PersistenceUploadEncoding::LZSS_DELTA || m_bEncodingRejected)
+		return;
+
+	if (m_DeltaBases.size() >= MAX_DELTA_BASES && !m_DeltaBases.contains(pUid))
+		m_DeltaBases.clear();
+
+	m_DeltaBases[pUid].assign(pPdata, iPdataSize);
+}
+
+bool PersistenceWriteQueue::IsWriting() const
+{
+	if (!m_InFlightUploads.empty())
+		return true;
+
+	for (const auto& [sUid, write] : m_PendingWrites)
+		if (!write.iFailedAttempts && !write.bFromSpool)
+			return true;
+
+	return false;
+}
+
+void PersistenceWriteQueue::RunFrame(double flCurrentTime)
+{
+	if (!m_bLoadedSpool)
+		LoadSpool(flCurrentTime);
+
+	// collect finished uploads
+	for (auto it = m_InFlightUploads.begin(); it != m_InFlightUploads.end();)
+	{
+		if (it->wait_for(0ms) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+
+		FinishUpload(it->get(), flCurrentTime);
+		it = m_InFlightUploads.erase(it);
+	}
+
+	// start new ones
+	for (auto& [sUid, write] : m_PendingWrites)
+	{
+		if (m_InFlightUploads.size() >= MAX_CONCURRENT_UPLOADS)
+			break;
+
+		if (!write.bInFlight && write.flNextAttemptTime <= flCurrentTime)
+			StartUpload(sUid, write);
+	}
+}
+
+void PersistenceWriteQueue::StartUpload(const std::string& sUid, PendingWrite_t& write)
+{
+	write.bInFlight = true;
+
+	PersistenceUploadEncoding encoding = (PersistenceUploadEncoding)std::clamp(
+		Cvar_ns_persistence_upload_encoding->GetInt(), (int)PersistenceUploadEncoding::RAW, (int)PersistenceUploadEncoding::LZSS_DELTA);
+	if (m_bEncodingRejected)
+		encoding = PersistenceUploadEncoding::RAW;
+
+	std::string sBase;
+	if (encoding == PersistenceUploadEncoding::LZSS_DELTA)
+	{
+		auto baseIt = m_DeltaBases.find(sUid);
+		if (baseIt != m_DeltaBases.end())
+			sBase = baseIt->second;
+	}
+
+	// still upload if we don't have a server id, since lobbies that aren't port forwarded need to be able to do this
+	std::string sUrl = fmt::format(
+		"{}/accounts/write_persistence?id={}&serverId={}",
+		Cvar_ns_masterserver_hostname->GetString(),
+		sUid,
+		g_pMasterServerManager->m_sOwnServerId);
+
+	m_InFlightUploads.push_back(std::async(
+		std::launch::async,
+		[sUid, sUrl, sBase, encoding, sPdata = write.sPdata, iVersion = write.iVersion]() mutable
+		{
+			UploadResult_t result {sUid, iVersion, encoding, UploadStatus::Retry, -1, 0, std::move(sPdata)};
+
+			std::string sBody = EncodePdata(result.encoding, result.sPdata, sBase);
+			result.iSentBytes = sBody.length();
+
+			if (result.encoding != PersistenceUploadEncoding::RAW)
+				sUrl += fmt::format("&encoding={}", GetEncodingName(result.encoding));
+			if (result.encoding == PersistenceUploadEncoding::LZSS_DELTA)
+				sUrl += fmt::format("&base={:016X}", FNV1a_64(sBase.data(), sBase.length()));
+
+			CURL* curl = curl_easy_init();
+			SetCommonHttpClientOptions(curl);
+
+			std::string readBuffer;
+			curl_easy_setopt(curl, CURLOPT_URL, sUrl.c_str());
+			curl_easy_setopt(curl, CURLOPT_POST, 1L);
+			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, CurlWriteToStringBufferCallback);
+			curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+
+			curl_mime* mime = curl_mime_init(curl);
+			curl_mimepart* part = curl_mime_addpart(mime);
+
+			curl_mime_data(part, sBody.data(), sBody.length());
+			curl_mime_name(part, "pdata");
+			curl_mime_filename(part, "file.pdata");
+			curl_mime_type(part, "application/octet-stream");
+
+			curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
+
+			CURLcode curlResult = curl_easy_perform(curl);
+			if (curlResult == CURLcode::CURLE_OK)
+			{
+				curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.iResponseStatus);
+
+				if (result.iResponseStatus >= 200 && result.iResponseStatus < 300)
+					result.status = UploadStatus::Success;
+				else if (result.iResponseStatus >= 400 && result.iResponseStatus < 500 && result.iResponseStatus != 408 &&
+						 result.iResponseStatus != 429)
+					result.status = UploadStatus::Rejected;
+			}
+			else
+				spdlog::warn("failed to write persistence for {}: {}", sUid, curl_easy_strerror(curlResult));
+
+			curl_mime_free(mime);
+			curl_easy_cleanup(curl);
+
+			return result;
+		}));
+}
+
+void PersistenceWriteQueue::FinishUpload(const UploadResult_t& result, double flCurrentTime)
+{
+	g_pMasterServerManager->m_bSuccessfullyConnected = result.iResponseStatus != -1;
+
+	auto it = m_PendingWrites.find(result.sUid);
+	if (it == m_PendingWrites.end())
+		return;
+
+	PendingWrite_t& write = it->second;
+	write.bInFlight = false;
+
+	const bool bSuperseded = write.iVersion != result.iVersion;
+
+	switch (result.status)
+	{
+	case UploadStatus::Success:
+	{
+		spdlog::info(
+			"wrote persistence for {} ({} bytes sent as {}, {} bytes of pdata)",
+			result.sUid,
+			result.iSentBytes,
+			GetEncodingName(result.encoding),
+			result.sPdata.length());
+
+		// this is what the master server has now, so it's what the next delta is made against
+		SetDeltaBase(result.sUid.c_str(), result.sPdata.data(), result.sPdata.length());
+
+		// the spool may hold an older version than what the master server has now, so it always goes
+		if (write.iSpooledVersion)
+			RemoveSpoolFile(result.sUid);
+
+		if (!bSuperseded)
+		{
+			m_PendingWrites.erase(it);
+			return;
+		}
+
+		write.iSpooledVersion = 0;
+		write.iFailedAttempts = 0;
+		return;
+	}
+
+	case UploadStatus::Rejected:
+	{
+		// an encoding the master server doesn't understand, or a delta against a base it doesn't have
+		// neither is the pdata's fault, so try again straight away without it
+		if (result.encoding == PersistenceUploadEncoding::LZSS_DELTA)
+		{
+			spdlog::warn(
+				"master server rejected persistence delta for {} (status {}), sending it whole", result.sUid, result.iResponseStatus);
+			m_DeltaBases.erase(result.sUid);
+			return;
+		}
+		else if (result.encoding != PersistenceUploadEncoding::RAW)
+		{
+			spdlog::warn(
+				"master server rejected compressed persistence (status {}), only sending raw pdata from now on", result.iResponseStatus);
+			m_bEncodingRejected = true;
+			m_DeltaBases.clear();
+			return;
+		}
+
+		spdlog::error("master server rejected persistence for {} (status {}), dropping it", result.sUid, result.iResponseStatus);
+
+		if (write.iSpooledVersion)
+			RemoveSpoolFile(result.sUid);
+
+		if (!bSuperseded)
+		{
+			m_PendingWrites.erase(it);
+			return;
+		}
+
+		write.iSpooledVersion = 0;
+		write.iFailedAttempts = 0;
+		return;
+	}
+
+	case UploadStatus::Retry:
+	{
+		// newer pdata came in while this was uploading, Enqueue already scheduled that one
+		if (bSuperseded)
+			return;
+
+		if (!write.iFailedAttempts++)
+			write.flFirstFailureTime = flCurrentTime;
+
+		if (write.iFailedAttempts >= MAX_FAILED_ATTEMPTS || flCurrentTime - write.flFirstFailureTime >= MAX_WRITE_AGE)
+		{
+			spdlog::error(
+				"giving up on writing persistence for {} after {} attempts over {:.0f}s, it may have been saved elsewhere since",
+				result.sUid,
+				write.iFailedAttempts,
+				flCurrentTime - write.flFirstFailureTime);
+
+			if (write.iSpooledVersion)
+				RemoveSpoolFile(result.sUid);
+
+			m_PendingWrites.erase(it);
+			return;
+		}
+
+		write.flNextAttemptTime =
+			flCurrentTime + std::min(MIN_RETRY_DELAY * (double)(1ull << std::min(write.iFailedAttempts - 1, 16)), MAX_RETRY_DELAY);
+
+		spdlog::warn(
+			"failed to write persistence for {} (status {}), retrying in {:.0f}s",
+			result.sUid,
+			result.iResponseStatus,
+			write.flNextAttemptTime - flCurrentTime);
+
+		// keep it on disk too, so it survives us closing before the master server comes back
+		if (write.iSpooledVersion != write.iVersion && IsValidSpoolUid(result.sUid))
+		{
+			WriteSpoolFile(result.sUid, write.sPdata);
+			write.iSpooledVersion = write.iVersion;
+		}
+
+		return;
+	}
+	}
+}
+
+std::string PersistenceWriteQueue::GetSpoolPath(const std::string& sUid)
+{
+	return fmt::format("{}/runtime/persistence/{}.pdata", GetNorthstarPrefix(), sUid);
+}
+
+void PersistenceWriteQueue::WriteSpoolFile(const std::string& sUid, const std::string& sPdata)
+{
+	std::error_code ec;
+	fs::path spoolPath = GetSpoolPath(sUid);
+	fs::create_directories(spoolPath.parent_path(), ec);
+
+	// write to a temp file first, so we never leave a truncated spool file behind
+	fs::path tempPath = spoolPath;
+	tempPath += ".tmp";
+	{
+		std::ofstream spoolStream(tempPath, std::ios::binary | std::ios::trunc);
+		spoolStream.write(sPdata.data(), sPdata.length());
+		if (!spoolStream)
+		{
+			spdlog::error("failed to spool persistence for {} to {}", sUid, tempPath.string());
+			return;
+		}
+	}
+
+	fs::rename(tempPath, spoolPath, ec);
+	if (ec)
+		spdlog::error("failed to spool persistence for {} to {}: {}", sUid, spoolPath.string(), ec.message());
+}
+
+void PersistenceWriteQueue::RemoveSpoolFile(const std::string& sUid)
+{
+	std::error_code ec;
+	fs::remove(GetSpoolPath(sUid), ec);
+}
+
+void PersistenceWriteQueue::LoadSpool(double flCurrentTime)
+{
+	m_bLoadedSpool = true;
+
+	std::error_code ec;
+	fs::path spoolDir = fs::path(GetSpoolPath("0")).parent_path();
+	if (!fs::is_directory(spoolDir, ec))
+		return;
+
+	int iLoaded = 0;
+	for (const fs::directory_entry& entry : fs::directory_iterator(spoolDir, ec))
+	{
+		if (!entry.is_regular_file(ec) || entry.path().extension() != ".pdata")
+			continue;
+
+		std::string sUid = entry.path().stem().string();
+		size_t iSize = (size_t)entry.file_size(ec);
+		if (!IsValidSpoolUid(sUid) || ec || !iSize || iSize > PERSISTENCE_MAX_SIZE)
+		{
+			spdlog::warn("ignoring invalid persistence spool file {}", entry.path().string());
+			continue;
+		}
+
+		// anything that's been written since we started is newer than what's on disk
+		if (m_PendingWrites.contains(sUid))
+			continue;
+
+		// the spool is written when a version first fails to upload, so its modification time is when its retries started
+		const fs::file_time_type writeTime = entry.last_write_time(ec);
+		const double flAge = std::chrono::duration<double>(fs::file_time_type::clock::now() - writeTime).count();
+		if (ec || flAge >= MAX_WRITE_AGE)
+		{
+			spdlog::warn("dropping persistence spooled for {} {:.0f}s ago, it's too old to be sure it's still the newest", sUid, flAge);
+			RemoveSpoolFile(sUid);
+			continue;
+		}
+
+		std::ifstream spoolStream(entry.path(), std::ios::binary);
+		std::string sPdata(iSize, '\0');
+		if (!spoolStream.read(sPdata.data(), iSize))
+			continue;
+
+		PendingWrite_t& write = m_PendingWrites[sUid];
+		write.sPdata = std::move(sPdata);
+		write.iVersion = 1;
+		write.iSpooledVersion = 1;
+		write.flNextAttemptTime = flCurrentTime;
+		write.bFromSpool = true;
+
+		// it already failed before we closed, so it only gets what's left of its time
+		write.iFailedAttempts = 1;
+		write.flFirstFailureTime = flCurrentTime - flAge;
+		iLoaded++;
+	}
+
+	if (iLoaded)
+		spdlog::info("retrying {} spooled persistence writes", iLoaded);
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "core/convar/convar.h"
+
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern ConVar* Cvar_ns_persistence_upload_encoding;
+
+// how pdata is sent to the master server, anything other than raw needs a master server that understands it
+enum class PersistenceUploadEncoding
+{
+	RAW = 0,
+	// lzss compressed, see util/lzss.h
+	LZSS = 1,
+	// lzss compressed xor against the last version the master server acknowledged, falls back to LZSS without one
+	LZSS_DELTA = 2,
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Write-back queue for player persistence uploads
+//          writes are coalesced per player, so only the newest pdata for each player is ever sent,
+//          and failed uploads are spooled to disk and retried with exponential backoff until they go through or get too old
+//          everything other than the uploads themselves happens on the main thread, in Enqueue and RunFrame
+//-----------------------------------------------------------------------------
+class PersistenceWriteQueue
+{
+public:
+	static constexpr size_t MAX_CONCURRENT_UPLOADS = 4;
+	static constexpr double MIN_RETRY_DELAY = 2.0;
+	static constexpr double MAX_RETRY_DELAY = 30.0;
+	// the player may have saved newer progress through another server since, and raw uploads just overwrite whatever the
+	// master server has, so pdata that couldn't be written within this long (or this many tries) is dropped rather than sent late
+	// spooled pdata is aged by its file's modification time, so this also covers writes left behind by an earlier session
+	static constexpr double MAX_WRITE_AGE = 120.0;
+	static constexpr int MAX_FAILED_ATTEMPTS = 6;
+	// delta bases are only kept for players we've seen recently, past this we just start over
+	static constexpr size_t MAX_DELTA_BASES = 128;
+
+private:
+	struct PendingWrite_t
+	{
+		std::string sPdata;
+		// bumped on every enqueue, so we know if newer pdata came in while an upload was running
+		uint64_t iVersion = 0;
+		int iFailedAttempts = 0;
+		// when the first attempt at this version failed, the write gets MAX_WRITE_AGE from then
+		double flFirstFailureTime = 0.0;
+		double flNextAttemptTime = 0.0;
+		// version currently on disk, 0 if it isn't spooled
+		uint64_t iSpooledVersion = 0;
+		bool bInFlight = false;
+		// loaded from the spool left by an earlier session, and nothing newer has been enqueued since
+		bool bFromSpool = false;
+	};
+
+	enum class UploadStatus
+	{
+		Success,
+		// network errors, timeouts and 5xx, worth trying again later
+		Retry,
+		// the master server didn't like what we sent, retrying the same thing won't help
+		Rejected,
+	};
+
+	struct UploadResult_t
+	{
+		std::string sUid;
+		uint64_t iVersion;
+		PersistenceUploadEncoding encoding;
+		UploadStatus status;
+		long iResponseStatus;
+		size_t iSentBytes;
+		std::string sPdata;
+	};
+
+	std::unordered_map<std::string, PendingWrite_t> m_PendingWrites;
+	std::unordered_map<std::string, std::string> m_DeltaBases;
+	std::vector<std::future<UploadResult_t>> m_InFlightUploads;
+
+	bool m_bLoadedSpool = false;
+	// set once the master server rejects an encoded upload, after which we only send raw pdata
+	bool m_bEncodingRejected = false;
+
+public:
+	void Enqueue(const char* pUid, const char* pPdata, size_t iPdataSize);
+	// the pdata the master server gave us for a player, used as the first delta base
+	void SetDeltaBase(const char* pUid, const char* pPdata, size_t iPdataSize);
+	void RunFrame(double flCurrentTime);
+
+	// whether there's anything that hasn't been attempted yet or is being uploaded right now
+	// writes reloaded from the spool only count while they're uploading, since nothing on this server is waiting on them
+	bool IsWriting() const;
+
+private:
+	void LoadSpool(double flCurrentTime);
+	void StartUpload(const std::string& sUid, PendingWrite_t& write);
+	void FinishUpload(const UploadResult_t& result, double flCurrentTime);
+
+	static std::string GetSpoolPath(const std::string& sUid);
+	static void WriteSpoolFile(const std::string& sUid, const std::string& sPdata);
+	static void RemoveSpoolFile(const std::string& sUid);
+};
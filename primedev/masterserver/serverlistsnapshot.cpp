@@ -0,0 +1,210 @@
+#include "masterserver/serverlistsnapshot.h"
+#include "masterserver/masterserver.h"
+#include "util/fnv1a.h"
+
+static void WriteSnapshotString(std::string& sBuffer, const char* pString, size_t iLength)
+{
+	// nothing in a server list gets anywhere near this long
+	const uint16_t iWrittenLength = (uint16_t)std::min<size_t>(iLength, UINT16_MAX);
+	sBuffer.append((const char*)&iWrittenLength, sizeof(iWrittenLength));
+	sBuffer.append(pString, iWrittenLength);
+}
+
+template <typename T> static void WriteSnapshotValue(std::string& sBuffer, const T& value)
+{
+	sBuffer.append((const char*)&value, sizeof(T));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Serializes a server list into a snapshot
+// Input  : vServers - Servers to save
+//          iSavedTime - Unix time the list was fetched at
+//          sBuffer - Replaced with the snapshot
+//-----------------------------------------------------------------------------
+void WriteServerListSnapshot(const std::vector<RemoteServerInfo>& vServers, int64_t iSavedTime, std::string& sBuffer)
+{
+	sBuffer.clear();
+	sBuffer.reserve(sizeof(ServerListSnapshotHeader_t) + vServers.size() * 256);
+	sBuffer.resize(sizeof(ServerListSnapshotHeader_t));
+
+	for (const RemoteServerInfo& server : vServers)
+	{
+		WriteSnapshotString(sBuffer, server.id, strnlen(server.id, sizeof(server.id)));
+		WriteSnapshotString(sBuffer, server.name, strnlen(server.name, sizeof(server.name)));
+		WriteSnapshotString(sBuffer, server.description.c_str(), server.description.length());
+		WriteSnapshotString(sBuffer, server.map, strnlen(server.map, sizeof(server.map)));
+		WriteSnapshotString(sBuffer, server.playlist, strnlen(server.playlist, sizeof(server.playlist)));
+		WriteSnapshotString(sBuffer, server.region, strnlen(server.region, sizeof(server.region)));
+
+		WriteSnapshotValue(sBuffer, (int32_t)server.playerCount);
+		WriteSnapshotValue(sBuffer, (int32_t)server.maxPlayers);
+		WriteSnapshotValue(sBuffer, (uint8_t)server.requiresPassword);
+
+		WriteSnapshotValue(sBuffer, (uint16_t)std::min<size_t>(server.requiredMods.size(), UINT16_MAX));
+		for (size_t i = 0; i < server.requiredMods.size() && i < UINT16_MAX; i++)
+		{
+			WriteSnapshotString(sBuffer, server.requiredMods[i].Name.c_str(), server.requiredMods[i].Name.length());
+			WriteSnapshotString(sBuffer, server.requiredMods[i].Version.c_str(), server.requiredMods[i].Version.length());
+		}
+	}
+
+	ServerListSnapshotHeader_t header;
+	header.iMagic = SERVER_LIST_SNAPSHOT_MAGIC;
+	header.iVersion = SERVER_LIST_SNAPSHOT_VERSION;
+	header.iSavedTime = iSavedTime;
+	header.iServerCount = (uint32_t)vServers.size();
+	header.iPayloadSize = (uint32_t)(sBuffer.size() - sizeof(header));
+	header.iChecksum = FNV1a_64(sBuffer.data() + sizeof(header), header.iPayloadSize);
+
+	memcpy(sBuffer.data(), &header, sizeof(header));
+}
+
+// reads values out of a snapshot's payload, failing rather than reading past the end of it
+class SnapshotReader
+{
+private:
+	const char* m_pData;
+	size_t m_iRemaining;
+
+public:
+	SnapshotReader(const char* pData, size_t iSize)
+		: m_pData(pData)
+		, m_iRemaining(iSize)
+	{
+	}
+
+	size_t Remaining() const { return m_iRemaining; }
+
+	template <typename T> bool Read(T& value)
+	{
+		if (m_iRemaining < sizeof(T))
+			return false;
+
+		memcpy(&value, m_pData, sizeof(T));
+		m_pData += sizeof(T);
+		m_iRemaining -= sizeof(T);
+		return true;
+	}
+
+	bool ReadString(std::string& sValue)
+	{
+		uint16_t iLength;
+		if (!Read(iLength) || m_iRemaining < iLength)
+			return false;
+
+		sValue.assign(m_pData, iLength);
+		m_pData += iLength;
+		m_iRemaining -= iLength;
+		return true;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Parses a snapshot, checking its version and checksum first
+// Input  : *pData, iSize - Whole snapshot
+//          vServers - Replaced with the snapshot's servers
+//          iSavedTime - Set to the unix time the snapshot was taken
+//          sError - Set to what was wrong with the snapshot on failure
+// Output : true if the whole snapshot was read
+//-----------------------------------------------------------------------------
+bool ReadServerListSnapshot(
+	const char* pData, size_t iSize, std::vector<RemoteServerInfo>& vServers, int64_t& iSavedTime, std::string& sError)
+{
+	vServers.clear();
+
+	ServerListSnapshotHeader_t header;
+	if (iSize < sizeof(header))
+	{
+		sError = "snapshot is too small";
+		return false;
+	}
+
+	memcpy(&header, pData, sizeof(header));
+	if (header.iMagic != SERVER_LIST_SNAPSHOT_MAGIC)
+	{
+		sError = "not a server list snapshot";
+		return false;
+	}
+
+	if (header.iVersion != SERVER_LIST_SNAPSHOT_VERSION)
+	{
+		sError = fmt::format("snapshot is version {}, expected {}", header.iVersion, SERVER_LIST_SNAPSHOT_VERSION);
+		return false;
+	}
+
+	const char* pPayload = pData + sizeof(header);
+	if (header.iPayloadSize != iSize - sizeof(header) || FNV1a_64(pPayload, header.iPayloadSize) != header.iChecksum)
+	{
+		sError = "snapshot is truncated or corrupt";
+		return false;
+	}
+
+	// every server takes up at least this much, so a bad count can't make us allocate loads
+	constexpr size_t MIN_SERVER_SIZE = sizeof(uint16_t) * 6 + sizeof(int32_t) * 2 + sizeof(uint8_t) + sizeof(uint16_t);
+	if (header.iServerCount > header.iPayloadSize / MIN_SERVER_SIZE)
+	{
+		sError = "snapshot has more servers than fit in it";
+		return false;
+	}
+
+	SnapshotReader reader(pPayload, header.iPayloadSize);
+	vServers.reserve(header.iServerCount);
+
+	std::string sId, sName, sDescription, sMap, sPlaylist, sRegion;
+	for (uint32_t i = 0; i < header.iServerCount; i++)
+	{
+		int32_t iPlayerCount;
+		int32_t iMaxPlayers;
+		uint8_t iRequiresPassword;
+		uint16_t iModCount;
+
+		if (!reader.ReadString(sId) || !reader.ReadString(sName) || !reader.ReadString(sDescription) || !reader.ReadString(sMap) ||
+			!reader.ReadString(sPlaylist) || !reader.ReadString(sRegion) || !reader.Read(iPlayerCount) || !reader.Read(iMaxPlayers) ||
+			!reader.Read(iRequiresPassword) || !reader.Read(iModCount))
+		{
+			sError = fmt::format("failed to read server {}", i);
+			vServers.clear();
+			return false;
+		}
+
+		RemoteServerInfo& server = vServers.emplace_back(
+			sId.c_str(),
+			sName.c_str(),
+			sDescription.c_str(),
+			sMap.c_str(),
+			sPlaylist.c_str(),
+			sRegion.c_str(),
+			iPlayerCount,
+			iMaxPlayers,
+			iRequiresPassword != 0);
+
+		// each mod is at least its two string lengths
+		if (iModCount > reader.Remaining() / (sizeof(uint16_t) * 2))
+		{
+			sError = fmt::format("server {} has more mods than fit in the snapshot", i);
+			vServers.clear();
+			return false;
+		}
+
+		server.requiredMods.resize(iModCount);
+		for (RemoteModInfo& mod : server.requiredMods)
+		{
+			if (!reader.ReadString(mod.Name) || !reader.ReadString(mod.Version))
+			{
+				sError = fmt::format("failed to read mods for server {}", i);
+				vServers.clear();
+				return false;
+			}
+		}
+	}
+
+	if (reader.Remaining())
+	{
+		sError = "unexpected data at the end of the snapshot";
+		vServers.clear();
+		return false;
+	}
+
+	iSavedTime = header.iSavedTime;
+	return true;
+}
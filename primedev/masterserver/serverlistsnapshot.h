@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RemoteServerInfo;
+
+// "NSSL"
+const uint32_t SERVER_LIST_SNAPSHOT_MAGIC = 0x4C53534E;
+// bump whenever the layout changes, snapshots from other versions are ignored
+const uint32_t SERVER_LIST_SNAPSHOT_VERSION = 1;
+// servers come and go, past this a snapshot isn't worth showing at all
+const int64_t SERVER_LIST_SNAPSHOT_MAX_AGE = 24 * 60 * 60;
+// way more than any real server list, anything bigger is garbage
+const size_t SERVER_LIST_SNAPSHOT_MAX_SIZE = 16 * 1024 * 1024;
+
+// everything after this is the payload, the checksum covers all of it
+#pragma pack(push, 1)
+struct ServerListSnapshotHeader_t
+{
+	uint32_t iMagic;
+	uint32_t iVersion;
+	// unix time the snapshot was taken
+	int64_t iSavedTime;
+	uint32_t iServerCount;
+	uint32_t iPayloadSize;
+	// fnv-1a
+	uint64_t iChecksum;
+};
+#pragma pack(pop)
+
+void WriteServerListSnapshot(const std::vector<RemoteServerInfo>& vServers, int64_t iSavedTime, std::string& sBuffer);
+bool ReadServerListSnapshot(
+	const char* pData, size_t iSize, std::vector<RemoteServerInfo>& vServers, int64_t& iSavedTime, std::string& sError);
@@ -1,51 +1,141 @@
 #include "mods/modmanager.h"
 #include "core/filesystem/filesystem.h"
+#include "shared/keyvaluestree.h"
+#include "util/fnv1a.h"
 
 #include <fstream>
 
-void ModManager::TryBuildKeyValues(const char* filename)
+constexpr const char* MOD_PATCH_KV_HEADER = "// AUTOGENERATED: MOD PATCH KV";
+
+// stable between runs so it can be compared against what we wrote to disk last time
+static uint64_t HashPatchInput(uint64_t iHash, const std::string& svData)
 {
-	spdlog::info("Building KeyValues for file {}", filename);
+	iHash = FNV1a_64(svData.data(), svData.length(), iHash);
 
-	std::string normalisedPath = g_pModManager->NormaliseModFilePath(fs::path(filename));
-	fs::path compiledPath = GetCompiledAssetsPath() / filename;
-	fs::path compiledDir = compiledPath.parent_path();
-	fs::create_directories(compiledDir);
+	// mix in the length too, so moving bytes between inputs changes the hash
+	const size_t iLength = svData.length();
+	return FNV1a_64(&iLength, sizeof(iLength), iHash);
+}
 
-	fs::path kvPath(filename);
+static void CopyKeyValuesNode(CKeyValuesTree& tree, KeyValuesNode_t* pParent, const KeyValuesNode_t* pNode)
+{
+	KeyValuesNode_t* pCopy = tree.AddKey(pParent, pNode->pszName);
+	if (pNode->pFirstChild)
+	{
+		for (const KeyValuesNode_t* pChild = pNode->pFirstChild; pChild; pChild = pChild->pNextPeer)
+			CopyKeyValuesNode(tree, pCopy, pChild);
+	}
+	else if (pNode->iDataType == TYPE_STRING)
+		tree.SetString(pCopy, nullptr, pNode->pszValue);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Merges pBase into pTarget the same way the engine merges #base files
+//          keys already in pTarget win, keys only in pBase get appended
+//-----------------------------------------------------------------------------
+static void MergeKeyValuesNode(CKeyValuesTree& tree, KeyValuesNode_t* pTarget, const KeyValuesNode_t* pBase)
+{
+	for (const KeyValuesNode_t* pBaseChild = pBase->pFirstChild; pBaseChild; pBaseChild = pBaseChild->pNextPeer)
+	{
+		KeyValuesNode_t* pTargetChild = tree.FindSubKey(pTarget, pBaseChild->pszName);
+		if (!pTargetChild)
+			CopyKeyValuesNode(tree, pTarget, pBaseChild);
+		else if (pTargetChild->pFirstChild || pTargetChild->iDataType == TYPE_NONE)
+			MergeKeyValuesNode(tree, pTargetChild, pBaseChild);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Merges the original file and all patches into one file
+// Input  : &svOriginalFile -
+//			&vPatches - patch file contents, highest priority first
+//			&svOut - receives the merged file, without a header
+// Output : false if any of the files use KeyValues features we can't merge ourselves
+//-----------------------------------------------------------------------------
+static bool MergePatchKeyValues(
+	const char* pszFilename, const std::string& svOriginalFile, const std::vector<std::string>& vPatches, std::string& svOut)
+{
+	CKeyValuesTree tree("");
+	std::vector<std::string> vBaseFiles;
+	std::string svError;
+
+	KeyValuesNode_t* pOriginal = tree.AddKey(tree.GetRoot(), "original");
+	if (!tree.ParseText(pOriginal, svOriginalFile.c_str(), svOriginalFile.length(), vBaseFiles, svError))
+	{
+		spdlog::warn("Couldn't parse {} for patching: {}", pszFilename, svError);
+		return false;
+	}
+
+	// the engine only reads the first root key, if there's more than one something's up so let the engine deal with it
+	if (pOriginal->iChildCount != 1)
+	{
+		spdlog::warn("Couldn't parse {} for patching: expected exactly one root key", pszFilename);
+		return false;
+	}
+
+	// #base files of the original file are kept as #bases, they only ever add keys that are missing so it doesn't matter
+	// that they're now applied after the patches rather than before
+	for (const std::string& svBaseFile : vBaseFiles)
+		svOut += fmt::format("#base \"{}\"\n", svBaseFile);
+
+	KeyValuesNode_t* pMerged = tree.AddKey(tree.GetRoot(), pOriginal->pFirstChild->pszName);
+	for (const std::string& svPatch : vPatches)
+	{
+		std::vector<std::string> vPatchBaseFiles;
+		KeyValuesNode_t* pPatch = tree.AddKey(tree.GetRoot(), "patch");
+		if (!tree.ParseText(pPatch, svPatch.c_str(), svPatch.length(), vPatchBaseFiles, svError) || !vPatchBaseFiles.empty())
+		{
+			spdlog::warn("Couldn't parse patch for {}: {}", pszFilename, vPatchBaseFiles.empty() ? svError : "#base is not supported");
+			return false;
+		}
+
+		// like #bases, the patch's root key name doesn't matter, just what's in it
+		for (KeyValuesNode_t* pRoot = pPatch->pFirstChild; pRoot; pRoot = pRoot->pNextPeer)
+			MergeKeyValuesNode(tree, pMerged, pRoot);
+	}
+
+	MergeKeyValuesNode(tree, pMerged, pOriginal->pFirstChild);
+
+	tree.WriteText(pMerged, svOut);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Builds a stub file that #bases all the patches and the original, and lets the engine merge them
+//          only used when we can't parse something ourselves
+//-----------------------------------------------------------------------------
+static void BuildBaseChainKeyValues(
+	const fs::path& compiledPath,
+	const fs::path& kvPath,
+	const std::string& svHeader,
+	const std::string& originalFile,
+	const std::vector<fs::path>& vPatchPaths)
+{
+	fs::path compiledDir = compiledPath.parent_path();
 	std::string ogFilePath = "mod_original_";
 	ogFilePath += kvPath.filename().string();
 
-	std::string newKvs = "// AUTOGENERATED: MOD PATCH KV\n";
-
-	int patchNum = 0;
+	std::string newKvs = svHeader;
 
 	// copy over patch kv files, and add #bases to new file, last mods' patches should be applied first
 	// note: #include should be identical but it's actually just broken, thanks respawn
-	for (int64_t i = m_LoadedMods.size() - 1; i > -1; i--)
+	int patchNum = 0;
+	for (const fs::path& patchPath : vPatchPaths)
 	{
-		if (!m_LoadedMods[i].m_bEnabled)
-			continue;
-
-		size_t fileHash = STR_HASH(normalisedPath);
-		auto modKv = m_LoadedMods[i].KeyValues.find(fileHash);
-		if (modKv != m_LoadedMods[i].KeyValues.end())
-		{
-			// should result in smth along the lines of #include "mod_patch_5_mp_weapon_car.txt"
+		// should result in smth along the lines of #include "mod_patch_5_mp_weapon_car.txt"
 
-			std::string patchFilePath = "mod_patch_";
-			patchFilePath += std::to_string(patchNum++);
-			patchFilePath += "_";
-			patchFilePath += kvPath.filename().string();
+		std::string patchFilePath = "mod_patch_";
+		patchFilePath += std::to_string(patchNum++);
+		patchFilePath += "_";
+		patchFilePath += kvPath.filename().string();
 
-			newKvs += "#base \"";
-			newKvs += patchFilePath;
-			newKvs += "\"\n";
+		newKvs += "#base \"";
+		newKvs += patchFilePath;
+		newKvs += "\"\n";
 
-			fs::remove(compiledDir / patchFilePath);
+		fs::remove(compiledDir / patchFilePath);
 
-			fs::copy_file(m_LoadedMods[i].m_ModDirectory / "keyvalues" / filename, compiledDir / patchFilePath);
-		}
+		fs::copy_file(patchPath, compiledDir / patchFilePath);
 	}
 
 	// add original #base last, #bases don't override preexisting keys, including the ones we've just done
@@ -53,15 +143,6 @@ void ModManager::TryBuildKeyValues(const char* filename)
 	newKvs += ogFilePath;
 	newKvs += "\"\n";
 
-	// load original file, so we can parse out the name of the root obj (e.g. WeaponData for weapons)
-	std::string originalFile = ReadVPKFile(filename, FileSourceType_ModOverride + FileSourceType_Original);
-
-	if (!originalFile.length())
-	{
-		spdlog::warn("Tried to patch kv {} but no base kv was found!", ogFilePath);
-		return;
-	}
-
 	char rootName[64];
 	memset(rootName, 0, sizeof(rootName));
 
@@ -77,7 +158,6 @@ void ModManager::TryBuildKeyValues(const char* filename)
 		i++;
 	}
 
-	int j = 0;
 	for (int j = 0; originalFile[i] >= 65 && originalFile[i] <= 122; j++)
 		rootName[j] = originalFile[i++];
 
@@ -92,6 +172,79 @@ void ModManager::TryBuildKeyValues(const char* filename)
 	std::ofstream writeStream(compiledPath, std::ios::binary);
 	writeStream << newKvs;
 	writeStream.close();
+}
+
+void ModManager::TryBuildKeyValues(const char* filename)
+{
+	std::string normalisedPath = g_pModManager->NormaliseModFilePath(fs::path(filename));
+	fs::path compiledPath = GetCompiledAssetsPath() / filename;
+	fs::path compiledDir = compiledPath.parent_path();
+	fs::create_directories(compiledDir);
+
+	fs::path kvPath(filename);
+
+	// load original file, so we can merge our patches into it
+	std::string originalFile = ReadVPKFile(filename, FileSourceType_ModOverride + FileSourceType_Original);
+
+	if (!originalFile.length())
+	{
+		spdlog::warn("Tried to patch kv {} but no base kv was found!", filename);
+		return;
+	}
+
+	// gather patch kv files, last mods' patches should be applied first
+	std::vector<fs::path> vPatchPaths;
+	std::vector<std::string> vPatches;
+	uint64_t iInputHash = HashPatchInput(FNV1A_64_OFFSET_BASIS, normalisedPath);
+	iInputHash = HashPatchInput(iInputHash, originalFile);
+
+	size_t fileHash = STR_HASH(normalisedPath);
+	for (int64_t i = m_LoadedMods.size() - 1; i > -1; i--)
+	{
+		if (!m_LoadedMods[i].m_bEnabled)
+			continue;
+
+		auto modKv = m_LoadedMods[i].KeyValues.find(fileHash);
+		if (modKv != m_LoadedMods[i].KeyValues.end())
+		{
+			fs::path patchPath = m_LoadedMods[i].m_ModDirectory / "keyvalues" / filename;
+
+			std::ifstream patchStream(patchPath, std::ios::binary);
+			std::stringstream patchStringStream;
+			patchStringStream << patchStream.rdbuf();
+
+			vPatchPaths.push_back(patchPath);
+			vPatches.push_back(patchStringStream.str());
+			iInputHash = HashPatchInput(iInputHash, vPatches.back());
+		}
+	}
+
+	// if nothing's changed since we last built this file, there's no need to do it again
+	const std::string svHeader = fmt::format("{} {:016X}\n", MOD_PATCH_KV_HEADER, iInputHash);
+	{
+		std::ifstream compiledStream(compiledPath, std::ios::binary);
+		std::string svExistingHeader;
+		if (compiledStream && std::getline(compiledStream, svExistingHeader) && svExistingHeader + "\n" == svHeader)
+		{
+			m_CompiledFiles.insert(normalisedPath);
+			return;
+		}
+	}
+
+	spdlog::info("Building KeyValues for file {}", filename);
+
+	std::string svMerged;
+	if (MergePatchKeyValues(filename, originalFile, vPatches, svMerged))
+	{
+		std::ofstream writeStream(compiledPath, std::ios::binary);
+		writeStream << svHeader << svMerged;
+		writeStream.close();
+	}
+	else
+	{
+		spdlog::warn("Falling back to #base patching for {}", filename);
+		BuildBaseChainKeyValues(compiledPath, kvPath, svHeader, originalFile, vPatchPaths);
+	}
 
 	m_CompiledFiles.insert(normalisedPath);
 }
@@ -68,6 +68,9 @@ public:
 	bool m_preload = false;
 	// Postload, this rpak depends on an rpak with this hash
 	size_t m_dependentPakHash;
+
+	// paths of the starpaks this rpak references, relative to the game directory
+	std::vector<std::string> m_starpakPaths;
 };
 
 class Mod
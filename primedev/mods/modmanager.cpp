@@ -6,6 +6,7 @@
 #include "core/filesystem/filesystem.h"
 #include "core/filesystem/rpakfilesystem.h"
 #include "config/profile.h"
+#include "util/printmaps.h"
 
 #include "rapidjson/error/en.h"
 #include "rapidjson/document.h"
@@ -318,6 +319,7 @@ void ModManager::LoadMods()
 						if (!str.empty())
 						{
 							mod.StarpakPaths.push_back(STR_HASH(str));
+							modPak.m_starpakPaths.push_back((mod.m_ModDirectory / "paks" / str).string());
 							spdlog::info("Mod {} registered starpak '{}'", mod.Name, str);
 							str = "";
 						}
@@ -397,12 +399,14 @@ void ModManager::LoadMods()
 					modFile.m_pOwningMod = &mod;
 					modFile.m_Path = path;
 					m_ModFiles.insert_or_assign(path, modFile);
+					g_MapCatalogue.AddModFile(modFile);
 				}
 			}
 		}
 	}
 
-	// build modinfo obj for masterserver
+	// build lookups and modinfo obj for masterserver
+	m_Registry.Build(m_LoadedMods);
 	BuildModInfo();
 
 	m_bHasLoadedMods = true;
@@ -411,6 +415,7 @@ void ModManager::LoadMods()
 void ModManager::UnloadMods()
 {
 	// clean up stuff from mods before we unload
+	m_Registry.Clear();
 	m_DependencyConstants.clear();
 
 	m_ModFiles.clear();
@@ -418,6 +423,7 @@ void ModManager::UnloadMods()
 	fs::remove_all(GetCompiledAssetsPath());
 
 	g_CustomAudioManager.ClearAudioOverrides();
+	g_MapCatalogue.ClearModMaps();
 	if (g_pPakLoadManager != nullptr)
 		g_pPakLoadManager->UnloadAllModPaks();
 
@@ -792,11 +798,9 @@ void ModManager::BuildModInfo()
 	modinfoDoc.AddMember("Mods", rapidjson::kArrayType, alloc);
 
 	int currentModIndex = 0;
-	for (Mod& mod : m_LoadedMods)
+	for (Mod* pMod : m_Registry.enabledMods)
 	{
-		if (!mod.m_bEnabled)
-			continue;
-
+		Mod& mod = *pMod;
 		modinfoDoc["Mods"].PushBack(rapidjson::kObjectType, modinfoDoc.GetAllocator());
 		modinfoDoc["Mods"][currentModIndex].AddMember("Name", rapidjson::StringRef(&mod.Name[0]), modinfoDoc.GetAllocator());
 		modinfoDoc["Mods"][currentModIndex].AddMember("Version", rapidjson::StringRef(&mod.Version[0]), modinfoDoc.GetAllocator());
@@ -10,6 +10,7 @@
 #include <unordered_set>
 #include <regex>
 #include "mod.h"
+#include "mods/modregistry.h"
 
 namespace fs = std::filesystem;
 
@@ -48,6 +49,7 @@ public:
 	std::unordered_set<std::string> m_CompiledFiles;
 	std::unordered_map<std::string, std::string> m_DependencyConstants;
 	std::unordered_set<std::string> m_PluginDependencyConstants;
+	ModRegistry_t m_Registry;
 
 private:
 	/**
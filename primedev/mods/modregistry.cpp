@@ -0,0 +1,23 @@
+#include "mods/modregistry.h"
+#include "mods/modmanager.h"
+
+//-----------------------------------------------------------------------------
+// Purpose: Rebuilds the lookups from the mods that are currently enabled
+// Input  : vMods - Loaded mods, in load order
+//-----------------------------------------------------------------------------
+void ModRegistry_t::Build(std::vector<Mod>& vMods)
+{
+	Clear();
+
+	for (Mod& mod : vMods)
+	{
+		if (!mod.m_bEnabled)
+			continue;
+
+		enabledMods.push_back(&mod);
+		modsByName.insert_or_assign(mod.Name, &mod);
+
+		for (const std::string& video : mod.BinkVideos)
+			binkVideos.insert_or_assign(video, &mod);
+	}
+}
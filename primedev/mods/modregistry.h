@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Mod;
+
+// lookups over enabled mods, so hooks don't have to walk every loaded mod each call
+// built on load and rebuilt whenever a mod is enabled or disabled, so it always matches each mod's m_bEnabled
+// points into ModManager::m_LoadedMods, so it's only valid until mods are next unloaded
+struct ModRegistry_t
+{
+	// in load order
+	std::vector<Mod*> enabledMods;
+	std::unordered_map<std::string, Mod*> modsByName;
+	// bink filename => mod overriding it, mods loaded later take priority like any other file
+	std::unordered_map<std::string, Mod*> binkVideos;
+
+	void Build(std::vector<Mod>& vMods);
+
+	void Clear()
+	{
+		enabledMods.clear();
+		modsByName.clear();
+		binkVideos.clear();
+	}
+};
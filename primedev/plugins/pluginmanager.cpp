@@ -5,6 +5,7 @@
 #include "plugins.h"
 #include "config/profile.h"
 #include "core/convar/concommand.h"
+#include "core/profiler.h"
 
 namespace fs = std::filesystem;
 
@@ -186,8 +187,11 @@ void PluginManager::InformDllLoad(HMODULE module, fs::path path) const
 
 void PluginManager::RunFrame() const
 {
+	NS_PROFILE_SCOPE("PluginManager::RunFrame");
+
 	for (const Plugin& plugin : GetLoadedPlugins())
 	{
+		NS_PROFILE_SCOPE_DYNAMIC(plugin.GetName());
 		plugin.RunFrame();
 	}
 }
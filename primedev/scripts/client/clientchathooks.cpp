@@ -26,7 +26,7 @@ static void __fastcall h_CHudChat__AddGameLine(void* self, const char* message,
 		payload = message + 1;
 	}
 
-	RemoveAsciiControlSequences(const_cast<char*>(message), true);
+	RemoveAsciiControlSequences(const_cast<char*>(message), strlen(message), true);
 
 	SQRESULT result = g_pSquirrel[ScriptContext::CLIENT]->Call(
 		"CHudChat_ProcessMessageStartThread", static_cast<int>(senderId) - 1, payload, isTeam, isDead, type);
@@ -109,6 +109,9 @@ ADD_SQFUNC(
 		if (!mod.Name.compare(modName) && !mod.Version.compare(modVersion))
 		{
 			mod.m_bEnabled = enabled;
+
+			// bink overrides and dependency constants follow the toggle straight away, other files wait for a reload
+			g_pModManager->m_Registry.Build(g_pModManager->m_LoadedMods);
 			return SQRESULT_NULL;
 		}
 	}
@@ -25,6 +25,12 @@ ADD_SQFUNC("bool", NSMasterServerConnectionSuccessful, "", "", ScriptContext::UI
 	return SQRESULT_NOTNULL;
 }
 
+ADD_SQFUNC("bool", NSIsServerListStale, "", "Whether the server list is from last time and hasn't been refreshed yet", ScriptContext::UI)
+{
+	g_pSquirrel[context]->pushbool(sqvm, g_pMasterServerManager->m_bServerListIsStale);
+	return SQRESULT_NOTNULL;
+}
+
 ADD_SQFUNC("int", NSGetServerCount, "", "", ScriptContext::UI)
 {
 	g_pSquirrel[context]->pushinteger(sqvm, (SQInteger)g_pMasterServerManager->m_vRemoteServers.size());
@@ -128,8 +134,9 @@ ADD_SQFUNC("void", NSCompleteAuthWithLocalServer, "", "", ScriptContext::UI)
 	NOTE_UNUSED(sqvm);
 	// literally just set serverfilter
 	// note: this assumes we have no authdata other than our own
-	if (g_pServerAuthentication->m_RemoteAuthenticationData.size())
-		g_pCVar->FindVar("serverfilter")->SetValue(g_pServerAuthentication->m_RemoteAuthenticationData.begin()->first.c_str());
+	std::string sAuthToken = g_pServerAuthentication->GetAnyRemoteAuthToken();
+	if (!sAuthToken.empty())
+		g_pCVar->FindVar("serverfilter")->SetValue(sAuthToken.c_str());
 
 	return SQRESULT_NULL;
 }
@@ -2,9 +2,16 @@
 #include "util/version.h"
 #include "squirrel/squirrel.h"
 #include "core/tier0.h"
+#include "core/convar/concommand.h"
+
+#include <chrono>
 
 HttpRequestHandler* g_httpRequestHandler;
 
+ConVar* Cvar_ns_http_max_concurrent_requests;
+ConVar* Cvar_ns_http_max_requests_per_second;
+ConVar* Cvar_ns_http_max_response_size;
+
 bool IsHttpDisabled()
 {
 	const static bool bIsHttpDisabled = CommandLine()->FindParm("-disablehttprequests");
@@ -23,6 +30,11 @@ bool DisableHttpSsl()
 	return bDisableHttpSsl;
 }
 
+static double GetHttpRequestTime()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 HttpRequestHandler::HttpRequestHandler()
 {
 	// Cache the launch parameters as early as possible in order to avoid possible exploits that change them at runtime.
@@ -39,7 +51,19 @@ void HttpRequestHandler::StartHttpRequestHandler()
 		return;
 	}
 
+	m_pMulti = curl_multi_init();
+	if (!m_pMulti)
+	{
+		spdlog::error("HttpRequestHandler failed to init libcurl, http requests will not work.");
+		return;
+	}
+
+	// Keep connections around for the next request, but don't open too many to the same host at once.
+	curl_multi_setopt(m_pMulti, CURLMOPT_MAXCONNECTS, (long)MAX_ACTIVE_REQUESTS);
+	curl_multi_setopt(m_pMulti, CURLMOPT_MAX_HOST_CONNECTIONS, 6L);
+
 	m_bIsHttpRequestHandlerRunning = true;
+	m_RequestThread = std::thread(&HttpRequestHandler::RunRequestThread, this);
 	spdlog::info("HttpRequestHandler started.");
 }
 
@@ -52,10 +76,19 @@ void HttpRequestHandler::StopHttpRequestHandler()
 	}
 
 	m_bIsHttpRequestHandlerRunning = false;
+	curl_multi_wakeup(m_pMulti);
+
+	if (m_RequestThread.joinable())
+		m_RequestThread.join();
+
+	curl_multi_cleanup(m_pMulti);
+	m_pMulti = nullptr;
+
 	spdlog::info("HttpRequestHandler stopped.");
 }
 
-bool IsHttpDestinationHostAllowed(const std::string& host, std::string& outHostname, std::string& outAddress, std::string& outPort)
+// Pulls the hostname and port out of a request url, this doesn't resolve anything.
+bool ParseHttpDestination(const std::string& host, std::string& outHostname, std::string& outPort)
 {
 	CURLU* url = curl_url();
 	if (!url)
@@ -81,16 +114,6 @@ bool IsHttpDestinationHostAllowed(const std::string& host, std::string& outHostn
 		return false;
 	}
 
-	char* urlScheme = nullptr;
-	if (curl_url_get(url, CURLUPART_SCHEME, &urlScheme, CURLU_DEFAULT_SCHEME) != CURLUE_OK)
-	{
-		spdlog::error("Failed to parse scheme from destination URL for http request.");
-
-		curl_url_cleanup(url);
-		curl_free(urlHostname);
-		return false;
-	}
-
 	char* urlPort = nullptr;
 	if (curl_url_get(url, CURLUPART_PORT, &urlPort, CURLU_DEFAULT_PORT) != CURLUE_OK)
 	{
@@ -98,25 +121,60 @@ bool IsHttpDestinationHostAllowed(const std::string& host, std::string& outHostn
 
 		curl_url_cleanup(url);
 		curl_free(urlHostname);
-		curl_free(urlScheme);
 		return false;
 	}
 
+	outHostname = urlHostname;
+	outPort = urlPort;
+
+	curl_free(urlHostname);
+	curl_free(urlPort);
+	curl_url_cleanup(url);
+
+	return true;
+}
+
+bool IsPrivateIPv4Address(const sockaddr_in* sockaddr_ipv4)
+{
+	// Fast checks for private ranges of IPv4.
+	// clang-format off
+	auto addrBytes = sockaddr_ipv4->sin_addr.S_un.S_un_b;
+
+	return addrBytes.s_b1 == 10														// 10.0.0.0			- 10.255.255.255		(Class A Private)
+		|| addrBytes.s_b1 == 172 && addrBytes.s_b2 >= 16 && addrBytes.s_b2 <= 31	// 172.16.0.0		- 172.31.255.255		(Class B Private)
+		|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 168							// 192.168.0.0		- 192.168.255.255		(Class C Private)
+		|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 0 && addrBytes.s_b3 == 0		// 192.0.0.0		- 192.0.0.255			(IETF Assignment)
+		|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 0 && addrBytes.s_b3 == 2		// 192.0.2.0		- 192.0.2.255			(TEST-NET-1)
+		|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 88 && addrBytes.s_b3 == 99	// 192.88.99.0		- 192.88.99.255			(IPv4-IPv6 Relay)
+		|| addrBytes.s_b1 == 192 && addrBytes.s_b2 >= 18 &&	addrBytes.s_b2 <= 19	// 192.18.0.0		- 192.19.255.255		(Internet Benchmark)
+		|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 51 && addrBytes.s_b3 == 100	// 192.51.100.0		- 192.51.100.255		(TEST-NET-2)
+		|| addrBytes.s_b1 == 203 && addrBytes.s_b2 == 0 && addrBytes.s_b3 == 113	// 203.0.113.0		- 203.0.113.255			(TEST-NET-3)
+		|| addrBytes.s_b1 == 169 && addrBytes.s_b2 == 254							// 169.254.00		- 169.254.255.255		(Link-local/APIPA)
+		|| addrBytes.s_b1 == 127													// 127.0.0.0		- 127.255.255.255		(Loopback)
+		|| addrBytes.s_b1 == 0														// 0.0.0.0			- 0.255.255.255			(Current network)
+		|| addrBytes.s_b1 == 100 && addrBytes.s_b2 >= 64 && addrBytes.s_b2 <= 127	// 100.64.0.0		- 100.127.255.255		(Shared address space)
+		|| sockaddr_ipv4->sin_addr.S_un.S_addr == 0xFFFFFFFF						// 255.255.255.255							(Broadcast)
+		|| addrBytes.s_b1 >= 224 && addrBytes.s_b2 <= 239							// 224.0.0.0		- 239.255.255.255		(Multicast)
+		|| addrBytes.s_b1 == 233 && addrBytes.s_b2 == 252 && addrBytes.s_b3 == 0	// 233.252.0.0		- 233.252.0.255			(MCAST-TEST-NET)
+		|| addrBytes.s_b1 >= 240 && addrBytes.s_b4 <= 254;							// 240.0.0.0		- 255.255.255.254		(Future Use Class E)
+	// clang-format on
+}
+
+// Resolves a hostname and decides whether requests may be made to it. This blocks, so it's run off the request thread.
+HttpDestinationCache::Destination_t ResolveHttpDestination(const std::string& hostname)
+{
+	HttpDestinationCache::Destination_t destination;
+
 	// Resolve the hostname into an address.
 	addrinfo* result;
 	addrinfo hints;
 	std::memset(&hints, 0, sizeof(addrinfo));
 	hints.ai_family = AF_UNSPEC;
 
-	if (getaddrinfo(urlHostname, urlScheme, &hints, &result) != 0)
+	if (getaddrinfo(hostname.c_str(), nullptr, &hints, &result) != 0)
 	{
-		spdlog::error("Failed to resolve http request destination {} using getaddrinfo().", urlHostname);
-
-		curl_url_cleanup(url);
-		curl_free(urlHostname);
-		curl_free(urlScheme);
-		curl_free(urlPort);
-		return false;
+		spdlog::error("Failed to resolve http request destination {} using getaddrinfo().", hostname);
+		return destination;
 	}
 
 	bool bFoundIPv6 = false;
@@ -140,78 +198,31 @@ bool IsHttpDestinationHostAllowed(const std::string& host, std::string& outHostn
 		}
 		else
 		{
-			spdlog::error("Failed to resolve http request destination {} into a valid IPv4 address.", urlHostname);
+			spdlog::error("Failed to resolve http request destination {} into a valid IPv4 address.", hostname);
 		}
 
 		freeaddrinfo(result);
-		curl_free(urlHostname);
-		curl_free(urlScheme);
-		curl_free(urlPort);
-		curl_url_cleanup(url);
-
-		return false;
+		return destination;
 	}
 
-	// Fast checks for private ranges of IPv4.
-	// clang-format off
+	if (IsPrivateIPv4Address(sockaddr_ipv4))
 	{
-		auto addrBytes = sockaddr_ipv4->sin_addr.S_un.S_un_b;
-
-		if (addrBytes.s_b1 == 10														// 10.0.0.0			- 10.255.255.255		(Class A Private)
-			|| addrBytes.s_b1 == 172 && addrBytes.s_b2 >= 16 && addrBytes.s_b2 <= 31	// 172.16.0.0		- 172.31.255.255		(Class B Private)
-			|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 168							// 192.168.0.0		- 192.168.255.255		(Class C Private)
-			|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 0 && addrBytes.s_b3 == 0		// 192.0.0.0		- 192.0.0.255			(IETF Assignment)
-			|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 0 && addrBytes.s_b3 == 2		// 192.0.2.0		- 192.0.2.255			(TEST-NET-1)
-			|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 88 && addrBytes.s_b3 == 99	// 192.88.99.0		- 192.88.99.255			(IPv4-IPv6 Relay)
-			|| addrBytes.s_b1 == 192 && addrBytes.s_b2 >= 18 &&	addrBytes.s_b2 <= 19	// 192.18.0.0		- 192.19.255.255		(Internet Benchmark)
-			|| addrBytes.s_b1 == 192 && addrBytes.s_b2 == 51 && addrBytes.s_b3 == 100	// 192.51.100.0		- 192.51.100.255		(TEST-NET-2)
-			|| addrBytes.s_b1 == 203 && addrBytes.s_b2 == 0 && addrBytes.s_b3 == 113	// 203.0.113.0		- 203.0.113.255			(TEST-NET-3)
-			|| addrBytes.s_b1 == 169 && addrBytes.s_b2 == 254							// 169.254.00		- 169.254.255.255		(Link-local/APIPA)
-			|| addrBytes.s_b1 == 127													// 127.0.0.0		- 127.255.255.255		(Loopback)
-			|| addrBytes.s_b1 == 0														// 0.0.0.0			- 0.255.255.255			(Current network)
-			|| addrBytes.s_b1 == 100 && addrBytes.s_b2 >= 64 && addrBytes.s_b2 <= 127	// 100.64.0.0		- 100.127.255.255		(Shared address space)
-			|| sockaddr_ipv4->sin_addr.S_un.S_addr == 0xFFFFFFFF						// 255.255.255.255							(Broadcast)
-			|| addrBytes.s_b1 >= 224 && addrBytes.s_b2 <= 239							// 224.0.0.0		- 239.255.255.255		(Multicast)
-			|| addrBytes.s_b1 == 233 && addrBytes.s_b2 == 252 && addrBytes.s_b3 == 0	// 233.252.0.0		- 233.252.0.255			(MCAST-TEST-NET)
-			|| addrBytes.s_b1 >= 240 && addrBytes.s_b4 <= 254)							// 240.0.0.0		- 255.255.255.254		(Future Use Class E)
-		{
-			freeaddrinfo(result);
-			curl_free(urlHostname);
-			curl_free(urlScheme);
-			curl_free(urlPort);
-			curl_url_cleanup(url);
-
-			return false;
-		}
+		destination.policy = HttpDestinationCache::Policy::Private;
 	}
+	else
+	{
+		char resolvedStr[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &sockaddr_ipv4->sin_addr, resolvedStr, INET_ADDRSTRLEN);
 
-	// clang-format on
-
-	char resolvedStr[INET_ADDRSTRLEN];
-	inet_ntop(AF_INET, &sockaddr_ipv4->sin_addr, resolvedStr, INET_ADDRSTRLEN);
-
-	// Use the resolved address as the new request host.
-	outHostname = urlHostname;
-	outAddress = resolvedStr;
-	outPort = urlPort;
+		destination.policy = HttpDestinationCache::Policy::Allowed;
+		destination.sAddress = resolvedStr;
+	}
 
 	freeaddrinfo(result);
-
-	curl_free(urlHostname);
-	curl_free(urlScheme);
-	curl_free(urlPort);
-	curl_url_cleanup(url);
-
-	return true;
-}
-
-size_t HttpCurlWriteToStringBufferCallback(char* contents, size_t size, size_t nmemb, void* userp)
-{
-	((std::string*)userp)->append((char*)contents, size * nmemb);
-	return size * nmemb;
+	return destination;
 }
 
-template <ScriptContext context> int HttpRequestHandler::MakeHttpRequest(const HttpRequest& requestParameters)
+template <ScriptContext context> int HttpRequestHandler::MakeHttpRequest(const HttpRequest& requestParameters, const std::string& svModName)
 {
 	if (!IsRunning())
 	{
@@ -226,232 +237,672 @@ template <ScriptContext context> int HttpRequestHandler::MakeHttpRequest(const H
 		return -1;
 	}
 
-	bool bAllowLocalHttp = IsLocalHttpAllowed();
-
 	// This handle will be returned to Squirrel so it can wait for the response and assign a callback for it.
 	int handle = ++m_iLastRequestHandle;
 
-	std::thread requestThread(
-		[this, handle, requestParameters, bAllowLocalHttp]()
-		{
-			std::string hostname, resolvedAddress, resolvedPort;
+	std::unique_ptr<HttpRequestJob_t> pJob = std::make_unique<HttpRequestJob_t>();
+	pJob->iHandle = handle;
+	pJob->context = context;
+	pJob->sModName = svModName;
+	pJob->request = requestParameters;
+	pJob->bAllowLocalHttp = IsLocalHttpAllowed();
+	pJob->iMaxConcurrent = std::max(Cvar_ns_http_max_concurrent_requests->GetInt(), 0);
 
-			if (!bAllowLocalHttp)
-			{
-				if (!IsHttpDestinationHostAllowed(requestParameters.baseUrl, hostname, resolvedAddress, resolvedPort))
-				{
-					spdlog::warn(
-						"HttpRequestHandler::MakeHttpRequest attempted to make a request to a private network. This is only allowed when "
-						"running the game with -allowlocalhttp.");
-					g_pSquirrel[context]->AsyncCall(
-						"NSHandleFailedHttpRequest",
-						handle,
-						(int)0,
-						"Cannot make HTTP requests to private network hosts without -allowlocalhttp. Check your console for more "
-						"information.");
-					return;
-				}
-			}
+	// Requests can ask for a lower limit than the user set, but not a higher one.
+	pJob->iMaxBodySize = std::max(Cvar_ns_http_max_response_size->GetInt(), 0);
+	if (requestParameters.maxResponseSize > 0 && (!pJob->iMaxBodySize || (size_t)requestParameters.maxResponseSize < pJob->iMaxBodySize))
+		pJob->iMaxBodySize = requestParameters.maxResponseSize;
 
-			CURL* curl = curl_easy_init();
-			if (!curl)
-			{
-				spdlog::error("HttpRequestHandler::MakeHttpRequest failed to init libcurl for request.");
-				g_pSquirrel[context]->AsyncCall(
-					"NSHandleFailedHttpRequest", handle, static_cast<int>(CURLE_FAILED_INIT), curl_easy_strerror(CURLE_FAILED_INIT));
-				return;
-			}
+	pJob->flQueuedTime = GetHttpRequestTime();
 
-			// HEAD has no body.
-			if (requestParameters.method == HttpRequestMethod::HRM_HEAD)
-			{
-				curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
-			}
+	const double flRequestsPerSecond = Cvar_ns_http_max_requests_per_second->GetFloat();
 
-			curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, HttpRequestMethod::ToString(requestParameters.method).c_str());
+	bool bAccepted;
+	bool bShouldWarn = false;
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		ModRequestState_t& modState = m_ModStates[svModName];
 
-			// Only resolve to IPv4 if we don't allow private network requests.
-			curl_slist* host = nullptr;
-			if (!bAllowLocalHttp)
-			{
-				curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
-				host = curl_slist_append(host, fmt::format("{}:{}:{}", hostname, resolvedPort, resolvedAddress).c_str());
-				curl_easy_setopt(curl, CURLOPT_RESOLVE, host);
-			}
+		bAccepted = modState.iQueued < MAX_QUEUED_REQUESTS_PER_MOD;
+		if (bAccepted && flRequestsPerSecond > 0.0)
+		{
+			// Let mods burst up to a second's worth of requests at once.
+			const double flBurst = std::max(flRequestsPerSecond, 1.0);
+			if (modState.flLastRefillTime < 0.0)
+				modState.flTokens = flBurst;
+			else
+				modState.flTokens =
+					std::min(flBurst, modState.flTokens + (pJob->flQueuedTime - modState.flLastRefillTime) * flRequestsPerSecond);
 
-			// Ensure we only allow HTTP or HTTPS.
-			curl_easy_setopt(curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS);
+			modState.flLastRefillTime = pJob->flQueuedTime;
 
-			// Allow redirects
-			curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-			curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 3L);
+			bAccepted = modState.flTokens >= 1.0;
+			if (bAccepted)
+				modState.flTokens -= 1.0;
+		}
 
-			// Check if the url already contains a query.
-			// If so, we'll know to append with & instead of start with ?
-			std::string queryUrl = requestParameters.baseUrl;
-			bool bUrlContainsQuery = false;
+		if (bAccepted)
+		{
+			modState.iQueued++;
+			modState.bWarnedRateLimited = false;
+			m_SubmittedRequests.push_back(std::move(pJob));
+		}
+		else
+		{
+			modState.iRateLimited++;
+			bShouldWarn = !modState.bWarnedRateLimited;
+			modState.bWarnedRateLimited = true;
+		}
+	}
 
-			// If this fails, just ignore the parsing and trust what the user wants to query.
-			// Probably will fail but handling it here would be annoying.
-			CURLU* curlUrl = curl_url();
-			if (curlUrl)
-			{
-				if (curl_url_set(curlUrl, CURLUPART_URL, queryUrl.c_str(), CURLU_DEFAULT_SCHEME) == CURLUE_OK)
-				{
-					char* currentQuery;
-					if (curl_url_get(curlUrl, CURLUPART_QUERY, &currentQuery, 0) == CURLUE_OK)
-					{
-						if (currentQuery && std::strlen(currentQuery) != 0)
-						{
-							bUrlContainsQuery = true;
-						}
-					}
-
-					curl_free(currentQuery);
-				}
+	if (!bAccepted)
+	{
+		if (bShouldWarn)
+		{
+			spdlog::warn(
+				"Mod {} is making too many http requests, requests will fail until it slows down. The limits can be changed with "
+				"ns_http_max_requests_per_second and ns_http_max_concurrent_requests.",
+				svModName);
+		}
 
-				curl_url_cleanup(curlUrl);
-			}
+		g_pSquirrel[context]->AsyncCall(
+			"NSHandleFailedHttpRequest", handle, (int)0, "Too many HTTP requests are being made. Check your console for more information.");
+		return handle;
+	}
 
-			// GET requests, or POST-like requests with an empty body, can have query parameters.
-			// Append them to the base url.
-			if (HttpRequestMethod::CanHaveQueryParameters(requestParameters.method) &&
-					!HttpRequestMethod::UsesCurlPostOptions(requestParameters.method) ||
-				requestParameters.body.empty())
-			{
-				bool isFirstValue = true;
-				for (const auto& kv : requestParameters.queryParameters)
-				{
-					char* key = curl_easy_escape(curl, kv.first.c_str(), (int)kv.first.length());
-
-					for (const std::string& queryValue : kv.second)
-					{
-						char* value = curl_easy_escape(curl, queryValue.c_str(), (int)queryValue.length());
-
-						if (isFirstValue && !bUrlContainsQuery)
-						{
-							queryUrl.append(fmt::format("?{}={}", key, value));
-							isFirstValue = false;
-						}
-						else
-						{
-							queryUrl.append(fmt::format("&{}={}", key, value));
-						}
-
-						curl_free(value);
-					}
-
-					curl_free(key);
-				}
-			}
+	curl_multi_wakeup(m_pMulti);
+	return handle;
+}
 
-			// If this method uses POST-like curl options, set those and set the body.
-			// The body won't be sent if it's empty anyway, meaning the query parameters above, if any, would be.
-			if (HttpRequestMethod::UsesCurlPostOptions(requestParameters.method))
-			{
-				// Grab the body and set it as a POST field
-				curl_easy_setopt(curl, CURLOPT_POST, 1L);
+void HttpRequestHandler::RunRequestThread()
+{
+	while (IsRunning())
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			for (std::unique_ptr<HttpRequestJob_t>& pJob : m_SubmittedRequests)
+				m_WaitingRequests.push_back(std::move(pJob));
 
-				curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, requestParameters.body.length());
-				curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, requestParameters.body.c_str());
-			}
+			m_SubmittedRequests.clear();
+		}
 
-			// Set the full URL for this http request.
-			curl_easy_setopt(curl, CURLOPT_URL, queryUrl.c_str());
+		PollResolves(GetHttpRequestTime());
+		StartWaitingRequests(GetHttpRequestTime());
 
-			std::string bodyBuffer;
-			std::string headerBuffer;
+		int iRunningHandles = 0;
+		curl_multi_perform(m_pMulti, &iRunningHandles);
 
-			// Set up buffers to write the response headers and body.
-			curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, HttpCurlWriteToStringBufferCallback);
-			curl_easy_setopt(curl, CURLOPT_WRITEDATA, &bodyBuffer);
-			curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HttpCurlWriteToStringBufferCallback);
-			curl_easy_setopt(curl, CURLOPT_HEADERDATA, &headerBuffer);
+		// Requests that were waiting on the ones that just finished can go straight away.
+		if (ReadFinishedRequests(GetHttpRequestTime()))
+			continue;
 
-			// Add all the headers for the request.
-			curl_slist* headers = nullptr;
+		// Curl wakes us up whenever a transfer needs attention, and new requests and finished lookups use curl_multi_wakeup.
+		curl_multi_poll(m_pMulti, nullptr, 0, 1000, nullptr);
+	}
+
+	AbandonAllRequests();
+}
+
+void HttpRequestHandler::PollResolves(double flTime)
+{
+	std::vector<std::pair<std::string, HttpDestinationCache::Destination_t>> finishedResolves;
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		finishedResolves.swap(m_FinishedResolves);
+	}
 
-			// Content-Type header for POST-like requests.
-			if (HttpRequestMethod::UsesCurlPostOptions(requestParameters.method) && !requestParameters.body.empty())
+	for (auto& [hostname, destination] : finishedResolves)
+	{
+		m_DestinationCache.Store(hostname, std::move(destination), flTime);
+		// The lookup has already handed over its result, so this won't wait for long.
+		m_PendingResolves.erase(hostname);
+	}
+}
+
+void HttpRequestHandler::StartWaitingRequests(double flTime)
+{
+	for (auto it = m_WaitingRequests.begin(); it != m_WaitingRequests.end() && m_ActiveRequests.size() < MAX_ACTIVE_REQUESTS;)
+	{
+		HttpRequestJob_t& job = **it;
+
+		// Requests from mods that are at their limit wait their turn.
+		if (job.iMaxConcurrent)
+		{
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			if (m_ModStates[job.sModName].iActive >= job.iMaxConcurrent)
 			{
-				headers = curl_slist_append(headers, fmt::format("Content-Type: {}", requestParameters.contentType).c_str());
+				++it;
+				continue;
 			}
+		}
+
+		if (!job.bAllowLocalHttp)
+		{
+			HttpDestinationCache::Destination_t destination;
+			bool bAllowed = false;
 
-			for (const auto& kv : requestParameters.headers)
+			if (job.sHostname.empty() && !ParseHttpDestination(job.request.baseUrl, job.sHostname, job.sPort))
+			{
+				bAllowed = false;
+			}
+			else if (!m_DestinationCache.Find(job.sHostname, flTime, destination))
 			{
-				for (const std::string& headerValue : kv.second)
+				// Wait for the lookup, starting one if nobody else is waiting on this host.
+				if (!m_PendingResolves.contains(job.sHostname) && m_PendingResolves.size() < MAX_CONCURRENT_RESOLVES)
 				{
-					headers = curl_slist_append(headers, fmt::format("{}: {}", kv.first, headerValue).c_str());
+					m_PendingResolves.emplace(
+						job.sHostname,
+						std::async(
+							std::launch::async,
+							[this, hostname = job.sHostname]()
+							{
+								HttpDestinationCache::Destination_t resolved = ResolveHttpDestination(hostname);
+								{
+									std::lock_guard<std::mutex> guard(m_Mutex);
+									m_FinishedResolves.emplace_back(hostname, std::move(resolved));
+								}
+
+								curl_multi_wakeup(m_pMulti);
+							}));
 				}
-			}
 
-			if (headers != nullptr)
-			{
-				curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+				++it;
+				continue;
 			}
-
-			// Disable SSL checks if requested by the user.
-			if (DisableHttpSsl())
+			else
 			{
-				curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-				curl_easy_setopt(curl, CURLOPT_SSL_VERIFYSTATUS, 0L);
+				bAllowed = destination.policy == HttpDestinationCache::Policy::Allowed;
+				job.sResolvedAddress = destination.sAddress;
 			}
 
-			// Enforce the Northstar user agent, unless an override was specified.
-			if (requestParameters.userAgent.empty())
+			if (!bAllowed)
 			{
-				curl_easy_setopt(curl, CURLOPT_USERAGENT, &NSUserAgent);
+				spdlog::warn(
+					"HttpRequestHandler::MakeHttpRequest attempted to make a request to a private network. This is only allowed when "
+					"running the game with -allowlocalhttp.");
+
+				std::unique_ptr<HttpRequestJob_t> pJob = std::move(*it);
+				it = m_WaitingRequests.erase(it);
+				FailQueuedRequest(
+					std::move(pJob),
+					0,
+					"Cannot make HTTP requests to private network hosts without -allowlocalhttp. Check your console for more information.");
+				continue;
 			}
-			else
+		}
+
+		std::unique_ptr<HttpRequestJob_t> pJob = std::move(*it);
+		it = m_WaitingRequests.erase(it);
+
+		if (!SetupRequest(*pJob))
+		{
+			FailQueuedRequest(std::move(pJob), static_cast<int>(CURLE_FAILED_INIT), curl_easy_strerror(CURLE_FAILED_INIT));
+			continue;
+		}
+
+		curl_multi_add_handle(m_pMulti, pJob->pCurl);
+
+		{
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			ModRequestState_t& modState = m_ModStates[pJob->sModName];
+			modState.iQueued--;
+			modState.iActive++;
+		}
+
+		m_ActiveRequests.push_back(std::move(pJob));
+	}
+}
+
+bool HttpRequestHandler::SetupRequest(HttpRequestJob_t& job)
+{
+	const HttpRequest& requestParameters = job.request;
+
+	// Reuse a handle from a finished request if we can, they were reset when they finished.
+	if (!m_FreeHandles.empty())
+	{
+		job.pCurl = m_FreeHandles.back();
+		m_FreeHandles.pop_back();
+	}
+	else
+	{
+		job.pCurl = curl_easy_init();
+	}
+
+	CURL* curl = job.pCurl;
+	if (!curl)
+	{
+		spdlog::error("HttpRequestHandler::MakeHttpRequest failed to init libcurl for request.");
+		return false;
+	}
+
+	// HEAD has no body.
+	if (requestParameters.method == HttpRequestMethod::HRM_HEAD)
+	{
+		curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+	}
+
+	curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, HttpRequestMethod::ToString(requestParameters.method).c_str());
+
+	// Only resolve to IPv4 if we don't allow private network requests.
+	if (!job.bAllowLocalHttp)
+	{
+		curl_easy_setopt(curl, CURLOPT_IPRESOLVE, CURL_IPRESOLVE_V4);
+		job.pResolve = curl_slist_append(job.pResolve, fmt::format("{}:{}:{}", job.sHostname, job.sPort, job.sResolvedAddress).c_str());
+		curl_easy_setopt(curl, CURLOPT_RESOLVE, job.pResolve);
+	}
+
+	// Ensure we only allow HTTP or HTTPS.
+	curl_easy_setopt(curl, CURLOPT_PROTOCOLS, CURLPROTO_HTTP | CURLPROTO_HTTPS);
+
+	// Allow redirects
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_MAXREDIRS, 3L);
+
+	// Check if the url already contains a query.
+	// If so, we'll know to append with & instead of start with ?
+	std::string queryUrl = requestParameters.baseUrl;
+	bool bUrlContainsQuery = false;
+
+	// If this fails, just ignore the parsing and trust what the user wants to query.
+	// Probably will fail but handling it here would be annoying.
+	CURLU* curlUrl = curl_url();
+	if (curlUrl)
+	{
+		if (curl_url_set(curlUrl, CURLUPART_URL, queryUrl.c_str(), CURLU_DEFAULT_SCHEME) == CURLUE_OK)
+		{
+			char* currentQuery;
+			if (curl_url_get(curlUrl, CURLUPART_QUERY, &currentQuery, 0) == CURLUE_OK)
 			{
-				curl_easy_setopt(curl, CURLOPT_USERAGENT, requestParameters.userAgent.c_str());
+				if (currentQuery && std::strlen(currentQuery) != 0)
+				{
+					bUrlContainsQuery = true;
+				}
 			}
 
-			// Set the timeout for this request. Max 60 seconds so mods can't just spin up native threads all the time.
-			curl_easy_setopt(curl, CURLOPT_TIMEOUT, std::clamp<long>(requestParameters.timeout, 1, 60));
+			curl_free(currentQuery);
+		}
+
+		curl_url_cleanup(curlUrl);
+	}
+
+	// GET requests, or POST-like requests with an empty body, can have query parameters.
+	// Append them to the base url.
+	if (HttpRequestMethod::CanHaveQueryParameters(requestParameters.method) &&
+			!HttpRequestMethod::UsesCurlPostOptions(requestParameters.method) ||
+		requestParameters.body.empty())
+	{
+		bool isFirstValue = true;
+		for (const auto& kv : requestParameters.queryParameters)
+		{
+			char* key = curl_easy_escape(curl, kv.first.c_str(), (int)kv.first.length());
 
-			CURLcode result = curl_easy_perform(curl);
-			if (IsRunning())
+			for (const std::string& queryValue : kv.second)
 			{
-				if (result == CURLE_OK)
+				char* value = curl_easy_escape(curl, queryValue.c_str(), (int)queryValue.length());
+
+				if (isFirstValue && !bUrlContainsQuery)
 				{
-					// While the curl request is OK, it could return a non success code.
-					// Squirrel side will handle firing the correct callback.
-					long httpCode = 0;
-					curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpCode);
-					g_pSquirrel[context]->AsyncCall(
-						"NSHandleSuccessfulHttpRequest", handle, static_cast<int>(httpCode), bodyBuffer, headerBuffer);
+					queryUrl.append(fmt::format("?{}={}", key, value));
+					isFirstValue = false;
 				}
 				else
 				{
-					// Pass CURL result code & error.
-					spdlog::error(
-						"curl_easy_perform() failed with code {}, error: {}", static_cast<int>(result), curl_easy_strerror(result));
-
-					// If it's an SSL issue, tell the user they may disable SSL checks using -disablehttpssl.
-					if (result == CURLE_PEER_FAILED_VERIFICATION || result == CURLE_SSL_CERTPROBLEM ||
-						result == CURLE_SSL_INVALIDCERTSTATUS)
-					{
-						spdlog::error("You can try disabling SSL verifications for this issue using the -disablehttpssl launch argument. "
-									  "Keep in mind this is potentially dangerous!");
-					}
-
-					g_pSquirrel[context]->AsyncCall(
-						"NSHandleFailedHttpRequest", handle, static_cast<int>(result), curl_easy_strerror(result));
+					queryUrl.append(fmt::format("&{}={}", key, value));
 				}
+
+				curl_free(value);
 			}
 
-			curl_easy_cleanup(curl);
-			curl_slist_free_all(headers);
-			curl_slist_free_all(host);
-		});
+			curl_free(key);
+		}
+	}
 
-	requestThread.detach();
-	return handle;
+	// If this method uses POST-like curl options, set those and set the body.
+	// The body won't be sent if it's empty anyway, meaning the query parameters above, if any, would be.
+	if (HttpRequestMethod::UsesCurlPostOptions(requestParameters.method))
+	{
+		// Grab the body and set it as a POST field
+		curl_easy_setopt(curl, CURLOPT_POST, 1L);
+
+		curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, requestParameters.body.length());
+		curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, requestParameters.body.c_str());
+	}
+
+	// Set the full URL for this http request.
+	curl_easy_setopt(curl, CURLOPT_URL, queryUrl.c_str());
+
+	// Set up buffers to write the response headers and body.
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteResponseBody);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &job);
+	curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, WriteResponseHeader);
+	curl_easy_setopt(curl, CURLOPT_HEADERDATA, &job);
+
+	// Lets curl give up straight away if the response says it's too big, the write callback catches anything that doesn't.
+	if (job.iMaxBodySize)
+	{
+		curl_easy_setopt(curl, CURLOPT_MAXFILESIZE_LARGE, (curl_off_t)job.iMaxBodySize);
+	}
+
+	// Add all the headers for the request.
+	// Content-Type header for POST-like requests.
+	if (HttpRequestMethod::UsesCurlPostOptions(requestParameters.method) && !requestParameters.body.empty())
+	{
+		job.pHeaders = curl_slist_append(job.pHeaders, fmt::format("Content-Type: {}", requestParameters.contentType).c_str());
+	}
+
+	for (const auto& kv : requestParameters.headers)
+	{
+		for (const std::string& headerValue : kv.second)
+		{
+			job.pHeaders = curl_slist_append(job.pHeaders, fmt::format("{}: {}", kv.first, headerValue).c_str());
+		}
+	}
+
+	if (job.pHeaders != nullptr)
+	{
+		curl_easy_setopt(curl, CURLOPT_HTTPHEADER, job.pHeaders);
+	}
+
+	// Disable SSL checks if requested by the user.
+	if (DisableHttpSsl())
+	{
+		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+		curl_easy_setopt(curl, CURLOPT_SSL_VERIFYSTATUS, 0L);
+	}
+
+	// Enforce the Northstar user agent, unless an override was specified.
+	if (requestParameters.userAgent.empty())
+	{
+		curl_easy_setopt(curl, CURLOPT_USERAGENT, &NSUserAgent);
+	}
+	else
+	{
+		curl_easy_setopt(curl, CURLOPT_USERAGENT, requestParameters.userAgent.c_str());
+	}
+
+	// Set the timeout for this request. Max 60 seconds so mods can't just hold onto transfers forever.
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT, std::clamp<long>(requestParameters.timeout, 1, 60));
+
+	return true;
+}
+
+size_t HttpRequestHandler::WriteResponseBody(char* pContents, size_t iSize, size_t iCount, void* pUserData)
+{
+	HttpRequestJob_t& job = *(HttpRequestJob_t*)pUserData;
+	const size_t iBytes = iSize * iCount;
+
+	// Taking less than we were given makes curl abort the transfer.
+	if (job.iMaxBodySize && job.iBodySize + iBytes > job.iMaxBodySize)
+	{
+		job.bResponseTooLarge = true;
+		return 0;
+	}
+
+	job.iBodySize += iBytes;
+	job.sBodyBuffer.append(pContents, iBytes);
+
+	if (job.request.streamResponse)
+		SendResponseChunks(job, false);
+
+	return iBytes;
+}
+
+size_t HttpRequestHandler::WriteResponseHeader(char* pContents, size_t iSize, size_t iCount, void* pUserData)
+{
+	HttpRequestJob_t& job = *(HttpRequestJob_t*)pUserData;
+	const size_t iBytes = iSize * iCount;
+
+	if (job.sHeaderBuffer.size() + iBytes > MAX_RESPONSE_HEADER_SIZE)
+	{
+		job.bResponseTooLarge = true;
+		job.bHeadersTooLarge = true;
+		return 0;
+	}
+
+	job.sHeaderBuffer.append(pContents, iBytes);
+	return iBytes;
+}
+
+void HttpRequestHandler::SendResponseChunks(HttpRequestJob_t& job, bool bFinished)
+{
+	size_t iSent = 0;
+	while (job.sBodyBuffer.size() - iSent >= RESPONSE_CHUNK_SIZE || (bFinished && iSent < job.sBodyBuffer.size()))
+	{
+		const size_t iChunkSize = std::min(job.sBodyBuffer.size() - iSent, RESPONSE_CHUNK_SIZE);
+		g_pSquirrel[job.context]->AsyncCall("NSHandleHttpRequestChunk", job.iHandle, job.sBodyBuffer.substr(iSent, iChunkSize));
+		iSent += iChunkSize;
+	}
+
+	job.sBodyBuffer.erase(0, iSent);
+}
+
+bool HttpRequestHandler::ReadFinishedRequests(double flTime)
+{
+	bool bFinishedAny = false;
+
+	int iMessagesLeft = 0;
+	while (CURLMsg* pMessage = curl_multi_info_read(m_pMulti, &iMessagesLeft))
+	{
+		if (pMessage->msg != CURLMSG_DONE)
+			continue;
+
+		// The message is freed once the handle is removed, so grab what we need first.
+		CURL* pCurl = pMessage->easy_handle;
+		CURLcode result = pMessage->data.result;
+		curl_multi_remove_handle(m_pMulti, pCurl);
+
+		auto it = std::find_if(
+			m_ActiveRequests.begin(),
+			m_ActiveRequests.end(),
+			[pCurl](const std::unique_ptr<HttpRequestJob_t>& pJob) { return pJob->pCurl == pCurl; });
+		if (it == m_ActiveRequests.end())
+			continue;
+
+		std::unique_ptr<HttpRequestJob_t> pJob = std::move(*it);
+		m_ActiveRequests.erase(it);
+
+		FinishActiveRequest(std::move(pJob), result, flTime);
+		bFinishedAny = true;
+	}
+
+	return bFinishedAny;
+}
+
+void HttpRequestHandler::ReleaseRequestHandles(HttpRequestJob_t& job)
+{
+	curl_slist_free_all(job.pHeaders);
+	curl_slist_free_all(job.pResolve);
+	job.pHeaders = nullptr;
+	job.pResolve = nullptr;
+
+	if (!job.pCurl)
+		return;
+
+	if (m_FreeHandles.size() < MAX_FREE_HANDLES)
+	{
+		curl_easy_reset(job.pCurl);
+		m_FreeHandles.push_back(job.pCurl);
+	}
+	else
+	{
+		curl_easy_cleanup(job.pCurl);
+	}
+
+	job.pCurl = nullptr;
+}
+
+void HttpRequestHandler::FailQueuedRequest(std::unique_ptr<HttpRequestJob_t> pJob, int iErrorCode, const std::string& svError)
+{
+	ReleaseRequestHandles(*pJob);
+
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		ModRequestState_t& modState = m_ModStates[pJob->sModName];
+		modState.iQueued--;
+		modState.iFailed++;
+	}
+
+	if (IsRunning())
+		g_pSquirrel[pJob->context]->AsyncCall("NSHandleFailedHttpRequest", pJob->iHandle, iErrorCode, svError);
+}
+
+void HttpRequestHandler::FinishActiveRequest(std::unique_ptr<HttpRequestJob_t> pJob, CURLcode result, double flTime)
+{
+	// Aborting from the write callbacks shows up as a write error, so report what actually happened.
+	if (pJob->bResponseTooLarge)
+		result = CURLE_FILESIZE_EXCEEDED;
+
+	if (IsRunning())
+	{
+		if (result == CURLE_OK)
+		{
+			// Streamed responses get the rest of their body before the callback, so scripts see the whole thing first.
+			if (pJob->request.streamResponse)
+				SendResponseChunks(*pJob, true);
+
+			// While the curl request is OK, it could return a non success code.
+			// Squirrel side will handle firing the correct callback.
+			long httpCode = 0;
+			curl_easy_getinfo(pJob->pCurl, CURLINFO_RESPONSE_CODE, &httpCode);
+			g_pSquirrel[pJob->context]->AsyncCall(
+				"NSHandleSuccessfulHttpRequest", pJob->iHandle, static_cast<int>(httpCode), pJob->sBodyBuffer, pJob->sHeaderBuffer);
+		}
+		else if (pJob->bHeadersTooLarge)
+		{
+			spdlog::warn(
+				"Http request from mod {} was aborted because the response headers were larger than {} bytes.",
+				pJob->sModName,
+				MAX_RESPONSE_HEADER_SIZE);
+
+			g_pSquirrel[pJob->context]->AsyncCall(
+				"NSHandleFailedHttpRequest",
+				pJob->iHandle,
+				static_cast<int>(result),
+				"Response headers were larger than the allowed maximum. Check your console for more information.");
+		}
+		else if (result == CURLE_FILESIZE_EXCEEDED)
+		{
+			spdlog::warn(
+				"Http request from mod {} was aborted because the response was larger than {} bytes. The limit can be changed with "
+				"ns_http_max_response_size.",
+				pJob->sModName,
+				pJob->iMaxBodySize);
+
+			g_pSquirrel[pJob->context]->AsyncCall(
+				"NSHandleFailedHttpRequest",
+				pJob->iHandle,
+				static_cast<int>(result),
+				"Response was larger than the allowed maximum. Check your console for more information.");
+		}
+		else
+		{
+			// Pass CURL result code & error.
+			spdlog::error("curl_easy_perform() failed with code {}, error: {}", static_cast<int>(result), curl_easy_strerror(result));
+
+			// If it's an SSL issue, tell the user they may disable SSL checks using -disablehttpssl.
+			if (result == CURLE_PEER_FAILED_VERIFICATION || result == CURLE_SSL_CERTPROBLEM || result == CURLE_SSL_INVALIDCERTSTATUS)
+			{
+				spdlog::error("You can try disabling SSL verifications for this issue using the -disablehttpssl launch argument. "
+							  "Keep in mind this is potentially dangerous!");
+			}
+
+			g_pSquirrel[pJob->context]->AsyncCall(
+				"NSHandleFailedHttpRequest", pJob->iHandle, static_cast<int>(result), curl_easy_strerror(result));
+		}
+	}
+
+	ReleaseRequestHandles(*pJob);
+
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	ModRequestState_t& modState = m_ModStates[pJob->sModName];
+	modState.iActive--;
+
+	if (result == CURLE_OK)
+		modState.iCompleted++;
+	else
+		modState.iFailed++;
+
+	// Latency is from when the request was made, so it includes any time spent queued.
+	const double flLatency = flTime - pJob->flQueuedTime;
+	modState.latency.Add(flLatency);
+	m_Latency.Add(flLatency);
+}
+
+void HttpRequestHandler::AbandonAllRequests()
+{
+	for (std::unique_ptr<HttpRequestJob_t>& pJob : m_ActiveRequests)
+	{
+		curl_multi_remove_handle(m_pMulti, pJob->pCurl);
+		ReleaseRequestHandles(*pJob);
+	}
+
+	m_ActiveRequests.clear();
+	m_WaitingRequests.clear();
+
+	for (CURL* pCurl : m_FreeHandles)
+		curl_easy_cleanup(pCurl);
+
+	m_FreeHandles.clear();
+
+	// Lookups were started with std::async, so this waits on any that are still running.
+	m_PendingResolves.clear();
+	m_DestinationCache.Clear();
+
+	std::lock_guard<std::mutex> guard(m_Mutex);
+	m_SubmittedRequests.clear();
+	m_FinishedResolves.clear();
+
+	for (auto& [modName, modState] : m_ModStates)
+	{
+		modState.iQueued = 0;
+		modState.iActive = 0;
+	}
+}
+
+void HttpRequestHandler::PrintStats()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	spdlog::info(
+		"http requests: p50 {:.0f}ms, p90 {:.0f}ms, p99 {:.0f}ms over the last {} requests",
+		m_Latency.GetPercentile(0.5) * 1000.0,
+		m_Latency.GetPercentile(0.9) * 1000.0,
+		m_Latency.GetPercentile(0.99) * 1000.0,
+		m_Latency.GetSampleCount());
+
+	for (const auto& [modName, modState] : m_ModStates)
+	{
+		spdlog::info(
+			"{}: {} completed, {} failed, {} rate limited, {} active, {} queued, p50 {:.0f}ms, p90 {:.0f}ms, p99 {:.0f}ms",
+			modName,
+			modState.iCompleted,
+			modState.iFailed,
+			modState.iRateLimited,
+			modState.iActive,
+			modState.iQueued,
+			modState.latency.GetPercentile(0.5) * 1000.0,
+			modState.latency.GetPercentile(0.9) * 1000.0,
+			modState.latency.GetPercentile(0.99) * 1000.0);
+	}
+}
+
+// NS_InternalMakeHttpRequest is only called through the http request wrappers, so the first mod further up the stack than
+// the one the wrappers live in is the one actually making the request
+template <ScriptContext context> std::string GetHttpRequestModName(HSQUIRRELVM sqvm)
+{
+	Mod* pWrapperMod = g_pSquirrel[context]->getcallingmod(sqvm);
+	for (int depth = 1; depth + 1 < sqvm->_callstacksize; depth++)
+	{
+		Mod* pMod = g_pSquirrel[context]->getcallingmod(sqvm, depth);
+		if (pMod && pMod != pWrapperMod)
+			return pMod->Name;
+	}
+
+	return pWrapperMod ? pWrapperMod->Name : "Unknown";
 }
 
 // int NS_InternalMakeHttpRequest(int method, string baseUrl, table<string, string> headers, table<string, string> queryParams,
-//	string contentType, string body, int timeout, string userAgent)
+//	string contentType, string body, int timeout, string userAgent, bool streamResponse = false, int maxResponseSize = 0)
 template <ScriptContext context> SQRESULT SQ_InternalMakeHttpRequest(HSQUIRRELVM sqvm)
 {
 	if (!g_httpRequestHandler || !g_httpRequestHandler->IsRunning())
@@ -522,8 +973,10 @@ template <ScriptContext context> SQRESULT SQ_InternalMakeHttpRequest(HSQUIRRELVM
 	request.body = g_pSquirrel[context]->getstring(sqvm, 6);
 	request.timeout = g_pSquirrel[context]->getinteger(sqvm, 7);
 	request.userAgent = g_pSquirrel[context]->getstring(sqvm, 8);
+	request.streamResponse = g_pSquirrel[context]->getbool(sqvm, 9);
+	request.maxResponseSize = g_pSquirrel[context]->getinteger(sqvm, 10);
 
-	int handle = g_httpRequestHandler->MakeHttpRequest<context>(request);
+	int handle = g_httpRequestHandler->MakeHttpRequest<context>(request, GetHttpRequestModName<context>(sqvm));
 	g_pSquirrel[context]->pushinteger(sqvm, handle);
 	return SQRESULT_NOTNULL;
 }
@@ -549,7 +1002,7 @@ template <ScriptContext context> void HttpRequestHandler::RegisterSQFuncs()
 		"NS_InternalMakeHttpRequest",
 		"int method, string baseUrl, table<string, array<string> > headers, table<string, array<string> > queryParams, string contentType, "
 		"string body, "
-		"int timeout, string userAgent",
+		"int timeout, string userAgent, bool streamResponse = false, int maxResponseSize = 0",
 		"[Internal use only] Passes the HttpRequest struct fields to be reconstructed in native and used for an http request",
 		SQ_InternalMakeHttpRequest<context>);
 
@@ -580,8 +1033,31 @@ ON_DLL_LOAD_RELIESON("server.dll", HttpRequestHandler_ServerInit, ServerSquirrel
 	g_httpRequestHandler->RegisterSQFuncs<ScriptContext::SERVER>();
 }
 
-ON_DLL_LOAD("engine.dll", HttpRequestHandler_Init, (CModule module))
+void ConCommand_ns_http_stats(const CCommand& args)
 {
+	g_httpRequestHandler->PrintStats();
+}
+
+ON_DLL_LOAD_RELIESON("engine.dll", HttpRequestHandler_Init, (ConCommand, ConVar), (CModule module))
+{
+	Cvar_ns_http_max_concurrent_requests = new ConVar(
+		"ns_http_max_concurrent_requests",
+		"4",
+		FCVAR_NONE,
+		"Maximum number of http requests each mod can have running at once, further requests wait for one to finish. 0 for no limit");
+	Cvar_ns_http_max_requests_per_second = new ConVar(
+		"ns_http_max_requests_per_second",
+		"10",
+		FCVAR_NONE,
+		"Maximum number of http requests each mod can make per second, further requests fail. 0 for no limit");
+	Cvar_ns_http_max_response_size = new ConVar(
+		"ns_http_max_response_size",
+		"16777216",
+		FCVAR_NONE,
+		"Maximum size of an http response body in bytes, requests with bigger responses are aborted. 0 for no limit");
+
+	RegisterConCommand("ns_http_stats", ConCommand_ns_http_stats, "Logs http request counts and latencies for each mod", FCVAR_NONE);
+
 	g_httpRequestHandler = new HttpRequestHandler;
 	g_httpRequestHandler->StartHttpRequestHandler();
 }
@@ -1,7 +1,18 @@
 #pragma once
+#include "core/convar/convar.h"
+#include "scripthttprequestutils.h"
+
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
 
 enum class ScriptContext : int;
 
+extern ConVar* Cvar_ns_http_max_concurrent_requests;
+extern ConVar* Cvar_ns_http_max_requests_per_second;
+extern ConVar* Cvar_ns_http_max_response_size;
+
 // These definitions below should match on the Squirrel side so we can easily pass them along through a function.
 
 /**
@@ -92,17 +103,40 @@ struct HttpRequest
 
 	/** If set, the override to use for the User-Agent header. */
 	std::string userAgent;
+
+	/**
+	 * If set, the body is sent to NSHandleHttpRequestChunk in pieces as it arrives, instead of being sent to
+	 * NSHandleSuccessfulHttpRequest in one piece once the request is done. The successful callback then gets an empty body.
+	 */
+	bool streamResponse = false;
+
+	/** The largest response body to accept in bytes, anything bigger aborts the request. 0 to just use ns_http_max_response_size. */
+	int maxResponseSize = 0;
 };
 
 /**
  * Handles making HTTP requests and sending the responses back to Squirrel.
+ * All requests are run by a single thread on a shared curl multi handle, so connections are reused between requests.
  */
 class HttpRequestHandler
 {
 public:
+	// total transfers running at once, anything past this waits in the queue
+	static constexpr size_t MAX_ACTIVE_REQUESTS = 16;
+	// requests a mod can have waiting to start, past this new requests just fail
+	static constexpr size_t MAX_QUEUED_REQUESTS_PER_MOD = 64;
+	// getaddrinfo blocks, so lookups run on their own threads, but only this many at once
+	static constexpr size_t MAX_CONCURRENT_RESOLVES = 4;
+	// easy handles kept around after a request finishes, so the next request doesn't have to make a new one
+	static constexpr size_t MAX_FREE_HANDLES = 16;
+	// streamed responses are sent to squirrel in pieces no bigger than this
+	static constexpr size_t RESPONSE_CHUNK_SIZE = 64 * 1024;
+	// curl already limits single headers, this limits all of them together, redirects included
+	static constexpr size_t MAX_RESPONSE_HEADER_SIZE = 1024 * 1024;
+
 	HttpRequestHandler();
 
-	// Start/Stop the HTTP request handler. Right now this doesn't do much.
+	// Start/Stop the HTTP request handler, along with the thread that runs requests.
 	void StartHttpRequestHandler();
 	void StopHttpRequestHandler();
 
@@ -110,18 +144,105 @@ public:
 	bool IsRunning() const { return m_bIsHttpRequestHandlerRunning; }
 
 	/**
-	 * Creates a new thread to execute an HTTP request.
+	 * Queues an HTTP request to be run on the request thread.
 	 * @param requestParameters The parameters to use for this http request.
+	 * @param svModName The mod making the request, used for rate limiting.
 	 * @returns The handle for the http request being sent, or -1 if the request failed.
 	 */
-	template <ScriptContext context> int MakeHttpRequest(const HttpRequest& requestParameters);
+	template <ScriptContext context> int MakeHttpRequest(const HttpRequest& requestParameters, const std::string& svModName);
 
 	/** Registers the HTTP request Squirrel functions for the given script context. */
 	template <ScriptContext context> void RegisterSQFuncs();
 
+	/** Logs request counts and latency percentiles for each mod. */
+	void PrintStats();
+
 private:
+	/** A request, from when it's queued until its callback is sent to Squirrel. */
+	struct HttpRequestJob_t
+	{
+		int iHandle;
+		ScriptContext context;
+		std::string sModName;
+		HttpRequest request;
+		bool bAllowLocalHttp;
+		// per mod cap at the time the request was made, 0 for unlimited
+		size_t iMaxConcurrent;
+		// 0 for unlimited
+		size_t iMaxBodySize;
+		double flQueuedTime;
+
+		// destination, only filled in when we need to check it
+		std::string sHostname;
+		std::string sPort;
+		std::string sResolvedAddress;
+
+		CURL* pCurl = nullptr;
+		curl_slist* pHeaders = nullptr;
+		curl_slist* pResolve = nullptr;
+		// for streamed responses, this only holds what hasn't been sent to squirrel yet
+		std::string sBodyBuffer;
+		std::string sHeaderBuffer;
+		size_t iBodySize = 0;
+		bool bResponseTooLarge = false;
+		// the headers went over MAX_RESPONSE_HEADER_SIZE, rather than the body going over iMaxBodySize
+		bool bHeadersTooLarge = false;
+	};
+
+	struct ModRequestState_t
+	{
+		// token bucket for ns_http_max_requests_per_second
+		double flTokens = 0.0;
+		double flLastRefillTime = -1.0;
+
+		size_t iQueued = 0;
+		size_t iActive = 0;
+
+		uint64_t iCompleted = 0;
+		uint64_t iFailed = 0;
+		uint64_t iRateLimited = 0;
+		// only warn about a mod being rate limited once, until it makes a request that isn't
+		bool bWarnedRateLimited = false;
+		HttpLatencyWindow latency;
+	};
+
 	int m_iLastRequestHandle = 0;
 	std::atomic_bool m_bIsHttpRequestHandlerRunning = false;
+
+	CURLM* m_pMulti = nullptr;
+	std::thread m_RequestThread;
+
+	// everything below here is shared between the main thread and the request thread
+	std::mutex m_Mutex;
+	std::vector<std::unique_ptr<HttpRequestJob_t>> m_SubmittedRequests;
+	std::unordered_map<std::string, ModRequestState_t> m_ModStates;
+	HttpLatencyWindow m_Latency;
+	// lookups that have finished but haven't been put in the destination cache yet
+	std::vector<std::pair<std::string, HttpDestinationCache::Destination_t>> m_FinishedResolves;
+
+	// everything below here is only ever touched by the request thread
+	std::deque<std::unique_ptr<HttpRequestJob_t>> m_WaitingRequests;
+	std::vector<std::unique_ptr<HttpRequestJob_t>> m_ActiveRequests;
+	// only kept so we can wait for lookups on shutdown, results go through m_FinishedResolves
+	std::unordered_map<std::string, std::future<void>> m_PendingResolves;
+	HttpDestinationCache m_DestinationCache;
+	std::vector<CURL*> m_FreeHandles;
+
+	void RunRequestThread();
+	void PollResolves(double flTime);
+	void StartWaitingRequests(double flTime);
+	// returns whether any requests finished
+	bool ReadFinishedRequests(double flTime);
+	void AbandonAllRequests();
+
+	bool SetupRequest(HttpRequestJob_t& job);
+	static size_t WriteResponseBody(char* pContents, size_t iSize, size_t iCount, void* pUserData);
+	static size_t WriteResponseHeader(char* pContents, size_t iSize, size_t iCount, void* pUserData);
+	// sends full chunks of a streamed body to squirrel, along with whatever's left over if bFinished is set
+	static void SendResponseChunks(HttpRequestJob_t& job, bool bFinished);
+	void ReleaseRequestHandles(HttpRequestJob_t& job);
+	void FailQueuedRequest(std::unique_ptr<HttpRequestJob_t> pJob, int iErrorCode, const std::string& svError);
+	void FinishActiveRequest(std::unique_ptr<HttpRequestJob_t> pJob, CURLcode result, double flTime);
 };
 
 extern HttpRequestHandler* g_httpRequestHandler;
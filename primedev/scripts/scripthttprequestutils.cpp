@@ -0,0 +1,66 @@
+#include "scripthttprequestutils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+// hostnames are case insensitive, so make sure differently cased urls share an entry
+static std::string GetDestinationKey(const std::string& sHostname)
+{
+	std::string sKey = sHostname;
+	std::transform(sKey.begin(), sKey.end(), sKey.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+	return sKey;
+}
+
+bool HttpDestinationCache::Find(const std::string& sHostname, double flTime, Destination_t& outDestination) const
+{
+	auto it = m_Destinations.find(GetDestinationKey(sHostname));
+	if (it == m_Destinations.end() || it->second.flExpireTime <= flTime)
+		return false;
+
+	outDestination = it->second;
+	return true;
+}
+
+void HttpDestinationCache::Store(const std::string& sHostname, Destination_t destination, double flTime)
+{
+	const std::string sKey = GetDestinationKey(sHostname);
+	destination.flExpireTime = flTime + (destination.policy == Policy::Unresolved ? UNRESOLVED_TTL : RESOLVED_TTL);
+
+	// make room by dropping anything that's expired, and if that isn't enough, whatever is closest to expiring
+	if (m_Destinations.size() >= MAX_ENTRIES && !m_Destinations.contains(sKey))
+	{
+		std::erase_if(m_Destinations, [flTime](const auto& entry) { return entry.second.flExpireTime <= flTime; });
+
+		if (m_Destinations.size() >= MAX_ENTRIES)
+		{
+			m_Destinations.erase(std::min_element(
+				m_Destinations.begin(),
+				m_Destinations.end(),
+				[](const auto& a, const auto& b) { return a.second.flExpireTime < b.second.flExpireTime; }));
+		}
+	}
+
+	m_Destinations[sKey] = std::move(destination);
+}
+
+void HttpLatencyWindow::Add(double flSeconds)
+{
+	m_Samples[m_iNextSample] = (float)flSeconds;
+	m_iNextSample = (m_iNextSample + 1) % MAX_SAMPLES;
+	m_iSampleCount = std::min(m_iSampleCount + 1, MAX_SAMPLES);
+}
+
+double HttpLatencyWindow::GetPercentile(double flPercentile) const
+{
+	if (!m_iSampleCount)
+		return 0.0;
+
+	// nearest rank, so p100 is the slowest request we have and p0 the fastest
+	std::array<float, MAX_SAMPLES> samples = m_Samples;
+	const size_t iRank = (size_t)std::ceil(std::clamp(flPercentile, 0.0, 1.0) * m_iSampleCount);
+	const size_t iIndex = std::max<size_t>(iRank, 1) - 1;
+
+	std::nth_element(samples.begin(), samples.begin() + iIndex, samples.begin() + m_iSampleCount);
+	return samples[iIndex];
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+
+//-----------------------------------------------------------------------------
+// Purpose: Remembers whether hosts are allowed as http request destinations, and what they resolved to
+//          so getaddrinfo only has to run for a host every so often, rather than for every single request
+//-----------------------------------------------------------------------------
+class HttpDestinationCache
+{
+public:
+	static constexpr double RESOLVED_TTL = 60.0;
+	// failed lookups might just be a blip, so don't hold onto them for long
+	static constexpr double UNRESOLVED_TTL = 5.0;
+	static constexpr size_t MAX_ENTRIES = 256;
+
+	enum class Policy
+	{
+		Allowed,
+		// resolved to a private network address
+		Private,
+		// couldn't be resolved to an ipv4 address
+		Unresolved,
+	};
+
+	struct Destination_t
+	{
+		Policy policy = Policy::Unresolved;
+		std::string sAddress;
+		double flExpireTime = 0.0;
+	};
+
+private:
+	std::unordered_map<std::string, Destination_t> m_Destinations;
+
+public:
+	// returns false if we don't know about the host, or what we knew has expired
+	bool Find(const std::string& sHostname, double flTime, Destination_t& outDestination) const;
+	void Store(const std::string& sHostname, Destination_t destination, double flTime);
+	void Clear() { m_Destinations.clear(); }
+	size_t GetSize() const { return m_Destinations.size(); }
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Keeps the most recent request latencies around, so we can report percentiles for them
+//-----------------------------------------------------------------------------
+class HttpLatencyWindow
+{
+public:
+	static constexpr size_t MAX_SAMPLES = 256;
+
+private:
+	std::array<float, MAX_SAMPLES> m_Samples {};
+	size_t m_iNextSample = 0;
+	size_t m_iSampleCount = 0;
+
+public:
+	void Add(double flSeconds);
+	// flPercentile is 0 to 1, returns 0 if there aren't any samples
+	double GetPercentile(double flPercentile) const;
+	size_t GetSampleCount() const { return m_iSampleCount; }
+};
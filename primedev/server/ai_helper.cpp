@@ -5,6 +5,7 @@
 #include "engine/hoststate.h"
 
 #include "core/math/vplane.h"
+#include "util/fnv1a.h"
 
 #include <fstream>
 
@@ -15,6 +16,7 @@ const int PLACEHOLDER_CRC = 0;
 static ConVar* Cvar_navmesh_debug_hull;
 static ConVar* Cvar_navmesh_debug_camera_radius;
 static ConVar* Cvar_navmesh_debug_lossy_optimization;
+static ConVar* Cvar_navmesh_debug_use_bvtree;
 
 //-----------------------------------------------------------------------------
 // Purpose: Get navmesh pointer for hull
@@ -58,6 +60,129 @@ __m128i PackVerticesSIMD16(const Vector3& v1, const Vector3& v2)
 	return xRes;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: Gets the vertices of one of a poly's detail triangles
+// Input  : *pTile -
+//          *pPoly -
+//          *pDetail -
+//          iTri - index of the triangle within the poly's detail mesh
+//          *pVerts - receives the 3 vertices
+//-----------------------------------------------------------------------------
+static void GetDetailTriVerts(const dtMeshTile* pTile, const dtPoly* pPoly, const dtPolyDetail* pDetail, int iTri, Vector3* pVerts)
+{
+	const unsigned char* t = &pTile->detailTris[(pDetail->triBase + iTri) * 4];
+	for (int i = 0; i < 3; ++i)
+	{
+		const float* pfVerts;
+		if (t[i] < pPoly->vertCount)
+			pfVerts = &pTile->verts[pPoly->verts[t[i]] * 3];
+		else
+			pfVerts = &pTile->detailVerts[(pDetail->vertBase + t[i] - pPoly->vertCount) * 3];
+
+		pVerts[i] = Vector3(pfVerts[0], pfVerts[1], pfVerts[2]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Checks whether every point of a tile is behind a plane
+//-----------------------------------------------------------------------------
+static bool IsTileBehindPlane(const dtMeshTile* pTile, const VPlane& plane)
+{
+	// only need to check the corner that's furthest along the normal
+	const dtMeshHeader* pHeader = pTile->header;
+	const Vector3 vCorner(
+		plane.m_Normal.x >= 0.0f ? pHeader->bmax[0] : pHeader->bmin[0],
+		plane.m_Normal.y >= 0.0f ? pHeader->bmax[1] : pHeader->bmin[1],
+		plane.m_Normal.z >= 0.0f ? pHeader->bmax[2] : pHeader->bmin[2]);
+
+	return plane.GetPointSide(vCorner) != SIDE_FRONT;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Works out which poly owns each outline, so we don't have to dedupe them every frame
+// Input  : *pNavMesh
+//-----------------------------------------------------------------------------
+void CAI_Helper::UpdateNavmeshCache(const dtNavMesh* pNavMesh)
+{
+	// tiles are replaced when a navmesh is loaded, so their headers and salts are enough to tell if anything changed
+	uint64_t iSignature = FNV1A_64_OFFSET_BASIS;
+	auto fnMix = [&iSignature](uint64_t iValue) { iSignature = FNV1a_64(&iValue, sizeof(iValue), iSignature); };
+
+	fnMix((uint64_t)pNavMesh->m_tiles);
+	fnMix((uint64_t)pNavMesh->m_maxTiles);
+	for (int i = 0; i < pNavMesh->m_maxTiles; ++i)
+	{
+		fnMix((uint64_t)pNavMesh->m_tiles[i].header);
+		fnMix((uint64_t)pNavMesh->m_tiles[i].salt);
+	}
+
+	if (pNavMesh == m_pCachedNavMesh && iSignature == m_iCachedNavMeshSignature)
+		return;
+
+	m_pCachedNavMesh = pNavMesh;
+	m_iCachedNavMeshSignature = iSignature;
+
+	m_vTilePolyBase.assign(pNavMesh->m_maxTiles, 0);
+	m_vTileEdgeBase.assign(pNavMesh->m_maxTiles, 0);
+
+	uint32_t nPolys = 0;
+	uint32_t nEdges = 0;
+	for (int i = 0; i < pNavMesh->m_maxTiles; ++i)
+	{
+		const dtMeshTile* pTile = &pNavMesh->m_tiles[i];
+
+		m_vTilePolyBase[i] = nPolys;
+		m_vTileEdgeBase[i] = nEdges;
+
+		if (pTile->header)
+		{
+			nPolys += pTile->header->polyCount;
+			nEdges += pTile->header->detailTriCount * 3;
+		}
+	}
+
+	m_vPolyDrawnFrame.assign(nPolys, 0);
+	m_iFrame = 0;
+
+	// same lossy key as we've always used, z is ignored when checking for duplicates
+	std::unordered_map<int64_t, uint32_t> mOutlineOwners;
+	m_vEdgeOwners.assign(nEdges, 0);
+
+	for (int i = 0; i < pNavMesh->m_maxTiles; ++i)
+	{
+		const dtMeshTile* pTile = &pNavMesh->m_tiles[i];
+
+		if (!pTile->header)
+			continue;
+
+		for (int j = 0; j < pTile->header->polyCount; j++)
+		{
+			const dtPoly* pPoly = &pTile->polys[j];
+			const uint32_t iPoly = m_vTilePolyBase[i] + j;
+
+			if (pPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+				continue;
+
+			const dtPolyDetail* pDetail = &pTile->detailMeshes[j];
+			for (int k = 0; k < pDetail->triCount; ++k)
+			{
+				const uint32_t iTri = pDetail->triBase + k;
+				if (iTri >= (uint32_t)pTile->header->detailTriCount)
+					break;
+
+				Vector3 v[3];
+				GetDetailTriVerts(pTile, pPoly, pDetail, k, v);
+
+				for (int l = 0; l < 3; ++l)
+				{
+					const int64_t iOutline = _mm_extract_epi64(PackVerticesSIMD16(v[l], v[(l + 1) % 3]), 1);
+					m_vEdgeOwners[m_vTileEdgeBase[i] + iTri * 3 + l] = mOutlineOwners.try_emplace(iOutline, iPoly).first->second;
+				}
+			}
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: Draw navmesh polys using debug overlay
 // Input  : *pNavMesh
@@ -78,11 +203,16 @@ void CAI_Helper::DrawNavmeshPolys(dtNavMesh* pNavMesh)
 
 	const float fCamRadius = Cvar_navmesh_debug_camera_radius->GetFloat();
 	const bool bOptimize = Cvar_navmesh_debug_lossy_optimization->GetBool();
+	const bool bUseBVTree = Cvar_navmesh_debug_use_bvtree->GetBool();
 
-	// Used for lossy optimization ( z is ignored when checking for duplicates )
-	// [Fifty]: On a release build i gained around 12 fps on a 1050 ti
-	std::unordered_set<int64_t> sOutlines;
+	const Vector3 vQueryMins = vCamera - Vector3(fCamRadius);
+	const Vector3 vQueryMaxs = vCamera + Vector3(fCamRadius);
 
+	UpdateNavmeshCache(pNavMesh);
+	m_iFrame++;
+
+	// find everything we're going to draw first, so we know which outline owners are being drawn this frame
+	m_vVisiblePolys.clear();
 	for (int i = 0; i < pNavMesh->m_maxTiles; ++i)
 	{
 		const dtMeshTile* pTile = &pNavMesh->m_tiles[i];
@@ -90,9 +220,29 @@ void CAI_Helper::DrawNavmeshPolys(dtNavMesh* pNavMesh)
 		if (!pTile->header)
 			continue;
 
-		for (int j = 0; j < pTile->header->polyCount; j++)
+		const int nTilePolys = pTile->header->polyCount;
+		if (m_vQueryPolys.size() < (size_t)nTilePolys)
+			m_vQueryPolys.resize(nTilePolys);
+
+		int nPolys;
+		if (bUseBVTree)
 		{
-			const dtPoly* pPoly = &pTile->polys[j];
+			if (!NavMesh_TileOverlapsBox(pTile, vQueryMins, vQueryMaxs) || IsTileBehindPlane(pTile, CullPlane))
+				continue;
+
+			nPolys = NavMesh_QueryPolygonsInTile(pTile, vQueryMins, vQueryMaxs, m_vQueryPolys.data(), nTilePolys);
+		}
+		else
+		{
+			for (int j = 0; j < nTilePolys; j++)
+				m_vQueryPolys[j] = j;
+
+			nPolys = nTilePolys;
+		}
+
+		for (int j = 0; j < nPolys; j++)
+		{
+			const dtPoly* pPoly = &pTile->polys[m_vQueryPolys[j]];
 
 			if (vCamera.DistTo(pPoly->org) > fCamRadius)
 				continue;
@@ -100,50 +250,46 @@ void CAI_Helper::DrawNavmeshPolys(dtNavMesh* pNavMesh)
 			if (CullPlane.GetPointSide(pPoly->org) != SIDE_FRONT)
 				continue;
 
-			const unsigned int ip = (unsigned int)(pPoly - pTile->polys);
+			m_vPolyDrawnFrame[m_vTilePolyBase[i] + m_vQueryPolys[j]] = m_iFrame;
+			m_vVisiblePolys.emplace_back(i, m_vQueryPolys[j]);
+		}
+	}
 
-			if (pPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
-			{
-				const dtOffMeshConnection* pCon = &pTile->offMeshConnections[ip - pTile->header->offMeshBase];
-				RenderLine(pCon->origin, pCon->dest, Color(255, 250, 50, 255), true);
-			}
-			else
-			{
-				const dtPolyDetail* pDetail = &pTile->detailMeshes[ip];
+	for (const auto& [iTile, ip] : m_vVisiblePolys)
+	{
+		const dtMeshTile* pTile = &pNavMesh->m_tiles[iTile];
+		const dtPoly* pPoly = &pTile->polys[ip];
 
-				Vector3 v[3];
+		if (pPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
+		{
+			const dtOffMeshConnection* pCon = &pTile->offMeshConnections[ip - pTile->header->offMeshBase];
+			RenderLine(pCon->origin, pCon->dest, Color(255, 250, 50, 255), true);
+			continue;
+		}
 
-				for (int k = 0; k < pDetail->triCount; ++k)
+		const dtPolyDetail* pDetail = &pTile->detailMeshes[ip];
+		const uint32_t iPoly = m_vTilePolyBase[iTile] + ip;
+
+		Vector3 v[3];
+
+		for (int k = 0; k < pDetail->triCount; ++k)
+		{
+			GetDetailTriVerts(pTile, pPoly, pDetail, k, v);
+
+			RenderTriangle(v[0], v[1], v[2], Color(110, 200, 220, 160), true);
+
+			const uint32_t iTri = pDetail->triBase + k;
+			for (int l = 0; l < 3; ++l)
+			{
+				// draw the outline if it's ours, or if whoever owns it isn't being drawn
+				if (bOptimize && iTri < (uint32_t)pTile->header->detailTriCount)
 				{
-					const unsigned char* t = &pTile->detailTris[(pDetail->triBase + k) * 4];
-					for (int l = 0; l < 3; ++l)
-					{
-						if (t[l] < pPoly->vertCount)
-						{
-							float* pfVerts = &pTile->verts[pPoly->verts[t[l]] * 3];
-							v[l] = Vector3(pfVerts[0], pfVerts[1], pfVerts[2]);
-						}
-						else
-						{
-							float* pfVerts = &pTile->detailVerts[(pDetail->vertBase + t[l] - pPoly->vertCount) * 3];
-							v[l] = Vector3(pfVerts[0], pfVerts[1], pfVerts[2]);
-						}
-					}
-
-					RenderTriangle(v[0], v[1], v[2], Color(110, 200, 220, 160), true);
-
-					auto r = sOutlines.insert(_mm_extract_epi64(PackVerticesSIMD16(v[0], v[1]), 1));
-					if (r.second || !bOptimize)
-						RenderLine(v[0], v[1], Color(0, 0, 150), true);
-
-					r = sOutlines.insert(_mm_extract_epi64(PackVerticesSIMD16(v[1], v[2]), 1));
-					if (r.second || !bOptimize)
-						RenderLine(v[1], v[2], Color(0, 0, 150), true);
-
-					r = sOutlines.insert(_mm_extract_epi64(PackVerticesSIMD16(v[2], v[0]), 1));
-					if (r.second || !bOptimize)
-						RenderLine(v[2], v[0], Color(0, 0, 150), true);
+					const uint32_t iOwner = m_vEdgeOwners[m_vTileEdgeBase[iTile] + iTri * 3 + l];
+					if (iOwner != iPoly && m_vPolyDrawnFrame[iOwner] == m_iFrame)
+						continue;
 				}
+
+				RenderLine(v[l], v[(l + 1) % 3], Color(0, 0, 150), true);
 			}
 		}
 	}
@@ -151,9 +297,16 @@ void CAI_Helper::DrawNavmeshPolys(dtNavMesh* pNavMesh)
 
 ON_DLL_LOAD("server.dll", ServerAIHelper, (CModule module))
 {
+	g_pAIHelper = new CAI_Helper;
+
 	Cvar_navmesh_debug_hull = new ConVar("navmesh_debug_hull", "0", FCVAR_RELEASE, "0 = NONE");
 	Cvar_navmesh_debug_camera_radius =
 		new ConVar("navmesh_debug_camera_radius", "1000", FCVAR_RELEASE, "Radius in which to draw navmeshes");
 	Cvar_navmesh_debug_lossy_optimization =
 		new ConVar("navmesh_debug_lossy_optimization", "1", FCVAR_RELEASE, "Whether to enable lossy navmesh debug draw optimizations");
+	Cvar_navmesh_debug_use_bvtree = new ConVar(
+		"navmesh_debug_use_bvtree",
+		"1",
+		FCVAR_RELEASE,
+		"Whether to use navmesh tile bounds and bounding volume trees to find polys to draw");
 }
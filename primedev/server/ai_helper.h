@@ -2,12 +2,33 @@
 
 #include "server/ai_navmesh.h"
 
+#include <vector>
+
 dtNavMesh* GetNavMeshForHull(int nHull);
 
 class CAI_Helper
 {
 public:
 	void DrawNavmeshPolys(dtNavMesh* pNavMesh = nullptr);
+
+private:
+	// rebuilds everything below if the navmesh has been (re)loaded since we last drew it
+	void UpdateNavmeshCache(const dtNavMesh* pNavMesh);
+
+	const dtNavMesh* m_pCachedNavMesh = nullptr;
+	uint64_t m_iCachedNavMeshSignature = 0;
+
+	// offsets of each tile's polys in m_vPolyDrawnFrame, and its detail triangle edges in m_vEdgeOwners
+	std::vector<uint32_t> m_vTilePolyBase;
+	std::vector<uint32_t> m_vTileEdgeBase;
+	// for every detail triangle edge, the first poly with the same outline, so shared outlines are only drawn once
+	std::vector<uint32_t> m_vEdgeOwners;
+	// the frame each poly was last drawn on, an edge whose owner wasn't drawn this frame is drawn by whoever else has it
+	std::vector<uint32_t> m_vPolyDrawnFrame;
+	uint32_t m_iFrame = 0;
+
+	std::vector<int> m_vQueryPolys;
+	std::vector<std::pair<int, int>> m_vVisiblePolys; // tile, poly
 };
 
 inline CAI_Helper* g_pAIHelper = nullptr;
@@ -1,5 +1,79 @@
 #include "ai_navmesh.h"
 
+#include <algorithm>
+
+bool NavMesh_TileOverlapsBox(const dtMeshTile* pTile, const Vector3& vMins, const Vector3& vMaxs)
+{
+	const dtMeshHeader* pHeader = pTile->header;
+
+	return pHeader->bmin[0] <= vMaxs.x && pHeader->bmax[0] >= vMins.x && pHeader->bmin[1] <= vMaxs.y && pHeader->bmax[1] >= vMins.y &&
+		   pHeader->bmin[2] <= vMaxs.z && pHeader->bmax[2] >= vMins.z;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Walks a tile's bounding volume tree for polys that may overlap a box
+//          the tree is stored depth first, every node is followed by its children, and a node that isn't a leaf
+//          stores how many nodes to skip to get past its subtree as a negative index
+// Input  : *pTile -
+//          &vMins -
+//          &vMaxs -
+//          *pPolys - receives the poly indices, relative to the tile
+//          nMaxPolys - size of pPolys
+// Output : number of polys written to pPolys
+//-----------------------------------------------------------------------------
+int NavMesh_QueryPolygonsInTile(const dtMeshTile* pTile, const Vector3& vMins, const Vector3& vMaxs, int* pPolys, int nMaxPolys)
+{
+	const dtMeshHeader* pHeader = pTile->header;
+
+	// off-mesh connections always come after the ground polys
+	const int nGroundPolys = std::clamp(pHeader->offMeshBase, 0, pHeader->polyCount);
+	int n = 0;
+
+	if (pTile->bvTree && pHeader->bvNodeCount > 0)
+	{
+		const float flQueryMins[3] = {vMins.x, vMins.y, vMins.z};
+		const float flQueryMaxs[3] = {vMaxs.x, vMaxs.y, vMaxs.z};
+
+		// clamp the query box to the tile, then quantize it the same way the tree was, rounding outwards
+		unsigned short iQuantMins[3];
+		unsigned short iQuantMaxs[3];
+		for (int i = 0; i < 3; i++)
+		{
+			const float flMin = std::clamp(flQueryMins[i], pHeader->bmin[i], pHeader->bmax[i]) - pHeader->bmin[i];
+			const float flMax = std::clamp(flQueryMaxs[i], pHeader->bmin[i], pHeader->bmax[i]) - pHeader->bmin[i];
+			iQuantMins[i] = (unsigned short)(pHeader->bvQuantFactor * flMin) & 0xFFFE;
+			iQuantMaxs[i] = (unsigned short)(pHeader->bvQuantFactor * flMax + 1) | 1;
+		}
+
+		const dtBVNode* pNode = pTile->bvTree;
+		const dtBVNode* pEnd = pTile->bvTree + pHeader->bvNodeCount;
+		while (pNode < pEnd)
+		{
+			const bool bOverlap = iQuantMins[0] <= pNode->bmax[0] && iQuantMaxs[0] >= pNode->bmin[0] && iQuantMins[1] <= pNode->bmax[1] &&
+								  iQuantMaxs[1] >= pNode->bmin[1] && iQuantMins[2] <= pNode->bmax[2] && iQuantMaxs[2] >= pNode->bmin[2];
+			const bool bLeaf = pNode->i >= 0;
+
+			if (bLeaf && bOverlap && pNode->i < nGroundPolys && n < nMaxPolys)
+				pPolys[n++] = pNode->i;
+
+			if (bOverlap || bLeaf)
+				pNode++;
+			else
+				pNode -= pNode->i;
+		}
+	}
+	else
+	{
+		for (int i = 0; i < nGroundPolys && n < nMaxPolys; i++)
+			pPolys[n++] = i;
+	}
+
+	for (int i = nGroundPolys; i < pHeader->polyCount && n < nMaxPolys; i++)
+		pPolys[n++] = i;
+
+	return n;
+}
+
 ON_DLL_LOAD("server.dll", ServerAiNavMesh, (CModule module))
 {
 	g_pNavMesh = module.Offset(0x105F5D0).RCast<dtNavMesh**>();
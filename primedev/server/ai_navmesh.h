@@ -246,3 +246,10 @@ struct dtBVNode
 };
 
 inline dtNavMesh** g_pNavMesh = nullptr;
+
+// whether a tile's bounds overlap the box [vMins, vMaxs]
+bool NavMesh_TileOverlapsBox(const dtMeshTile* pTile, const Vector3& vMins, const Vector3& vMaxs);
+// collects the indices of polys in a tile whose bounds may overlap the box [vMins, vMaxs], the same way dtNavMeshQuery::queryPolygonsInTile
+// does, falling back to every poly if the tile has no bounding volume tree. off-mesh connections aren't in the tree, so they're always
+// returned. returns the number of indices written to pPolys
+int NavMesh_QueryPolygonsInTile(const dtMeshTile* pTile, const Vector3& vMins, const Vector3& vMaxs, int* pPolys, int nMaxPolys);
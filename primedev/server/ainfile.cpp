@@ -0,0 +1,348 @@
+#include "ainfile.h"
+#include "spdlog/fmt/fmt.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_set>
+
+// appends raw values to a buffer, everything in an ain file is little endian and packed so this is all we need
+class AinBufferWriter
+{
+private:
+	std::vector<char>& m_Buffer;
+
+public:
+	AinBufferWriter(std::vector<char>& buffer)
+		: m_Buffer(buffer)
+	{
+	}
+
+	size_t Tell() const { return m_Buffer.size(); }
+
+	void WriteBytes(const void* pData, size_t size)
+	{
+		const char* pBytes = (const char*)pData;
+		m_Buffer.insert(m_Buffer.end(), pBytes, pBytes + size);
+	}
+
+	template <typename T> void Write(const T& value) { WriteBytes(&value, sizeof(T)); }
+	template <typename T> void WriteArray(const std::vector<T>& values) { WriteBytes(values.data(), values.size() * sizeof(T)); }
+};
+
+// reads raw values out of a buffer, failing rather than reading past the end of it
+class AinBufferReader
+{
+private:
+	const char* m_pData;
+	size_t m_Size;
+	size_t m_Offset = 0;
+
+public:
+	AinBufferReader(const char* pData, size_t size)
+		: m_pData(pData)
+		, m_Size(size)
+	{
+	}
+
+	size_t Tell() const { return m_Offset; }
+	size_t Remaining() const { return m_Size - m_Offset; }
+
+	bool ReadBytes(void* pData, size_t size)
+	{
+		if (Remaining() < size)
+			return false;
+
+		if (!size)
+			return true;
+
+		memcpy(pData, m_pData + m_Offset, size);
+		m_Offset += size;
+		return true;
+	}
+
+	template <typename T> bool Read(T& value) { return ReadBytes(&value, sizeof(T)); }
+
+	// count comes straight from the file, so check it against what's left before allocating anything
+	template <typename T> bool ReadArray(std::vector<T>& values, int count)
+	{
+		if (count < 0 || Remaining() / sizeof(T) < (size_t)count)
+			return false;
+
+		values.resize(count);
+		return ReadBytes(values.data(), count * sizeof(T));
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Serializes an ain file into one contiguous buffer
+// Input  : ain - File to write
+//          buffer - Replaced with the file's bytes
+//          *pLayout - Optional, filled with the offset of each block
+//-----------------------------------------------------------------------------
+void WriteAinFile(const AinFile_t& ain, std::vector<char>& buffer, AinFileLayout_t* pLayout)
+{
+	// work out the size up front so the buffer is only allocated once, header ints and counts first
+	size_t size = sizeof(int) * 10 + sizeof(ain.traverseNodeCount) + sizeof(ain.unkHullBlock);
+	size += ain.nodes.size() * sizeof(CAI_NodeDisk);
+	size += ain.links.size() * sizeof(CAI_NodeLinkDisk);
+	size += ain.unkNodeBlock.size() * sizeof(uint32_t);
+	size += ain.unkLinks.size() * sizeof(UnkLinkStruct1);
+	size += ain.scriptNodes.size() * sizeof(CAI_ScriptNode);
+	size += ain.hints.size() * sizeof(short);
+
+	for (const AinUnkNode_t& unkNode : ain.unkNodes)
+		size += 26 + (unkNode.unk2.size() + unkNode.unk3.size()) * sizeof(short);
+
+	buffer.clear();
+	buffer.reserve(size);
+
+	AinFileLayout_t layout;
+	AinBufferWriter writer(buffer);
+
+	writer.Write(ain.version);
+	writer.Write(ain.mapVersion);
+	writer.Write(ain.crc);
+
+	// path nodes
+	layout.nodes = writer.Tell();
+	writer.Write((int)ain.nodes.size());
+	writer.WriteArray(ain.nodes);
+
+	layout.links = writer.Tell();
+	writer.Write((int)ain.links.size());
+	writer.WriteArray(ain.links);
+
+	layout.unkNodeBlock = writer.Tell();
+	writer.WriteArray(ain.unkNodeBlock);
+
+	layout.traverseNodes = writer.Tell();
+	writer.Write(ain.traverseNodeCount);
+
+	layout.unkHullBlock = writer.Tell();
+	writer.WriteBytes(ain.unkHullBlock, sizeof(ain.unkHullBlock));
+
+	layout.unkNodes = writer.Tell();
+	writer.Write((int)ain.unkNodes.size());
+	for (const AinUnkNode_t& unkNode : ain.unkNodes)
+	{
+		writer.Write(unkNode.index);
+		writer.Write(unkNode.unk1);
+		writer.Write(unkNode.x);
+		writer.Write(unkNode.y);
+		writer.Write(unkNode.z);
+
+		writer.Write((int)unkNode.unk2.size());
+		writer.WriteArray(unkNode.unk2);
+		writer.Write((int)unkNode.unk3.size());
+		writer.WriteArray(unkNode.unk3);
+
+		writer.Write(unkNode.unk5);
+	}
+
+	layout.unkLinks = writer.Tell();
+	writer.Write((int)ain.unkLinks.size());
+	writer.WriteArray(ain.unkLinks);
+
+	writer.Write(ain.unk8);
+
+	// tf2-exclusive stuff past this point, i.e. ain v57 only
+	layout.scriptNodes = writer.Tell();
+	writer.Write((int)ain.scriptNodes.size());
+	writer.WriteArray(ain.scriptNodes);
+
+	layout.hints = writer.Tell();
+	writer.Write((int)ain.hints.size());
+	writer.WriteArray(ain.hints);
+
+	layout.size = writer.Tell();
+	if (pLayout)
+		*pLayout = layout;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Parses an ain file, checking every count against the data actually there
+// Input  : *pData, size - Whole file
+//          ain - Filled with the file's contents
+//          error - Set to what was wrong with the file on failure
+// Output : true if the file was read completely with nothing left over
+//-----------------------------------------------------------------------------
+bool ReadAinFile(const char* pData, size_t size, AinFile_t& ain, std::string& error)
+{
+	AinBufferReader reader(pData, size);
+	ain = AinFile_t();
+
+	auto fnFail = [&](const char* pWhat)
+	{
+		error = fmt::format("failed to read {} at {:x}, file is {:x} bytes", pWhat, reader.Tell(), size);
+		return false;
+	};
+
+	if (!reader.Read(ain.version) || !reader.Read(ain.mapVersion) || !reader.Read(ain.crc))
+		return fnFail("header");
+
+	if (ain.version != AINET_VERSION_NUMBER)
+	{
+		error = fmt::format("unsupported ainet version {}, expected {}", ain.version, AINET_VERSION_NUMBER);
+		return false;
+	}
+
+	int count;
+	if (!reader.Read(count) || !reader.ReadArray(ain.nodes, count))
+		return fnFail("nodes");
+
+	if (!reader.Read(count) || !reader.ReadArray(ain.links, count))
+		return fnFail("links");
+
+	if (!reader.ReadArray(ain.unkNodeBlock, (int)ain.nodes.size()))
+		return fnFail("unknown node block");
+
+	if (!reader.Read(ain.traverseNodeCount))
+		return fnFail("traverse node count");
+
+	if (ain.traverseNodeCount != 0)
+	{
+		error = fmt::format("file has {} traverse nodes, which we can't read", ain.traverseNodeCount);
+		return false;
+	}
+
+	if (!reader.ReadBytes(ain.unkHullBlock, sizeof(ain.unkHullBlock)))
+		return fnFail("unknown hull block");
+
+	if (!reader.Read(count) || count < 0)
+		return fnFail("unknown node struct count");
+
+	for (int i = 0; i < count; i++)
+	{
+		AinUnkNode_t unkNode;
+		if (!reader.Read(unkNode.index) || !reader.Read(unkNode.unk1) || !reader.Read(unkNode.x) || !reader.Read(unkNode.y) ||
+			!reader.Read(unkNode.z))
+			return fnFail("unknown node struct");
+
+		int unkCount;
+		if (!reader.Read(unkCount) || !reader.ReadArray(unkNode.unk2, unkCount) || !reader.Read(unkCount) ||
+			!reader.ReadArray(unkNode.unk3, unkCount) || !reader.Read(unkNode.unk5))
+			return fnFail("unknown node struct");
+
+		ain.unkNodes.push_back(std::move(unkNode));
+	}
+
+	if (!reader.Read(count) || !reader.ReadArray(ain.unkLinks, count))
+		return fnFail("unknown link structs");
+
+	if (!reader.Read(ain.unk8))
+		return fnFail("unknown int");
+
+	if (!reader.Read(count) || !reader.ReadArray(ain.scriptNodes, count))
+		return fnFail("script nodes");
+
+	if (!reader.Read(count) || !reader.ReadArray(ain.hints, count))
+		return fnFail("hints");
+
+	if (reader.Remaining())
+	{
+		error = fmt::format("{:x} unexpected bytes at the end of the file", reader.Remaining());
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Gathers structural stats about an ain file's node graph
+//-----------------------------------------------------------------------------
+AinFileStats_t GetAinFileStats(const AinFile_t& ain)
+{
+	AinFileStats_t stats;
+	stats.nodeCount = (int)ain.nodes.size();
+	stats.linkCount = (int)ain.links.size();
+	stats.unkNodeCount = (int)ain.unkNodes.size();
+	stats.unkLinkCount = (int)ain.unkLinks.size();
+	stats.scriptNodeCount = (int)ain.scriptNodes.size();
+	stats.hintCount = (int)ain.hints.size();
+
+	for (int i = 0; i < stats.nodeCount; i++)
+	{
+		const float pos[3] = {ain.nodes[i].x, ain.nodes[i].y, ain.nodes[i].z};
+		for (int j = 0; j < 3; j++)
+		{
+			stats.mins[j] = i ? std::min(stats.mins[j], pos[j]) : pos[j];
+			stats.maxs[j] = i ? std::max(stats.maxs[j], pos[j]) : pos[j];
+		}
+	}
+
+	std::vector<int> nodeLinks(stats.nodeCount);
+	std::unordered_set<uint32_t> seenLinks;
+	seenLinks.reserve(ain.links.size());
+
+	for (const CAI_NodeLinkDisk& link : ain.links)
+	{
+		if (link.srcId < 0 || link.srcId >= stats.nodeCount || link.destId < 0 || link.destId >= stats.nodeCount)
+		{
+			stats.badLinks++;
+			continue;
+		}
+
+		if (link.srcId == link.destId)
+			stats.selfLinks++;
+
+		// links are used in both directions, so a => b and b => a are the same link
+		const uint32_t linkKey = ((uint32_t)std::min(link.srcId, link.destId) << 16) | (uint16_t)std::max(link.srcId, link.destId);
+		if (!seenLinks.insert(linkKey).second)
+			stats.duplicateLinks++;
+
+		nodeLinks[link.srcId]++;
+		if (link.destId != link.srcId)
+			nodeLinks[link.destId]++;
+
+		// hulls come straight from the file, so don't trust them to be a valid bool
+		for (int i = 0; i < MAX_HULLS; i++)
+			if (((const char*)link.hulls)[i])
+				stats.linksPerHull[i]++;
+	}
+
+	for (int linkCount : nodeLinks)
+	{
+		if (!linkCount)
+			stats.isolatedNodes++;
+
+		stats.maxNodeLinks = std::max(stats.maxNodeLinks, linkCount);
+	}
+
+	return stats;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads an ain file, checks that it writes back out identically and that its graph makes sense
+// Input  : *pData, size - Whole file
+//          stats - Filled with the file's stats if it could be read
+//          error - Set to what was wrong with the file on failure
+// Output : true if the file is valid
+//-----------------------------------------------------------------------------
+bool ValidateAinFile(const char* pData, size_t size, AinFileStats_t& stats, std::string& error)
+{
+	AinFile_t ain;
+	if (!ReadAinFile(pData, size, ain, error))
+		return false;
+
+	stats = GetAinFileStats(ain);
+
+	// everything in the file should be accounted for, so writing what we read should give back exactly the same bytes
+	std::vector<char> rewritten;
+	WriteAinFile(ain, rewritten);
+	if (rewritten.size() != size || memcmp(rewritten.data(), pData, size))
+	{
+		const size_t compareSize = std::min(size, rewritten.size());
+		const size_t firstDifference = std::mismatch(pData, pData + compareSize, rewritten.data()).first - pData;
+
+		error = fmt::format("file doesn't round trip, rewritten file is {:x} bytes and differs at {:x}", rewritten.size(), firstDifference);
+		return false;
+	}
+
+	if (stats.badLinks)
+	{
+		error = fmt::format("{} links reference nodes that don't exist", stats.badLinks);
+		return false;
+	}
+
+	return true;
+}
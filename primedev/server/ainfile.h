@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// on-disk format of .ain files, kept free of anything game specific so files can be read and checked outside of the game
+
+const int AINET_VERSION_NUMBER = 57;
+const int AINET_SCRIPT_VERSION_NUMBER = 21;
+const int PLACEHOLDER_CRC = 0;
+const int MAX_HULLS = 5;
+
+#pragma pack(push, 1)
+struct CAI_NodeLinkDisk
+{
+	short srcId;
+	short destId;
+	char unk0;
+	bool hulls[MAX_HULLS];
+};
+#pragma pack(pop)
+
+// the way CAI_Nodes are represented in on-disk ain files
+#pragma pack(push, 1)
+struct CAI_NodeDisk
+{
+	float x;
+	float y;
+	float z;
+	float yaw;
+	float hulls[MAX_HULLS];
+
+	char unk0;
+	int unk1;
+	short unk2[MAX_HULLS];
+	char unk3[MAX_HULLS];
+	short unk4;
+	short unk5;
+	char unk6[8];
+}; // total size of 68 bytes
+#pragma pack(pop)
+
+#pragma pack(push, 1)
+struct UnkLinkStruct1
+{
+	short unk0;
+	short unk1;
+	int unk2;
+	char unk3;
+	char unk4;
+	char unk5;
+};
+#pragma pack(pop)
+
+#pragma pack(push, 1)
+struct CAI_ScriptNode
+{
+	float x;
+	float y;
+	float z;
+	uint64_t scriptdata;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(CAI_NodeDisk) == 68);
+static_assert(sizeof(CAI_NodeLinkDisk) == 10);
+static_assert(sizeof(UnkLinkStruct1) == 11);
+static_assert(sizeof(CAI_ScriptNode) == 20);
+
+// unknown node-related struct, variable size on disk so it doesn't have a packed disk struct
+struct AinUnkNode_t
+{
+	int index;
+	char unk1;
+	float x;
+	float y;
+	float z;
+	std::vector<short> unk2;
+	std::vector<short> unk3;
+	char unk5;
+};
+
+// everything in an ain file, in the order it's written
+struct AinFile_t
+{
+	int version = AINET_VERSION_NUMBER;
+	int mapVersion = 0;
+	int crc = PLACEHOLDER_CRC;
+
+	std::vector<CAI_NodeDisk> nodes;
+	std::vector<CAI_NodeLinkDisk> links;
+	// should just be 1 int per node
+	std::vector<uint32_t> unkNodeBlock;
+	// always 0 in tf2 ains, we don't know the format of traverse nodes so can't read or write anything else
+	short traverseNodeCount = 0;
+	char unkHullBlock[MAX_HULLS * 8] {};
+	std::vector<AinUnkNode_t> unkNodes;
+	std::vector<UnkLinkStruct1> unkLinks;
+	int unk8 = 0;
+	std::vector<CAI_ScriptNode> scriptNodes;
+	std::vector<short> hints;
+};
+
+// where each block of the file starts, mostly for debugging the format
+struct AinFileLayout_t
+{
+	size_t nodes;
+	size_t links;
+	size_t unkNodeBlock;
+	size_t traverseNodes;
+	size_t unkHullBlock;
+	size_t unkNodes;
+	size_t unkLinks;
+	size_t scriptNodes;
+	size_t hints;
+	size_t size;
+};
+
+struct AinFileStats_t
+{
+	int nodeCount = 0;
+	int linkCount = 0;
+	int linksPerHull[MAX_HULLS] {};
+
+	// nodes without any links
+	int isolatedNodes = 0;
+	int maxNodeLinks = 0;
+	// links from a node to itself, and links that appear more than once in either direction
+	int selfLinks = 0;
+	int duplicateLinks = 0;
+	// links referencing nodes that don't exist, any of these make the file invalid
+	int badLinks = 0;
+
+	float mins[3] {};
+	float maxs[3] {};
+
+	int unkNodeCount = 0;
+	int unkLinkCount = 0;
+	int scriptNodeCount = 0;
+	int hintCount = 0;
+};
+
+void WriteAinFile(const AinFile_t& ain, std::vector<char>& buffer, AinFileLayout_t* pLayout = nullptr);
+
+bool ReadAinFile(const char* pData, size_t size, AinFile_t& ain, std::string& error);
+
+AinFileStats_t GetAinFileStats(const AinFile_t& ain);
+
+bool ValidateAinFile(const char* pData, size_t size, AinFileStats_t& stats, std::string& error);
@@ -23,30 +23,199 @@
 ServerAuthenticationManager* g_pServerAuthentication;
 CBaseServer__RejectConnectionType CBaseServer__RejectConnection;
 
-void ServerAuthenticationManager::AddRemotePlayer(std::string token, uint64_t uid, std::string username, std::string pdata)
+RemoteAuthPdataPool::~RemoteAuthPdataPool()
 {
-	std::string uidS = std::to_string(uid);
+	for (std::vector<char*>& vFreeBuffers : m_vFreeBuffers)
+		for (char* pBuffer : vFreeBuffers)
+			delete[] pBuffer;
+}
+
+char* RemoteAuthPdataPool::Alloc(size_t iSize, size_t& iCapacity)
+{
+	size_t iSizeClass = 0;
+	while ((size_t(1) << (SMALLEST_SIZE_CLASS_BITS + iSizeClass)) < iSize)
+		iSizeClass++;
+
+	assert(iSizeClass < NUM_SIZE_CLASSES); // RemoteAuthStore::Add rejects anything bigger than PERSISTENCE_MAX_SIZE
+	iCapacity = size_t(1) << (SMALLEST_SIZE_CLASS_BITS + iSizeClass);
+
+	std::vector<char*>& vFreeBuffers = m_vFreeBuffers[iSizeClass];
+	if (vFreeBuffers.empty())
+		return new char[iCapacity];
+
+	char* pBuffer = vFreeBuffers.back();
+	vFreeBuffers.pop_back();
+	return pBuffer;
+}
+
+void RemoteAuthPdataPool::Free(char* pBuffer, size_t iCapacity)
+{
+	size_t iSizeClass = 0;
+	while ((size_t(1) << (SMALLEST_SIZE_CLASS_BITS + iSizeClass)) < iCapacity)
+		iSizeClass++;
+
+	// keep a few around for the next joins, anything past that was probably a burst we don't need to keep memory around for
+	std::vector<char*>& vFreeBuffers = m_vFreeBuffers[iSizeClass];
+	if (vFreeBuffers.size() < MAX_FREE_PER_SIZE_CLASS)
+		vFreeBuffers.push_back(pBuffer);
+	else
+		delete[] pBuffer;
+}
+
+RemoteAuthStore::~RemoteAuthStore()
+{
+	Clear();
+}
+
+RemoteAuthAddResult RemoteAuthStore::Add(
+	const std::string& sToken, const char* pUid, const char* pUsername, const char* pPdata, size_t iPdataSize, double flExpiryTime)
+{
+	if (iPdataSize > PERSISTENCE_MAX_SIZE)
+		return RemoteAuthAddResult::PdataTooLarge;
+
+	// readding a token replaces it
+	auto existing = m_AuthData.find(sToken);
+	if (existing != m_AuthData.end())
+		Remove(existing);
+
+	if (m_iPendingPdataBytes + iPdataSize > MAX_PENDING_PDATA_BYTES)
+		return RemoteAuthAddResult::TooMuchPendingPdata;
 
 	RemoteAuthData newAuthData {};
-	strncpy_s(newAuthData.uid, sizeof(newAuthData.uid), uidS.c_str(), uidS.length());
-	strncpy_s(newAuthData.username, sizeof(newAuthData.username), username.c_str(), username.length());
-	newAuthData.pdata = new char[pdata.length()];
-	newAuthData.pdataSize = pdata.length();
-	memcpy(newAuthData.pdata, pdata.c_str(), newAuthData.pdataSize);
+	strncpy_s(newAuthData.uid, sizeof(newAuthData.uid), pUid, sizeof(newAuthData.uid) - 1);
+	strncpy_s(newAuthData.username, sizeof(newAuthData.username), pUsername, sizeof(newAuthData.username) - 1);
+	newAuthData.pdata = m_PdataPool.Alloc(iPdataSize, newAuthData.pdataCapacity);
+	newAuthData.pdataSize = iPdataSize;
+	memcpy(newAuthData.pdata, pPdata, iPdataSize);
+	newAuthData.expiryTime = flExpiryTime;
+
+	m_iPendingPdataBytes += iPdataSize;
+	m_UidIndex.emplace(newAuthData.uid, sToken);
+	m_AuthData.emplace(sToken, newAuthData);
+	return RemoteAuthAddResult::Success;
+}
+
+RemoteAuthData* RemoteAuthStore::Find(const char* pToken)
+{
+	auto authData = m_AuthData.find(pToken);
+	return authData != m_AuthData.end() ? &authData->second : nullptr;
+}
 
+bool RemoteAuthStore::RemoveByUid(const char* pUid)
+{
+	auto uidEntry = m_UidIndex.find(pUid);
+	if (uidEntry == m_UidIndex.end())
+		return false;
+
+	Remove(m_AuthData.find(uidEntry->second));
+	return true;
+}
+
+void RemoteAuthStore::Clear()
+{
+	for (auto& authData : m_AuthData)
+		m_PdataPool.Free(authData.second.pdata, authData.second.pdataCapacity);
+
+	m_AuthData.clear();
+	m_UidIndex.clear();
+	m_iPendingPdataBytes = 0;
+}
+
+size_t RemoteAuthStore::RemoveExpired(double flTime)
+{
+	size_t iRemoved = 0;
+	for (auto it = m_AuthData.begin(); it != m_AuthData.end();)
+	{
+		auto next = std::next(it);
+		if (!it->second.claimed && it->second.expiryTime && it->second.expiryTime < flTime)
+		{
+			Remove(it);
+			iRemoved++;
+		}
+
+		it = next;
+	}
+
+	return iRemoved;
+}
+
+size_t RemoteAuthStore::GetCount() const
+{
+	return m_AuthData.size();
+}
+
+const std::string* RemoteAuthStore::GetAnyToken() const
+{
+	return m_AuthData.empty() ? nullptr : &m_AuthData.begin()->first;
+}
+
+void RemoteAuthStore::Remove(std::unordered_map<std::string, RemoteAuthData>::iterator it)
+{
+	auto uidEntries = m_UidIndex.equal_range(it->second.uid);
+	for (auto uidEntry = uidEntries.first; uidEntry != uidEntries.second; uidEntry++)
+	{
+		if (uidEntry->second == it->first)
+		{
+			m_UidIndex.erase(uidEntry);
+			break;
+		}
+	}
+
+	m_PdataPool.Free(it->second.pdata, it->second.pdataCapacity);
+	m_iPendingPdataBytes -= it->second.pdataSize;
+	m_AuthData.erase(it);
+}
+
+RemoteAuthAddResult ServerAuthenticationManager::AddRemotePlayer(std::string token, uint64_t uid, std::string username, std::string pdata)
+{
+	std::string uidS = std::to_string(uid);
+	double flExpiryTime = Plat_FloatTime() + std::max(Cvar_ns_auth_pending_timeout->GetFloat(), 1.0f);
+
+	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
+	return m_RemoteAuthenticationData.Add(token, uidS.c_str(), username.c_str(), pdata.c_str(), pdata.length(), flExpiryTime);
+}
+
+bool ServerAuthenticationManager::SetOwnRemoteAuthData(const std::string& sToken, const char* pUid, const std::string& sPdata)
+{
 	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
-	m_RemoteAuthenticationData[token] = newAuthData;
+	m_RemoteAuthenticationData.Clear();
+
+	// we may sit in menus for a while before using this, so it never expires
+	return m_RemoteAuthenticationData.Add(sToken, pUid, "", sPdata.c_str(), sPdata.length(), 0.0) == RemoteAuthAddResult::Success;
+}
+
+std::string ServerAuthenticationManager::GetAnyRemoteAuthToken()
+{
+	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
+
+	const std::string* pToken = m_RemoteAuthenticationData.GetAnyToken();
+	return pToken ? *pToken : "";
+}
+
+void ServerAuthenticationManager::RunFrame()
+{
+	// if we're keeping auth data forever, it shouldn't time out either
+	if (!Cvar_ns_erase_auth_info->GetBool())
+		return;
+
+	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
+	if (size_t iExpired = m_RemoteAuthenticationData.RemoveExpired(Plat_FloatTime()))
+		spdlog::info("Removed {} pending authentications that were never used", iExpired);
 }
 
 void ServerAuthenticationManager::AddPlayer(CBaseClient* pPlayer, const char* pToken)
 {
 	PlayerAuthenticationData additionalData;
 
-	auto remoteAuthData = m_RemoteAuthenticationData.find(pToken);
-	if (remoteAuthData != m_RemoteAuthenticationData.end())
-		additionalData.pdataSize = remoteAuthData->second.pdataSize;
-	else
-		additionalData.pdataSize = PERSISTENCE_MAX_SIZE;
+	{
+		std::lock_guard<std::mutex> guard(m_AuthDataMutex);
+
+		RemoteAuthData* pRemoteAuthData = m_RemoteAuthenticationData.Find(pToken);
+		if (pRemoteAuthData)
+			additionalData.pdataSize = pRemoteAuthData->pdataSize;
+		else
+			additionalData.pdataSize = PERSISTENCE_MAX_SIZE;
+	}
 
 	additionalData.usingLocalPdata = pPlayer->m_iPersistenceReady == ePersistenceReady::READY_INSECURE;
 
@@ -65,9 +234,9 @@ bool ServerAuthenticationManager::VerifyPlayerName(const char* pAuthToken, const
 
 	// always use name from masterserver if available
 	// use of strncpy_s here should verify that this is always nullterminated within valid buffer size
-	auto authData = m_RemoteAuthenticationData.find(pAuthToken);
-	if (authData != m_RemoteAuthenticationData.end() && *authData->second.username)
-		strncpy_s(pOutVerifiedName, 64, authData->second.username, 63);
+	RemoteAuthData* pAuthData = m_RemoteAuthenticationData.Find(pAuthToken);
+	if (pAuthData && *pAuthData->username)
+		strncpy_s(pOutVerifiedName, 64, pAuthData->username, 63);
 	else
 		strncpy_s(pOutVerifiedName, 64, pName, 63);
 
@@ -117,8 +286,8 @@ bool ServerAuthenticationManager::CheckAuthentication(CBaseClient* pPlayer, uint
 		return false;
 
 	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
-	auto authData = m_RemoteAuthenticationData.find(pAuthToken);
-	if (authData != m_RemoteAuthenticationData.end() && !strcmp(sUid.c_str(), authData->second.uid))
+	RemoteAuthData* pAuthData = m_RemoteAuthenticationData.Find(pAuthToken);
+	if (pAuthData && !strcmp(sUid.c_str(), pAuthData->uid))
 		return true;
 
 	return false;
@@ -136,16 +305,22 @@ void ServerAuthenticationManager::AuthenticatePlayer(CBaseClient* pPlayer, uint6
 	strcpy(pPlayer->m_UID, sUid.c_str());
 
 	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
-	auto authData = m_RemoteAuthenticationData.find(pAuthToken);
-	if (authData != m_RemoteAuthenticationData.end())
+	RemoteAuthData* pAuthData = m_RemoteAuthenticationData.Find(pAuthToken);
+	if (pAuthData)
 	{
 		// if we're resetting let script handle the reset with InitPersistentData() on connect
 		if (!m_bForceResetLocalPlayerPersistence || strcmp(sUid.c_str(), g_pLocalPlayerUserID))
 		{
 			// copy pdata into buffer
-			memcpy(pPlayer->m_PersistenceBuffer, authData->second.pdata, authData->second.pdataSize);
+			memcpy(pPlayer->m_PersistenceBuffer, pAuthData->pdata, pAuthData->pdataSize);
 		}
 
+		// this is what the master server has for them, so their first write can be sent as a delta against it
+		g_pMasterServerManager->m_PersistenceWriteQueue.SetDeltaBase(sUid.c_str(), pAuthData->pdata, pAuthData->pdataSize);
+
+		// the player is connecting with this now, so keep it until they've joined rather than expiring it
+		pAuthData->claimed = true;
+
 		// set persistent data as ready
 		pPlayer->m_iPersistenceReady = ePersistenceReady::READY_REMOTE;
 	}
@@ -168,21 +343,8 @@ bool ServerAuthenticationManager::RemovePlayerAuthData(CBaseClient* pPlayer)
 		return false;
 
 	// we don't have our auth token at this point, so lookup authdata by uid
-	for (auto& auth : m_RemoteAuthenticationData)
-	{
-		if (!strcmp(pPlayer->m_UID, auth.second.uid))
-		{
-			// pretty sure this is fine, since we don't iterate after the erase
-			// i think if we iterated after it'd be undefined behaviour tho
-			std::lock_guard<std::mutex> guard(m_AuthDataMutex);
-
-			delete[] auth.second.pdata;
-			m_RemoteAuthenticationData.erase(auth.first);
-			return true;
-		}
-	}
-
-	return false;
+	std::lock_guard<std::mutex> guard(m_AuthDataMutex);
+	return m_RemoteAuthenticationData.RemoveByUid(pPlayer->m_UID);
 }
 
 void ServerAuthenticationManager::WritePersistentData(CBaseClient* pPlayer)
@@ -378,6 +540,11 @@ ON_DLL_LOAD_RELIESON("engine.dll", ServerAuthentication, (ConCommand, ConVar), (
 		"0",
 		FCVAR_GAMEDLL,
 		"Whether the pdata of unauthenticated clients will be written to disk when changed");
+	g_pServerAuthentication->Cvar_ns_auth_pending_timeout = new ConVar(
+		"ns_auth_pending_timeout",
+		"60",
+		FCVAR_GAMEDLL,
+		"How many seconds auth data from the masterserver is kept for if the player never connects with it");
 
 	RegisterConCommand(
 		"ns_resetpersistence", ConCommand_ns_resetpersistence, "resets your pdata when you next enter the lobby", FCVAR_NONE);
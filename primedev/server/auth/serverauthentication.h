@@ -2,6 +2,7 @@
 #include "core/convar/convar.h"
 #include "engine/r2engine.h"
 #include <unordered_map>
+#include <vector>
 #include <string>
 
 struct RemoteAuthData
@@ -9,11 +10,80 @@ struct RemoteAuthData
 	char uid[33];
 	char username[64];
 
-	// pdata
+	// pdata, buffer is owned by the store's pool
 	char* pdata;
 	size_t pdataSize;
+	size_t pdataCapacity;
+
+	double expiryTime; // 0 if this never expires
+	bool claimed; // a client has connected with this, it stays around until they've fully joined
+};
+
+enum class RemoteAuthAddResult
+{
+	Success,
+	// the pdata is bigger than PERSISTENCE_MAX_SIZE
+	PdataTooLarge,
+	// adding it would go over RemoteAuthStore::MAX_PENDING_PDATA_BYTES
+	TooMuchPendingPdata,
 };
 
+//-----------------------------------------------------------------------------
+// Purpose: Size classed free lists for pdata buffers, so joins reuse buffers rather than allocating new ones
+//-----------------------------------------------------------------------------
+class RemoteAuthPdataPool
+{
+public:
+	static constexpr size_t SMALLEST_SIZE_CLASS_BITS = 12; // 4kb
+	static constexpr size_t NUM_SIZE_CLASSES = 5; // 4kb - 64kb
+	static constexpr size_t MAX_FREE_PER_SIZE_CLASS = 8;
+
+	static_assert((1 << (SMALLEST_SIZE_CLASS_BITS + NUM_SIZE_CLASSES - 1)) >= PERSISTENCE_MAX_SIZE);
+
+private:
+	std::vector<char*> m_vFreeBuffers[NUM_SIZE_CLASSES];
+
+public:
+	~RemoteAuthPdataPool();
+
+	char* Alloc(size_t iSize, size_t& iCapacity);
+	void Free(char* pBuffer, size_t iCapacity);
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Pending remote auths, indexed by both auth token and uid
+//          not thread safe by itself, callers hold ServerAuthenticationManager::m_AuthDataMutex
+//-----------------------------------------------------------------------------
+class RemoteAuthStore
+{
+public:
+	// upper bound on pdata held for auths, so the masterserver can't make us hold on to an unbounded amount of it
+	static constexpr size_t MAX_PENDING_PDATA_BYTES = 8 * 1024 * 1024;
+
+private:
+	std::unordered_map<std::string, RemoteAuthData> m_AuthData;
+	std::unordered_multimap<std::string, std::string> m_UidIndex; // uid => token
+	RemoteAuthPdataPool m_PdataPool;
+	size_t m_iPendingPdataBytes = 0;
+
+public:
+	~RemoteAuthStore();
+
+	RemoteAuthAddResult Add(
+		const std::string& sToken, const char* pUid, const char* pUsername, const char* pPdata, size_t iPdataSize, double flExpiryTime);
+	RemoteAuthData* Find(const char* pToken);
+	bool RemoveByUid(const char* pUid);
+	void Clear();
+
+	// removes unclaimed auths that expired before flTime, returns how many were removed
+	size_t RemoveExpired(double flTime);
+
+	size_t GetCount() const;
+	const std::string* GetAnyToken() const;
+
+private:
+	void Remove(std::unordered_map<std::string, RemoteAuthData>::iterator it);
+};
 struct PlayerAuthenticationData
 {
 	bool usingLocalPdata;
@@ -30,9 +100,10 @@ public:
 	ConVar* Cvar_ns_erase_auth_info;
 	ConVar* Cvar_ns_auth_allow_insecure;
 	ConVar* Cvar_ns_auth_allow_insecure_write;
+	ConVar* Cvar_ns_auth_pending_timeout;
 
 	std::mutex m_AuthDataMutex;
-	std::unordered_map<std::string, RemoteAuthData> m_RemoteAuthenticationData;
+	RemoteAuthStore m_RemoteAuthenticationData;
 	std::unordered_map<CBaseClient*, PlayerAuthenticationData> m_PlayerAuthenticationData;
 
 	bool m_bAllowDuplicateAccounts = false;
@@ -41,7 +112,11 @@ public:
 	bool m_bStartingLocalSPGame = false;
 
 public:
-	void AddRemotePlayer(std::string token, uint64_t uid, std::string username, std::string pdata);
+	RemoteAuthAddResult AddRemotePlayer(std::string token, uint64_t uid, std::string username, std::string pdata);
+	// replaces all auth data with our own, for authenticating with our own local server
+	bool SetOwnRemoteAuthData(const std::string& sToken, const char* pUid, const std::string& sPdata);
+	std::string GetAnyRemoteAuthToken();
+	void RunFrame();
 
 	void AddPlayer(CBaseClient* pPlayer, const char* pAuthToken);
 	void RemovePlayer(CBaseClient* pPlayer);
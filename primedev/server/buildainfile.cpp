@@ -1,4 +1,7 @@
+#include "ainfile.h"
+#include "core/convar/concommand.h"
 #include "core/convar/convar.h"
+#include "core/tier0.h"
 #include "engine/hoststate.h"
 #include "engine/r2engine.h"
 
@@ -7,11 +10,6 @@
 
 namespace fs = std::filesystem;
 
-const int AINET_VERSION_NUMBER = 57;
-const int AINET_SCRIPT_VERSION_NUMBER = 21;
-const int PLACEHOLDER_CRC = 0;
-const int MAX_HULLS = 5;
-
 #pragma pack(push, 1)
 struct CAI_NodeLink
 {
@@ -25,16 +23,6 @@ struct CAI_NodeLink
 };
 #pragma pack(pop)
 
-#pragma pack(push, 1)
-struct CAI_NodeLinkDisk
-{
-	short srcId;
-	short destId;
-	char unk0;
-	bool hulls[MAX_HULLS];
-};
-#pragma pack(pop)
-
 #pragma pack(push, 1)
 struct CAI_Node
 {
@@ -66,26 +54,6 @@ struct CAI_Node
 };
 #pragma pack(pop)
 
-// the way CAI_Nodes are represented in on-disk ain files
-#pragma pack(push, 1)
-struct CAI_NodeDisk
-{
-	float x;
-	float y;
-	float z;
-	float yaw;
-	float hulls[MAX_HULLS];
-
-	char unk0;
-	int unk1;
-	short unk2[MAX_HULLS];
-	char unk3[MAX_HULLS];
-	short unk4;
-	short unk5;
-	char unk6[8];
-}; // total size of 68 bytes
-#pragma pack(pop)
-
 #pragma pack(push, 1)
 struct UnkNodeStruct0
 {
@@ -116,31 +84,9 @@ struct UnkNodeStruct0
 int* pUnkStruct0Count;
 UnkNodeStruct0*** pppUnkNodeStruct0s;
 
-#pragma pack(push, 1)
-struct UnkLinkStruct1
-{
-	short unk0;
-	short unk1;
-	int unk2;
-	char unk3;
-	char unk4;
-	char unk5;
-};
-#pragma pack(pop)
-
 int* pUnkLinkStruct1Count;
 UnkLinkStruct1*** pppUnkStruct1s;
 
-#pragma pack(push, 1)
-struct CAI_ScriptNode
-{
-	float x;
-	float y;
-	float z;
-	uint64_t scriptdata;
-};
-#pragma pack(pop)
-
 #pragma pack(push, 1)
 struct CAI_Network
 {
@@ -174,65 +120,58 @@ struct CAI_Network
 #pragma pack(pop)
 
 ConVar* Cvar_ns_ai_dumpAINfileFromLoad;
-
-void DumpAINInfo(CAI_Network* aiNetwork)
+ConVar* Cvar_ns_ai_dumpAINfileVerbose;
+
+//-----------------------------------------------------------------------------
+// Purpose: Converts an ai network from memory into its on-disk form
+// Input  : *aiNetwork - Network to convert
+//          ain - Filled with the converted network
+//          bVerbose - Whether to log every node, link and unknown struct
+//-----------------------------------------------------------------------------
+static void BuildAinFile(CAI_Network* aiNetwork, AinFile_t& ain, bool bVerbose)
 {
-	fs::path writePath(fmt::format("{}/maps/graphs", g_pModName));
-	writePath /= g_pGlobals->m_pMapName;
-	writePath += ".ain";
-
-	// dump from memory
-	spdlog::info("writing ain file {}", writePath.string());
-	spdlog::info("");
-	spdlog::info("");
-	spdlog::info("");
-	spdlog::info("");
-	spdlog::info("");
-
-	std::ofstream writeStream(writePath, std::ofstream::binary);
-	spdlog::info("writing ainet version: {}", AINET_VERSION_NUMBER);
-	writeStream.write((char*)&AINET_VERSION_NUMBER, sizeof(int));
-
-	int mapVersion = g_pGlobals->m_nMapVersion;
-	spdlog::info("writing map version: {}", mapVersion);
-	writeStream.write((char*)&mapVersion, sizeof(int));
-	spdlog::info("writing placeholder crc: {}", PLACEHOLDER_CRC);
-	writeStream.write((char*)&PLACEHOLDER_CRC, sizeof(int));
+	ain.mapVersion = g_pGlobals->m_nMapVersion;
 
 	int calculatedLinkcount = 0;
 
 	// path nodes
-	spdlog::info("writing nodecount: {}", aiNetwork->nodecount);
-	writeStream.write((char*)&aiNetwork->nodecount, sizeof(int));
-
+	ain.nodes.resize(aiNetwork->nodecount);
 	for (int i = 0; i < aiNetwork->nodecount; i++)
 	{
+		const CAI_Node* pNode = aiNetwork->nodes[i];
+
 		// construct on-disk node struct
-		CAI_NodeDisk diskNode;
-		diskNode.x = aiNetwork->nodes[i]->x;
-		diskNode.y = aiNetwork->nodes[i]->y;
-		diskNode.z = aiNetwork->nodes[i]->z;
-		diskNode.yaw = aiNetwork->nodes[i]->yaw;
-		memcpy(diskNode.hulls, aiNetwork->nodes[i]->hulls, sizeof(diskNode.hulls));
-		diskNode.unk0 = (char)aiNetwork->nodes[i]->unk0;
-		diskNode.unk1 = aiNetwork->nodes[i]->unk1;
+		CAI_NodeDisk& diskNode = ain.nodes[i];
+		diskNode.x = pNode->x;
+		diskNode.y = pNode->y;
+		diskNode.z = pNode->z;
+		diskNode.yaw = pNode->yaw;
+		memcpy(diskNode.hulls, pNode->hulls, sizeof(diskNode.hulls));
+		diskNode.unk0 = (char)pNode->unk0;
+		diskNode.unk1 = pNode->unk1;
 
 		for (int j = 0; j < MAX_HULLS; j++)
-		{
-			diskNode.unk2[j] = (short)aiNetwork->nodes[i]->unk2[j];
-			spdlog::info((short)aiNetwork->nodes[i]->unk2[j]);
-		}
+			diskNode.unk2[j] = (short)pNode->unk2[j];
 
-		memcpy(diskNode.unk3, aiNetwork->nodes[i]->unk3, sizeof(diskNode.unk3));
-		diskNode.unk4 = aiNetwork->nodes[i]->unk6;
-		diskNode.unk5 =
-			-1; // aiNetwork->nodes[i]->unk8; // this field is wrong, however, it's always -1 in vanilla navmeshes anyway, so no biggie
-		memcpy(diskNode.unk6, aiNetwork->nodes[i]->unk10, sizeof(diskNode.unk6));
+		memcpy(diskNode.unk3, pNode->unk3, sizeof(diskNode.unk3));
+		diskNode.unk4 = pNode->unk6;
+		diskNode.unk5 = -1; // pNode->unk8; // this field is wrong, however, it's always -1 in vanilla navmeshes anyway, so no biggie
+		memcpy(diskNode.unk6, pNode->unk10, sizeof(diskNode.unk6));
 
-		spdlog::info("writing node {} from {} to {:x}", aiNetwork->nodes[i]->index, (void*)aiNetwork->nodes[i], writeStream.tellp());
-		writeStream.write((char*)&diskNode, sizeof(CAI_NodeDisk));
+		if (bVerbose)
+		{
+			spdlog::info(
+				"node {} from {}: unk2 {} {} {} {} {}",
+				pNode->index,
+				(void*)pNode,
+				diskNode.unk2[0],
+				diskNode.unk2[1],
+				diskNode.unk2[2],
+				diskNode.unk2[3],
+				diskNode.unk2[4]);
+		}
 
-		calculatedLinkcount += aiNetwork->nodes[i]->linkcount;
+		calculatedLinkcount += pNode->linkcount;
 	}
 
 	// links
@@ -248,113 +187,191 @@ void DumpAINInfo(CAI_Network* aiNetwork)
 			spdlog::warn("calculated linkcount has weird value! this is expected on build!");
 	}
 
-	spdlog::info("writing linkcount: {}", calculatedLinkcount);
-	writeStream.write((char*)&calculatedLinkcount, sizeof(int));
-
+	ain.links.reserve(calculatedLinkcount);
 	for (int i = 0; i < aiNetwork->nodecount; i++)
 	{
-		for (int j = 0; j < aiNetwork->nodes[i]->linkcount; j++)
+		const CAI_Node* pNode = aiNetwork->nodes[i];
+		for (int j = 0; j < pNode->linkcount; j++)
 		{
 			// skip links that don't originate from current node
-			if (aiNetwork->nodes[i]->links[j]->srcId != aiNetwork->nodes[i]->index)
+			if (pNode->links[j]->srcId != pNode->index)
 				continue;
 
-			CAI_NodeLinkDisk diskLink;
-			diskLink.srcId = aiNetwork->nodes[i]->links[j]->srcId;
-			diskLink.destId = aiNetwork->nodes[i]->links[j]->destId;
-			diskLink.unk0 = aiNetwork->nodes[i]->links[j]->unk1;
-			memcpy(diskLink.hulls, aiNetwork->nodes[i]->links[j]->hulls, sizeof(diskLink.hulls));
+			CAI_NodeLinkDisk& diskLink = ain.links.emplace_back();
+			diskLink.srcId = pNode->links[j]->srcId;
+			diskLink.destId = pNode->links[j]->destId;
+			diskLink.unk0 = pNode->links[j]->unk1;
+			memcpy(diskLink.hulls, pNode->links[j]->hulls, sizeof(diskLink.hulls));
 
-			spdlog::info("writing link {} => {} to {:x}", diskLink.srcId, diskLink.destId, writeStream.tellp());
-			writeStream.write((char*)&diskLink, sizeof(CAI_NodeLinkDisk));
+			if (bVerbose)
+				spdlog::info("link {} => {}", diskLink.srcId, diskLink.destId);
 		}
 	}
 
+	// the count is written from the links we actually have, so the file stays readable even if this is off
+	if (ain.links.size() != (size_t)calculatedLinkcount)
+		spdlog::warn("wrote {} links, but nodes have {} links between them", ain.links.size(), calculatedLinkcount);
+
 	// don't know what this is, it's likely a block from tf1 that got deprecated? should just be 1 int per node
-	spdlog::info("writing {:x} bytes for unknown block at {:x}", aiNetwork->nodecount * sizeof(uint32_t), writeStream.tellp());
-	uint32_t* unkNodeBlock = new uint32_t[aiNetwork->nodecount];
-	memset(unkNodeBlock, 0, aiNetwork->nodecount * sizeof(uint32_t));
-	writeStream.write((char*)unkNodeBlock, aiNetwork->nodecount * sizeof(uint32_t));
-	delete[] unkNodeBlock;
-
-	// TODO: this is traverse nodes i think? these aren't used in tf2 ains so we can get away with just writing count=0 and skipping
-	// but ideally should actually dump these
-	spdlog::info("writing {} traversal nodes at {:x}...", 0, writeStream.tellp());
-	short traverseNodeCount = 0;
-	writeStream.write((char*)&traverseNodeCount, sizeof(short));
-	// only write count since count=0 means we don't have to actually do anything here
-
-	// TODO: ideally these should be actually dumped, but they're always 0 in tf2 from what i can tell
-	spdlog::info("writing {} bytes for unknown hull block at {:x}", MAX_HULLS * 8, writeStream.tellp());
-	char* unkHullBlock = new char[MAX_HULLS * 8];
-	memset(unkHullBlock, 0, MAX_HULLS * 8);
-	writeStream.write(unkHullBlock, MAX_HULLS * 8);
-	delete[] unkHullBlock;
+	ain.unkNodeBlock.assign(aiNetwork->nodecount, 0);
+
+	// TODO: traverse nodes and the unknown hull block are left empty, the former isn't used in tf2 ains and the latter always seems to be
+	// 0 in tf2, but ideally both should actually be dumped
 
 	// unknown struct that's seemingly node-related
-	spdlog::info("writing {} unknown node structs at {:x}", *pUnkStruct0Count, writeStream.tellp());
-	writeStream.write((char*)pUnkStruct0Count, sizeof(*pUnkStruct0Count));
+	ain.unkNodes.resize(*pUnkStruct0Count);
 	for (int i = 0; i < *pUnkStruct0Count; i++)
 	{
-		spdlog::info("writing unknown node struct {} at {:x}", i, writeStream.tellp());
-		UnkNodeStruct0* nodeStruct = (*pppUnkNodeStruct0s)[i];
-
-		writeStream.write((char*)&nodeStruct->index, sizeof(nodeStruct->index));
-		writeStream.write((char*)&nodeStruct->unk1, sizeof(nodeStruct->unk1));
+		const UnkNodeStruct0* nodeStruct = (*pppUnkNodeStruct0s)[i];
+		AinUnkNode_t& unkNode = ain.unkNodes[i];
 
-		writeStream.write((char*)&nodeStruct->x, sizeof(nodeStruct->x));
-		writeStream.write((char*)&nodeStruct->y, sizeof(nodeStruct->y));
-		writeStream.write((char*)&nodeStruct->z, sizeof(nodeStruct->z));
+		unkNode.index = nodeStruct->index;
+		unkNode.unk1 = nodeStruct->unk1;
+		unkNode.x = nodeStruct->x;
+		unkNode.y = nodeStruct->y;
+		unkNode.z = nodeStruct->z;
 
-		writeStream.write((char*)&nodeStruct->unkcount0, sizeof(nodeStruct->unkcount0));
+		// these are ints in memory but shorts on disk
+		unkNode.unk2.resize(nodeStruct->unkcount0);
 		for (int j = 0; j < nodeStruct->unkcount0; j++)
-		{
-			short unk2Short = (short)nodeStruct->unk2[j];
-			writeStream.write((char*)&unk2Short, sizeof(unk2Short));
-		}
+			unkNode.unk2[j] = (short)nodeStruct->unk2[j];
 
-		writeStream.write((char*)&nodeStruct->unkcount1, sizeof(nodeStruct->unkcount1));
+		unkNode.unk3.resize(nodeStruct->unkcount1);
 		for (int j = 0; j < nodeStruct->unkcount1; j++)
-		{
-			short unk3Short = (short)nodeStruct->unk3[j];
-			writeStream.write((char*)&unk3Short, sizeof(unk3Short));
-		}
+			unkNode.unk3[j] = (short)nodeStruct->unk3[j];
+
+		unkNode.unk5 = nodeStruct->unk5;
 
-		writeStream.write((char*)&nodeStruct->unk5, sizeof(nodeStruct->unk5));
+		if (bVerbose)
+			spdlog::info("unknown node struct {}: {} unk2, {} unk3", i, nodeStruct->unkcount0, nodeStruct->unkcount1);
 	}
 
-	// unknown struct that's seemingly link-related
-	spdlog::info("writing {} unknown link structs at {:x}", *pUnkLinkStruct1Count, writeStream.tellp());
-	writeStream.write((char*)pUnkLinkStruct1Count, sizeof(*pUnkLinkStruct1Count));
+	// unknown struct that's seemingly link-related, disk and memory structs are literally identical here
+	ain.unkLinks.resize(*pUnkLinkStruct1Count);
 	for (int i = 0; i < *pUnkLinkStruct1Count; i++)
-	{
-		// disk and memory structs are literally identical here so just directly write
-		spdlog::info("writing unknown link struct {} at {:x}", i, writeStream.tellp());
-		writeStream.write((char*)(*pppUnkStruct1s)[i], sizeof(*(*pppUnkStruct1s)[i]));
-	}
+		ain.unkLinks[i] = *(*pppUnkStruct1s)[i];
 
 	// some weird int idk what this is used for
-	writeStream.write((char*)&aiNetwork->unk5, sizeof(aiNetwork->unk5));
+	ain.unk8 = aiNetwork->unk5;
 
 	// tf2-exclusive stuff past this point, i.e. ain v57 only
-	spdlog::info("writing {} script nodes at {:x}", aiNetwork->scriptnodecount, writeStream.tellp());
-	writeStream.write((char*)&aiNetwork->scriptnodecount, sizeof(aiNetwork->scriptnodecount));
-	for (int i = 0; i < aiNetwork->scriptnodecount; i++)
+	ain.scriptNodes.assign(aiNetwork->scriptnodes, aiNetwork->scriptnodes + aiNetwork->scriptnodecount);
+	ain.hints.assign(aiNetwork->hints, aiNetwork->hints + aiNetwork->hintcount);
+}
+
+static void LogAinFileStats(const AinFileStats_t& stats)
+{
+	spdlog::info(
+		"{} nodes, {} links, {} nodes without links, at most {} links on one node",
+		stats.nodeCount,
+		stats.linkCount,
+		stats.isolatedNodes,
+		stats.maxNodeLinks);
+	spdlog::info(
+		"links per hull: {} {} {} {} {}",
+		stats.linksPerHull[0],
+		stats.linksPerHull[1],
+		stats.linksPerHull[2],
+		stats.linksPerHull[3],
+		stats.linksPerHull[4]);
+	spdlog::info(
+		"nodes span ({} {} {}) to ({} {} {})",
+		stats.mins[0],
+		stats.mins[1],
+		stats.mins[2],
+		stats.maxs[0],
+		stats.maxs[1],
+		stats.maxs[2]);
+	spdlog::info(
+		"{} unknown node structs, {} unknown link structs, {} script nodes, {} hints",
+		stats.unkNodeCount,
+		stats.unkLinkCount,
+		stats.scriptNodeCount,
+		stats.hintCount);
+
+	if (stats.selfLinks || stats.duplicateLinks)
+		spdlog::warn("{} links from a node to itself, {} duplicate links", stats.selfLinks, stats.duplicateLinks);
+}
+
+static fs::path GetAinFilePath(const char* pMapName)
+{
+	fs::path path(fmt::format("{}/maps/graphs", g_pModName));
+	path /= pMapName;
+	path += ".ain";
+
+	return path;
+}
+
+void DumpAINInfo(CAI_Network* aiNetwork)
+{
+	const fs::path writePath = GetAinFilePath(g_pGlobals->m_pMapName);
+	const bool bVerbose = Cvar_ns_ai_dumpAINfileVerbose->GetBool();
+	const double dStartTime = Plat_FloatTime();
+
+	// dump from memory
+	spdlog::info("writing ain file {}", writePath.string());
+
+	AinFile_t ain;
+	BuildAinFile(aiNetwork, ain, bVerbose);
+
+	// serialize the whole thing up front, so the file only needs one write
+	std::vector<char> buffer;
+	AinFileLayout_t layout;
+	WriteAinFile(ain, buffer, &layout);
+
+	if (bVerbose)
 	{
-		// disk and memory structs are literally identical here so just directly write
-		spdlog::info("writing script node {} at {:x}", i, writeStream.tellp());
-		writeStream.write((char*)&aiNetwork->scriptnodes[i], sizeof(aiNetwork->scriptnodes[i]));
+		spdlog::info("nodes at {:x}, links at {:x}, unknown node block at {:x}", layout.nodes, layout.links, layout.unkNodeBlock);
+		spdlog::info("traversal nodes at {:x}, unknown hull block at {:x}", layout.traverseNodes, layout.unkHullBlock);
+		spdlog::info("unknown node structs at {:x}, unknown link structs at {:x}", layout.unkNodes, layout.unkLinks);
+		spdlog::info("script nodes at {:x}, hints at {:x}, {:x} bytes total", layout.scriptNodes, layout.hints, layout.size);
 	}
 
-	spdlog::info("writing {} hints at {:x}", aiNetwork->hintcount, writeStream.tellp());
-	writeStream.write((char*)&aiNetwork->hintcount, sizeof(aiNetwork->hintcount));
-	for (int i = 0; i < aiNetwork->hintcount; i++)
+	// make sure what we're about to write can actually be read back
+	AinFileStats_t stats;
+	std::string error;
+	if (!ValidateAinFile(buffer.data(), buffer.size(), stats, error))
+		spdlog::warn("ain file failed validation: {}", error);
+
+	std::ofstream writeStream(writePath, std::ofstream::binary);
+	writeStream.write(buffer.data(), buffer.size());
+	writeStream.close();
+
+	if (writeStream.fail())
 	{
-		spdlog::info("writing hint data {} at {:x}", i, writeStream.tellp());
-		writeStream.write((char*)&aiNetwork->hints[i], sizeof(aiNetwork->hints[i]));
+		spdlog::error("failed to write ain file {}", writePath.string());
+		return;
 	}
 
-	writeStream.close();
+	spdlog::info("wrote {} bytes to {} in {:.3f}s", buffer.size(), writePath.string(), Plat_FloatTime() - dStartTime);
+	LogAinFileStats(stats);
+}
+
+void ConCommand_ns_ai_validate_ain(const CCommand& args)
+{
+	// default to the current map's ain
+	const char* pMapName = args.ArgC() >= 2 ? args.Arg(1) : g_pGlobals->m_pMapName;
+	const fs::path path = GetAinFilePath(pMapName);
+
+	std::ifstream readStream(path, std::ifstream::binary);
+	if (!readStream.is_open())
+	{
+		spdlog::error("couldn't open ain file {}", path.string());
+		return;
+	}
+
+	const std::vector<char> buffer((std::istreambuf_iterator<char>(readStream)), std::istreambuf_iterator<char>());
+
+	AinFileStats_t stats;
+	std::string error;
+	if (!ValidateAinFile(buffer.data(), buffer.size(), stats, error))
+	{
+		spdlog::error("ain file {} is invalid: {}", path.string(), error);
+		return;
+	}
+
+	spdlog::info("ain file {} is valid", path.string());
+	LogAinFileStats(stats);
 }
 
 static void(__fastcall* o_pCAI_NetworkBuilder__Build)(void* builder, CAI_Network* aiNetwork, void* unknown) = nullptr;
@@ -377,7 +394,7 @@ static void __fastcall h_LoadAINFile(void* aimanager, void* buf, const char* fil
 	}
 }
 
-ON_DLL_LOAD("server.dll", BuildAINFile, (CModule module))
+ON_DLL_LOAD_RELIESON("server.dll", BuildAINFile, ConCommand, (CModule module))
 {
 	o_pCAI_NetworkBuilder__Build = module.Offset(0x385E20).RCast<decltype(o_pCAI_NetworkBuilder__Build)>();
 	HookAttach(&(PVOID&)o_pCAI_NetworkBuilder__Build, (PVOID)h_CAI_NetworkBuilder__Build);
@@ -387,6 +404,14 @@ ON_DLL_LOAD("server.dll", BuildAINFile, (CModule module))
 
 	Cvar_ns_ai_dumpAINfileFromLoad = new ConVar(
 		"ns_ai_dumpAINfileFromLoad", "0", FCVAR_NONE, "For debugging: whether we should dump ain data for ains loaded from disk");
+	Cvar_ns_ai_dumpAINfileVerbose = new ConVar(
+		"ns_ai_dumpAINfileVerbose", "0", FCVAR_NONE, "Whether to log every node, link and unknown struct when writing ain files");
+
+	RegisterConCommand(
+		"ns_ai_validate_ain",
+		ConCommand_ns_ai_validate_ain,
+		"Checks that a map's ain file can be read back and logs stats about it, defaults to the current map",
+		FCVAR_NONE);
 
 	pUnkStruct0Count = module.Offset(0x1063BF8).RCast<int*>();
 	pppUnkNodeStruct0s = module.Offset(0x1063BE0).RCast<UnkNodeStruct0***>();
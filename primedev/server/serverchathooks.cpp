@@ -36,7 +36,7 @@ static void(__fastcall* o_pCServerGameDLL__OnReceivedSayTextMessage)(
 static void __fastcall h_CServerGameDLL__OnReceivedSayTextMessage(
 	CServerGameDLL* self, unsigned int senderPlayerId, const char* text, bool isTeam)
 {
-	RemoveAsciiControlSequences(const_cast<char*>(text), true);
+	RemoveAsciiControlSequences(const_cast<char*>(text), strlen(text), true);
 
 	// MiniHook doesn't allow calling the base function outside of anywhere but the hook function.
 	// To allow bypassing the hook, isSkippingHook can be set.
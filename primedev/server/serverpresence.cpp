@@ -2,14 +2,13 @@
 #include "shared/playlist.h"
 #include "core/tier0.h"
 #include "core/convar/convar.h"
-
-#include <regex>
+#include "core/profiler.h"
 
 ServerPresenceManager* g_pServerPresence;
 
 ConVar* Cvar_hostname;
 
-// Convert a hex digit char to integer.
+// Convert a hex digit char to integer, or -1 if it isn't one.
 inline int hctod(char c)
 {
 	if (c >= 'A' && c <= 'F')
@@ -20,53 +19,61 @@ inline int hctod(char c)
 	{
 		return c - 'a' + 10;
 	}
-	else
+	else if (c >= '0' && c <= '9')
 	{
 		return c - '0';
 	}
+	else
+	{
+		return -1;
+	}
 }
 
 // This function interprets all 4-hexadecimal-digit unicode codepoint characters like \u4E2D to UTF-8 encoding.
+// Done in a single pass over the string, since this runs whenever the server name or description changes.
 std::string UnescapeUnicode(const std::string& str)
 {
+	// escapes only ever get shorter when decoded, so this is the most we'll need
 	std::string result;
+	result.reserve(str.size());
 
-	std::regex r("\\\\u([a-f\\d]{4})", std::regex::icase);
-	auto matches_begin = std::sregex_iterator(str.begin(), str.end(), r);
-	auto matches_end = std::sregex_iterator();
-	std::smatch last_match;
-
-	for (std::sregex_iterator i = matches_begin; i != matches_end; ++i)
+	for (size_t i = 0; i < str.size(); i++)
 	{
-		last_match = *i;
-		result.append(last_match.prefix());
+		// \u or \U followed by exactly 4 hex digits, anything else is copied as is
 		unsigned int cp = 0;
-		for (int i = 2; i <= 5; ++i)
+		bool bIsEscape = i + 5 < str.size() && str[i] == '\\' && (str[i + 1] == 'u' || str[i + 1] == 'U');
+		for (size_t j = i + 2; bIsEscape && j < i + 6; j++)
 		{
-			cp *= 16;
-			cp += hctod(last_match.str()[i]);
+			const int iDigit = hctod(str[j]);
+			bIsEscape = iDigit != -1;
+			cp = cp * 16 + iDigit;
 		}
+
+		if (!bIsEscape)
+		{
+			result.push_back(str[i]);
+			continue;
+		}
+
 		if (cp <= 0x7F)
 		{
 			result.push_back(cp);
 		}
 		else if (cp <= 0x7FF)
 		{
-			result.push_back((cp >> 6) | 0b11000000 & (~(1 << 5)));
-			result.push_back(cp & ((1 << 6) - 1) | 0b10000000 & (~(1 << 6)));
+			result.push_back((cp >> 6) | 0b11000000);
+			result.push_back(cp & ((1 << 6) - 1) | 0b10000000);
 		}
-		else if (cp <= 0xFFFF)
+		else
 		{
-			result.push_back((cp >> 12) | 0b11100000 & (~(1 << 4)));
-			result.push_back((cp >> 6) & ((1 << 6) - 1) | 0b10000000 & (~(1 << 6)));
-			result.push_back(cp & ((1 << 6) - 1) | 0b10000000 & (~(1 << 6)));
+			result.push_back((cp >> 12) | 0b11100000);
+			result.push_back((cp >> 6) & ((1 << 6) - 1) | 0b10000000);
+			result.push_back(cp & ((1 << 6) - 1) | 0b10000000);
 		}
-	}
 
-	if (!last_match.ready())
-		return str;
-	else
-		result.append(last_match.suffix());
+		// skip the rest of the escape
+		i += 5;
+	}
 
 	return result;
 }
@@ -124,6 +131,7 @@ void ServerPresenceManager::CreatePresence()
 	memset(m_ServerPresence.m_MapName, 0, sizeof(m_ServerPresence.m_MapName));
 	memset(m_ServerPresence.m_PlaylistName, 0, sizeof(m_ServerPresence.m_PlaylistName));
 	m_ServerPresence.m_bIsSingleplayerServer = false;
+	m_ServerPresence.m_iDirtyFields = PRESENCE_FIELD_ALL;
 
 	m_bHasPresence = true;
 	m_bFirstPresenceUpdate = true;
@@ -141,6 +149,8 @@ void ServerPresenceManager::DestroyPresence()
 
 void ServerPresenceManager::RunFrame(double flCurrentTime)
 {
+	NS_PROFILE_SCOPE("ServerPresenceManager::RunFrame");
+
 	if (!m_bHasPresence || !Cvar_ns_report_server_to_masterserver->GetBool()) // don't run until we actually have server presence
 		return;
 
@@ -170,29 +180,44 @@ void ServerPresenceManager::RunFrame(double flCurrentTime)
 
 	for (ServerPresenceReporter* reporter : m_vPresenceReporters)
 		reporter->ReportPresence(&m_ServerPresence);
+
+	// reporters have seen these now
+	m_ServerPresence.m_iDirtyFields = 0;
 }
 
 void ServerPresenceManager::SetPort(const int iPort)
 {
 	// update port
+	if (m_ServerPresence.m_iPort != iPort)
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_PORT;
+
 	m_ServerPresence.m_iPort = iPort;
 }
 
 void ServerPresenceManager::SetName(const std::string sServerNameUnicode)
 {
 	// update name
+	if (m_ServerPresence.m_sServerName != sServerNameUnicode)
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_NAME;
+
 	m_ServerPresence.m_sServerName = sServerNameUnicode;
 }
 
 void ServerPresenceManager::SetDescription(const std::string sServerDescUnicode)
 {
 	// update desc
+	if (m_ServerPresence.m_sServerDesc != sServerDescUnicode)
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_DESC;
+
 	m_ServerPresence.m_sServerDesc = sServerDescUnicode;
 }
 
 void ServerPresenceManager::SetPassword(const char* pPassword)
 {
 	// update password
+	if (strncmp(m_ServerPresence.m_Password, pPassword, sizeof(m_ServerPresence.m_Password) - 1))
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_PASSWORD;
+
 	strncpy_s(m_ServerPresence.m_Password, sizeof(m_ServerPresence.m_Password), pPassword, sizeof(m_ServerPresence.m_Password) - 1);
 }
 
@@ -203,12 +228,18 @@ void ServerPresenceManager::SetMap(const char* pMapName, bool isInitialising)
 		m_ServerPresence.m_bIsSingleplayerServer = !strncmp(pMapName, "sp_", 3);
 
 	// update map
+	if (strncmp(m_ServerPresence.m_MapName, pMapName, sizeof(m_ServerPresence.m_MapName) - 1))
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_MAP;
+
 	strncpy_s(m_ServerPresence.m_MapName, sizeof(m_ServerPresence.m_MapName), pMapName, sizeof(m_ServerPresence.m_MapName) - 1);
 }
 
 void ServerPresenceManager::SetPlaylist(const char* pPlaylistName)
 {
 	// update playlist
+	if (strncmp(m_ServerPresence.m_PlaylistName, pPlaylistName, sizeof(m_ServerPresence.m_PlaylistName) - 1))
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_PLAYLIST;
+
 	strncpy_s(
 		m_ServerPresence.m_PlaylistName,
 		sizeof(m_ServerPresence.m_PlaylistName),
@@ -219,14 +250,18 @@ void ServerPresenceManager::SetPlaylist(const char* pPlaylistName)
 	const char* pMaxPlayers = R2::GetCurrentPlaylistVar("max_players", true);
 
 	// can be null in some situations, so default 6
-	if (pMaxPlayers)
-		m_ServerPresence.m_iMaxPlayers = std::stoi(pMaxPlayers);
-	else
-		m_ServerPresence.m_iMaxPlayers = 6;
+	const int iMaxPlayers = pMaxPlayers ? std::stoi(pMaxPlayers) : 6;
+	if (m_ServerPresence.m_iMaxPlayers != iMaxPlayers)
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_MAX_PLAYERS;
+
+	m_ServerPresence.m_iMaxPlayers = iMaxPlayers;
 }
 
 void ServerPresenceManager::SetPlayerCount(const int iPlayerCount)
 {
+	if (m_ServerPresence.m_iPlayerCount != iPlayerCount)
+		m_ServerPresence.m_iDirtyFields |= PRESENCE_FIELD_PLAYER_COUNT;
+
 	m_ServerPresence.m_iPlayerCount = iPlayerCount;
 }
 
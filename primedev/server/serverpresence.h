@@ -1,6 +1,21 @@
 #pragma once
 #include "core/convar/convar.h"
 
+// one bit per reported field of ServerPresence, so reporters can tell what's changed since they last reported
+enum ServerPresenceFields_t : uint32_t
+{
+	PRESENCE_FIELD_PORT = 1 << 0,
+	PRESENCE_FIELD_NAME = 1 << 1,
+	PRESENCE_FIELD_DESC = 1 << 2,
+	PRESENCE_FIELD_PASSWORD = 1 << 3,
+	PRESENCE_FIELD_MAP = 1 << 4,
+	PRESENCE_FIELD_PLAYLIST = 1 << 5,
+	PRESENCE_FIELD_PLAYER_COUNT = 1 << 6,
+	PRESENCE_FIELD_MAX_PLAYERS = 1 << 7,
+
+	PRESENCE_FIELD_ALL = (1 << 8) - 1
+};
+
 struct ServerPresence
 {
 public:
@@ -19,6 +34,9 @@ public:
 	int m_iPlayerCount;
 	int m_iMaxPlayers;
 
+	// ServerPresenceFields_t that have changed since the last report
+	uint32_t m_iDirtyFields = PRESENCE_FIELD_ALL;
+
 	ServerPresence() {}
 
 	ServerPresence(const ServerPresence* obj)
@@ -36,6 +54,8 @@ public:
 
 		m_iPlayerCount = obj->m_iPlayerCount;
 		m_iMaxPlayers = obj->m_iMaxPlayers;
+
+		m_iDirtyFields = obj->m_iDirtyFields;
 	}
 };
 
@@ -43,6 +63,8 @@ class ServerPresenceReporter
 {
 public:
 	virtual void CreatePresence(const ServerPresence* /*pServerPresence*/) {}
+	// pServerPresence->m_iDirtyFields holds what's changed since the last call, reporters that send deltas need to keep track of it
+	// themselves if they can't report straight away
 	virtual void ReportPresence(const ServerPresence* /*pServerPresence*/) {}
 	virtual void DestroyPresence(const ServerPresence* /*pServerPresence*/) {}
 	virtual void RunFrame(double /*flCurrentTime*/, const ServerPresence* /*pServerPresence*/) {}
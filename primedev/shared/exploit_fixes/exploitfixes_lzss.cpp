@@ -1,14 +1,7 @@
+#include "util/lzss.h"
 
 AUTOHOOK_INIT()
 
-static constexpr int LZSS_LOOKSHIFT = 4;
-
-struct lzss_header_t
-{
-	unsigned int id;
-	unsigned int actualSize;
-};
-
 // Rewrite of CLZSS::SafeUncompress to fix a vulnerability where malicious compressed payloads could cause the decompressor to try to read
 // out of the bounds of the output buffer.
 // clang-format off
@@ -17,60 +10,19 @@ unsigned int, __fastcall, (void* self, const unsigned char* pInput, unsigned cha
 // clang-format on
 {
 	NOTE_UNUSED(self);
-	unsigned int totalBytes = 0;
-	int getCmdByte = 0;
-	int cmdByte = 0;
 
-	lzss_header_t header = *(lzss_header_t*)pInput;
-
-	if (!pInput || !header.actualSize || header.id != 0x53535A4C || header.actualSize > unBufSize)
+	if (!pInput)
 		return 0;
 
-	pInput += sizeof(lzss_header_t);
-
-	for (;;)
-	{
-		if (!getCmdByte)
-			cmdByte = *pInput++;
-
-		getCmdByte = (getCmdByte + 1) & 0x07;
-
-		if (cmdByte & 0x01)
-		{
-			int position = *pInput++ << LZSS_LOOKSHIFT;
-			position |= (*pInput >> LZSS_LOOKSHIFT);
-			position += 1;
-			int count = (*pInput++ & 0x0F) + 1;
-			if (count == 1)
-				break;
-
-			// Ensure reference chunk exists entirely within our buffer
-			if (position > totalBytes)
-				return 0;
-
-			totalBytes += count;
-			if (totalBytes > unBufSize)
-				return 0;
-
-			unsigned char* pSource = pOutput - position;
-			for (int i = 0; i < count; i++)
-				*pOutput++ = *pSource++;
-		}
-		else
-		{
-			totalBytes++;
-			if (totalBytes > unBufSize)
-				return 0;
-
-			*pOutput++ = *pInput++;
-		}
-		cmdByte = cmdByte >> 1;
-	}
+	lzss_header_t header;
+	memcpy(&header, pInput, sizeof(header));
 
-	if (totalBytes != header.actualSize)
+	if (!header.actualSize || header.id != LZSS_ID || header.actualSize > unBufSize)
 		return 0;
 
-	return totalBytes;
+	// the engine doesn't give us the input size, but no valid payload for this output size is longer than this
+	// so at least malformed payloads can't walk through memory indefinitely
+	return LZSS_Decompress(pInput, LZSS_GetMaxCompressedSize(header.actualSize), pOutput, unBufSize);
 }
 
 ON_DLL_LOAD("engine.dll", ExploitFixes_LZSS, (CModule module))
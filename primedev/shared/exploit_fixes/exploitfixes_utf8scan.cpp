@@ -0,0 +1,100 @@
+#include "exploitfixes_utf8scan.h"
+
+#include <cstdint>
+#include <emmintrin.h>
+
+//-----------------------------------------------------------------------------
+// Purpose: Finds the first backslash in [pCur, pEnd), or nullptr if there isn't one
+//-----------------------------------------------------------------------------
+static const char* FindNextEscape(const char* pCur, const char* pEnd)
+{
+	const __m128i xBackslash = _mm_set1_epi8('\\');
+	for (; pEnd - pCur >= 16; pCur += 16)
+	{
+		int iMask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pCur)), xBackslash));
+		if (iMask)
+		{
+			unsigned long iIndex;
+			_BitScanForward(&iIndex, iMask);
+			return pCur + iIndex;
+		}
+	}
+
+	for (; pCur != pEnd; pCur++)
+		if (*pCur == '\\')
+			return pCur;
+
+	return nullptr;
+}
+
+// hex digits are decoded exactly like the engine does, including whatever garbage it makes of non-hex characters
+static uint32_t DecodeEscapedHexDigit(char c)
+{
+	uint32_t v = c | 0x20;
+	return v - (v <= 0x39 ? 48 : 87);
+}
+
+static uint32_t DecodeEscapedCodepoint(const char* pHex)
+{
+	return (DecodeEscapedHexDigit(pHex[0]) << 12) | (DecodeEscapedHexDigit(pHex[1]) << 8) | (DecodeEscapedHexDigit(pHex[2]) << 4) |
+		   DecodeEscapedHexDigit(pHex[3]);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Checks that unescaping a string token won't run off the end of it
+//          the engine only stops when it lands exactly on the closing quote, so an escape sequence that steps over it
+//          makes it keep reading (and writing) through memory. plain characters always move it forward by one,
+//          so only escapes can do that, and we can skip straight from one to the next
+// Input  : *pCur - First character after the opening quote
+//          *pEnd - The closing quote, must be after pCur
+// Output : false if the engine would step over the closing quote
+//-----------------------------------------------------------------------------
+bool CheckEscapedTokenEnd(const char* pCur, const char* pEnd)
+{
+	for (;;)
+	{
+		pCur = FindNextEscape(pCur, pEnd);
+		if (!pCur)
+			return true;
+
+		// escaped character, everything other than \u is a single character
+		pCur++;
+		if (*pCur++ == 'u')
+		{
+			// the engine would decode the quote and whatever follows it as hex digits, and always ends up past the quote
+			// unless that happened to look like a malformed surrogate, either way it's not a string we want to parse
+			if (pEnd - pCur < 4)
+				return false;
+
+			uint32_t iCodepoint = DecodeEscapedCodepoint(pCur);
+			pCur += 4;
+
+			// surrogate pairs, the engine gives up on anything malformed here and treats it as fine
+			if (iCodepoint - 0xD800 <= 0x7FF)
+			{
+				if (iCodepoint >= 0xDC00)
+					return true;
+
+				// the closing quote isn't a backslash, so the engine gives up here too
+				if (pEnd - pCur < 2 || pCur[0] != '\\' || pCur[1] != 'u')
+					return true;
+
+				// the closing quote can be the last hex digit, that's never a valid low surrogate so the engine gives up there
+				if (pEnd - pCur < 5)
+					return false;
+
+				if (DecodeEscapedCodepoint(pCur + 2) - 0xDC00 > 0x3FF)
+					return true;
+
+				pCur += 6;
+			}
+		}
+
+		if (pCur == pEnd)
+			return true;
+
+		// stepped over the closing quote
+		if (pCur > pEnd)
+			return false;
+	}
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// checks that unescaping a string token the way the engine's rson parser does ends exactly at the end of the token
+// pCur and pEnd are the token's contents without the quotes, only [pCur, pEnd] is read
+bool CheckEscapedTokenEnd(const char* pCur, const char* pEnd);
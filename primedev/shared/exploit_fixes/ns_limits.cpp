@@ -5,6 +5,7 @@
 #include "server/r2server.h"
 #include "core/tier0.h"
 #include "core/math/vector.h"
+#include "core/profiler.h"
 #include "server/auth/serverauthentication.h"
 
 AUTOHOOK_INIT()
@@ -16,6 +17,8 @@ float (*CEngineServer__GetTimescale)();
 // todo: make this work on higher timescales, also possibly disable when sv_cheats is set
 void ServerLimitsManager::RunFrame(double flCurrentTime, float flFrameTime)
 {
+	NS_PROFILE_SCOPE("ServerLimitsManager::RunFrame");
+
 	NOTE_UNUSED(flCurrentTime);
 	if (Cvar_sv_antispeedhack_enable->GetBool())
 	{
@@ -1,4 +1,5 @@
 #include "keyvalues.h"
+#include "shared/playlist.h"
 #include <winnt.h>
 
 // implementation of the ConVar class
@@ -1313,7 +1314,13 @@ char, __fastcall, (KeyValues* self, const char* pResourceName, const char* pBuff
 	if (!pFileSystem && !strcmp(pResourceName, "playlists"))
 		pFileSystem = pSavedFilesystemPtr;
 
-	return KeyValues__LoadFromBuffer(self, pResourceName, pBuffer, pFileSystem, a5, a6, a7);
+	char cResult = KeyValues__LoadFromBuffer(self, pResourceName, pBuffer, pFileSystem, a5, a6, a7);
+
+	// cached playlist vars point into the old playlists kv
+	if (!strcmp(pResourceName, "playlists"))
+		g_PlaylistVarCache.Invalidate();
+
+	return cResult;
 }
 
 ON_DLL_LOAD("engine.dll", EngineKeyValues, (CModule module))
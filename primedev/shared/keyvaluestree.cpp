@@ -0,0 +1,828 @@
+#include "keyvaluestree.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cwchar>
+
+// defined in keyvalues.cpp, grabbed from vstdlib
+extern int (*V_UnicodeToUTF8)(const wchar_t* pUnicode, char* pUTF8, int cubDestSizeInBytes);
+
+static inline char KVToLower(char c)
+{
+	return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+// fnv-1a over the lowercase name
+static uint32_t HashKeyName(const char* pszName, size_t iLength)
+{
+	uint32_t iHash = 2166136261u;
+	for (size_t i = 0; i < iLength; i++)
+	{
+		iHash ^= (unsigned char)KVToLower(pszName[i]);
+		iHash *= 16777619u;
+	}
+
+	return iHash;
+}
+
+static bool KeyNamesEqual(const KeyValuesNode_t* pNode, const char* pszName, size_t iLength, uint32_t iHash)
+{
+	if (pNode->iNameHash != iHash || pNode->iNameLength != iLength)
+		return false;
+
+	for (size_t i = 0; i < iLength; i++)
+		if (KVToLower(pNode->pszName[i]) != KVToLower(pszName[i]))
+			return false;
+
+	return true;
+}
+
+CKeyValuesArena::~CKeyValuesArena()
+{
+	Release();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Allocates from the current block, starting a new one if it's full
+//          blocks double in size up to MAX_BLOCK_SIZE so big trees don't end up with thousands of them
+//-----------------------------------------------------------------------------
+void* CKeyValuesArena::Alloc(size_t iSize, size_t iAlign)
+{
+	if (!m_vBlocks.empty())
+	{
+		Block_t& block = m_vBlocks.back();
+		const size_t iOffset = (block.iUsed + iAlign - 1) & ~(iAlign - 1);
+		if (iOffset + iSize <= block.iSize)
+		{
+			block.iUsed = iOffset + iSize;
+			m_iBytesUsed += iSize;
+			return block.pData + iOffset;
+		}
+	}
+
+	size_t iBlockSize = m_vBlocks.empty() ? MIN_BLOCK_SIZE : std::min(m_vBlocks.back().iSize * 2, MAX_BLOCK_SIZE);
+	iBlockSize = std::max(iBlockSize, iSize + iAlign);
+
+	// operator new gives us at least max_align_t alignment, which is all we ever ask for
+	Block_t block {new char[iBlockSize], iBlockSize, 0};
+	m_vBlocks.push_back(block);
+
+	return Alloc(iSize, iAlign);
+}
+
+const char* CKeyValuesArena::CopyString(const char* pszString, size_t iLength)
+{
+	char* pszCopy = static_cast<char*>(Alloc(iLength + 1, alignof(char)));
+	memcpy(pszCopy, pszString, iLength);
+	pszCopy[iLength] = '\0';
+	return pszCopy;
+}
+
+const wchar_t* CKeyValuesArena::CopyWString(const wchar_t* pwszString)
+{
+	const size_t iLength = wcslen(pwszString);
+	wchar_t* pwszCopy = static_cast<wchar_t*>(Alloc((iLength + 1) * sizeof(wchar_t), alignof(wchar_t)));
+	memcpy(pwszCopy, pwszString, (iLength + 1) * sizeof(wchar_t));
+	return pwszCopy;
+}
+
+void CKeyValuesArena::Release()
+{
+	for (Block_t& block : m_vBlocks)
+		delete[] block.pData;
+
+	m_vBlocks.clear();
+	m_iBytesUsed = 0;
+}
+
+size_t CKeyValuesArena::GetBytesUsed() const
+{
+	return m_iBytesUsed;
+}
+
+CKeyValuesTree::CKeyValuesTree(const char* pszRootName)
+{
+	m_pRoot = CreateNode(pszRootName, strlen(pszRootName));
+}
+
+KeyValuesNode_t* CKeyValuesTree::GetRoot() const
+{
+	return m_pRoot;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Frees every node in one go, leaving just an empty root with the same name
+//-----------------------------------------------------------------------------
+void CKeyValuesTree::Clear()
+{
+	const std::string svRootName(m_pRoot->pszName, m_pRoot->iNameLength);
+	m_Arena.Release();
+	m_pRoot = CreateNode(svRootName.c_str(), svRootName.length());
+}
+
+size_t CKeyValuesTree::GetBytesUsed() const
+{
+	return m_Arena.GetBytesUsed();
+}
+
+KeyValuesNode_t* CKeyValuesTree::CreateNode(const char* pszName, size_t iNameLength)
+{
+	KeyValuesNode_t* pNode = static_cast<KeyValuesNode_t*>(m_Arena.Alloc(sizeof(KeyValuesNode_t), alignof(KeyValuesNode_t)));
+	memset(pNode, 0, sizeof(KeyValuesNode_t));
+
+	pNode->pszName = m_Arena.CopyString(pszName, iNameLength);
+	pNode->iNameLength = (uint32_t)iNameLength;
+	pNode->iNameHash = HashKeyName(pszName, iNameLength);
+	pNode->iDataType = TYPE_NONE;
+	return pNode;
+}
+
+KeyValuesNode_t* CKeyValuesTree::AddKey(KeyValuesNode_t* pParent, const char* pszName)
+{
+	KeyValuesNode_t* pChild = CreateNode(pszName, strlen(pszName));
+	LinkChild(pParent, pChild);
+	return pChild;
+}
+
+void CKeyValuesTree::LinkChild(KeyValuesNode_t* pParent, KeyValuesNode_t* pChild)
+{
+	if (pParent->pLastChild)
+		pParent->pLastChild->pNextPeer = pChild;
+	else
+		pParent->pFirstChild = pChild;
+
+	pParent->pLastChild = pChild;
+	pParent->iChildCount++;
+
+	// a key graduates to be a submsg as soon as it has children, same as KeyValues
+	// any value it had, or its cached string form, goes with it
+	pParent->iDataType = TYPE_NONE;
+	pParent->pszValue = nullptr;
+
+	if (pParent->ppChildIndex)
+	{
+		// keep the table at most half full
+		if (pParent->iChildCount * 2 > pParent->iChildIndexSize)
+			BuildChildIndex(pParent, pParent->iChildIndexSize * 2);
+		else
+			InsertIntoChildIndex(pParent, pChild);
+	}
+	else if (pParent->iChildCount > CHILD_INDEX_THRESHOLD)
+	{
+		uint32_t iSize = 1;
+		while (iSize < pParent->iChildCount * 2)
+			iSize <<= 1;
+
+		BuildChildIndex(pParent, iSize);
+	}
+}
+
+void CKeyValuesTree::BuildChildIndex(KeyValuesNode_t* pParent, uint32_t iSize)
+{
+	// old tables just stay in the arena, they're small and geometric growth bounds the waste
+	pParent->ppChildIndex = static_cast<KeyValuesNode_t**>(m_Arena.Alloc(iSize * sizeof(KeyValuesNode_t*), alignof(KeyValuesNode_t*)));
+	pParent->iChildIndexSize = iSize;
+	memset(pParent->ppChildIndex, 0, iSize * sizeof(KeyValuesNode_t*));
+
+	for (KeyValuesNode_t* pChild = pParent->pFirstChild; pChild; pChild = pChild->pNextPeer)
+		InsertIntoChildIndex(pParent, pChild);
+}
+
+void CKeyValuesTree::InsertIntoChildIndex(KeyValuesNode_t* pParent, KeyValuesNode_t* pChild)
+{
+	const uint32_t iMask = pParent->iChildIndexSize - 1;
+	for (uint32_t i = pChild->iNameHash & iMask;; i = (i + 1) & iMask)
+	{
+		KeyValuesNode_t* pSlot = pParent->ppChildIndex[i];
+		if (!pSlot)
+		{
+			pParent->ppChildIndex[i] = pChild;
+			return;
+		}
+
+		// first key with a given name wins, same as walking the peer list
+		if (KeyNamesEqual(pSlot, pChild->pszName, pChild->iNameLength, pChild->iNameHash))
+			return;
+	}
+}
+
+KeyValuesNode_t* CKeyValuesTree::FindChild(const KeyValuesNode_t* pParent, const char* pszName, size_t iNameLength, uint32_t iHash) const
+{
+	if (pParent->ppChildIndex)
+	{
+		const uint32_t iMask = pParent->iChildIndexSize - 1;
+		for (uint32_t i = iHash & iMask;; i = (i + 1) & iMask)
+		{
+			KeyValuesNode_t* pSlot = pParent->ppChildIndex[i];
+			if (!pSlot || KeyNamesEqual(pSlot, pszName, iNameLength, iHash))
+				return pSlot;
+		}
+	}
+
+	for (KeyValuesNode_t* pChild = pParent->pFirstChild; pChild; pChild = pChild->pNextPeer)
+		if (KeyNamesEqual(pChild, pszName, iNameLength, iHash))
+			return pChild;
+
+	return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Find a key by path, creating it if it is not found and bCreate is set
+// Input  : *pNode - node the path is relative to
+//			*pszPath - '/' separated path, nullptr or "" returns pNode, "/" on its own is a key name
+//			bCreate -
+//-----------------------------------------------------------------------------
+KeyValuesNode_t* CKeyValuesTree::FindKey(KeyValuesNode_t* pNode, const char* pszPath, bool bCreate)
+{
+	if (!pszPath || !*pszPath)
+		return pNode;
+
+	if (!strcmp(pszPath, "/"))
+	{
+		KeyValuesNode_t* pChild = FindChild(pNode, pszPath, 1, HashKeyName(pszPath, 1));
+		if (!pChild && bCreate)
+		{
+			pChild = CreateNode(pszPath, 1);
+			LinkChild(pNode, pChild);
+		}
+
+		return pChild;
+	}
+
+	const char* pszSegment = pszPath;
+	while (pNode)
+	{
+		const char* pszSegmentEnd = pszSegment;
+		while (*pszSegmentEnd && *pszSegmentEnd != '/')
+			pszSegmentEnd++;
+
+		const size_t iLength = pszSegmentEnd - pszSegment;
+		const uint32_t iHash = HashKeyName(pszSegment, iLength);
+
+		KeyValuesNode_t* pChild = FindChild(pNode, pszSegment, iLength, iHash);
+		if (!pChild && bCreate)
+		{
+			pChild = CreateNode(pszSegment, iLength);
+			LinkChild(pNode, pChild);
+		}
+
+		pNode = pChild;
+		if (!*pszSegmentEnd)
+			break;
+
+		pszSegment = pszSegmentEnd + 1;
+	}
+
+	return pNode;
+}
+
+KeyValuesNode_t* CKeyValuesTree::FindSubKey(const KeyValuesNode_t* pNode, const char* pszName) const
+{
+	const size_t iLength = strlen(pszName);
+	return FindChild(pNode, pszName, iLength, HashKeyName(pszName, iLength));
+}
+
+void CKeyValuesTree::SetCachedString(KeyValuesNode_t* pNode, const char* pszValue)
+{
+	pNode->pszValue = m_Arena.CopyString(pszValue, strlen(pszValue));
+}
+
+const char* CKeyValuesTree::GetString(KeyValuesNode_t* pNode, const char* pszPath, const char* pszDefaultValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath);
+	if (!pKey)
+		return pszDefaultValue;
+
+	// non-string values are converted once and cached on the node
+	if (pKey->pszValue)
+		return pKey->pszValue;
+
+	char buf[64];
+	switch (pKey->iDataType)
+	{
+	case TYPE_FLOAT:
+		snprintf(buf, sizeof(buf), "%f", pKey->flValue);
+		break;
+	case TYPE_PTR:
+		snprintf(buf, sizeof(buf), "%" PRIu64, reinterpret_cast<uint64_t>(pKey->pValue));
+		break;
+	case TYPE_INT:
+		snprintf(buf, sizeof(buf), "%d", pKey->iValue);
+		break;
+	case TYPE_UINT64:
+		snprintf(buf, sizeof(buf), "%" PRIu64, pKey->iUint64Value);
+		break;
+	case TYPE_COLOR:
+		snprintf(buf, sizeof(buf), "%d %d %d %d", pKey->Color[0], pKey->Color[1], pKey->Color[2], pKey->Color[3]);
+		break;
+	case TYPE_WSTRING:
+	{
+		char wideBuf[512];
+		if (!V_UnicodeToUTF8(pKey->pwszValue, wideBuf, sizeof(wideBuf)))
+			return pszDefaultValue;
+
+		SetCachedString(pKey, wideBuf);
+		return pKey->pszValue;
+	}
+	default:
+		return pszDefaultValue;
+	}
+
+	SetCachedString(pKey, buf);
+	return pKey->pszValue;
+}
+
+int CKeyValuesTree::GetInt(KeyValuesNode_t* pNode, const char* pszPath, int iDefaultValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath);
+	if (!pKey)
+		return iDefaultValue;
+
+	switch (pKey->iDataType)
+	{
+	case TYPE_STRING:
+		return atoi(pKey->pszValue);
+	case TYPE_WSTRING:
+		return (int)wcstol(pKey->pwszValue, nullptr, 10);
+	case TYPE_FLOAT:
+		return static_cast<int>(pKey->flValue);
+	case TYPE_UINT64:
+		// can't convert, since it would lose data
+		return 0;
+	case TYPE_INT:
+	case TYPE_PTR:
+	default:
+		return pKey->iValue;
+	}
+}
+
+float CKeyValuesTree::GetFloat(KeyValuesNode_t* pNode, const char* pszPath, float flDefaultValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath);
+	if (!pKey)
+		return flDefaultValue;
+
+	switch (pKey->iDataType)
+	{
+	case TYPE_STRING:
+		return static_cast<float>(atof(pKey->pszValue));
+	case TYPE_WSTRING:
+		return static_cast<float>(wcstod(pKey->pwszValue, nullptr));
+	case TYPE_FLOAT:
+		return pKey->flValue;
+	case TYPE_INT:
+		return static_cast<float>(pKey->iValue);
+	case TYPE_UINT64:
+		return static_cast<float>(pKey->iUint64Value);
+	case TYPE_PTR:
+	default:
+		return 0.0f;
+	}
+}
+
+uint64_t CKeyValuesTree::GetUint64(KeyValuesNode_t* pNode, const char* pszPath, uint64_t iDefaultValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath);
+	if (!pKey)
+		return iDefaultValue;
+
+	switch (pKey->iDataType)
+	{
+	case TYPE_STRING:
+		return strtoull(pKey->pszValue, nullptr, 10);
+	case TYPE_WSTRING:
+		return wcstoull(pKey->pwszValue, nullptr, 10);
+	case TYPE_FLOAT:
+		return static_cast<int>(pKey->flValue);
+	case TYPE_UINT64:
+		return pKey->iUint64Value;
+	case TYPE_PTR:
+		return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pKey->pValue));
+	case TYPE_INT:
+	default:
+		return pKey->iValue;
+	}
+}
+
+void CKeyValuesTree::SetString(KeyValuesNode_t* pNode, const char* pszPath, const char* pszValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	SetCachedString(pKey, pszValue ? pszValue : "");
+	pKey->pwszValue = nullptr;
+	pKey->iDataType = TYPE_STRING;
+}
+
+void CKeyValuesTree::SetWString(KeyValuesNode_t* pNode, const char* pszPath, const wchar_t* pwszValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	pKey->pwszValue = m_Arena.CopyWString(pwszValue ? pwszValue : L"");
+	pKey->pszValue = nullptr;
+	pKey->iDataType = TYPE_WSTRING;
+}
+
+void CKeyValuesTree::SetInt(KeyValuesNode_t* pNode, const char* pszPath, int iValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	pKey->pszValue = nullptr;
+	pKey->pwszValue = nullptr;
+	pKey->iValue = iValue;
+	pKey->iDataType = TYPE_INT;
+}
+
+void CKeyValuesTree::SetFloat(KeyValuesNode_t* pNode, const char* pszPath, float flValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	pKey->pszValue = nullptr;
+	pKey->pwszValue = nullptr;
+	pKey->flValue = flValue;
+	pKey->iDataType = TYPE_FLOAT;
+}
+
+void CKeyValuesTree::SetUint64(KeyValuesNode_t* pNode, const char* pszPath, uint64_t iValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	pKey->pszValue = nullptr;
+	pKey->pwszValue = nullptr;
+	pKey->iUint64Value = iValue;
+	pKey->iDataType = TYPE_UINT64;
+}
+
+void CKeyValuesTree::SetPtr(KeyValuesNode_t* pNode, const char* pszPath, void* pValue)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	pKey->pszValue = nullptr;
+	pKey->pwszValue = nullptr;
+	pKey->pValue = pValue;
+	pKey->iDataType = TYPE_PTR;
+}
+
+void CKeyValuesTree::SetColor(KeyValuesNode_t* pNode, const char* pszPath, Color color)
+{
+	KeyValuesNode_t* pKey = FindKey(pNode, pszPath, true);
+	pKey->pszValue = nullptr;
+	pKey->pwszValue = nullptr;
+	pKey->Color[0] = color[0];
+	pKey->Color[1] = color[1];
+	pKey->Color[2] = color[2];
+	pKey->Color[3] = color[3];
+	pKey->iDataType = TYPE_COLOR;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Copies an engine KeyValues and all its subkeys into the tree
+//          chained keys (m_pChain) aren't followed, the tree has no concept of them
+// Input  : *pParent - node to add the copy to
+//			*pKV -
+// Output : the new node
+//-----------------------------------------------------------------------------
+KeyValuesNode_t* CKeyValuesTree::CopyFromKeyValues(KeyValuesNode_t* pParent, const KeyValues* pKV)
+{
+	KeyValuesNode_t* pNode = AddKey(pParent, pKV->GetName());
+
+	if (pKV->m_pSub)
+	{
+		for (KeyValues* pSub = pKV->GetFirstSubKey(); pSub; pSub = pSub->GetNextKey())
+			CopyFromKeyValues(pNode, pSub);
+
+		return pNode;
+	}
+
+	switch (pKV->m_iDataType)
+	{
+	case TYPE_STRING:
+		SetString(pNode, nullptr, pKV->m_sValue);
+		break;
+	case TYPE_WSTRING:
+		SetWString(pNode, nullptr, pKV->m_wsValue);
+		break;
+	case TYPE_INT:
+		SetInt(pNode, nullptr, pKV->m_iValue);
+		break;
+	case TYPE_FLOAT:
+		SetFloat(pNode, nullptr, pKV->m_flValue);
+		break;
+	case TYPE_PTR:
+		SetPtr(pNode, nullptr, pKV->m_pValue);
+		break;
+	case TYPE_UINT64:
+		SetUint64(pNode, nullptr, *reinterpret_cast<uint64_t*>(pKV->m_sValue));
+		break;
+	case TYPE_COLOR:
+		SetColor(pNode, nullptr, Color(pKV->m_Color[0], pKV->m_Color[1], pKV->m_Color[2], pKV->m_Color[3]));
+		break;
+	}
+
+	return pNode;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Builds a new engine KeyValues from a node and all its children
+// Input  : *pNode -
+// Output : KeyValues*, caller owns it
+//-----------------------------------------------------------------------------
+KeyValues* CKeyValuesTree::MakeKeyValues(const KeyValuesNode_t* pNode) const
+{
+	KeyValues* pKV = new KeyValues(pNode->pszName);
+
+	if (pNode->pFirstChild)
+	{
+		// link children directly rather than going through AddSubKey, which walks the peer list every time
+		KeyValues* pPrev = nullptr;
+		for (const KeyValuesNode_t* pChild = pNode->pFirstChild; pChild; pChild = pChild->pNextPeer)
+		{
+			KeyValues* pSub = MakeKeyValues(pChild);
+			if (pPrev)
+				pPrev->m_pPeer = pSub;
+			else
+				pKV->m_pSub = pSub;
+
+			pPrev = pSub;
+		}
+
+		return pKV;
+	}
+
+	switch (pNode->iDataType)
+	{
+	case TYPE_STRING:
+		pKV->SetStringValue(pNode->pszValue);
+		break;
+	case TYPE_WSTRING:
+		pKV->SetWString(nullptr, pNode->pwszValue);
+		break;
+	case TYPE_INT:
+		pKV->SetInt(nullptr, pNode->iValue);
+		break;
+	case TYPE_FLOAT:
+		pKV->SetFloat(nullptr, pNode->flValue);
+		break;
+	case TYPE_PTR:
+		pKV->SetPtr(nullptr, pNode->pValue);
+		break;
+	case TYPE_UINT64:
+		pKV->SetUint64(nullptr, pNode->iUint64Value);
+		break;
+	case TYPE_COLOR:
+		pKV->SetColor(nullptr, Color(pNode->Color[0], pNode->Color[1], pNode->Color[2], pNode->Color[3]));
+		break;
+	default:
+		// valueless keys stay empty, the compiled int types only come from the engine's binary format
+		break;
+	}
+
+	return pKV;
+}
+
+// same as KEYVALUES_TOKEN_SIZE in the engine, which truncates anything longer
+constexpr size_t KV_MAX_TOKEN_LENGTH = 1023;
+
+enum class eKVTokenType
+{
+	END,
+	OPEN,
+	CLOSE,
+	STRING,
+	ERROR
+};
+
+struct KVToken_t
+{
+	eKVTokenType eType;
+	const char* pszStart = nullptr;
+	size_t iLength = 0;
+	bool bQuoted = false;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Reads the next token, skipping whitespace and // comments like KeyValues::ReadToken
+//-----------------------------------------------------------------------------
+static KVToken_t ReadKVToken(const char*& pCur, const char* pEnd, std::string& svError)
+{
+	while (pCur < pEnd)
+	{
+		if (isspace((unsigned char)*pCur))
+			pCur++;
+		else if (*pCur == '/' && pCur + 1 < pEnd && pCur[1] == '/')
+		{
+			while (pCur < pEnd && *pCur != '\n')
+				pCur++;
+		}
+		else
+			break;
+	}
+
+	if (pCur >= pEnd || !*pCur)
+		return {eKVTokenType::END};
+
+	if (*pCur == '{' || *pCur == '}')
+		return {*pCur++ == '{' ? eKVTokenType::OPEN : eKVTokenType::CLOSE};
+
+	KVToken_t token {eKVTokenType::STRING};
+	if (*pCur == '"')
+	{
+		token.bQuoted = true;
+		token.pszStart = ++pCur;
+		while (pCur < pEnd && *pCur != '"')
+			pCur++;
+
+		if (pCur >= pEnd)
+		{
+			svError = "unterminated quoted string";
+			return {eKVTokenType::ERROR};
+		}
+
+		token.iLength = pCur++ - token.pszStart;
+
+		// the engine may or may not treat \" as an escaped quote depending on the file, so don't guess
+		if (token.iLength && token.pszStart[token.iLength - 1] == '\\')
+		{
+			svError = "escape sequences are not supported";
+			return {eKVTokenType::ERROR};
+		}
+	}
+	else
+	{
+		token.bQuoted = false;
+		token.pszStart = pCur;
+		while (pCur < pEnd && *pCur && !isspace((unsigned char)*pCur) && *pCur != '"' && *pCur != '{' && *pCur != '}')
+			pCur++;
+
+		token.iLength = pCur - token.pszStart;
+
+		if (*token.pszStart == '[')
+		{
+			svError = "conditionals are not supported";
+			return {eKVTokenType::ERROR};
+		}
+	}
+
+	if (token.iLength > KV_MAX_TOKEN_LENGTH)
+	{
+		svError = "token is too long";
+		return {eKVTokenType::ERROR};
+	}
+
+	return token;
+}
+
+static bool KVTokenEquals(const KVToken_t& token, const char* pszString)
+{
+	return token.iLength == strlen(pszString) && !strncmp(token.pszStart, pszString, token.iLength);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Parses KeyValues text into the tree
+// Input  : *pParent - node top level keys are added to
+//			*pszText -
+//			iLength -
+//			&vBaseFiles - receives the names of any #base files, in order
+//			&svError - receives the reason parsing failed
+// Output : false if the text is malformed or uses something we can't round trip
+//-----------------------------------------------------------------------------
+bool CKeyValuesTree::ParseText(
+	KeyValuesNode_t* pParent, const char* pszText, size_t iLength, std::vector<std::string>& vBaseFiles, std::string& svError)
+{
+	const char* pCur = pszText;
+	const char* pEnd = pszText + iLength;
+
+	std::vector<KeyValuesNode_t*> vStack {pParent};
+	while (true)
+	{
+		KVToken_t key = ReadKVToken(pCur, pEnd, svError);
+		switch (key.eType)
+		{
+		case eKVTokenType::ERROR:
+			return false;
+
+		case eKVTokenType::END:
+			if (vStack.size() > 1)
+			{
+				svError = "unexpected end of file, missing }";
+				return false;
+			}
+
+			return true;
+
+		case eKVTokenType::CLOSE:
+			if (vStack.size() == 1)
+			{
+				svError = "unexpected }";
+				return false;
+			}
+
+			vStack.pop_back();
+			continue;
+
+		case eKVTokenType::OPEN:
+			svError = "unexpected {";
+			return false;
+
+		case eKVTokenType::STRING:
+			break;
+		}
+
+		// top level # directives
+		if (vStack.size() == 1 && !key.bQuoted && *key.pszStart == '#')
+		{
+			if (!KVTokenEquals(key, "#base"))
+			{
+				svError = fmt::format("unsupported directive {}", std::string(key.pszStart, key.iLength));
+				return false;
+			}
+
+			KVToken_t file = ReadKVToken(pCur, pEnd, svError);
+			if (file.eType != eKVTokenType::STRING)
+			{
+				if (file.eType != eKVTokenType::ERROR)
+					svError = "expected a file name after #base";
+
+				return false;
+			}
+
+			vBaseFiles.emplace_back(file.pszStart, file.iLength);
+			continue;
+		}
+
+		KVToken_t value = ReadKVToken(pCur, pEnd, svError);
+		if (value.eType == eKVTokenType::ERROR)
+			return false;
+
+		if (value.eType == eKVTokenType::END || value.eType == eKVTokenType::CLOSE)
+		{
+			svError = fmt::format("key {} has no value", std::string(key.pszStart, key.iLength));
+			return false;
+		}
+
+		KeyValuesNode_t* pNode = CreateNode(key.pszStart, key.iLength);
+		LinkChild(vStack.back(), pNode);
+
+		if (value.eType == eKVTokenType::OPEN)
+			vStack.push_back(pNode);
+		else
+		{
+			pNode->pszValue = m_Arena.CopyString(value.pszStart, value.iLength);
+			pNode->iDataType = TYPE_STRING;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Writes a node and its children as KeyValues text, everything quoted and tab indented
+//-----------------------------------------------------------------------------
+void CKeyValuesTree::WriteText(const KeyValuesNode_t* pNode, std::string& svOut, int iDepth) const
+{
+	svOut.append(iDepth, '\t');
+	svOut += '"';
+	svOut.append(pNode->pszName, pNode->iNameLength);
+	svOut += '"';
+
+	if (pNode->pFirstChild || pNode->iDataType == TYPE_NONE)
+	{
+		svOut += '\n';
+		svOut.append(iDepth, '\t');
+		svOut += "{\n";
+
+		for (const KeyValuesNode_t* pChild = pNode->pFirstChild; pChild; pChild = pChild->pNextPeer)
+			WriteText(pChild, svOut, iDepth + 1);
+
+		svOut.append(iDepth, '\t');
+		svOut += "}\n";
+		return;
+	}
+
+	// GetString caches conversions on the node, which we can't do here, so non-string values are formatted on the fly
+	char buf[512];
+	const char* pszValue = pNode->pszValue;
+	if (!pszValue)
+	{
+		switch (pNode->iDataType)
+		{
+		case TYPE_FLOAT:
+			snprintf(buf, sizeof(buf), "%f", pNode->flValue);
+			break;
+		case TYPE_INT:
+			snprintf(buf, sizeof(buf), "%d", pNode->iValue);
+			break;
+		case TYPE_UINT64:
+			snprintf(buf, sizeof(buf), "%" PRIu64, pNode->iUint64Value);
+			break;
+		case TYPE_COLOR:
+			snprintf(buf, sizeof(buf), "%d %d %d %d", pNode->Color[0], pNode->Color[1], pNode->Color[2], pNode->Color[3]);
+			break;
+		case TYPE_WSTRING:
+			if (!V_UnicodeToUTF8(pNode->pwszValue, buf, sizeof(buf)))
+				buf[0] = '\0';
+			break;
+		default:
+			// pointers don't mean anything once written out
+			buf[0] = '\0';
+			break;
+		}
+
+		pszValue = buf;
+	}
+
+	svOut += "\t\"";
+	svOut += pszValue;
+	svOut += "\"\n";
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include "shared/keyvalues.h"
+
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Purpose: A node in a CKeyValuesTree, everything it points to is owned by the tree's arena
+//-----------------------------------------------------------------------------
+struct KeyValuesNode_t
+{
+	const char* pszName;
+	uint32_t iNameLength;
+	uint32_t iNameHash; // case insensitive, names are compared case insensitively like engine symbols
+
+	KeyValuesTypes_t iDataType;
+	const char* pszValue; // string value, or the cached string form of a non-string value
+	const wchar_t* pwszValue;
+	union
+	{
+		int iValue;
+		float flValue;
+		void* pValue;
+		uint64_t iUint64Value;
+		unsigned char Color[4];
+	};
+
+	KeyValuesNode_t* pFirstChild;
+	KeyValuesNode_t* pLastChild;
+	KeyValuesNode_t* pNextPeer;
+	uint32_t iChildCount;
+
+	// open addressed lookup table over our children, only built once we have more than a handful of them
+	KeyValuesNode_t** ppChildIndex;
+	uint32_t iChildIndexSize; // always a power of 2
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Bump allocator, nothing is freed individually, everything goes at once on Release
+//-----------------------------------------------------------------------------
+class CKeyValuesArena
+{
+private:
+	struct Block_t
+	{
+		char* pData;
+		size_t iSize;
+		size_t iUsed;
+	};
+
+	std::vector<Block_t> m_vBlocks;
+	size_t m_iBytesUsed = 0;
+
+public:
+	static constexpr size_t MIN_BLOCK_SIZE = 16 * 1024;
+	static constexpr size_t MAX_BLOCK_SIZE = 1024 * 1024;
+
+	CKeyValuesArena() = default;
+	~CKeyValuesArena();
+
+	CKeyValuesArena(const CKeyValuesArena&) = delete;
+	CKeyValuesArena& operator=(const CKeyValuesArena&) = delete;
+
+	void* Alloc(size_t iSize, size_t iAlign);
+	const char* CopyString(const char* pszString, size_t iLength);
+	const wchar_t* CopyWString(const wchar_t* pwszString);
+	void Release();
+
+	size_t GetBytesUsed() const;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Arena backed alternative to KeyValues for trees we build ourselves
+//          lookups on nodes with many children are hashed rather than walking the peer list,
+//          and the whole tree is freed in one go when the tree is destroyed or cleared
+//          convert to engine KeyValues with MakeKeyValues when something in the engine needs the tree
+//-----------------------------------------------------------------------------
+class CKeyValuesTree
+{
+public:
+	// nodes with more children than this get a hashed child index
+	static constexpr uint32_t CHILD_INDEX_THRESHOLD = 8;
+
+private:
+	CKeyValuesArena m_Arena;
+	KeyValuesNode_t* m_pRoot;
+
+public:
+	CKeyValuesTree(const char* pszRootName);
+
+	CKeyValuesTree(const CKeyValuesTree&) = delete;
+	CKeyValuesTree& operator=(const CKeyValuesTree&) = delete;
+
+	KeyValuesNode_t* GetRoot() const;
+	void Clear();
+	size_t GetBytesUsed() const;
+
+	// always appends a new child, duplicate names are allowed like in KeyValues, lookups return the first one
+	KeyValuesNode_t* AddKey(KeyValuesNode_t* pParent, const char* pszName);
+	// finds a key by '/' separated path relative to pNode, optionally creating it
+	KeyValuesNode_t* FindKey(KeyValuesNode_t* pNode, const char* pszPath, bool bCreate = false);
+	// finds a direct child by name, without treating '/' as a path separator
+	KeyValuesNode_t* FindSubKey(const KeyValuesNode_t* pNode, const char* pszName) const;
+
+	// getters follow the same type conversion rules as the KeyValues ones
+	const char* GetString(KeyValuesNode_t* pNode, const char* pszPath = nullptr, const char* pszDefaultValue = "");
+	int GetInt(KeyValuesNode_t* pNode, const char* pszPath, int iDefaultValue = 0);
+	float GetFloat(KeyValuesNode_t* pNode, const char* pszPath, float flDefaultValue = 0.0f);
+	uint64_t GetUint64(KeyValuesNode_t* pNode, const char* pszPath, uint64_t iDefaultValue = 0);
+
+	void SetString(KeyValuesNode_t* pNode, const char* pszPath, const char* pszValue);
+	void SetWString(KeyValuesNode_t* pNode, const char* pszPath, const wchar_t* pwszValue);
+	void SetInt(KeyValuesNode_t* pNode, const char* pszPath, int iValue);
+	void SetFloat(KeyValuesNode_t* pNode, const char* pszPath, float flValue);
+	void SetUint64(KeyValuesNode_t* pNode, const char* pszPath, uint64_t iValue);
+	void SetPtr(KeyValuesNode_t* pNode, const char* pszPath, void* pValue);
+	void SetColor(KeyValuesNode_t* pNode, const char* pszPath, Color color);
+
+	// copies an engine KeyValues and all its subkeys into the tree as a child of pParent
+	KeyValuesNode_t* CopyFromKeyValues(KeyValuesNode_t* pParent, const KeyValues* pKV);
+	// builds a new engine KeyValues from a node and all its children, caller owns the result
+	KeyValues* MakeKeyValues(const KeyValuesNode_t* pNode) const;
+
+	// parses KeyValues text, adding every top level key to pParent, and any #base file names to vBaseFiles
+	// only handles the subset of the format we can round trip exactly: no conditionals, #include or escape sequences
+	bool ParseText(KeyValuesNode_t* pParent, const char* pszText, size_t iLength, std::vector<std::string>& vBaseFiles, std::string& svError);
+	// writes a node and all its children out as KeyValues text
+	void WriteText(const KeyValuesNode_t* pNode, std::string& svOut, int iDepth = 0) const;
+
+private:
+	KeyValuesNode_t* CreateNode(const char* pszName, size_t iNameLength);
+	void LinkChild(KeyValuesNode_t* pParent, KeyValuesNode_t* pChild);
+	KeyValuesNode_t* FindChild(const KeyValuesNode_t* pParent, const char* pszName, size_t iNameLength, uint32_t iHash) const;
+	void BuildChildIndex(KeyValuesNode_t* pParent, uint32_t iSize);
+	void InsertIntoChildIndex(KeyValuesNode_t* pParent, KeyValuesNode_t* pChild);
+	void SetCachedString(KeyValuesNode_t* pNode, const char* pszValue);
+};
@@ -1,5 +1,6 @@
 #include "misccommands.h"
 #include "core/convar/concommand.h"
+#include "core/convar/cvarindex.h"
 #include "shared/playlist.h"
 #include "engine/r2engine.h"
 #include "client/r2client.h"
@@ -30,8 +31,9 @@ void ConCommand_ns_start_reauth_and_leave_to_lobby(const CCommand& arg)
 void ConCommand_ns_end_reauth_and_leave_to_lobby(const CCommand& arg)
 {
 	NOTE_UNUSED(arg);
-	if (g_pServerAuthentication->m_RemoteAuthenticationData.size())
-		g_pCVar->FindVar("serverfilter")->SetValue(g_pServerAuthentication->m_RemoteAuthenticationData.begin()->first.c_str());
+	std::string sAuthToken = g_pServerAuthentication->GetAnyRemoteAuthToken();
+	if (!sAuthToken.empty())
+		g_pCVar->FindVar("serverfilter")->SetValue(sAuthToken.c_str());
 
 	// weird way of checking, but check if client script vm is initialised, mainly just to allow players to cancel this
 	if (g_pSquirrel[ScriptContext::CLIENT]->m_pSQVM)
@@ -149,10 +151,10 @@ void FixupCvarFlags()
 	{
 		// strip hidden and devonly cvar flags
 		int iNumCvarsAltered = 0;
-		for (auto& pair : g_pCVar->DumpToMap())
+		for (ConCommandBase* pCommand : g_pCvarIndex->GetAll())
 		{
 			// strip flags
-			int flags = pair.second->GetFlags();
+			int flags = pCommand->GetFlags();
 			if (flags & FCVAR_DEVELOPMENTONLY)
 			{
 				flags &= ~FCVAR_DEVELOPMENTONLY;
@@ -165,7 +167,7 @@ void FixupCvarFlags()
 				iNumCvarsAltered++;
 			}
 
-			pair.second->m_nFlags = flags;
+			pCommand->m_nFlags = flags;
 		}
 
 		spdlog::info("Removed {} hidden/devonly cvar flags", iNumCvarsAltered);
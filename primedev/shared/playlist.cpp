@@ -20,6 +20,8 @@ namespace R2
 
 ConVar* Cvar_ns_use_clc_SetPlaylistVarOverride;
 
+PlaylistVarCache g_PlaylistVarCache;
+
 // clang-format off
 AUTOHOOK(clc_SetPlaylistVarOverride__Process, engine.dll + 0x222180,
 char, __fastcall, (void* a1, void* a2))
@@ -30,7 +32,9 @@ char, __fastcall, (void* a1, void* a2))
 		strcmp(g_pGlobals->m_pMapName, "mp_lobby"))
 		return 1;
 
-	return clc_SetPlaylistVarOverride__Process(a1, a2);
+	char cResult = clc_SetPlaylistVarOverride__Process(a1, a2);
+	g_PlaylistVarCache.Invalidate();
+	return cResult;
 }
 
 // clang-format off
@@ -39,6 +43,7 @@ bool, __fastcall, (const char* pPlaylistName))
 // clang-format on
 {
 	bool bSuccess = SetCurrentPlaylist(pPlaylistName);
+	g_PlaylistVarCache.Invalidate();
 
 	if (bSuccess)
 	{
@@ -58,6 +63,7 @@ void, __fastcall, (const char* pVarName, const char* pValue))
 		return;
 
 	SetPlaylistVarOverride(pVarName, pValue);
+	g_PlaylistVarCache.Invalidate();
 }
 
 // clang-format off
@@ -68,7 +74,57 @@ const char*, __fastcall, (const char* pVarName, bool bUseOverrides))
 	if (!bUseOverrides && !strcmp(pVarName, "max_players"))
 		bUseOverrides = true;
 
-	return GetCurrentPlaylistVar(pVarName, bUseOverrides);
+	return g_PlaylistVarCache.Get(pVarName, bUseOverrides).pValue;
+}
+
+PlaylistVarCache::Var_t PlaylistVarCache::Get(const char* pVarName, bool bUseOverrides)
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	VarMap_t& vars = bUseOverrides ? m_VarsWithOverrides : m_VarsWithoutOverrides;
+	if (auto it = vars.find(std::string_view(pVarName)); it != vars.end())
+	{
+		m_iHits++;
+		return it->second;
+	}
+
+	m_iMisses++;
+
+	// call the original directly, we're what the hook calls
+	Var_t var;
+	var.pValue = GetCurrentPlaylistVar(pVarName, bUseOverrides);
+	if (var.pValue)
+	{
+		var.iValue = atoi(var.pValue);
+		var.flValue = (float)atof(var.pValue);
+	}
+
+	vars.emplace(pVarName, var);
+	return var;
+}
+
+void PlaylistVarCache::Invalidate()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	m_VarsWithOverrides.clear();
+	m_VarsWithoutOverrides.clear();
+	m_iInvalidations++;
+}
+
+void PlaylistVarCache::PrintStats()
+{
+	std::lock_guard<std::mutex> guard(m_Mutex);
+
+	const uint64_t iLookups = m_iHits + m_iMisses;
+	spdlog::info(
+		"playlist var cache: {} lookups, {} hits ({:.1f}%), {} misses, {} invalidations, {} vars cached",
+		iLookups,
+		m_iHits,
+		iLookups ? (double)m_iHits * 100.0 / (double)iLookups : 0.0,
+		m_iMisses,
+		m_iInvalidations,
+		m_VarsWithOverrides.size() + m_VarsWithoutOverrides.size());
 }
 
 // clang-format off
@@ -76,12 +132,40 @@ AUTOHOOK(GetCurrentGamemodeMaxPlayers, engine.dll + 0x18C430,
 int, __fastcall, ())
 // clang-format on
 {
-	const char* pMaxPlayers = R2::GetCurrentPlaylistVar("max_players", 0);
-	if (!pMaxPlayers)
+	// GetCurrentPlaylistVar always uses overrides for max_players
+	const PlaylistVarCache::Var_t maxPlayers = g_PlaylistVarCache.Get("max_players", true);
+	if (!maxPlayers.pValue)
 		return GetCurrentGamemodeMaxPlayers();
 
-	int iMaxPlayers = atoi(pMaxPlayers);
-	return iMaxPlayers;
+	return maxPlayers.iValue;
+}
+
+// clang-format off
+ADD_SQFUNC("int", NSGetCurrentPlaylistVarInt, "string varName, int defaultValue = 0",
+	"Gets the int value of a playlist var, or defaultValue if it isn't set",
+	ScriptContext::UI | ScriptContext::CLIENT | ScriptContext::SERVER)
+// clang-format on
+{
+	const char* pVarName = g_pSquirrel[context]->getstring(sqvm, 1);
+	const int iDefaultValue = g_pSquirrel[context]->getinteger(sqvm, 2);
+
+	const PlaylistVarCache::Var_t var = g_PlaylistVarCache.Get(pVarName, true);
+	g_pSquirrel[context]->pushinteger(sqvm, var.pValue ? var.iValue : iDefaultValue);
+	return SQRESULT_NOTNULL;
+}
+
+// clang-format off
+ADD_SQFUNC("float", NSGetCurrentPlaylistVarFloat, "string varName, float defaultValue = 0",
+	"Gets the float value of a playlist var, or defaultValue if it isn't set",
+	ScriptContext::UI | ScriptContext::CLIENT | ScriptContext::SERVER)
+// clang-format on
+{
+	const char* pVarName = g_pSquirrel[context]->getstring(sqvm, 1);
+	const float flDefaultValue = g_pSquirrel[context]->getfloat(sqvm, 2);
+
+	const PlaylistVarCache::Var_t var = g_PlaylistVarCache.Get(pVarName, true);
+	g_pSquirrel[context]->pushfloat(sqvm, var.pValue ? var.flValue : flDefaultValue);
+	return SQRESULT_NOTNULL;
 }
 
 void ConCommand_playlist(const CCommand& args)
@@ -101,6 +185,11 @@ void ConCommand_setplaylistvaroverride(const CCommand& args)
 		R2::SetPlaylistVarOverride(args.Arg(i), args.Arg(i + 1));
 }
 
+void ConCommand_ns_playlist_var_cache_stats(const CCommand& args)
+{
+	g_PlaylistVarCache.PrintStats();
+}
+
 ON_DLL_LOAD_RELIESON("engine.dll", PlaylistHooks, (ConCommand, ConVar), (CModule module))
 {
 	AUTOHOOK_DISPATCH()
@@ -109,6 +198,8 @@ ON_DLL_LOAD_RELIESON("engine.dll", PlaylistHooks, (ConCommand, ConVar), (CModule
 	RegisterConCommand("playlist", ConCommand_playlist, "Sets the current playlist", FCVAR_NONE);
 	RegisterConCommand("setplaylist", ConCommand_playlist, "Sets the current playlist", FCVAR_NONE);
 	RegisterConCommand("setplaylistvaroverrides", ConCommand_setplaylistvaroverride, "sets a playlist var override", FCVAR_NONE);
+	RegisterConCommand(
+		"ns_playlist_var_cache_stats", ConCommand_ns_playlist_var_cache_stats, "Prints playlist var cache hit rates", FCVAR_NONE);
 
 	// note: clc_SetPlaylistVarOverride is pretty insecure, since it allows for entirely arbitrary playlist var overrides to be sent to the
 	// server, this is somewhat restricted on custom servers to prevent it being done outside of private matches, but ideally it should be
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
 // use the R2 namespace for game funcs
 namespace R2
 {
@@ -8,3 +13,47 @@ namespace R2
 	inline void (*SetPlaylistVarOverride)(const char* pVarName, const char* pValue);
 	inline const char* (*GetCurrentPlaylistVar)(const char* pVarName, bool bUseOverrides);
 } // namespace R2
+
+//-----------------------------------------------------------------------------
+// Purpose: Caches playlist var lookups, scripts ask for the same handful of vars constantly and the engine finds them by string every time
+//          entries keep the engine's own value pointer alongside pre-parsed int and float forms, vars that aren't set are cached too
+//          the whole cache is dropped whenever the playlist, its overrides or the playlists file change
+//-----------------------------------------------------------------------------
+class PlaylistVarCache
+{
+public:
+	struct Var_t
+	{
+		// null if the var isn't set
+		const char* pValue = nullptr;
+		int iValue = 0;
+		float flValue = 0.0f;
+	};
+
+private:
+	// lets us look up std::string keys with a string_view, so lookups don't allocate
+	struct VarNameHash_t
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view svName) const { return std::hash<std::string_view> {}(svName); }
+	};
+
+	using VarMap_t = std::unordered_map<std::string, Var_t, VarNameHash_t, std::equal_to<>>;
+
+	std::mutex m_Mutex;
+	// lookups with and without overrides can give different values, so they're kept apart
+	VarMap_t m_VarsWithOverrides;
+	VarMap_t m_VarsWithoutOverrides;
+
+	uint64_t m_iHits = 0;
+	uint64_t m_iMisses = 0;
+	uint64_t m_iInvalidations = 0;
+
+public:
+	Var_t Get(const char* pVarName, bool bUseOverrides);
+	void Invalidate();
+
+	void PrintStats();
+};
+
+extern PlaylistVarCache g_PlaylistVarCache;
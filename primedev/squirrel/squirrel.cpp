@@ -10,6 +10,7 @@
 #include "plugins/pluginmanager.h"
 #include "ns_version.h"
 #include "core/vanilla.h"
+#include "core/profiler.h"
 
 #include "vscript/vscript.h"
 
@@ -178,20 +179,7 @@ void SquirrelManager::VMCreated(CSquirrelVM* newSqvm)
 
 	for (auto& pair : g_pModManager->m_DependencyConstants)
 	{
-		bool bWasFound = false;
-
-		for (Mod& dependency : g_pModManager->m_LoadedMods)
-		{
-			if (!dependency.m_bEnabled)
-				continue;
-
-			if (dependency.Name == pair.second)
-			{
-				bWasFound = true;
-				break;
-			}
-		}
-
+		const bool bWasFound = g_pModManager->m_Registry.modsByName.contains(pair.second);
 		defconst(m_pSQVM, pair.first.c_str(), bWasFound);
 	}
 
@@ -375,12 +363,15 @@ template <ScriptContext context> bool (*CSquirrelVM_init)(CSquirrelVM* vm, Scrip
 template <ScriptContext context> bool __fastcall CSquirrelVM_initHook(CSquirrelVM* vm, ScriptContext realContext, float time)
 {
 	bool ret = CSquirrelVM_init<context>(vm, realContext, time);
-	for (Mod mod : g_pModManager->m_LoadedMods)
+
+	// copy, init scripts can call NSSetModEnabled which rebuilds the registry under us
+	const std::vector<Mod*> vEnabledMods = g_pModManager->m_Registry.enabledMods;
+	for (const Mod* pMod : vEnabledMods)
 	{
-		if (mod.m_bEnabled && mod.initScript.size() != 0)
+		if (pMod->initScript.size() != 0)
 		{
-			std::string name = mod.initScript.substr(mod.initScript.find_last_of('/') + 1);
-			std::string path = std::string("scripts/vscripts/") + mod.initScript;
+			std::string name = pMod->initScript.substr(pMod->initScript.find_last_of('/') + 1);
+			std::string path = std::string("scripts/vscripts/") + pMod->initScript;
 			if (g_pSquirrel[context]->compilefile(vm, path.c_str(), name.c_str(), 0))
 				g_pSquirrel[context]->compilefile(vm, path.c_str(), name.c_str(), 1);
 		}
@@ -523,16 +514,17 @@ template <ScriptContext context> bool __fastcall CallScriptInitCallbackHook(void
 	else
 		CheckFuncOverrides<context>();
 
+	// copy, callbacks can call NSSetModEnabled which rebuilds the registry while we're iterating it
+	// after callbacks use the same list as before callbacks so every mod gets both or neither
+	const std::vector<Mod*> vEnabledMods = g_pModManager->m_Registry.enabledMods;
+
 	if (bShouldCallCustomCallbacks)
 	{
-		for (Mod mod : g_pModManager->m_LoadedMods)
+		for (const Mod* pMod : vEnabledMods)
 		{
-			if (!mod.m_bEnabled)
-				continue;
-
-			for (ModScript script : mod.Scripts)
+			for (const ModScript& script : pMod->Scripts)
 			{
-				for (ModScriptCallback modCallback : script.Callbacks)
+				for (const ModScriptCallback& modCallback : script.Callbacks)
 				{
 					if (modCallback.Context == realContext && modCallback.BeforeCallback.length())
 					{
@@ -552,14 +544,11 @@ template <ScriptContext context> bool __fastcall CallScriptInitCallbackHook(void
 	// run after callbacks
 	if (bShouldCallCustomCallbacks)
 	{
-		for (Mod mod : g_pModManager->m_LoadedMods)
+		for (const Mod* pMod : vEnabledMods)
 		{
-			if (!mod.m_bEnabled)
-				continue;
-
-			for (ModScript script : mod.Scripts)
+			for (const ModScript& script : pMod->Scripts)
 			{
-				for (ModScriptCallback modCallback : script.Callbacks)
+				for (const ModScriptCallback& modCallback : script.Callbacks)
 				{
 					if (modCallback.Context == realContext && modCallback.AfterCallback.length())
 					{
@@ -603,9 +592,12 @@ template <ScriptContext context> void StubUnsafeSQFuncs()
 
 void SquirrelManager::ProcessMessageBuffer()
 {
+	NS_PROFILE_SCOPE("SquirrelManager::ProcessMessageBuffer");
+
 	while (std::optional<SquirrelMessage> maybeMessage = m_messageBuffer->pop())
 	{
 		SquirrelMessage message = maybeMessage.value();
+		NS_PROFILE_SCOPE_DYNAMIC(message.functionName);
 
 		SQObject functionobj {};
 		int result = sq_getfunction(m_pSQVM->sqvm, message.functionName.c_str(), &functionobj, 0);
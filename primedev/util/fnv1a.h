@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 64 bit fnv-1a, a fast non-cryptographic hash that's stable between runs and builds
+// good for noticing that data changed or got corrupted, useless against anyone doing it on purpose
+
+constexpr uint64_t FNV1A_64_OFFSET_BASIS = 14695981039346656037ull;
+constexpr uint64_t FNV1A_64_PRIME = 1099511628211ull;
+
+//-----------------------------------------------------------------------------
+// Purpose: Hashes a buffer, or continues hashing from an earlier result to cover several buffers
+// Input  : *pData, iSize - Bytes to hash
+//          iHash - Result of hashing whatever came before, the offset basis to start fresh
+//-----------------------------------------------------------------------------
+inline uint64_t FNV1a_64(const void* pData, size_t iSize, uint64_t iHash = FNV1A_64_OFFSET_BASIS)
+{
+	const unsigned char* pBytes = static_cast<const unsigned char*>(pData);
+	for (size_t i = 0; i < iSize; i++)
+	{
+		iHash ^= pBytes[i];
+		iHash *= FNV1A_64_PRIME;
+	}
+
+	return iHash;
+}
@@ -0,0 +1,217 @@
+#include "lzss.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// hash chains only follow this many candidates per position, long runs of similar data would make it quadratic otherwise
+static constexpr int LZSS_MAX_CHAIN = 64;
+static constexpr size_t LZSS_HASH_BITS = 13;
+
+size_t LZSS_GetMaxCompressedSize(size_t iDecompressedSize)
+{
+	// header, literals, a flag byte per 8 commands including the terminator, and the terminator itself
+	return sizeof(lzss_header_t) + iDecompressedSize + (iDecompressedSize + 8) / 8 + 2;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Copies a back reference that's already been bounds checked
+//          references are at most LZSS_MAX_MATCH long, so unless they overlap or we're near the end of the buffer,
+//          two word sized copies cover them, with the extra bytes overwritten by whatever comes next
+//-----------------------------------------------------------------------------
+static inline void CopyBackReference(unsigned char* pOut, const unsigned char* pOutEnd, size_t iDistance, size_t iCount)
+{
+	const unsigned char* pSource = pOut - iDistance;
+
+	if (iDistance >= 8 && size_t(pOutEnd - pOut) >= LZSS_MAX_MATCH)
+	{
+		// the second copy can read what the first one wrote, but neither overlaps itself
+		memcpy(pOut, pSource, 8);
+		memcpy(pOut + 8, pSource + 8, 8);
+	}
+	else if (iDistance == 1)
+		memset(pOut, *pSource, iCount);
+	else
+	{
+		for (size_t i = 0; i < iCount; i++)
+			pOut[i] = pSource[i];
+	}
+}
+
+unsigned int LZSS_Decompress(const unsigned char* pInput, size_t iInputSize, unsigned char* pOutput, unsigned int iOutputSize)
+{
+	if (!pInput || iInputSize < sizeof(lzss_header_t))
+		return 0;
+
+	lzss_header_t header;
+	memcpy(&header, pInput, sizeof(header));
+
+	if (!header.actualSize || header.id != LZSS_ID || header.actualSize > iOutputSize)
+		return 0;
+
+	const unsigned char* pIn = pInput + sizeof(header);
+	const unsigned char* const pInEnd = pInput + iInputSize;
+
+	// anything that would write past actualSize fails the size check at the end anyway, so stop there
+	unsigned char* pOut = pOutput;
+	unsigned char* const pOutEnd = pOutput + header.actualSize;
+
+	for (;;)
+	{
+		if (pIn == pInEnd)
+			return 0;
+
+		unsigned int cmdByte = *pIn++;
+
+		// a whole group of literals
+		if (!cmdByte && pInEnd - pIn >= 8 && pOutEnd - pOut >= 8)
+		{
+			memcpy(pOut, pIn, 8);
+			pIn += 8;
+			pOut += 8;
+			continue;
+		}
+
+		for (int i = 0; i < 8; i++, cmdByte >>= 1)
+		{
+			if (cmdByte & 0x01)
+			{
+				if (pInEnd - pIn < 2)
+					return 0;
+
+				size_t position = ((size_t(pIn[0]) << LZSS_LOOKSHIFT) | (pIn[1] >> LZSS_LOOKSHIFT)) + 1;
+				size_t count = (pIn[1] & 0x0F) + 1;
+				pIn += 2;
+
+				if (count == 1)
+					return pOut == pOutEnd ? header.actualSize : 0;
+
+				// ensure reference chunk exists entirely within our buffer
+				if (position > size_t(pOut - pOutput) || count > size_t(pOutEnd - pOut))
+					return 0;
+
+				CopyBackReference(pOut, pOutEnd, position, count);
+				pOut += count;
+			}
+			else
+			{
+				if (pIn == pInEnd || pOut == pOutEnd)
+					return 0;
+
+				*pOut++ = *pIn++;
+			}
+		}
+	}
+}
+
+static inline size_t HashLZSSPosition(const unsigned char* pData)
+{
+	unsigned int iValue = pData[0] | (pData[1] << 8) | (pData[2] << 16);
+	return (iValue * 2654435761u) >> (32 - LZSS_HASH_BITS);
+}
+
+size_t LZSS_Compress(const unsigned char* pInput, unsigned int iInputSize, unsigned char* pOutput, size_t iOutputSize)
+{
+	if (iOutputSize < LZSS_GetMaxCompressedSize(iInputSize))
+		return 0;
+
+	lzss_header_t header {LZSS_ID, iInputSize};
+	memcpy(pOutput, &header, sizeof(header));
+	unsigned char* pOut = pOutput + sizeof(header);
+
+	// most recent position for each hash, and the previous position with the same hash for each position in the window
+	std::vector<int> vHashHeads(1 << LZSS_HASH_BITS, -1);
+	std::vector<int> vHashChain(LZSS_WINDOW_SIZE, -1);
+
+	auto fnInsert = [&](size_t iPosition)
+	{
+		if (iPosition + LZSS_MIN_MATCH > iInputSize)
+			return;
+
+		size_t iHash = HashLZSSPosition(pInput + iPosition);
+		vHashChain[iPosition & (LZSS_WINDOW_SIZE - 1)] = vHashHeads[iHash];
+		vHashHeads[iHash] = int(iPosition);
+	};
+
+	unsigned char* pCmdByte = nullptr;
+	int iCmdBit = 8;
+
+	auto fnNextCommand = [&](bool bBackReference)
+	{
+		if (iCmdBit == 8)
+		{
+			pCmdByte = pOut++;
+			*pCmdByte = 0;
+			iCmdBit = 0;
+		}
+
+		if (bBackReference)
+			*pCmdByte |= 1 << iCmdBit;
+
+		iCmdBit++;
+	};
+
+	size_t i = 0;
+	while (i < iInputSize)
+	{
+		size_t iBestLength = 0;
+		size_t iBestDistance = 0;
+
+		if (iInputSize - i >= LZSS_MIN_MATCH)
+		{
+			size_t iMaxLength = std::min(LZSS_MAX_MATCH, iInputSize - i);
+
+			int iCandidate = vHashHeads[HashLZSSPosition(pInput + i)];
+			for (int iDepth = 0; iCandidate >= 0 && i - size_t(iCandidate) <= LZSS_WINDOW_SIZE && iDepth < LZSS_MAX_CHAIN; iDepth++)
+			{
+				const unsigned char* pMatch = pInput + iCandidate;
+				size_t iLength = 0;
+				while (iLength < iMaxLength && pMatch[iLength] == pInput[i + iLength])
+					iLength++;
+
+				if (iLength > iBestLength)
+				{
+					iBestLength = iLength;
+					iBestDistance = i - iCandidate;
+
+					if (iLength == iMaxLength)
+						break;
+				}
+
+				// chain entries only ever point backwards, anything else is a slot reused by a newer position
+				int iNext = vHashChain[iCandidate & (LZSS_WINDOW_SIZE - 1)];
+				if (iNext >= iCandidate)
+					break;
+
+				iCandidate = iNext;
+			}
+		}
+
+		if (iBestLength >= LZSS_MIN_MATCH)
+		{
+			fnNextCommand(true);
+			*pOut++ = (unsigned char)((iBestDistance - 1) >> LZSS_LOOKSHIFT);
+			*pOut++ = (unsigned char)((((iBestDistance - 1) & 0x0F) << LZSS_LOOKSHIFT) | (iBestLength - 1));
+
+			for (size_t j = 0; j < iBestLength; j++)
+				fnInsert(i + j);
+
+			i += iBestLength;
+		}
+		else
+		{
+			fnNextCommand(false);
+			*pOut++ = pInput[i];
+
+			fnInsert(i);
+			i++;
+		}
+	}
+
+	// terminator, a back reference with a length of 1
+	fnNextCommand(true);
+	*pOut++ = 0;
+	*pOut++ = 0;
+
+	return pOut - pOutput;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// LZSS as used by the engine's CLZSS, for netchan payloads
+// an 8 byte header, then groups of 8 commands each preceded by a byte of flags, low bit first
+// a clear flag is a literal byte, a set flag is a 2 byte back reference: 12 bits of distance - 1 and 4 bits of length - 1
+// a back reference with a length of 1 ends the stream
+
+constexpr unsigned int LZSS_ID = 0x53535A4C; // "LZSS"
+constexpr int LZSS_LOOKSHIFT = 4;
+constexpr size_t LZSS_WINDOW_SIZE = 1 << 12;
+constexpr size_t LZSS_MIN_MATCH = 3;
+constexpr size_t LZSS_MAX_MATCH = 1 << LZSS_LOOKSHIFT;
+
+struct lzss_header_t
+{
+	unsigned int id;
+	unsigned int actualSize;
+};
+
+// largest possible valid payload that decompresses to iDecompressedSize bytes, i.e. every byte stored as a literal
+size_t LZSS_GetMaxCompressedSize(size_t iDecompressedSize);
+
+// returns the decompressed size, or 0 if the payload is malformed, truncated or doesn't fit in pOutput
+unsigned int LZSS_Decompress(const unsigned char* pInput, size_t iInputSize, unsigned char* pOutput, unsigned int iOutputSize);
+// returns the compressed size, or 0 if pOutput is smaller than LZSS_GetMaxCompressedSize(iInputSize)
+size_t LZSS_Compress(const unsigned char* pInput, unsigned int iInputSize, unsigned char* pOutput, size_t iOutputSize);
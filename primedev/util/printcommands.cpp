@@ -2,6 +2,7 @@
 #include "core/convar/cvar.h"
 #include "core/convar/convar.h"
 #include "core/convar/concommand.h"
+#include "core/convar/cvarindex.h"
 
 void PrintCommandHelpDialogue(const ConCommandBase* command, const char* name)
 {
@@ -73,6 +74,20 @@ void TryPrintCvarHelpForCommand(const char* pCommand)
 	delete[] pCvarStr;
 }
 
+// gets all convars/concommands that aren't hidden or devonly, sorted by name
+std::vector<ConCommandBase*> GetVisibleCommands()
+{
+	std::vector<ConCommandBase*> vCommands = g_pCvarIndex->GetAll();
+	vCommands.erase(
+		std::remove_if(
+			vCommands.begin(),
+			vCommands.end(),
+			[](ConCommandBase* var) { return var->IsFlagSet(FCVAR_DEVELOPMENTONLY) || var->IsFlagSet(FCVAR_HIDDEN); }),
+		vCommands.end());
+
+	return vCommands;
+}
+
 void ConCommand_help(const CCommand& arg)
 {
 	if (arg.ArgC() < 2)
@@ -81,57 +96,69 @@ void ConCommand_help(const CCommand& arg)
 		return;
 	}
 
-	PrintCommandHelpDialogue(g_pCVar->FindCommandBase(arg.Arg(1)), arg.Arg(1));
-}
-
-void ConCommand_find(const CCommand& arg)
-{
-	if (arg.ArgC() < 2)
+	ConCommandBase* pCommand = g_pCVar->FindCommandBase(arg.Arg(1));
+	if (pCommand)
 	{
-		spdlog::info("Usage: find <string> [<string>...]");
+		PrintCommandHelpDialogue(pCommand, arg.Arg(1));
 		return;
 	}
 
-	char pTempName[256];
-	char pTempSearchTerm[256];
+	spdlog::info("unknown command {}", arg.Arg(1));
 
-	ConCommandBase* var;
-	CCVarIteratorInternal* itint = g_pCVar->FactoryInternalIterator();
-	std::map<std::string, ConCommandBase*> sorted;
-	for (itint->SetFirst(); itint->IsValid(); itint->Next())
+	// suggest anything that starts with what they typed
+	std::vector<ConCommandBase*> vSuggestions = g_pCvarIndex->FindPrefix(arg.Arg(1), 10, FCVAR_DEVELOPMENTONLY | FCVAR_HIDDEN);
+	if (!vSuggestions.empty())
 	{
-		var = itint->Get();
-		if (!var->IsFlagSet(FCVAR_DEVELOPMENTONLY) && !var->IsFlagSet(FCVAR_HIDDEN))
-		{
-			sorted.insert({var->m_pszName, var});
-		}
+		spdlog::info("did you mean:");
+		for (ConCommandBase* pSuggestion : vSuggestions)
+			spdlog::info("   - {}", pSuggestion->m_pszName);
 	}
-	delete itint;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Completes the first argument of a command with convar/concommand names
+//-----------------------------------------------------------------------------
+int ConCommand_cvarNameCompletion(const char* const partial, char commands[COMMAND_COMPLETION_MAXITEMS][COMMAND_COMPLETION_ITEM_LENGTH])
+{
+	const char* space = strchr(partial, ' ');
+	if (!space)
+		return 0;
 
-	for (auto& map : sorted)
+	const char* query = space + 1;
+	const size_t cmdLength = query - partial;
+	if (cmdLength >= COMMAND_COMPLETION_ITEM_LENGTH)
+		return 0;
+
+	int numCompletions = 0;
+	for (ConCommandBase* pCommand : g_pCvarIndex->FindPrefix(query, COMMAND_COMPLETION_MAXITEMS, FCVAR_DEVELOPMENTONLY | FCVAR_HIDDEN))
 	{
-		bool bPrintCommand = true;
-		for (int i = 0; i < arg.ArgC() - 1; i++)
-		{
-			// make lowercase to avoid case sensitivity
-			strncpy_s(pTempName, sizeof(pTempName), map.second->m_pszName, sizeof(pTempName) - 1);
-			strncpy_s(pTempSearchTerm, sizeof(pTempSearchTerm), arg.Arg(i + 1), sizeof(pTempSearchTerm) - 1);
+		strncpy(commands[numCompletions], partial, cmdLength);
+		strncpy_s(
+			commands[numCompletions++] + cmdLength,
+			COMMAND_COMPLETION_ITEM_LENGTH - cmdLength,
+			pCommand->m_pszName,
+			COMMAND_COMPLETION_ITEM_LENGTH - cmdLength - 1);
+	}
 
-			for (int i = 0; pTempName[i]; i++)
-				pTempName[i] = tolower(pTempName[i]);
+	return numCompletions;
+}
 
-			for (int i = 0; pTempSearchTerm[i]; i++)
-				pTempSearchTerm[i] = tolower(pTempSearchTerm[i]);
+void ConCommand_find(const CCommand& arg)
+{
+	if (arg.ArgC() < 2)
+	{
+		spdlog::info("Usage: find <string> [<string>...]");
+		return;
+	}
 
-			if (!strstr(pTempName, pTempSearchTerm))
-			{
-				bPrintCommand = false;
-				break;
-			}
-		}
+	std::vector<std::string> vTerms;
+	for (int i = 1; i < arg.ArgC(); i++)
+		vTerms.push_back(arg.Arg(i));
 
-		if (bPrintCommand)
-			PrintCommandHelpDialogue(map.second, map.second->m_pszName);
+	for (ConCommandBase* var : g_pCvarIndex->FindSubstrings(vTerms))
+	{
+		if (!var->IsFlagSet(FCVAR_DEVELOPMENTONLY) && !var->IsFlagSet(FCVAR_HIDDEN))
+			PrintCommandHelpDialogue(var, var->m_pszName);
 	}
 }
 
@@ -164,23 +191,12 @@ void ConCommand_findflags(const CCommand& arg)
 		}
 	}
 
-	ConCommandBase* var;
-	CCVarIteratorInternal* itint = g_pCVar->FactoryInternalIterator();
-	std::map<std::string, ConCommandBase*> sorted;
-	for (itint->SetFirst(); itint->IsValid(); itint->Next())
-	{
-		var = itint->Get();
-		if (!var->IsFlagSet(FCVAR_DEVELOPMENTONLY) && !var->IsFlagSet(FCVAR_HIDDEN))
-		{
-			sorted.insert({var->m_pszName, var});
-		}
-	}
-	delete itint;
+	std::vector<ConCommandBase*> sorted = GetVisibleCommands();
 
-	for (auto& map : sorted)
+	for (ConCommandBase* var : sorted)
 	{
-		if (map.second->m_nFlags & resolvedFlag)
-			PrintCommandHelpDialogue(map.second, map.second->m_pszName);
+		if (var->m_nFlags & resolvedFlag)
+			PrintCommandHelpDialogue(var, var->m_pszName);
 	}
 
 	delete[] upperFlag;
@@ -189,22 +205,11 @@ void ConCommand_findflags(const CCommand& arg)
 void ConCommand_list(const CCommand& arg)
 {
 	NOTE_UNUSED(arg);
-	ConCommandBase* var;
-	CCVarIteratorInternal* itint = g_pCVar->FactoryInternalIterator();
-	std::map<std::string, ConCommandBase*> sorted;
-	for (itint->SetFirst(); itint->IsValid(); itint->Next())
-	{
-		var = itint->Get();
-		if (!var->IsFlagSet(FCVAR_DEVELOPMENTONLY) && !var->IsFlagSet(FCVAR_HIDDEN))
-		{
-			sorted.insert({var->m_pszName, var});
-		}
-	}
-	delete itint;
+	std::vector<ConCommandBase*> sorted = GetVisibleCommands();
 
-	for (auto& map : sorted)
+	for (ConCommandBase* var : sorted)
 	{
-		PrintCommandHelpDialogue(map.second, map.second->m_pszName);
+		PrintCommandHelpDialogue(var, var->m_pszName);
 	}
 	spdlog::info("{} total convars/concommands", sorted.size());
 }
@@ -212,22 +217,11 @@ void ConCommand_list(const CCommand& arg)
 void ConCommand_differences(const CCommand& arg)
 {
 	NOTE_UNUSED(arg);
-	CCVarIteratorInternal* itint = g_pCVar->FactoryInternalIterator();
-	std::map<std::string, ConCommandBase*> sorted;
-
-	for (itint->SetFirst(); itint->IsValid(); itint->Next())
-	{
-		ConCommandBase* var = itint->Get();
-		if (!var->IsFlagSet(FCVAR_DEVELOPMENTONLY) && !var->IsFlagSet(FCVAR_HIDDEN))
-		{
-			sorted.insert({var->m_pszName, var});
-		}
-	}
-	delete itint;
+	std::vector<ConCommandBase*> sorted = GetVisibleCommands();
 
-	for (auto& map : sorted)
+	for (ConCommandBase* var : sorted)
 	{
-		ConVar* cvar = g_pCVar->FindVar(map.second->m_pszName);
+		ConVar* cvar = g_pCVar->FindVar(var->m_pszName);
 
 		if (!cvar)
 		{
@@ -265,13 +259,19 @@ void ConCommand_differences(const CCommand& arg)
 void InitialiseCommandPrint()
 {
 	RegisterConCommand(
-		"convar_find", ConCommand_find, "Find convars/concommands with the specified string in their name/help text.", FCVAR_NONE);
+		"convar_find",
+		ConCommand_find,
+		"Find convars/concommands with the specified string in their name/help text.",
+		FCVAR_NONE,
+		ConCommand_cvarNameCompletion);
 
 	// these commands already exist, so we need to modify the preexisting command to use our func instead
 	// and clear the flags also
 	ConCommand* helpCommand = g_pCVar->FindCommand("help");
 	helpCommand->m_nFlags = FCVAR_NONE;
 	helpCommand->m_pCommandCallback = ConCommand_help;
+	helpCommand->m_pCompletionCallback = ConCommand_cvarNameCompletion;
+	helpCommand->m_nCallbackFlags |= 0x3;
 
 	ConCommand* findCommand = g_pCVar->FindCommand("convar_findByFlags");
 	findCommand->m_nFlags = FCVAR_NONE;
@@ -6,30 +6,14 @@
 #include "engine/r2engine.h"
 #include "squirrel/squirrel.h"
 
-#include <filesystem>
-#include <regex>
+#include <algorithm>
 
 AUTOHOOK_INIT()
 
-enum class MapSource_t
-{
-	VPK,
-	GAMEDIR,
-	MOD
-};
-
 const std::unordered_map<MapSource_t, const char*> PrintMapSource = {
 	{MapSource_t::VPK, "VPK"}, {MapSource_t::MOD, "MOD"}, {MapSource_t::GAMEDIR, "R2"}};
 
-struct MapVPKInfo
-{
-	std::string name;
-	std::string parent;
-	MapSource_t source;
-};
-
-// our current list of maps in the game
-std::vector<MapVPKInfo> vMapList;
+MapCatalogue g_MapCatalogue;
 
 typedef void (*Host_Map_helperType)(const CCommand&, void*);
 typedef void (*Host_Changelevel_fType)(const CCommand&);
@@ -37,90 +21,104 @@ typedef void (*Host_Changelevel_fType)(const CCommand&);
 Host_Map_helperType Host_Map_helper;
 Host_Changelevel_fType Host_Changelevel_f;
 
-void RefreshMapList()
+bool MapCatalogue::DirectoryWatch_t::PollChanged(const fs::path& path, double flTime)
 {
-	// Only update the maps list every 10 seconds max to we avoid constantly reading fs
-	static double fLastRefresh = -999;
-
-	if (fLastRefresh + 10.0 > g_pGlobals->m_flRealTime)
-		return;
+	if (hChange == INVALID_HANDLE_VALUE)
+	{
+		// the directory might not exist, so only try again every so often, scanning whatever's there when we do
+		if (flTime < flNextAttemptTime)
+			return false;
 
-	fLastRefresh = g_pGlobals->m_flRealTime;
+		flNextAttemptTime = flTime + 10.0;
+		hChange = FindFirstChangeNotificationW(path.c_str(), FALSE, FILE_NOTIFY_CHANGE_FILE_NAME);
+		return true;
+	}
 
-	// Rebuild map list
-	vMapList.clear();
+	if (WaitForSingleObject(hChange, 0) != WAIT_OBJECT_0)
+		return false;
 
-	// get modded maps
-	// TODO: could probably check mod vpks to get mapnames from there too?
-	for (auto& modFilePair : g_pModManager->m_ModFiles)
+	// rearm before the caller rescans, so changes made during the scan aren't missed
+	if (!FindNextChangeNotification(hChange))
 	{
-		ModOverrideFile file = modFilePair.second;
-		if (file.m_Path.extension() == ".bsp" && file.m_Path.parent_path().string() == "maps") // only allow mod maps actually in /maps atm
-		{
-			MapVPKInfo& map = vMapList.emplace_back();
-			map.name = file.m_Path.stem().string();
-			map.parent = file.m_pOwningMod->Name;
-			map.source = MapSource_t::MOD;
-		}
+		FindCloseChangeNotification(hChange);
+		hChange = INVALID_HANDLE_VALUE;
 	}
 
-	// get maps in vpk
-	{
-		const int iNumRetailNonMapVpks = 1;
-		static const char* const ppRetailNonMapVpks[] = {
-			"englishclient_frontend.bsp.pak000_dir.vpk"}; // don't include mp_common here as it contains mp_lobby
+	return true;
+}
+
+void MapCatalogue::AddModFile(const ModOverrideFile& file)
+{
+	// only allow mod maps actually in /maps atm
+	// TODO: could probably check mod vpks to get mapnames from there too?
+	if (file.m_Path.extension() != ".bsp" || file.m_Path.parent_path().string() != "maps")
+		return;
 
-		// matches directory vpks, and captures their map name in the first group
-		static const std::regex rVpkMapRegex("englishclient_([a-zA-Z0-9_]+)\\.bsp\\.pak000_dir\\.vpk", std::regex::icase);
+	m_ModMaps.insert_or_assign(file.m_Path.stem().string(), file.m_pOwningMod->Name);
+	m_bDirty = true;
+}
 
-		for (fs::directory_entry file : fs::directory_iterator("./vpk"))
-		{
-			std::string pathString = file.path().filename().string();
-
-			bool bIsValidMapVpk = true;
-			for (int i = 0; i < iNumRetailNonMapVpks; i++)
-			{
-				if (!pathString.compare(ppRetailNonMapVpks[i]))
-				{
-					bIsValidMapVpk = false;
-					break;
-				}
-			}
-
-			if (!bIsValidMapVpk)
-				continue;
-
-			// run our map vpk regex on the filename
-			std::smatch match;
-			std::regex_match(pathString, match, rVpkMapRegex);
-
-			if (match.length() < 2)
-				continue;
-
-			std::string mapName = match[1].str();
-			// special case: englishclient_mp_common contains mp_lobby, so hardcode the name here
-			if (mapName == "mp_common")
-				mapName = "mp_lobby";
-
-			MapVPKInfo& map = vMapList.emplace_back();
-			map.name = mapName;
-			map.parent = pathString;
-			map.source = MapSource_t::VPK;
-		}
-	}
+void MapCatalogue::ClearModMaps()
+{
+	m_ModMaps.clear();
+	m_bDirty = true;
+}
 
-	// get maps in game dir
-	std::string gameDir = fmt::format("{}/maps", g_pModName);
-	if (!std::filesystem::exists(gameDir))
+void MapCatalogue::ScanVpkMaps()
+{
+	m_VpkMaps.clear();
+	m_bDirty = true;
+
+	// don't include mp_common here as it contains mp_lobby
+	static const char* const ppRetailNonMapVpks[] = {"englishclient_frontend.bsp.pak000_dir.vpk"};
+
+	// directory vpks are englishclient_<map>.bsp.pak000_dir.vpk, where the map name is alphanumeric or underscores
+	static constexpr std::string_view svVpkPrefix = "englishclient_";
+	static constexpr std::string_view svVpkSuffix = ".bsp.pak000_dir.vpk";
+
+	auto fnEqualsNoCase = [](std::string_view a, std::string_view b)
+	{ return a.size() == b.size() && !_strnicmp(a.data(), b.data(), a.size()); };
+
+	std::error_code ec;
+	for (const fs::directory_entry& file : fs::directory_iterator("./vpk", ec))
 	{
-		return;
+		const std::string pathString = file.path().filename().string();
+
+		if (std::any_of(
+				std::begin(ppRetailNonMapVpks), std::end(ppRetailNonMapVpks), [&](const char* pVpk) { return pathString == pVpk; }))
+			continue;
+
+		if (pathString.size() <= svVpkPrefix.size() + svVpkSuffix.size() ||
+			!fnEqualsNoCase(std::string_view(pathString).substr(0, svVpkPrefix.size()), svVpkPrefix) ||
+			!fnEqualsNoCase(std::string_view(pathString).substr(pathString.size() - svVpkSuffix.size()), svVpkSuffix))
+			continue;
+
+		std::string mapName = pathString.substr(svVpkPrefix.size(), pathString.size() - svVpkPrefix.size() - svVpkSuffix.size());
+		if (!std::all_of(mapName.begin(), mapName.end(), [](unsigned char c) { return std::isalnum(c) || c == '_'; }))
+			continue;
+
+		// special case: englishclient_mp_common contains mp_lobby, so hardcode the name here
+		if (mapName == "mp_common")
+			mapName = "mp_lobby";
+
+		MapVPKInfo& map = m_VpkMaps.emplace_back();
+		map.name = mapName;
+		map.parent = pathString;
+		map.source = MapSource_t::VPK;
 	}
+}
 
-	for (fs::directory_entry file : fs::directory_iterator(gameDir))
+void MapCatalogue::ScanGameDirMaps()
+{
+	m_GameDirMaps.clear();
+	m_bDirty = true;
+
+	std::error_code ec;
+	for (const fs::directory_entry& file : fs::directory_iterator(fmt::format("{}/maps", g_pModName), ec))
 	{
 		if (file.path().extension() == ".bsp")
 		{
-			MapVPKInfo& map = vMapList.emplace_back();
+			MapVPKInfo& map = m_GameDirMaps.emplace_back();
 			map.name = file.path().stem().string();
 			map.parent = "R2";
 			map.source = MapSource_t::GAMEDIR;
@@ -128,6 +126,56 @@ void RefreshMapList()
 	}
 }
 
+void MapCatalogue::Update(double flTime)
+{
+	if (m_VpkWatch.PollChanged("./vpk", flTime))
+		ScanVpkMaps();
+
+	if (m_GameDirWatch.PollChanged(fmt::format("{}/maps", g_pModName), flTime))
+		ScanGameDirMaps();
+
+	if (!m_bDirty)
+		return;
+
+	m_Maps.clear();
+	m_Maps.reserve(m_ModMaps.size() + m_VpkMaps.size() + m_GameDirMaps.size());
+
+	for (const auto& [mapName, modName] : m_ModMaps)
+		m_Maps.push_back({mapName, modName, MapSource_t::MOD});
+
+	m_Maps.insert(m_Maps.end(), m_VpkMaps.begin(), m_VpkMaps.end());
+	m_Maps.insert(m_Maps.end(), m_GameDirMaps.begin(), m_GameDirMaps.end());
+
+	// stable, so a map that's in several places keeps them in the order above
+	std::stable_sort(m_Maps.begin(), m_Maps.end(), [](const MapVPKInfo& a, const MapVPKInfo& b) { return a.name < b.name; });
+	m_bDirty = false;
+}
+
+std::pair<MapCatalogue::MapIterator_t, MapCatalogue::MapIterator_t> MapCatalogue::FindByPrefix(std::string_view svPrefix) const
+{
+	auto begin = std::lower_bound(
+		m_Maps.begin(), m_Maps.end(), svPrefix, [](const MapVPKInfo& map, std::string_view svValue) { return map.name < svValue; });
+
+	auto end = begin;
+	while (end != m_Maps.end() && std::string_view(end->name).starts_with(svPrefix))
+		++end;
+
+	return {begin, end};
+}
+
+bool MapCatalogue::HasMap(std::string_view svName) const
+{
+	auto begin = std::lower_bound(
+		m_Maps.begin(), m_Maps.end(), svName, [](const MapVPKInfo& map, std::string_view svValue) { return map.name < svValue; });
+
+	return begin != m_Maps.end() && begin->name == svName;
+}
+
+void RefreshMapList()
+{
+	g_MapCatalogue.Update(g_pGlobals->m_flRealTime);
+}
+
 // clang-format off
 AUTOHOOK(_Host_Map_f_CompletionFunc, engine.dll + 0x161AE0,
 int, __fastcall, (const char *const cmdname, const char *const partial, char commands[COMMAND_COMPLETION_MAXITEMS][COMMAND_COMPLETION_ITEM_LENGTH]))
@@ -141,17 +189,15 @@ int, __fastcall, (const char *const cmdname, const char *const partial, char com
 	const size_t queryLength = strlen(query);
 
 	int numMaps = 0;
-	for (int i = 0; i < vMapList.size() && numMaps < COMMAND_COMPLETION_MAXITEMS; i++)
+	auto [begin, end] = g_MapCatalogue.FindByPrefix(std::string_view(query, queryLength));
+	for (auto it = begin; it != end && numMaps < COMMAND_COMPLETION_MAXITEMS; ++it)
 	{
-		if (!strncmp(query, vMapList[i].name.c_str(), queryLength))
-		{
-			strcpy(commands[numMaps], cmdname);
-			strncpy_s(
-				commands[numMaps++] + cmdLength,
-				COMMAND_COMPLETION_ITEM_LENGTH,
-				&vMapList[i].name[0],
-				COMMAND_COMPLETION_ITEM_LENGTH - cmdLength);
-		}
+		strcpy(commands[numMaps], cmdname);
+		strncpy_s(
+			commands[numMaps++] + cmdLength,
+			COMMAND_COMPLETION_ITEM_LENGTH,
+			&it->name[0],
+			COMMAND_COMPLETION_ITEM_LENGTH - cmdLength);
 	}
 
 	return numMaps;
@@ -164,12 +210,11 @@ ADD_SQFUNC(
 	"Returns a string array of loaded map file names",
 	ScriptContext::UI | ScriptContext::CLIENT | ScriptContext::SERVER)
 {
-	// Maybe we should call this on mods reload instead
 	RefreshMapList();
 
 	g_pSquirrel[context]->newarray(sqvm, 0);
 
-	for (MapVPKInfo& map : vMapList)
+	for (const MapVPKInfo& map : g_MapCatalogue.GetMaps())
 	{
 		g_pSquirrel[context]->pushstring(sqvm, map.name.c_str());
 		g_pSquirrel[context]->arrayappend(sqvm, -2);
@@ -189,7 +234,8 @@ void ConCommand_maps(const CCommand& args)
 
 	RefreshMapList();
 
-	for (MapVPKInfo& map : vMapList) // need to figure out a nice way to include parent path without making the formatting awful
+	// need to figure out a nice way to include parent path without making the formatting awful
+	for (const MapVPKInfo& map : g_MapCatalogue.GetMaps())
 		if ((*args.Arg(1) == '*' && !args.Arg(1)[1]) || strstr(map.name.c_str(), args.Arg(1)))
 			spdlog::info("({}) {}", PrintMapSource.at(map.source), map.name);
 }
@@ -205,9 +251,7 @@ AUTOHOOK(Host_Map_f, engine.dll + 0x15B340, void, __fastcall, (const CCommand& a
 		spdlog::warn("Map load failed: too many arguments provided");
 		return;
 	}
-	else if (
-		args.ArgC() == 2 &&
-		std::find_if(vMapList.begin(), vMapList.end(), [&](MapVPKInfo map) -> bool { return map.name == args.Arg(1); }) == vMapList.end())
+	else if (args.ArgC() == 2 && !g_MapCatalogue.HasMap(args.Arg(1)))
 	{
 		spdlog::warn("Map load failed: {} not found or invalid", args.Arg(1));
 		return;
@@ -1,2 +1,79 @@
 #pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct ModOverrideFile;
+
+enum class MapSource_t
+{
+	VPK,
+	GAMEDIR,
+	MOD
+};
+
+struct MapVPKInfo
+{
+	std::string name;
+	std::string parent;
+	MapSource_t source;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Keeps track of every map in the game, so map commands don't have to go looking for them every time
+//          mod maps are added as mods register their files, and map directories are only rescanned when windows says they changed
+//-----------------------------------------------------------------------------
+class MapCatalogue
+{
+public:
+	using MapIterator_t = std::vector<MapVPKInfo>::const_iterator;
+
+private:
+	// tells us when files are added to, removed from or renamed in a directory
+	struct DirectoryWatch_t
+	{
+		HANDLE hChange = INVALID_HANDLE_VALUE;
+		double flNextAttemptTime = 0.0;
+
+		// true the first time, and then whenever the directory has changed since we last asked
+		bool PollChanged(const fs::path& path, double flTime);
+	};
+
+	// map name => owning mod, later mods override maps from earlier ones like any other file
+	std::unordered_map<std::string, std::string> m_ModMaps;
+	std::vector<MapVPKInfo> m_VpkMaps;
+	std::vector<MapVPKInfo> m_GameDirMaps;
+
+	DirectoryWatch_t m_VpkWatch;
+	DirectoryWatch_t m_GameDirWatch;
+
+	// every map from all of the above, sorted by name
+	std::vector<MapVPKInfo> m_Maps;
+	bool m_bDirty = true;
+
+public:
+	// called for every file a mod registers, anything that isn't a map is ignored
+	void AddModFile(const ModOverrideFile& file);
+	void ClearModMaps();
+
+	// rescans map directories that have changed, and rebuilds the map list if anything did
+	void Update(double flTime);
+
+	const std::vector<MapVPKInfo>& GetMaps() const { return m_Maps; }
+	// maps with names starting with svPrefix, as a range of GetMaps()
+	std::pair<MapIterator_t, MapIterator_t> FindByPrefix(std::string_view svPrefix) const;
+	bool HasMap(std::string_view svName) const;
+
+private:
+	void ScanVpkMaps();
+	void ScanGameDirMaps();
+};
+
+extern MapCatalogue g_MapCatalogue;
+
 void InitialiseMapsPrint();
@@ -1,13 +1,13 @@
 #include <ctype.h>
+#include <emmintrin.h>
 #include "utils.h"
 
-bool skip_valid_ansi_csi_sgr(char*& str)
+// checks for an ANSI CSI SGR sequence (\x1B[...m) at str, a sequence cut off by the end of the string counts as valid
+static bool is_valid_ansi_csi_sgr(const char* str, const char* end)
 {
-	if (*str++ != '\x1B')
+	if (end - str < 2 || str[0] != '\x1B' || str[1] != '[') // CSI
 		return false;
-	if (*str++ != '[') // CSI
-		return false;
-	for (char* c = str; *c; c++)
+	for (const char* c = str + 2; c != end && *c; c++)
 	{
 		if (*c >= '0' && *c <= '9')
 			continue;
@@ -20,9 +20,36 @@ bool skip_valid_ansi_csi_sgr(char*& str)
 	return true;
 }
 
-void RemoveAsciiControlSequences(char* str, bool allow_color_codes)
+// printable ASCII is always left alone, so skip over it 16 bytes at a time
+static char* skip_printable_ascii(char* str, const char* end)
 {
-	for (char *pc = str, c = *pc; c = *pc; pc++)
+	const __m128i lowest_control = _mm_set1_epi8(0x1F);
+	const __m128i del = _mm_set1_epi8(0x7F);
+
+	for (; end - str >= 16; str += 16)
+	{
+		__m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+
+		// bytes with the top bit set compare as negative, so this catches both control characters and non-ASCII
+		int printable = _mm_movemask_epi8(_mm_cmpgt_epi8(chars, lowest_control)) & ~_mm_movemask_epi8(_mm_cmpeq_epi8(chars, del));
+		if (printable != 0xFFFF)
+		{
+			unsigned long index = 0;
+			_BitScanForward(&index, ~printable);
+			return str + index;
+		}
+	}
+
+	while (str != end && *str >= 0x20 && *str != 0x7F)
+		str++;
+
+	return str;
+}
+
+void RemoveAsciiControlSequences(char* str, size_t len, bool allow_color_codes)
+{
+	char* end = str + len;
+	for (char *pc = skip_printable_ascii(str, end), c; pc != end && (c = *pc); pc = skip_printable_ascii(pc + 1, end))
 	{
 		// skip UTF-8 characters
 		int bytesToSkip = 0;
@@ -41,16 +68,14 @@ void RemoveAsciiControlSequences(char* str, bool allow_color_codes)
 		char* orgpc = pc;
 		for (int i = 0; i < bytesToSkip; i++)
 		{
-			char next = pc[1];
-
 			// valid UTF-8 part
-			if ((next & 0xC0) == 0x80)
+			if (pc + 1 != end && (pc[1] & 0xC0) == 0x80)
 			{
 				pc++;
 				continue;
 			}
 
-			// invalid UTF-8 part or encountered \0
+			// invalid UTF-8 part or encountered the end of the string
 			invalid = true;
 			break;
 		}
@@ -58,25 +83,24 @@ void RemoveAsciiControlSequences(char* str, bool allow_color_codes)
 		{
 			// erase the whole "UTF-8" sequence
 			for (char* x = orgpc; x <= pc; x++)
-				if (*x != '\0')
-					*x = ' ';
-				else
-					break;
+				*x = ' ';
 		}
 		if (bytesToSkip > 0)
 			continue; // this byte was already handled as UTF-8
 
 		// an invalid control character or an UTF-8 part outside of UTF-8 sequence
-		if ((iscntrl(c) && c != '\n' && c != '\r' && c != '\x1B') || (c & 0x80) != 0)
+		if ((c & 0x80) != 0 || (iscntrl(c) && c != '\n' && c != '\r' && c != '\x1B'))
 		{
 			*pc = ' ';
 			continue;
 		}
 
 		if (c == '\x1B') // separate handling for this escape sequence...
-			if (allow_color_codes && skip_valid_ansi_csi_sgr(pc)) // ...which we allow for color codes...
-				pc--;
+		{
+			if (allow_color_codes && is_valid_ansi_csi_sgr(pc, end)) // ...which we allow for color codes...
+				pc++; // skip the [ too, the rest is printable
 			else // ...but remove it otherwise
 				*pc = ' ';
+		}
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 
-void RemoveAsciiControlSequences(char* str, bool allow_color_codes);
+// sanitises at most len bytes of str in place, stopping early at a null terminator
+void RemoveAsciiControlSequences(char* str, size_t len, bool allow_color_codes);
 
 template <typename T> class ScopeGuard
 {
@@ -0,0 +1,105 @@
+#include "core/filesystem/pakprefetch.h"
+#include "core/filesystem/simulatedfileio.h"
+#include "nstest.h"
+
+constexpr size_t MB = 1024 * 1024;
+
+static void WaitForIdle(PakPrefetcher& prefetcher)
+{
+	while (!prefetcher.IsIdle())
+		std::this_thread::yield();
+}
+
+static void TestBudget()
+{
+	PrefetchIoBudget budget;
+	budget.SetRate(100, 50, 0.0);
+
+	// starts with a full burst, and never gives out more than that
+	NS_CHECK(budget.Acquire(80, 0.0) == 50);
+	NS_CHECK(budget.GetWaitTime(50, 0.0) == 0.5);
+	NS_CHECK(budget.Acquire(50, 0.25) == 25);
+	NS_CHECK(budget.GetWaitTime(1000, 10.0) == 0.0);
+
+	// a rate of 0 is unlimited
+	budget.SetRate(0, 50, 0.0);
+	NS_CHECK(budget.Acquire(1000, 0.0) == 1000);
+	NS_CHECK(budget.GetWaitTime(1000, 0.0) == 0.0);
+}
+
+static void TestRateLimitedReads()
+{
+	SimulatedFileIo simulatedIo;
+	simulatedIo.AddFile("a", 10 * MB);
+	simulatedIo.AddFile("b", 3 * MB);
+	simulatedIo.AddFile("c", 1234567);
+
+	PakPrefetcher prefetcher(simulatedIo.GetFileIo());
+	prefetcher.Prefetch({"a", "missing", "b", "c"}, 2 * MB);
+	WaitForIdle(prefetcher);
+
+	// missing files are skipped
+	const size_t iTotal = 13 * MB + 1234567;
+	NS_CHECK(prefetcher.GetBytesRead() == iTotal);
+	NS_CHECK(prefetcher.GetFilesRead() == 3);
+	NS_CHECK(simulatedIo.GetOpenFileCount() == 0);
+
+	// the first chunk comes out of the initial burst, everything after that is limited to the rate
+	const double flExpectedTime = (iTotal - PakPrefetcher::READ_CHUNK_SIZE) / double(2 * MB);
+	NS_CHECK(simulatedIo.GetTime() >= flExpectedTime * 0.95);
+	NS_CHECK(simulatedIo.GetTime() <= flExpectedTime * 1.1);
+}
+
+static void TestReplacingQueue()
+{
+	SimulatedFileIo simulatedIo;
+	simulatedIo.AddFile("big", 1000 * MB);
+	simulatedIo.AddFile("c", 1234567);
+
+	PakPrefetcher prefetcher(simulatedIo.GetFileIo());
+	prefetcher.Prefetch({"big"}, 1 * MB);
+	while (prefetcher.GetBytesRead() < 5 * MB)
+		std::this_thread::yield();
+
+	// the big file is given up on part way through, and its handle closed
+	prefetcher.Prefetch({"c"}, 0);
+	WaitForIdle(prefetcher);
+
+	NS_CHECK(prefetcher.GetFilesRead() == 1);
+	NS_CHECK(prefetcher.GetBytesRead() - 1234567 < 500 * MB);
+	NS_CHECK(simulatedIo.GetOpenFileCount() == 0);
+
+	// cancelling leaves it idle, and shutting down with work queued doesn't hang
+	prefetcher.Prefetch({"big"}, 1 * MB);
+	prefetcher.Cancel();
+	WaitForIdle(prefetcher);
+	prefetcher.Prefetch({"big"}, 1 * MB);
+	prefetcher.Shutdown();
+	NS_CHECK(simulatedIo.GetOpenFileCount() == 0);
+}
+
+static void TestMapFileStems()
+{
+	NS_CHECK(IsMapFileStem("mp_box", "mp_box"));
+	NS_CHECK(IsMapFileStem("mp_box_large", "mp_box"));
+	NS_CHECK(IsMapFileStem("mp_box_extra_large", "mp_box"));
+	NS_CHECK(IsMapFileStem("mp_box_script", "mp_box"));
+	NS_CHECK(IsMapFileStem("mp_box.bsp.0000", "mp_box"));
+
+	// other maps that share a prefix with this one
+	NS_CHECK(!IsMapFileStem("mp_box_xyz", "mp_box"));
+	NS_CHECK(!IsMapFileStem("mp_box_xyz_large", "mp_box"));
+	NS_CHECK(!IsMapFileStem("mp_boxes", "mp_box"));
+	NS_CHECK(!IsMapFileStem("mp_bo", "mp_box"));
+	NS_CHECK(!IsMapFileStem("mp_box_", "mp_box"));
+}
+
+int main()
+{
+	TestBudget();
+	TestMapFileStems();
+	TestRateLimitedReads();
+	TestReplacingQueue();
+
+	return NS_TestResult();
+}
@@ -0,0 +1,126 @@
+#include "core/math/bitbuf.h"
+#include "nstest.h"
+
+// compares the bulk and byte aligned paths against doing the same work one field at a time
+
+// prints how many bits each iteration moved per nanosecond, under the time NS_Benchmark printed for it
+static void PrintThroughput(double flNanoseconds, double flBits)
+{
+	printf("%-48s %12.2f bits/ns\n", "  throughput", flBits / flNanoseconds);
+}
+
+int main()
+{
+	constexpr size_t FIELD_COUNT = 100000;
+	constexpr int FIELD_BITS = 11;
+
+	std::vector<u32> fields(FIELD_COUNT);
+	for (size_t i = 0; i < FIELD_COUNT; i++)
+		fields[i] = u32(i * 2654435761u) & s_nMaskTable[FIELD_BITS];
+
+	std::vector<u8> buffer(FIELD_COUNT * 4 + 64);
+	std::vector<u8> bytes(1 << 20, 7);
+
+	PrintThroughput(
+		NS_Benchmark(
+			"WriteUBitLong x100000, 11 bits",
+			100,
+			[&]
+			{
+				BFWrite writer(uptr(buffer.data()), buffer.size());
+				for (u32 field : fields)
+					writer.WriteUBitLong(field, FIELD_BITS);
+				NS_DoNotOptimise(writer.GetNumBitsWritten());
+			}),
+		FIELD_COUNT * FIELD_BITS);
+
+	PrintThroughput(
+		NS_Benchmark(
+			"WriteUBitLongArray x100000, 11 bits",
+			100,
+			[&]
+			{
+				BFWrite writer(uptr(buffer.data()), buffer.size());
+				writer.WriteUBitLongArray(fields.data(), fields.size(), FIELD_BITS);
+				NS_DoNotOptimise(writer.GetNumBitsWritten());
+			}),
+		FIELD_COUNT * FIELD_BITS);
+
+	std::vector<u32> readFields(FIELD_COUNT);
+	PrintThroughput(
+		NS_Benchmark(
+			"ReadUBitLong x100000, 11 bits",
+			100,
+			[&]
+			{
+				BFRead reader(uptr(buffer.data()), buffer.size());
+				for (u32& field : readFields)
+					field = reader.ReadUBitLong(FIELD_BITS);
+				NS_DoNotOptimise(readFields[FIELD_COUNT - 1]);
+			}),
+		FIELD_COUNT * FIELD_BITS);
+
+	PrintThroughput(
+		NS_Benchmark(
+			"ReadUBitLongArray x100000, 11 bits",
+			100,
+			[&]
+			{
+				BFRead reader(uptr(buffer.data()), buffer.size());
+				reader.ReadUBitLongArray(readFields.data(), readFields.size(), FIELD_BITS);
+				NS_DoNotOptimise(readFields[FIELD_COUNT - 1]);
+			}),
+		FIELD_COUNT * FIELD_BITS);
+
+	std::vector<u8> out(bytes.size() + 64);
+	PrintThroughput(
+		NS_Benchmark(
+			"WriteBytes 1MB, aligned",
+			100,
+			[&]
+			{
+				BFWrite writer(uptr(out.data()), out.size());
+				writer.WriteBytes(uptr(bytes.data()), i32(bytes.size()));
+				NS_DoNotOptimise(writer.GetNumBitsWritten());
+			}),
+		bytes.size() * 8.0);
+
+	PrintThroughput(
+		NS_Benchmark(
+			"WriteBytes 1MB, 3 bits in",
+			100,
+			[&]
+			{
+				BFWrite writer(uptr(out.data()), out.size());
+				writer.WriteUBitLong(0, 3);
+				writer.WriteBytes(uptr(bytes.data()), i32(bytes.size()) - 4);
+				NS_DoNotOptimise(writer.GetNumBitsWritten());
+			}),
+		(bytes.size() - 4) * 8.0);
+
+	PrintThroughput(
+		NS_Benchmark(
+			"ReadBytes 1MB, aligned",
+			100,
+			[&]
+			{
+				BFRead reader(uptr(bytes.data()), bytes.size());
+				reader.ReadBytes(uptr(out.data()), u32(bytes.size()));
+				NS_DoNotOptimise(out[0]);
+			}),
+		bytes.size() * 8.0);
+
+	PrintThroughput(
+		NS_Benchmark(
+			"ReadBytes 1MB, 3 bits in",
+			100,
+			[&]
+			{
+				BFRead reader(uptr(bytes.data()), bytes.size(), 3);
+				reader.ReadBytes(uptr(out.data()), u32(bytes.size()) - 4);
+				NS_DoNotOptimise(out[0]);
+			}),
+		(bytes.size() - 4) * 8.0);
+
+	return 0;
+}
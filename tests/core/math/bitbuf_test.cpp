@@ -0,0 +1,230 @@
+#include "core/math/bitbuf.h"
+#include "nstest.h"
+
+#include <random>
+
+// checks the bit buffers against a bit at a time reference, fields are packed lsb first into little endian dwords
+
+static u32 ReferenceRead(const std::vector<u8>& data, size_t bitPos, int numBits)
+{
+	u32 value = 0;
+	for (int i = 0; i < numBits; i++)
+		value |= u32((data[(bitPos + i) >> 3] >> ((bitPos + i) & 7)) & 1) << i;
+
+	return value;
+}
+
+static void ReferenceWrite(std::vector<bool>& bits, u32 value, int numBits)
+{
+	for (int i = 0; i < numBits; i++)
+		bits.push_back((value >> i) & 1);
+}
+
+static void FuzzReads(std::mt19937_64& rng, int iterations)
+{
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		// exactly sized heap buffer, so running off the end shows up under asan
+		const size_t byteLength = 1 + rng() % 64;
+		std::vector<u8> data(byteLength);
+		for (u8& byte : data)
+			byte = u8(rng());
+
+		u8* buffer = new u8[byteLength];
+		memcpy(buffer, data.data(), byteLength);
+
+		const size_t numBits = byteLength * 8;
+		BFRead reader(uptr(buffer), byteLength, rng() % (numBits + 1));
+		for (int op = 0; op < 20; op++)
+		{
+			const size_t bitPos = reader.GetNumBitsRead();
+			const size_t bitsLeft = numBits - bitPos;
+			if (!bitsLeft)
+				break;
+
+			bool ok = true;
+			switch (rng() % 4)
+			{
+			case 0:
+			{
+				const int width = 1 + rng() % std::min<size_t>(32, bitsLeft);
+				ok = reader.ReadUBitLong(width) == ReferenceRead(data, bitPos, width);
+				break;
+			}
+			case 1:
+			{
+				const int width = 1 + rng() % std::min<size_t>(32, bitsLeft);
+				const size_t count = rng() % (bitsLeft / width + 1);
+				std::vector<u32> values(count);
+				reader.ReadUBitLongArray(values.data(), count, width);
+				for (size_t i = 0; i < count; i++)
+					ok &= values[i] == ReferenceRead(data, bitPos + i * width, width);
+				break;
+			}
+			case 2:
+			{
+				// misaligned output too, ReadBits aligns it itself
+				const u32 bits = rng() % (bitsLeft + 1);
+				const size_t outOffset = rng() % 4;
+				std::vector<u8> out(outOffset + (bits + 7) / 8 + 4, 0);
+				reader.ReadBits(uptr(out.data() + outOffset), bits);
+				for (u32 i = 0; i < bits; i++)
+					ok &= ((out[outOffset + i / 8] >> (i & 7)) & 1) == ReferenceRead(data, bitPos + i, 1);
+				break;
+			}
+			case 3:
+				reader.Seek(rng() % (numBits + 1));
+				break;
+			}
+
+			ok &= !reader.IsOverflowed();
+			if (!ok)
+			{
+				fprintf(stderr, "read mismatch, iteration %d op %d, %zu byte buffer at bit %zu\n", it, op, byteLength, bitPos);
+				failures++;
+				break;
+			}
+		}
+
+		delete[] buffer;
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+// reads that run off the end have to leave the reader in the same state whichever path they took
+static void FuzzOverflowingReads(std::mt19937_64& rng, int iterations)
+{
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		const size_t byteLength = 1 + rng() % 16;
+		std::vector<u8> data(byteLength);
+		for (u8& byte : data)
+			byte = u8(rng());
+
+		const size_t startPos = rng() % (byteLength * 8 + 1);
+		BFRead scalar(uptr(data.data()), byteLength, startPos);
+		BFRead bulk(uptr(data.data()), byteLength, startPos);
+
+		const int width = 1 + rng() % 32;
+		const size_t count = 1 + rng() % 16;
+		std::vector<u32> scalarValues(count), bulkValues(count);
+		for (size_t i = 0; i < count; i++)
+			scalarValues[i] = scalar.ReadUBitLong(width);
+		bulk.ReadUBitLongArray(bulkValues.data(), count, width);
+
+		if (scalarValues != bulkValues || scalar.IsOverflowed() != bulk.IsOverflowed() ||
+			scalar.GetNumBitsRead() != bulk.GetNumBitsRead())
+		{
+			fprintf(stderr, "overflowing read mismatch, iteration %d\n", it);
+			failures++;
+		}
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+static void FuzzWrites(std::mt19937_64& rng, int iterations)
+{
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		// plenty of room, overflow isn't what's being tested here
+		std::vector<u8> buffer(4096, 0xCD);
+		BFWrite writer(uptr(buffer.data()), buffer.size());
+		std::vector<bool> bits;
+
+		for (int op = 0; op < 40; op++)
+		{
+			switch (rng() % 4)
+			{
+			case 0:
+			{
+				// high bits past the width must not leak into the next field
+				const int width = 1 + rng() % 32;
+				const u32 value = u32(rng());
+				writer.WriteUBitLong(value, width, rng() & 1);
+				ReferenceWrite(bits, value, width);
+				break;
+			}
+			case 1:
+			{
+				const int width = 1 + rng() % 32;
+				std::vector<u32> values(rng() % 16);
+				for (u32& value : values)
+					value = u32(rng());
+
+				writer.WriteUBitLongArray(values.data(), values.size(), width);
+				for (u32 value : values)
+					ReferenceWrite(bits, value, width);
+				break;
+			}
+			case 2:
+			{
+				std::vector<u8> bytes(rng() % 40);
+				for (u8& byte : bytes)
+					byte = u8(rng());
+
+				writer.WriteBytes(uptr(bytes.data()), i32(bytes.size()));
+				for (u8 byte : bytes)
+					ReferenceWrite(bits, byte, 8);
+				break;
+			}
+			case 3:
+			{
+				const int value = int(rng() & 1);
+				writer.WriteOneBit(value);
+				ReferenceWrite(bits, value, 1);
+				break;
+			}
+			}
+		}
+
+		bool ok = !writer.IsOverflowed() && size_t(writer.GetNumBitsWritten()) == bits.size();
+
+		const u8* out = writer.GetData();
+		for (size_t i = 0; i < bits.size() && ok; i++)
+			ok = ((out[i >> 3] >> (i & 7)) & 1) == bits[i];
+
+		if (!ok)
+		{
+			fprintf(stderr, "write mismatch, iteration %d, %zu bits written\n", it, bits.size());
+			failures++;
+		}
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+static void TestWriteOverflow()
+{
+	u8 buffer[8] {};
+	BFWrite writer(uptr(buffer), sizeof(buffer));
+
+	const u32 values[3] = {1, 2, 3};
+	writer.WriteUBitLongArray(values, 2, 32);
+	NS_CHECK(!writer.IsOverflowed());
+
+	writer.WriteUBitLong(values[2], 32);
+	NS_CHECK(writer.IsOverflowed());
+
+	u8 bytes[16] {};
+	BFWrite byteWriter(uptr(buffer), sizeof(buffer));
+	NS_CHECK(!byteWriter.WriteBytes(uptr(bytes), sizeof(bytes)));
+	NS_CHECK(byteWriter.IsOverflowed());
+}
+
+int main(int argc, char** argv)
+{
+	const int iterations = argc > 1 ? atoi(argv[1]) : 20000;
+	std::mt19937_64 rng(argc > 2 ? strtoull(argv[2], nullptr, 10) : 1234);
+
+	FuzzReads(rng, iterations);
+	FuzzOverflowingReads(rng, iterations);
+	FuzzWrites(rng, iterations);
+	TestWriteOverflow();
+
+	return NS_TestResult();
+}
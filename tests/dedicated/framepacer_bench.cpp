@@ -0,0 +1,97 @@
+#include "dedicated/framepacer.h"
+#include "nstest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+// stands in for g_pEngine->Frame(), busy for a random fraction of the tick like a real server frame
+static void SimulateFrame(std::mt19937& rng, double flInterval)
+{
+	const std::chrono::duration<double> frameTime(flInterval * (0.1 + (rng() % 400) / 1000.0));
+	const Clock::time_point end = Clock::now() + std::chrono::duration_cast<Clock::duration>(frameTime);
+	while (Clock::now() < end)
+		;
+}
+
+static void PrintJitter(const char* pszName, const std::vector<double>& vIntervals, double flInterval, double flElapsed)
+{
+	double flSum = 0.0;
+	double flWorst = 0.0;
+	for (double flTick : vIntervals)
+	{
+		flSum += std::abs(flTick - flInterval);
+		flWorst = std::max(flWorst, std::abs(flTick - flInterval));
+	}
+
+	std::vector<double> vSorted = vIntervals;
+	std::sort(vSorted.begin(), vSorted.end());
+
+	printf("%s\n", pszName);
+	printf("  %-46s %12.1f us\n", "mean abs tick interval error", flSum / vIntervals.size() * 1e6);
+	printf("  %-46s %12.1f us\n", "p99 tick interval", vSorted[vSorted.size() * 99 / 100] * 1e6);
+	printf("  %-46s %12.1f us\n", "worst tick interval error", flWorst * 1e6);
+	// the old loop's errors add up, so the server slowly runs fewer ticks than its tickrate
+	printf("  %-46s %12.1f us\n", "drift over the run", (flElapsed - vIntervals.size() * flInterval) * 1e6);
+}
+
+int main(int argc, char** argv)
+{
+	const int iTicks = argc > 1 ? atoi(argv[1]) : 300;
+	const double flInterval = 1.0 / 60.0;
+
+	std::vector<double> vIntervals;
+	vIntervals.reserve(iTicks);
+
+	// what RunServer does with ns_tickpacer_enable 0, sleep for whatever is left of the tick after the frame
+	{
+		std::mt19937 rng(1);
+		const Clock::time_point start = Clock::now();
+		Clock::time_point lastTick = start;
+		for (int i = 0; i < iTicks; i++)
+		{
+			const Clock::time_point frameStart = Clock::now();
+			if (i)
+				vIntervals.push_back(std::chrono::duration<double>(frameStart - lastTick).count());
+			lastTick = frameStart;
+
+			SimulateFrame(rng, flInterval);
+			const double flFrameTime = std::chrono::duration<double>(Clock::now() - frameStart).count();
+			std::this_thread::sleep_for(std::chrono::duration<double>(flInterval - std::min(flFrameTime, 0.25)));
+		}
+
+		PrintJitter("sleep after frame", vIntervals, flInterval, std::chrono::duration<double>(lastTick - start).count());
+	}
+
+	vIntervals.clear();
+	{
+		std::mt19937 rng(1);
+		CFramePacer pacer;
+		pacer.SetInterval(flInterval);
+
+		Clock::time_point start;
+		Clock::time_point lastTick;
+		for (int i = 0; i < iTicks; i++)
+		{
+			pacer.WaitForNextFrame();
+
+			const Clock::time_point frameStart = Clock::now();
+			if (i)
+				vIntervals.push_back(std::chrono::duration<double>(frameStart - lastTick).count());
+			else
+				start = frameStart;
+			lastTick = frameStart;
+
+			SimulateFrame(rng, flInterval);
+		}
+
+		PrintJitter("frame pacer", vIntervals, flInterval, std::chrono::duration<double>(lastTick - start).count());
+		printf("  %-46s %12.1f us\n", "spin window", pacer.GetSpinTime() * 1e6);
+		printf("  %-46s %12llu\n", "resyncs", (unsigned long long)pacer.m_iResyncs);
+	}
+
+	return 0;
+}
@@ -0,0 +1,125 @@
+#include "dedicated/framepacer.h"
+#include "nstest.h"
+
+#include <cmath>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+// intervals are long compared to the os timer, so only stalls we cause ourselves can make a frame late
+constexpr double INTERVAL = 0.02;
+
+static double SecondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void Stall(double flSeconds)
+{
+	std::this_thread::sleep_for(std::chrono::duration<double>(flSeconds));
+}
+
+static void TestSchedule()
+{
+	CFramePacer pacer;
+	pacer.SetInterval(INTERVAL);
+
+	// the first frame starts the schedule straight away
+	Clock::time_point start = Clock::now();
+	pacer.WaitForNextFrame();
+	NS_CHECK(SecondsSince(start) < INTERVAL);
+
+	// frames never start before their deadline, and deadlines follow each other rather than when frames finished
+	start = Clock::now();
+	for (int i = 0; i < 10; i++)
+	{
+		Stall(INTERVAL / 4);
+		pacer.WaitForNextFrame();
+	}
+
+	NS_CHECK(SecondsSince(start) >= 10 * INTERVAL - 0.001);
+	NS_CHECK(pacer.m_IntervalHistogram.m_iCount == 10);
+	NS_CHECK(pacer.m_iResyncs == 0);
+}
+
+static void TestBoundedCatchup()
+{
+	CFramePacer pacer;
+	pacer.SetInterval(INTERVAL);
+	pacer.m_eCatchup = eFramePacerCatchup::BOUNDED;
+	pacer.m_iMaxCatchupFrames = 4;
+
+	pacer.WaitForNextFrame();
+	const Clock::time_point start = Clock::now();
+
+	// a frame that runs over by half an interval is caught up on, the next frame runs back to back
+	Stall(INTERVAL * 1.5);
+	pacer.WaitForNextFrame();
+	NS_CHECK(pacer.m_iResyncs == 0);
+
+	// which keeps the original schedule, the third frame is due two intervals after the first
+	pacer.WaitForNextFrame();
+	NS_CHECK(SecondsSince(start) >= 2 * INTERVAL - 0.001);
+	NS_CHECK(pacer.m_iResyncs == 0);
+
+	// a stall longer than the catchup limit restarts the schedule from now instead
+	Stall(INTERVAL * 10);
+	pacer.WaitForNextFrame();
+	NS_CHECK(pacer.m_iResyncs == 1);
+
+	const Clock::time_point resyncTime = Clock::now();
+	pacer.WaitForNextFrame();
+	NS_CHECK(SecondsSince(resyncTime) >= INTERVAL - 0.002);
+}
+
+static void TestResync()
+{
+	CFramePacer pacer;
+	pacer.SetInterval(INTERVAL);
+	pacer.m_eCatchup = eFramePacerCatchup::RESYNC;
+
+	pacer.WaitForNextFrame();
+
+	// any missed deadline restarts the schedule, frames are never run back to back
+	Stall(INTERVAL * 1.5);
+	pacer.WaitForNextFrame();
+	NS_CHECK(pacer.m_iResyncs == 1);
+
+	const Clock::time_point resyncTime = Clock::now();
+	pacer.WaitForNextFrame();
+	NS_CHECK(SecondsSince(resyncTime) >= INTERVAL - 0.002);
+	NS_CHECK(pacer.m_iResyncs == 1);
+
+	// a reset schedule starts again on the next frame without counting as a resync
+	pacer.Reset();
+	Stall(INTERVAL * 3);
+	const Clock::time_point resetTime = Clock::now();
+	pacer.WaitForNextFrame();
+	NS_CHECK(SecondsSince(resetTime) < INTERVAL);
+	NS_CHECK(pacer.m_iResyncs == 1);
+}
+
+static void TestHistogram()
+{
+	CPacerHistogram histogram;
+	histogram.Setup(0.001, 10);
+	for (int i = 0; i < 100; i++)
+		histogram.Add(i < 90 ? 0.0005 : 0.0055);
+
+	histogram.Add(1.0);
+	NS_CHECK(histogram.m_iCount == 101);
+	NS_CHECK(histogram.m_iOverflow == 1);
+	NS_CHECK(histogram.GetPercentile(0.5) == 0.001);
+	NS_CHECK(std::abs(histogram.GetPercentile(0.95) - 0.006) < 1e-9);
+	NS_CHECK(histogram.GetPercentile(1.0) == 1.0);
+}
+
+int main()
+{
+	TestSchedule();
+	TestBoundedCatchup();
+	TestResync();
+	TestHistogram();
+
+	return NS_TestResult();
+}
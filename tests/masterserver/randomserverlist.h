@@ -0,0 +1,42 @@
+#pragma once
+
+#include "masterserver/masterserver.h"
+
+#include <random>
+
+//-----------------------------------------------------------------------------
+// Purpose: Makes a server list with roughly the shape of a real one, names and descriptions of varying length and a
+//          handful of required mods per server
+//-----------------------------------------------------------------------------
+inline std::vector<RemoteServerInfo> MakeRandomServerList(std::mt19937& rng, int iServers)
+{
+	auto fnRandomString = [&](int iMaxLength)
+	{
+		std::string sValue(rng() % iMaxLength, ' ');
+		for (char& c : sValue)
+			c = 'a' + rng() % 26;
+
+		return sValue;
+	};
+
+	std::vector<RemoteServerInfo> vServers;
+	vServers.reserve(iServers);
+	for (int i = 0; i < iServers; i++)
+	{
+		RemoteServerInfo& server = vServers.emplace_back(
+			fnRandomString(33).c_str(),
+			fnRandomString(70).c_str(),
+			fnRandomString(300).c_str(),
+			fnRandomString(20).c_str(),
+			fnRandomString(16).c_str(),
+			fnRandomString(10).c_str(),
+			(int)(rng() % 32),
+			32,
+			(bool)(rng() & 1));
+
+		for (int iMods = rng() % 8; iMods; iMods--)
+			server.requiredMods.push_back({fnRandomString(30), fnRandomString(8)});
+	}
+
+	return vServers;
+}
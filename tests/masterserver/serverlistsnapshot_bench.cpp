@@ -0,0 +1,116 @@
+#include "masterserver/serverlistsnapshot.h"
+#include "randomserverlist.h"
+#include "nstest.h"
+
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+// the same list as a masterserver response, which is what the browser had to wait for before snapshots
+static std::string WriteServerListJson(const std::vector<RemoteServerInfo>& vServers)
+{
+	rapidjson::StringBuffer buffer;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+
+	writer.StartArray();
+	for (const RemoteServerInfo& server : vServers)
+	{
+		writer.StartObject();
+		writer.Key("id");
+		writer.String(server.id);
+		writer.Key("name");
+		writer.String(server.name);
+		writer.Key("description");
+		writer.String(server.description.c_str());
+		writer.Key("map");
+		writer.String(server.map);
+		writer.Key("playlist");
+		writer.String(server.playlist);
+		writer.Key("region");
+		writer.String(server.region);
+		writer.Key("playerCount");
+		writer.Int(server.playerCount);
+		writer.Key("maxPlayers");
+		writer.Int(server.maxPlayers);
+		writer.Key("hasPassword");
+		writer.Bool(server.requiresPassword);
+
+		writer.Key("modInfo");
+		writer.StartObject();
+		writer.Key("Mods");
+		writer.StartArray();
+		for (const RemoteModInfo& mod : server.requiredMods)
+		{
+			writer.StartObject();
+			writer.Key("Name");
+			writer.String(mod.Name.c_str());
+			writer.Key("Version");
+			writer.String(mod.Version.c_str());
+			writer.Key("RequiredOnClient");
+			writer.Bool(true);
+			writer.EndObject();
+		}
+		writer.EndArray();
+		writer.EndObject();
+
+		writer.EndObject();
+	}
+	writer.EndArray();
+
+	return buffer.GetString();
+}
+
+// parses a response the way MasterServerManager::RequestServerList does, minus the checks for malformed servers
+static void ReadServerListJson(const std::string& sJson, std::vector<RemoteServerInfo>& vServers)
+{
+	rapidjson::Document document;
+	document.Parse(sJson.c_str());
+
+	vServers.clear();
+	for (auto& serverObj : document.GetArray())
+	{
+		RemoteServerInfo& server = vServers.emplace_back(
+			serverObj["id"].GetString(),
+			serverObj["name"].GetString(),
+			serverObj["description"].GetString(),
+			serverObj["map"].GetString(),
+			serverObj["playlist"].GetString(),
+			serverObj["region"].GetString(),
+			serverObj["playerCount"].GetInt(),
+			serverObj["maxPlayers"].GetInt(),
+			serverObj["hasPassword"].IsTrue());
+
+		for (auto& requiredMod : serverObj["modInfo"]["Mods"].GetArray())
+			server.requiredMods.push_back({requiredMod["Name"].GetString(), requiredMod["Version"].GetString()});
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(5);
+
+	// a few thousand servers is already more than the masterserver usually lists
+	for (int iServers : {500, 3000})
+	{
+		const std::vector<RemoteServerInfo> vServers = MakeRandomServerList(rng, iServers);
+		const std::string sJson = WriteServerListJson(vServers);
+
+		std::string sSnapshot;
+		WriteServerListSnapshot(vServers, 0, sSnapshot);
+		printf("%d servers, %zu bytes of json, %zu byte snapshot\n", iServers, sJson.size(), sSnapshot.size());
+
+		std::vector<RemoteServerInfo> vRead;
+		int64_t iSavedTime;
+		std::string sError;
+		const double flJson = NS_Benchmark("parse masterserver json", 50, [&] { ReadServerListJson(sJson, vRead); });
+		const double flSnapshot = NS_Benchmark(
+			"read snapshot",
+			50,
+			[&] { NS_DoNotOptimise(ReadServerListSnapshot(sSnapshot.data(), sSnapshot.size(), vRead, iSavedTime, sError)); });
+		printf("%-48s %12.2fx\n", "speedup", flJson / flSnapshot);
+
+		NS_Benchmark("write snapshot", 50, [&] { WriteServerListSnapshot(vServers, 0, sSnapshot); });
+	}
+
+	return 0;
+}
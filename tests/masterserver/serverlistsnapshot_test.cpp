@@ -0,0 +1,102 @@
+#include "masterserver/serverlistsnapshot.h"
+#include "randomserverlist.h"
+#include "nstest.h"
+
+static bool ServersMatch(const RemoteServerInfo& a, const RemoteServerInfo& b)
+{
+	if (strcmp(a.id, b.id) || strcmp(a.name, b.name) || a.description != b.description || strcmp(a.map, b.map) ||
+		strcmp(a.playlist, b.playlist) || strcmp(a.region, b.region) || a.playerCount != b.playerCount || a.maxPlayers != b.maxPlayers ||
+		a.requiresPassword != b.requiresPassword || a.requiredMods.size() != b.requiredMods.size())
+		return false;
+
+	for (size_t i = 0; i < a.requiredMods.size(); i++)
+	{
+		if (a.requiredMods[i].Name != b.requiredMods[i].Name || a.requiredMods[i].Version != b.requiredMods[i].Version)
+			return false;
+	}
+
+	return true;
+}
+
+static void TestRoundTrip(std::mt19937& rng)
+{
+	const std::vector<RemoteServerInfo> vServers = MakeRandomServerList(rng, 500);
+
+	std::string sSnapshot;
+	WriteServerListSnapshot(vServers, 12345, sSnapshot);
+
+	std::vector<RemoteServerInfo> vRead;
+	int64_t iSavedTime = 0;
+	std::string sError;
+	NS_CHECK(ReadServerListSnapshot(sSnapshot.data(), sSnapshot.size(), vRead, iSavedTime, sError));
+	NS_CHECK(iSavedTime == 12345);
+	NS_CHECK(vRead.size() == vServers.size());
+
+	bool bAllMatch = vRead.size() == vServers.size();
+	for (size_t i = 0; bAllMatch && i < vServers.size(); i++)
+		bAllMatch = ServersMatch(vRead[i], vServers[i]);
+
+	NS_CHECK(bAllMatch);
+
+	// an empty list is still a valid snapshot
+	WriteServerListSnapshot({}, 1, sSnapshot);
+	NS_CHECK(ReadServerListSnapshot(sSnapshot.data(), sSnapshot.size(), vRead, iSavedTime, sError) && vRead.empty());
+}
+
+static void TestCorruption(std::mt19937& rng)
+{
+	const std::vector<RemoteServerInfo> vServers = MakeRandomServerList(rng, 200);
+
+	std::string sSnapshot;
+	WriteServerListSnapshot(vServers, 12345, sSnapshot);
+
+	std::vector<RemoteServerInfo> vRead;
+	int64_t iSavedTime;
+	std::string sError;
+
+	// truncated snapshots, e.g. from running out of disk space, are rejected and leave nothing behind
+	bool bAllRejected = true;
+	for (size_t iSize = 0; iSize < sSnapshot.size(); iSize += 1 + sSnapshot.size() / 500)
+		bAllRejected &= !ReadServerListSnapshot(sSnapshot.data(), iSize, vRead, iSavedTime, sError) && vRead.empty();
+
+	NS_CHECK(bAllRejected);
+
+	// any flipped bit is caught, by the header checks or by the checksum
+	bAllRejected = true;
+	for (int i = 0; i < 500; i++)
+	{
+		std::string sCorrupted = sSnapshot;
+		sCorrupted[rng() % sCorrupted.size()] ^= 1 << (rng() % 8);
+		bAllRejected &= !ReadServerListSnapshot(sCorrupted.data(), sCorrupted.size(), vRead, iSavedTime, sError) && vRead.empty();
+	}
+
+	NS_CHECK(bAllRejected);
+
+	std::string sTrailing = sSnapshot + '\0';
+	NS_CHECK(!ReadServerListSnapshot(sTrailing.data(), sTrailing.size(), vRead, iSavedTime, sError));
+
+	// headers from other versions are ignored even when the payload is fine
+	ServerListSnapshotHeader_t header;
+	std::string sOtherVersion = sSnapshot;
+	memcpy(&header, sOtherVersion.data(), sizeof(header));
+	header.iVersion++;
+	memcpy(sOtherVersion.data(), &header, sizeof(header));
+	NS_CHECK(!ReadServerListSnapshot(sOtherVersion.data(), sOtherVersion.size(), vRead, iSavedTime, sError));
+
+	// a huge server count behind a valid checksum mustn't turn into a huge allocation
+	std::string sBadCount = sSnapshot;
+	memcpy(&header, sBadCount.data(), sizeof(header));
+	header.iServerCount = UINT32_MAX;
+	memcpy(sBadCount.data(), &header, sizeof(header));
+	NS_CHECK(!ReadServerListSnapshot(sBadCount.data(), sBadCount.size(), vRead, iSavedTime, sError));
+	NS_CHECK(sError == "snapshot has more servers than fit in it");
+}
+
+int main()
+{
+	std::mt19937 rng(5);
+	TestRoundTrip(rng);
+	TestCorruption(rng);
+
+	return NS_TestResult();
+}
@@ -0,0 +1,74 @@
+#include "mods/modmanager.h"
+#include "nstest.h"
+
+#include <algorithm>
+
+// how h_BinkOpen found the overriding mod before the registry, a scan over every loaded mod's videos
+static Mod* FindBinkOwner(std::vector<Mod>& vMods, const std::string& sFilename)
+{
+	Mod* pOwner = nullptr;
+	for (Mod& mod : vMods)
+	{
+		if (!mod.m_bEnabled)
+			continue;
+
+		if (std::find(mod.BinkVideos.begin(), mod.BinkVideos.end(), sFilename) != mod.BinkVideos.end())
+			pOwner = &mod;
+	}
+
+	return pOwner;
+}
+
+// and how VMCreated resolved each dependency constant
+static bool IsModEnabled(const std::vector<Mod>& vMods, const std::string& sName)
+{
+	for (const Mod& mod : vMods)
+	{
+		if (mod.m_bEnabled && mod.Name == sName)
+			return true;
+	}
+
+	return false;
+}
+
+int main()
+{
+	// a big but real mod list, most mods don't ship videos
+	std::vector<Mod> vMods(300);
+	for (size_t i = 0; i < vMods.size(); i++)
+	{
+		vMods[i].Name = "Author.Mod" + std::to_string(i);
+		vMods[i].m_bEnabled = i % 7 != 3;
+		if (i % 10 == 0)
+			vMods[i].BinkVideos = {"menu_act0" + std::to_string(i % 4) + ".bik", "mod" + std::to_string(i) + ".bik"};
+	}
+
+	ModRegistry_t registry;
+	registry.Build(vMods);
+
+	// the game opens both videos that are overridden and ones that aren't
+	const std::string sVideos[] = {"menu_act01.bik", "mod150.bik", "intro.bik", "ea.bik"};
+	int iOpen = 0;
+	const double flScan =
+		NS_Benchmark("bink owner, scan", 100000, [&] { NS_DoNotOptimise(FindBinkOwner(vMods, sVideos[iOpen++ % 4])); });
+	const double flRegistry = NS_Benchmark(
+		"bink owner, registry",
+		100000,
+		[&] { NS_DoNotOptimise(registry.binkVideos.find(sVideos[iOpen++ % 4]) != registry.binkVideos.end()); });
+	printf("%-48s %12.2fx\n", "speedup", flScan / flRegistry);
+
+	const std::string sDependencies[] = {"Author.Mod7", "Author.Mod299", "Missing.Mod"};
+	int iDependency = 0;
+	const double flDependencyScan =
+		NS_Benchmark("dependency constant, scan", 100000, [&] { NS_DoNotOptimise(IsModEnabled(vMods, sDependencies[iDependency++ % 3])); });
+	const double flDependencyRegistry = NS_Benchmark(
+		"dependency constant, registry",
+		100000,
+		[&] { NS_DoNotOptimise(registry.modsByName.contains(sDependencies[iDependency++ % 3])); });
+	printf("%-48s %12.2fx\n", "speedup", flDependencyScan / flDependencyRegistry);
+
+	// what toggling a mod in the menu now costs
+	NS_Benchmark("rebuild registry", 10000, [&] { registry.Build(vMods); });
+
+	return 0;
+}
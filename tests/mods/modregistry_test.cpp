@@ -0,0 +1,45 @@
+#include "mods/modmanager.h"
+#include "nstest.h"
+
+static Mod MakeMod(const char* pszName, std::vector<std::string> vBinkVideos, bool bEnabled = true)
+{
+	Mod mod;
+	mod.Name = pszName;
+	mod.BinkVideos = std::move(vBinkVideos);
+	mod.m_bEnabled = bEnabled;
+	return mod;
+}
+
+int main()
+{
+	std::vector<Mod> vMods;
+	vMods.push_back(MakeMod("Northstar.Client", {"intro.bik"}));
+	vMods.push_back(MakeMod("Disabled", {"menu_act01.bik"}, false));
+	vMods.push_back(MakeMod("Late", {"intro.bik", "menu_act02.bik"}));
+
+	ModRegistry_t registry;
+	registry.Build(vMods);
+
+	NS_CHECK(registry.enabledMods.size() == 2);
+	NS_CHECK(registry.enabledMods[0] == &vMods[0] && registry.enabledMods[1] == &vMods[2]);
+	NS_CHECK(registry.modsByName.contains("Northstar.Client") && !registry.modsByName.contains("Disabled"));
+
+	// mods loaded later win, disabled mods don't override anything
+	NS_CHECK(registry.binkVideos.at("intro.bik") == &vMods[2]);
+	NS_CHECK(!registry.binkVideos.contains("menu_act01.bik"));
+
+	// rebuilding picks up mods being toggled, without keeping anything from before
+	vMods[1].m_bEnabled = true;
+	vMods[2].m_bEnabled = false;
+	registry.Build(vMods);
+
+	NS_CHECK(registry.enabledMods.size() == 2 && registry.enabledMods[1] == &vMods[1]);
+	NS_CHECK(registry.modsByName.contains("Disabled") && !registry.modsByName.contains("Late"));
+	NS_CHECK(registry.binkVideos.at("intro.bik") == &vMods[0]);
+	NS_CHECK(registry.binkVideos.contains("menu_act01.bik") && !registry.binkVideos.contains("menu_act02.bik"));
+
+	registry.Clear();
+	NS_CHECK(registry.enabledMods.empty() && registry.modsByName.empty() && registry.binkVideos.empty());
+
+	return NS_TestResult();
+}
@@ -0,0 +1,61 @@
+#include "scripts/scripthttprequestutils.h"
+#include "nstest.h"
+
+#ifdef _WIN32
+#include <ws2tcpip.h>
+#else
+#include <netdb.h>
+#endif
+
+// what every request used to pay before the destination cache, the handler resolves through getaddrinfo too
+static bool Resolve(const char* pszHostname)
+{
+	addrinfo hints {};
+	hints.ai_family = AF_INET;
+
+	addrinfo* pResult = nullptr;
+	if (getaddrinfo(pszHostname, nullptr, &hints, &pResult) != 0)
+		return false;
+
+	freeaddrinfo(pResult);
+	return true;
+}
+
+int main()
+{
+	HttpDestinationCache cache;
+	HttpDestinationCache::Destination_t destination;
+	destination.policy = HttpDestinationCache::Policy::Allowed;
+	destination.sAddress = "127.0.0.1";
+
+	// a realistic number of hosts, mods tend to talk to a handful of apis
+	std::string sHosts[16];
+	for (int i = 0; i < 16; i++)
+	{
+		sHosts[i] = "api" + std::to_string(i) + ".example.com";
+		cache.Store(sHosts[i], destination, 0.0);
+	}
+
+	int iRequest = 0;
+	HttpDestinationCache::Destination_t found;
+	const double flResolve = NS_Benchmark("getaddrinfo localhost", 2000, [] { NS_DoNotOptimise(Resolve("localhost")); });
+	const double flCached =
+		NS_Benchmark("destination cache hit", 1000000, [&] { NS_DoNotOptimise(cache.Find(sHosts[iRequest++ % 16], 1.0, found)); });
+	printf("%-48s %12.2fx\n", "speedup", flResolve / flCached);
+
+	// a full cache, every store has to evict something
+	double flTime = 0.0;
+	for (size_t i = 0; i < HttpDestinationCache::MAX_ENTRIES; i++)
+		cache.Store("host" + std::to_string(i), destination, flTime += 0.001);
+
+	NS_Benchmark(
+		"destination cache store, full",
+		100000,
+		[&] { cache.Store("host" + std::to_string(iRequest++), destination, flTime += 0.001); });
+
+	HttpLatencyWindow window;
+	NS_Benchmark("latency window add", 1000000, [&] { window.Add((iRequest++ % 1000) * 0.001); });
+	NS_Benchmark("latency window p99", 100000, [&] { NS_DoNotOptimise(window.GetPercentile(0.99)); });
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include "scripts/scripthttprequestutils.h"
+#include "nstest.h"
+
+static void TestLatencyWindow()
+{
+	HttpLatencyWindow window;
+	NS_CHECK(window.GetPercentile(0.5) == 0.0);
+
+	for (int i = 1; i <= 100; i++)
+		window.Add(i);
+
+	// nearest rank
+	NS_CHECK(window.GetPercentile(0.0) == 1.0);
+	NS_CHECK(window.GetPercentile(0.5) == 50.0);
+	NS_CHECK(window.GetPercentile(0.99) == 99.0);
+	NS_CHECK(window.GetPercentile(1.0) == 100.0);
+
+	// only the most recent samples are kept
+	for (int i = 0; i < 1000; i++)
+		window.Add(1000 + i);
+
+	NS_CHECK(window.GetSampleCount() == HttpLatencyWindow::MAX_SAMPLES);
+	NS_CHECK(window.GetPercentile(0.0) == 2000.0 - HttpLatencyWindow::MAX_SAMPLES);
+	NS_CHECK(window.GetPercentile(1.0) == 1999.0);
+}
+
+static void TestDestinationCache()
+{
+	HttpDestinationCache cache;
+	HttpDestinationCache::Destination_t destination;
+	HttpDestinationCache::Destination_t found;
+
+	destination.policy = HttpDestinationCache::Policy::Allowed;
+	destination.sAddress = "1.2.3.4";
+	cache.Store("Example.COM", destination, 0.0);
+
+	// hostnames are case insensitive, and entries expire
+	NS_CHECK(cache.Find("example.com", HttpDestinationCache::RESOLVED_TTL - 1.0, found) && found.sAddress == "1.2.3.4");
+	NS_CHECK(!cache.Find("example.com", HttpDestinationCache::RESOLVED_TTL, found));
+
+	// failed lookups don't stick around for as long
+	destination.policy = HttpDestinationCache::Policy::Unresolved;
+	cache.Store("bad", destination, 0.0);
+	NS_CHECK(cache.Find("bad", HttpDestinationCache::UNRESOLVED_TTL - 1.0, found));
+	NS_CHECK(!cache.Find("bad", HttpDestinationCache::UNRESOLVED_TTL, found));
+
+	// when full, whatever is closest to expiring goes first
+	destination.policy = HttpDestinationCache::Policy::Allowed;
+	for (int i = 0; i < 1000; i++)
+		cache.Store("host" + std::to_string(i), destination, i * 0.01);
+
+	NS_CHECK(cache.GetSize() == HttpDestinationCache::MAX_ENTRIES);
+	NS_CHECK(cache.Find("host999", 10.0, found));
+	NS_CHECK(!cache.Find("host0", 10.0, found));
+}
+
+int main()
+{
+	TestLatencyWindow();
+	TestDestinationCache();
+
+	return NS_TestResult();
+}
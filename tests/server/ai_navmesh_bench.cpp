@@ -0,0 +1,212 @@
+#include "server/ai_navmesh.h"
+#include "nstest.h"
+
+#include <random>
+
+constexpr int TILES_PER_SIDE = 16;
+constexpr int GROUND_POLYS_PER_TILE = 400;
+constexpr int OFFMESH_POLYS_PER_TILE = 5;
+constexpr float TILE_SIZE = 2048.0f;
+constexpr float QUERY_RADIUS = 1000.0f;
+
+struct BVItem_t
+{
+	unsigned short bmin[3];
+	unsigned short bmax[3];
+	int i;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: Builds a bounding volume tree the same way detour's createBVTree does, median split on the longest axis,
+//          stored depth first with escape indices
+//-----------------------------------------------------------------------------
+static void Subdivide(std::vector<BVItem_t>& items, int iMin, int iMax, int& iCurNode, dtBVNode* pNodes)
+{
+	const int iNode = iCurNode;
+	dtBVNode& node = pNodes[iCurNode++];
+
+	if (iMax - iMin == 1)
+	{
+		memcpy(node.bmin, items[iMin].bmin, sizeof(node.bmin));
+		memcpy(node.bmax, items[iMin].bmax, sizeof(node.bmax));
+		node.i = items[iMin].i;
+		return;
+	}
+
+	for (int k = 0; k < 3; k++)
+	{
+		node.bmin[k] = 0xFFFF;
+		node.bmax[k] = 0;
+		for (int j = iMin; j < iMax; j++)
+		{
+			node.bmin[k] = std::min(node.bmin[k], items[j].bmin[k]);
+			node.bmax[k] = std::max(node.bmax[k], items[j].bmax[k]);
+		}
+	}
+
+	int iAxis = 0;
+	for (int k = 1; k < 3; k++)
+		if (node.bmax[k] - node.bmin[k] > node.bmax[iAxis] - node.bmin[iAxis])
+			iAxis = k;
+
+	std::sort(
+		items.begin() + iMin,
+		items.begin() + iMax,
+		[iAxis](const BVItem_t& a, const BVItem_t& b) { return a.bmin[iAxis] < b.bmin[iAxis]; });
+
+	const int iSplit = iMin + (iMax - iMin) / 2;
+	Subdivide(items, iMin, iSplit, iCurNode, pNodes);
+	Subdivide(items, iSplit, iMax, iCurNode, pNodes);
+	node.i = -(iCurNode - iNode);
+}
+
+struct NavMesh_t
+{
+	std::vector<dtMeshHeader> headers;
+	std::vector<std::vector<dtPoly>> polys;
+	std::vector<std::vector<dtBVNode>> trees;
+	std::vector<dtMeshTile> tiles;
+};
+
+// a grid of tiles with randomly placed polys, roughly the density of a real map's navmesh
+static void BuildNavMesh(NavMesh_t& mesh, std::mt19937& rng)
+{
+	const int nTiles = TILES_PER_SIDE * TILES_PER_SIDE;
+	const int nPolys = GROUND_POLYS_PER_TILE + OFFMESH_POLYS_PER_TILE;
+
+	mesh.headers.resize(nTiles);
+	mesh.polys.resize(nTiles);
+	mesh.trees.resize(nTiles);
+	mesh.tiles.resize(nTiles);
+
+	for (int t = 0; t < nTiles; t++)
+	{
+		dtMeshHeader& header = mesh.headers[t];
+		header = {};
+		header.bmin[0] = (t % TILES_PER_SIDE) * TILE_SIZE;
+		header.bmin[1] = (t / TILES_PER_SIDE) * TILE_SIZE;
+		header.bmin[2] = -100.0f;
+		header.bmax[0] = header.bmin[0] + TILE_SIZE;
+		header.bmax[1] = header.bmin[1] + TILE_SIZE;
+		header.bmax[2] = 500.0f;
+		header.bvQuantFactor = 0.25f;
+		header.polyCount = nPolys;
+		header.offMeshBase = GROUND_POLYS_PER_TILE;
+		header.offMeshConCount = OFFMESH_POLYS_PER_TILE;
+
+		std::vector<BVItem_t> items(GROUND_POLYS_PER_TILE);
+		mesh.polys[t].resize(nPolys);
+		for (int p = 0; p < nPolys; p++)
+		{
+			const Vector3 vOrigin(
+				header.bmin[0] + rng() % (int)TILE_SIZE, header.bmin[1] + rng() % (int)TILE_SIZE, (float)(rng() % 400) - 50.0f);
+			const float flRadius = (float)(rng() % 60 + 5);
+
+			dtPoly& poly = mesh.polys[t][p];
+			poly = {};
+			poly.org = vOrigin;
+			poly.setType(p >= GROUND_POLYS_PER_TILE ? DT_POLYTYPE_OFFMESH_CONNECTION : DT_POLYTYPE_GROUND);
+
+			if (p >= GROUND_POLYS_PER_TILE)
+				continue;
+
+			const float flMins[3] = {
+				std::max(vOrigin.x - flRadius, header.bmin[0]), std::max(vOrigin.y - flRadius, header.bmin[1]), vOrigin.z - 10.0f};
+			const float flMaxs[3] = {
+				std::min(vOrigin.x + flRadius, header.bmax[0]), std::min(vOrigin.y + flRadius, header.bmax[1]), vOrigin.z + 10.0f};
+			for (int k = 0; k < 3; k++)
+			{
+				items[p].bmin[k] = (unsigned short)((flMins[k] - header.bmin[k]) * header.bvQuantFactor);
+				items[p].bmax[k] = (unsigned short)((flMaxs[k] - header.bmin[k]) * header.bvQuantFactor);
+			}
+			items[p].i = p;
+		}
+
+		mesh.trees[t].resize(2 * GROUND_POLYS_PER_TILE);
+		int iNodes = 0;
+		Subdivide(items, 0, GROUND_POLYS_PER_TILE, iNodes, mesh.trees[t].data());
+		header.bvNodeCount = iNodes;
+
+		mesh.tiles[t] = {};
+		mesh.tiles[t].header = &header;
+		mesh.tiles[t].polys = mesh.polys[t].data();
+		mesh.tiles[t].bvTree = mesh.trees[t].data();
+	}
+}
+
+// what the debug drawer does with the bvtree off, every poly in every tile is distance checked
+static int QueryLinear(const NavMesh_t& mesh, Vector3 vCamera, std::vector<std::pair<int, int>>& vFound)
+{
+	vFound.clear();
+	for (size_t t = 0; t < mesh.tiles.size(); t++)
+		for (int p = 0; p < mesh.tiles[t].header->polyCount; p++)
+			if (vCamera.DistTo(mesh.tiles[t].polys[p].org) <= QUERY_RADIUS)
+				vFound.emplace_back((int)t, p);
+
+	return (int)vFound.size();
+}
+
+static int QueryBVTree(const NavMesh_t& mesh, Vector3 vCamera, std::vector<int>& vPolys, std::vector<std::pair<int, int>>& vFound)
+{
+	const Vector3 vMins = vCamera - Vector3(QUERY_RADIUS);
+	const Vector3 vMaxs = vCamera + Vector3(QUERY_RADIUS);
+
+	vFound.clear();
+	for (size_t t = 0; t < mesh.tiles.size(); t++)
+	{
+		const dtMeshTile* pTile = &mesh.tiles[t];
+		if (!NavMesh_TileOverlapsBox(pTile, vMins, vMaxs))
+			continue;
+
+		const int nPolys = NavMesh_QueryPolygonsInTile(pTile, vMins, vMaxs, vPolys.data(), (int)vPolys.size());
+		for (int j = 0; j < nPolys; j++)
+			if (vCamera.DistTo(pTile->polys[vPolys[j]].org) <= QUERY_RADIUS)
+				vFound.emplace_back((int)t, vPolys[j]);
+	}
+
+	return (int)vFound.size();
+}
+
+int main()
+{
+	std::mt19937 rng(5);
+
+	NavMesh_t mesh;
+	BuildNavMesh(mesh, rng);
+
+	constexpr int QUERIES = 256;
+	std::vector<Vector3> vCameras;
+	for (int i = 0; i < QUERIES; i++)
+		vCameras.emplace_back(
+			(float)(rng() % (int)(TILES_PER_SIDE * TILE_SIZE)), (float)(rng() % (int)(TILES_PER_SIDE * TILE_SIZE)), (float)(rng() % 300));
+
+	// both have to find the same polys, just in a different order
+	std::vector<int> vPolys(GROUND_POLYS_PER_TILE + OFFMESH_POLYS_PER_TILE);
+	std::vector<std::pair<int, int>> vLinear, vBVTree;
+	int nMismatches = 0;
+	size_t nFound = 0;
+	for (const Vector3& vCamera : vCameras)
+	{
+		QueryLinear(mesh, vCamera, vLinear);
+		QueryBVTree(mesh, vCamera, vPolys, vBVTree);
+		std::sort(vBVTree.begin(), vBVTree.end());
+		nMismatches += vLinear != vBVTree;
+		nFound += vLinear.size();
+	}
+
+	printf(
+		"%d tiles, %d polys each, %zu polys found per query on average, %d mismatching queries\n",
+		TILES_PER_SIDE * TILES_PER_SIDE,
+		GROUND_POLYS_PER_TILE + OFFMESH_POLYS_PER_TILE,
+		nFound / QUERIES,
+		nMismatches);
+
+	int iQuery = 0;
+	const double flLinear =
+		NS_Benchmark("linear", 2000, [&] { NS_DoNotOptimise(QueryLinear(mesh, vCameras[iQuery++ % QUERIES], vLinear)); });
+	const double flBVTree =
+		NS_Benchmark("bvtree", 2000, [&] { NS_DoNotOptimise(QueryBVTree(mesh, vCameras[iQuery++ % QUERIES], vPolys, vBVTree)); });
+
+	printf("%-48s %12.2fx\n", "speedup", flLinear / flBVTree);
+	return nMismatches ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+#include "server/ainfile.h"
+#include "nstest.h"
+
+#include <random>
+
+// independent writer following the order the original DumpAINInfo wrote things in
+template <typename T> static void Append(std::vector<char>& buffer, const T& value)
+{
+	const char* pBytes = (const char*)&value;
+	buffer.insert(buffer.end(), pBytes, pBytes + sizeof(T));
+}
+
+template <typename T> static void AppendArray(std::vector<char>& buffer, const std::vector<T>& values, bool bCount = true)
+{
+	if (bCount)
+		Append(buffer, (int)values.size());
+
+	for (const T& value : values)
+		Append(buffer, value);
+}
+
+static std::vector<char> ReferenceWriteAinFile(const AinFile_t& ain)
+{
+	std::vector<char> buffer;
+	Append(buffer, ain.version);
+	Append(buffer, ain.mapVersion);
+	Append(buffer, ain.crc);
+	AppendArray(buffer, ain.nodes);
+	AppendArray(buffer, ain.links);
+	AppendArray(buffer, ain.unkNodeBlock, false);
+	Append(buffer, ain.traverseNodeCount);
+	buffer.insert(buffer.end(), ain.unkHullBlock, ain.unkHullBlock + sizeof(ain.unkHullBlock));
+
+	Append(buffer, (int)ain.unkNodes.size());
+	for (const AinUnkNode_t& unkNode : ain.unkNodes)
+	{
+		Append(buffer, unkNode.index);
+		Append(buffer, unkNode.unk1);
+		Append(buffer, unkNode.x);
+		Append(buffer, unkNode.y);
+		Append(buffer, unkNode.z);
+		AppendArray(buffer, unkNode.unk2);
+		AppendArray(buffer, unkNode.unk3);
+		Append(buffer, unkNode.unk5);
+	}
+
+	AppendArray(buffer, ain.unkLinks);
+	Append(buffer, ain.unk8);
+	AppendArray(buffer, ain.scriptNodes);
+	AppendArray(buffer, ain.hints);
+	return buffer;
+}
+
+static AinFile_t MakeAinFile(std::mt19937& rng, int nNodes)
+{
+	AinFile_t ain;
+	ain.mapVersion = rng();
+	ain.nodes.resize(nNodes);
+	for (CAI_NodeDisk& node : ain.nodes)
+	{
+		for (size_t i = 0; i < sizeof(node); i++)
+			((char*)&node)[i] = (char)rng();
+
+		node.x = (float)(rng() % 1000);
+		node.y = (float)(rng() % 1000);
+		node.z = (float)(rng() % 1000);
+	}
+
+	for (int i = 0; i < nNodes * 3; i++)
+	{
+		CAI_NodeLinkDisk link {};
+		link.srcId = (short)(rng() % nNodes);
+		link.destId = (short)(rng() % nNodes);
+		link.unk0 = (char)rng();
+		for (bool& bHull : link.hulls)
+			bHull = rng() & 1;
+
+		ain.links.push_back(link);
+	}
+
+	ain.unkNodeBlock.assign(nNodes, 0);
+	for (int i = 0; i < nNodes / 10; i++)
+	{
+		AinUnkNode_t unkNode {};
+		unkNode.index = i;
+		unkNode.unk2.resize(rng() % 5);
+		unkNode.unk3.resize(rng() % 5);
+		ain.unkNodes.push_back(unkNode);
+	}
+
+	ain.unkLinks.resize(nNodes / 7);
+	ain.scriptNodes.resize(nNodes / 3);
+	ain.hints.resize(nNodes / 5);
+	ain.unk8 = 7;
+	return ain;
+}
+
+static void Fuzz(int iterations, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		const AinFile_t ain = MakeAinFile(rng, 1 + rng() % 300);
+
+		std::vector<char> buffer;
+		AinFileLayout_t layout;
+		WriteAinFile(ain, buffer, &layout);
+		bool ok = buffer == ReferenceWriteAinFile(ain) && layout.size == buffer.size();
+
+		AinFileStats_t stats;
+		std::string error;
+		ok &= ValidateAinFile(buffer.data(), buffer.size(), stats, error) && stats.nodeCount == (int)ain.nodes.size() &&
+			  stats.linkCount == (int)ain.links.size();
+
+		// truncated files must fail cleanly, the reader never goes past the end
+		for (size_t size = 0; size < buffer.size(); size += 1 + buffer.size() / 97)
+		{
+			AinFile_t truncated;
+			std::vector<char> truncatedBuffer(buffer.begin(), buffer.begin() + size);
+			ok &= !ReadAinFile(truncatedBuffer.data(), truncatedBuffer.size(), truncated, error);
+		}
+
+		// corrupted ones only have to not crash
+		for (int m = 0; m < 50; m++)
+		{
+			std::vector<char> corrupted = buffer;
+			corrupted[rng() % corrupted.size()] ^= 1 << (rng() % 8);
+			ValidateAinFile(corrupted.data(), corrupted.size(), stats, error);
+		}
+
+		buffer.push_back(0);
+		ok &= !ValidateAinFile(buffer.data(), buffer.size(), stats, error);
+
+		if (!ok)
+		{
+			fprintf(stderr, "ain mismatch, iteration %d, %zu nodes\n", it, ain.nodes.size());
+			failures++;
+		}
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+static void TestGraphStats()
+{
+	AinFile_t ain;
+	ain.nodes.resize(4);
+	ain.unkNodeBlock.resize(4);
+	ain.links.push_back({0, 1, 0, {true, false, false, false, true}});
+	ain.links.push_back({1, 0, 0, {true, false, false, false, false}});
+	ain.links.push_back({2, 2, 0, {}});
+
+	std::vector<char> buffer;
+	WriteAinFile(ain, buffer);
+
+	AinFileStats_t stats;
+	std::string error;
+	NS_CHECK(ValidateAinFile(buffer.data(), buffer.size(), stats, error));
+	NS_CHECK(stats.duplicateLinks == 1);
+	NS_CHECK(stats.selfLinks == 1);
+	NS_CHECK(stats.isolatedNodes == 1);
+	NS_CHECK(stats.maxNodeLinks == 2);
+	NS_CHECK(stats.linksPerHull[0] == 2 && stats.linksPerHull[4] == 1);
+
+	// links to nodes that don't exist make the file invalid
+	ain.links.push_back({0, 50, 0, {}});
+	WriteAinFile(ain, buffer);
+	NS_CHECK(!ValidateAinFile(buffer.data(), buffer.size(), stats, error));
+	NS_CHECK(stats.badLinks == 1);
+}
+
+int main(int argc, char** argv)
+{
+	Fuzz(argc > 1 ? atoi(argv[1]) : 50, argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 1);
+	TestGraphStats();
+
+	return NS_TestResult();
+}
@@ -0,0 +1,47 @@
+#include "shared/exploit_fixes/exploitfixes_utf8scan.h"
+#include "utf8parser_reference.h"
+#include "nstest.h"
+
+#include <string>
+
+// the reference reads up to 10 bytes past the closing quote
+constexpr size_t REFERENCE_PADDING = 16;
+
+static void Bench(const char* pszName, std::string token)
+{
+	const size_t size = token.size();
+	token += '"';
+	token.append(REFERENCE_PADDING, '\0');
+
+	const char* pCur = token.data();
+	const char* pEnd = pCur + size;
+
+	char szName[64];
+	snprintf(szName, sizeof(szName), "%s (%zu bytes) engine walk", pszName, size);
+	const double flReference = NS_Benchmark(
+		szName,
+		20000,
+		[&]
+		{
+			const char* pLastRead;
+			NS_DoNotOptimise(ReferenceUTF8_EndsOnQuote(pCur, pEnd, &pLastRead));
+		});
+
+	snprintf(szName, sizeof(szName), "%s (%zu bytes) CheckEscapedTokenEnd", pszName, size);
+	const double flOurs = NS_Benchmark(szName, 20000, [&] { NS_DoNotOptimise(CheckEscapedTokenEnd(pCur, pEnd)); });
+
+	printf("%-48s %12.2fx\n", "speedup", flReference / flOurs);
+}
+
+int main()
+{
+	std::string escaped;
+	for (int i = 0; i < 500; i++)
+		escaped += "ab\\u00e9\\n";
+
+	Bench("ascii", std::string(4096, 'a'));
+	Bench("escaped", escaped);
+	Bench("short", "player name");
+
+	return 0;
+}
@@ -0,0 +1,41 @@
+#include "shared/exploit_fixes/exploitfixes_utf8scan.h"
+#include "utf8parser_reference.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+// the reference reads up to 10 bytes past the closing quote, this keeps it reading escapes for as long as it can
+static const char s_szReferencePadding[] = "0000\\uDC000000\\u";
+
+// libfuzzer entry point, the input is a token's contents without its quotes
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t iSize)
+{
+	// empty tokens are rejected before the scan is reached, it requires at least one character
+	if (!iSize)
+		return 0;
+
+	// token and closing quote in an exactly sized buffer, so asan catches us reading past the quote
+	std::unique_ptr<char[]> exact(new char[iSize + 1]);
+	memcpy(exact.get(), pData, iSize);
+	exact[iSize] = '"';
+	const bool result = CheckEscapedTokenEnd(exact.get(), exact.get() + iSize);
+
+	std::unique_ptr<char[]> padded(new char[iSize + sizeof(s_szReferencePadding)]);
+	memcpy(padded.get(), exact.get(), iSize + 1);
+	memcpy(padded.get() + iSize + 1, s_szReferencePadding, sizeof(s_szReferencePadding) - 1);
+
+	const char* pLastRead;
+	const char* pEnd = padded.get() + iSize;
+	const bool reference = ReferenceUTF8_EndsOnQuote(padded.get(), pEnd, &pLastRead);
+
+	// same rule as the randomised test, reject anything the engine would overread for and otherwise agree with it
+	if (pLastRead > pEnd ? result : result != reference)
+	{
+		fprintf(stderr, "utf8 scan mismatch, ours %d engine %d\n", result, reference);
+		abort();
+	}
+
+	return 0;
+}
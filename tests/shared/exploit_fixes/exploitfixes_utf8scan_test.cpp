@@ -0,0 +1,108 @@
+#include "shared/exploit_fixes/exploitfixes_utf8scan.h"
+#include "utf8parser_reference.h"
+#include "nstest.h"
+
+#include <memory>
+#include <random>
+
+// the reference reads up to 10 bytes past the closing quote
+constexpr size_t REFERENCE_PADDING = 16;
+
+static const char* const s_pszPieces[] = {
+	"a", "b", "u", "0", "F", "\xff", "\"", "\\n", "\\t", "\\\\", "\\\"", "\\u12", "\\uD800", "\\uDC00", "\\uD83D\\uDE00", "\\uD83D\\u",
+	"\\ud8ff\\udfff", "\\uD800\\uzz00"};
+
+// escapes right before the closing quote are where the engine overshoots
+static const char* const s_pszTrailingEscapes[] = {"\\", "\\u", "\\u00e", "\\uD83D", "\\uD83D\\", "\\uD83D\\uDE", "\\uD83D\\uDE0"};
+
+static std::string MakeToken(std::mt19937& rng)
+{
+	std::string token;
+	for (int i = 1 + rng() % 12; i > 0; i--)
+		token += s_pszPieces[rng() % (sizeof(s_pszPieces) / sizeof(*s_pszPieces))];
+
+	if (rng() % 8 == 0)
+		for (int i = 0; i < 40; i++)
+			token += "abc"[rng() % 3];
+
+	if (rng() & 1)
+		token += s_pszTrailingEscapes[rng() % (sizeof(s_pszTrailingEscapes) / sizeof(*s_pszTrailingEscapes))];
+
+	return token;
+}
+
+static void Fuzz(int iterations, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		const std::string token = MakeToken(rng);
+		const size_t size = token.size() + 1;
+
+		// token and closing quote in an exactly sized buffer, so asan catches us reading past the quote
+		std::unique_ptr<char[]> exact(new char[size]);
+		memcpy(exact.get(), token.data(), token.size());
+		exact[token.size()] = '"';
+		const bool result = CheckEscapedTokenEnd(exact.get(), exact.get() + token.size());
+
+		std::unique_ptr<char[]> padded(new char[size + REFERENCE_PADDING]);
+		memcpy(padded.get(), exact.get(), size);
+		for (size_t i = 0; i < REFERENCE_PADDING; i++)
+			padded[size + i] = "xyz0uD\\"[rng() % 7];
+
+		const char* pLastRead;
+		const char* pEnd = padded.get() + token.size();
+		const bool reference = ReferenceUTF8_EndsOnQuote(padded.get(), pEnd, &pLastRead);
+
+		// anything the engine would have to read past the closing quote for must be rejected,
+		// everything else must get the same answer as the engine
+		if (pLastRead > pEnd ? result : result != reference)
+		{
+			fprintf(stderr, "utf8 scan mismatch, iteration %d, ours %d engine %d token %s\n", it, result, reference, token.c_str());
+			failures++;
+		}
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+static bool Check(const std::string& token)
+{
+	std::unique_ptr<char[]> buffer(new char[token.size() + 1]);
+	memcpy(buffer.get(), token.data(), token.size());
+	buffer[token.size()] = '"';
+	return CheckEscapedTokenEnd(buffer.get(), buffer.get() + token.size());
+}
+
+static void TestEdgeCases()
+{
+	NS_CHECK(Check("plain"));
+	NS_CHECK(Check(std::string(100, 'a') + "\\n"));
+	NS_CHECK(Check("\\u00e9\\uD83D\\uDE00"));
+
+	// escaping the closing quote
+	NS_CHECK(!Check("abc\\"));
+	NS_CHECK(!Check(std::string(40, 'a') + "\\"));
+
+	// \u escapes cut short by the closing quote
+	NS_CHECK(!Check("\\u"));
+	NS_CHECK(!Check("\\u00e"));
+	NS_CHECK(!Check("\\uD83D\\u"));
+	NS_CHECK(!Check("\\uD83D\\uDE"));
+
+	// malformed surrogate pairs make the engine give up, which is harmless
+	NS_CHECK(Check("\\uD83D"));
+	NS_CHECK(Check("\\uD83Da"));
+	NS_CHECK(Check("\\uDE00\\u"));
+	NS_CHECK(Check("\\uD83D\\uDE0"));
+}
+
+int main(int argc, char** argv)
+{
+	Fuzz(argc > 1 ? atoi(argv[1]) : 200000, argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 7);
+	TestEdgeCases();
+
+	return NS_TestResult();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+
+//-----------------------------------------------------------------------------
+// Purpose: How far the engine's rson string unescaper (engine.dll + 0xEF670) walks through a token, kept as the
+//          reference to check CheckEscapedTokenEnd against. it only stops once it lands exactly on the closing quote,
+//          this stops as soon as it steps over it instead of reading on through memory
+// Input  : *pCur - First character after the opening quote
+//          *pEnd - The closing quote, the input must be padded at least 10 bytes past it
+//          *pLastRead - Set to the furthest character the engine looked at
+// Output : false if the engine would step over the closing quote
+//-----------------------------------------------------------------------------
+inline bool ReferenceUTF8_EndsOnQuote(const char* pCur, const char* pEnd, const char** pLastRead)
+{
+	auto Read = [&](const char* p)
+	{
+		if (p > *pLastRead)
+			*pLastRead = p;
+
+		return *p;
+	};
+
+	auto DecodeCodepoint = [&](const char* pHex)
+	{
+		uint32_t iCodepoint = 0;
+		for (int i = 0; i < 4; i++)
+		{
+			uint32_t v = Read(pHex + i) | 0x20;
+			iCodepoint |= (v - (v <= 0x39 ? 48 : 87)) << (12 - 4 * i);
+		}
+
+		return iCodepoint;
+	};
+
+	*pLastRead = pCur;
+	for (;;)
+	{
+		if (Read(pCur++) == '\\' && Read(pCur++) == 'u')
+		{
+			uint32_t iCodepoint = DecodeCodepoint(pCur);
+			pCur += 4;
+
+			if (iCodepoint - 0xD800 <= 0x7FF)
+			{
+				// anything that isn't a well formed surrogate pair makes the engine give up on the token
+				if (iCodepoint >= 0xDC00)
+					return true;
+
+				if (Read(pCur) != '\\' || Read(pCur + 1) != 'u')
+					return true;
+
+				if (DecodeCodepoint(pCur + 2) - 0xDC00 > 0x3FF)
+					return true;
+
+				pCur += 6;
+			}
+		}
+
+		if (pCur == pEnd)
+			return true;
+
+		if (pCur > pEnd)
+			return false;
+	}
+}
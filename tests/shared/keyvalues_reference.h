@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+// port of how engine KeyValues find a subkey, so benchmarks compare against what the game actually does
+// names are interned by KeyValuesSystem into integer symbols through a case insensitive hash table, FindKey turns the name
+// it's given into a symbol and then walks the peer list comparing symbols
+
+typedef int HKeySymbol;
+constexpr HKeySymbol INVALID_KEY_SYMBOL = -1;
+
+//-----------------------------------------------------------------------------
+// Purpose: CKeyValuesSystem's symbol table, 2047 buckets of chained entries
+//-----------------------------------------------------------------------------
+class ReferenceKeySymbolTable
+{
+private:
+	static constexpr int BUCKET_COUNT = 2047;
+
+	struct HashItem_t
+	{
+		HKeySymbol iSymbol;
+		std::string svName;
+	};
+
+	std::vector<HashItem_t> m_Buckets[BUCKET_COUNT];
+	HKeySymbol m_iNextSymbol = 0;
+
+	static int CaseInsensitiveHash(const char* pszString)
+	{
+		unsigned int iHash = 0;
+		for (; *pszString; pszString++)
+		{
+			if (*pszString >= 'A' && *pszString <= 'Z')
+				iHash = (iHash << 1) + (*pszString - 'A' + 'a');
+			else
+				iHash = (iHash << 1) + *pszString;
+		}
+
+		return iHash % BUCKET_COUNT;
+	}
+
+public:
+	HKeySymbol GetSymbolForString(const char* pszName, bool bCreate)
+	{
+		std::vector<HashItem_t>& vBucket = m_Buckets[CaseInsensitiveHash(pszName)];
+		for (const HashItem_t& item : vBucket)
+		{
+			if (!strcasecmp(item.svName.c_str(), pszName))
+				return item.iSymbol;
+		}
+
+		if (!bCreate)
+			return INVALID_KEY_SYMBOL;
+
+		vBucket.push_back({m_iNextSymbol, pszName});
+		return m_iNextSymbol++;
+	}
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: The parts of an engine KeyValues that FindKey touches
+//-----------------------------------------------------------------------------
+struct ReferenceKeyValues
+{
+	HKeySymbol iKeyName = INVALID_KEY_SYMBOL;
+	ReferenceKeyValues* pPeer = nullptr;
+	ReferenceKeyValues* pSub = nullptr;
+
+	// KeyValues::FindKey without the chained keys and path handling, which lookups of a plain name never hit
+	ReferenceKeyValues* FindKey(ReferenceKeySymbolTable& symbols, const char* pszKeyName)
+	{
+		if (!pszKeyName || !*pszKeyName)
+			return this;
+
+		// the engine looks for a path separator before anything else
+		const char* pSubStr = strchr(pszKeyName, '/');
+		if (pSubStr)
+			return nullptr;
+
+		const HKeySymbol iSearchStr = symbols.GetSymbolForString(pszKeyName, false);
+		if (iSearchStr == INVALID_KEY_SYMBOL)
+			return nullptr;
+
+		for (ReferenceKeyValues* pCurrent = pSub; pCurrent; pCurrent = pCurrent->pPeer)
+		{
+			if (pCurrent->iKeyName == iSearchStr)
+				return pCurrent;
+		}
+
+		return nullptr;
+	}
+};
@@ -0,0 +1,98 @@
+#include "shared/keyvaluestree.h"
+#include "nstest.h"
+#include "keyvalues_reference.h"
+
+#include <memory>
+
+static void BenchmarkLookups(int iChildren)
+{
+	CKeyValuesTree tree("root");
+	KeyValuesNode_t* pNode = tree.AddKey(tree.GetRoot(), "node");
+
+	// the same children as engine KeyValues, in the same order and each allocated on its own like the engine does
+	ReferenceKeySymbolTable symbols;
+	ReferenceKeyValues engineNode;
+	std::vector<std::unique_ptr<ReferenceKeyValues>> vEngineChildren;
+
+	std::vector<std::string> vNames;
+	for (int i = 0; i < iChildren; i++)
+	{
+		vNames.push_back(fmt::format("SomeKeyName{}", i));
+		tree.SetInt(pNode, vNames.back().c_str(), i);
+
+		ReferenceKeyValues* pEngineChild = vEngineChildren.emplace_back(std::make_unique<ReferenceKeyValues>()).get();
+		pEngineChild->iKeyName = symbols.GetSymbolForString(vNames.back().c_str(), true);
+		if (i)
+			vEngineChildren[i - 1]->pPeer = pEngineChild;
+		else
+			engineNode.pSub = pEngineChild;
+	}
+
+	size_t iNext = 0;
+	const double flTree = NS_Benchmark(
+		fmt::format("FindSubKey, {} children", iChildren).c_str(),
+		1000000,
+		[&]
+		{
+			NS_DoNotOptimise(tree.FindSubKey(pNode, vNames[iNext].c_str()));
+			iNext = (iNext + 1) % vNames.size();
+		});
+
+	const double flEngine = NS_Benchmark(
+		fmt::format("engine KeyValues::FindKey, {} children", iChildren).c_str(),
+		1000000,
+		[&]
+		{
+			NS_DoNotOptimise(engineNode.FindKey(symbols, vNames[iNext].c_str()));
+			iNext = (iNext + 1) % vNames.size();
+		});
+	printf("%-48s %12.2fx\n", "speedup", flEngine / flTree);
+}
+
+static void BenchmarkBuild()
+{
+	// roughly the shape of a playlists file
+	std::string svText = "\"playlists\"\n{\n";
+	for (int i = 0; i < 200; i++)
+	{
+		svText += fmt::format("\t\"playlist{}\"\n\t{{\n\t\t\"vars\"\n\t\t{{\n", i);
+		for (int j = 0; j < 40; j++)
+			svText += fmt::format("\t\t\t\"var{}\" \"{}\"\n", j, i * j);
+		svText += "\t\t}\n\t}\n";
+	}
+	svText += "}\n";
+
+	CKeyValuesTree tree("file");
+	std::vector<std::string> vBaseFiles;
+	std::string svError;
+	NS_Benchmark(
+		fmt::format("ParseText + Clear, {} bytes", svText.size()).c_str(),
+		200,
+		[&]
+		{
+			tree.ParseText(tree.GetRoot(), svText.data(), svText.size(), vBaseFiles, svError);
+			tree.Clear();
+		});
+
+	tree.ParseText(tree.GetRoot(), svText.data(), svText.size(), vBaseFiles, svError);
+	std::string svOut;
+	NS_Benchmark(
+		"WriteText",
+		200,
+		[&]
+		{
+			svOut.clear();
+			tree.WriteText(tree.GetRoot()->pFirstChild, svOut);
+		});
+
+	printf("tree uses %zu arena bytes\n", tree.GetBytesUsed());
+}
+
+int main()
+{
+	for (int iChildren : {4, 16, 64, 1024})
+		BenchmarkLookups(iChildren);
+
+	BenchmarkBuild();
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "shared/keyvaluestree.h"
+#include "nstest.h"
+
+static void TestPaths()
+{
+	CKeyValuesTree tree("root");
+	KeyValuesNode_t* pRoot = tree.GetRoot();
+
+	tree.SetString(pRoot, "a/b/c", "hello");
+	NS_CHECK(!strcmp(tree.GetString(pRoot, "A/B/C"), "hello"));
+	NS_CHECK(tree.FindKey(pRoot, "a/b") == tree.FindSubKey(tree.FindSubKey(pRoot, "a"), "b"));
+	NS_CHECK(!tree.FindKey(pRoot, "a/x/y"));
+	NS_CHECK(tree.FindKey(pRoot, "a/x/y", true) != nullptr);
+	NS_CHECK(tree.FindKey(pRoot, "a/x/y") != nullptr);
+
+	// values convert between types like KeyValues
+	tree.SetInt(pRoot, "a/n", 5);
+	NS_CHECK(!strcmp(tree.GetString(pRoot, "a/n"), "5"));
+	tree.SetInt(pRoot, "a/n", 7);
+	NS_CHECK(!strcmp(tree.GetString(pRoot, "a/n"), "7"));
+	NS_CHECK(tree.GetFloat(pRoot, "a/n") == 7.0f);
+	NS_CHECK(tree.GetInt(pRoot, "a/missing", 3) == 3);
+
+	tree.SetFloat(pRoot, "f", 1.5f);
+	NS_CHECK(tree.GetFloat(pRoot, "f") == 1.5f);
+	tree.SetUint64(pRoot, "u", 0x123456789ull);
+	NS_CHECK(tree.GetUint64(pRoot, "u") == 0x123456789ull);
+
+	// a key that gains children stops being a value, including its cached string
+	tree.SetString(pRoot, "p", "value");
+	tree.SetInt(pRoot, "p/child", 1);
+	NS_CHECK(!strcmp(tree.GetString(pRoot, "p", "default"), "default"));
+	tree.SetInt(pRoot, "q", 2);
+	NS_CHECK(!strcmp(tree.GetString(pRoot, "q"), "2"));
+	tree.SetInt(pRoot, "q/child", 1);
+	NS_CHECK(!strcmp(tree.GetString(pRoot, "q", "default"), "default"));
+}
+
+static void TestWideNodes()
+{
+	CKeyValuesTree tree("root");
+	KeyValuesNode_t* pWide = tree.AddKey(tree.GetRoot(), "wide");
+
+	char szName[32];
+	for (int i = 0; i < 1000; i++)
+	{
+		snprintf(szName, sizeof(szName), "Key%d", i);
+		tree.SetInt(pWide, szName, i);
+	}
+
+	// duplicates are allowed, but lookups return the first one
+	KeyValuesNode_t* pDuplicate = tree.AddKey(pWide, "key5");
+	NS_CHECK(tree.FindSubKey(pWide, "KEY5") != pDuplicate);
+
+	bool bAllFound = true;
+	for (int i = 0; i < 1000; i++)
+	{
+		snprintf(szName, sizeof(szName), "key%d", i);
+		bAllFound &= tree.GetInt(pWide, szName, -1) == i;
+	}
+	NS_CHECK(bAllFound);
+
+	NS_CHECK(pWide->iChildCount == 1001);
+	NS_CHECK(pWide->ppChildIndex != nullptr && pWide->iChildIndexSize >= 2 * pWide->iChildCount);
+
+	// the index must not change iteration order
+	int iCount = 0;
+	bool bInOrder = true;
+	for (KeyValuesNode_t* pChild = pWide->pFirstChild; pChild; pChild = pChild->pNextPeer, iCount++)
+	{
+		snprintf(szName, sizeof(szName), iCount < 1000 ? "Key%d" : "key5", iCount);
+		bInOrder &= !strcmp(pChild->pszName, szName);
+	}
+	NS_CHECK(iCount == 1001 && bInOrder);
+
+	tree.Clear();
+	NS_CHECK(!tree.GetRoot()->pFirstChild && !strcmp(tree.GetRoot()->pszName, "root"));
+}
+
+static void TestTextRoundTrip()
+{
+	const char szText[] = "#base \"base.txt\"\n"
+						  "// comment\n"
+						  "\"Root\"\n"
+						  "{\n"
+						  "\t\"Name\" \"value\"\n"
+						  "\tunquoted 12\n"
+						  "\t\"Sub\"\n"
+						  "\t{\n"
+						  "\t\t\"Empty\"\n"
+						  "\t\t{\n"
+						  "\t\t}\n"
+						  "\t}\n"
+						  "}\n";
+
+	CKeyValuesTree tree("file");
+	std::vector<std::string> vBaseFiles;
+	std::string svError;
+	NS_CHECK(tree.ParseText(tree.GetRoot(), szText, sizeof(szText) - 1, vBaseFiles, svError));
+	NS_CHECK(vBaseFiles.size() == 1 && vBaseFiles[0] == "base.txt");
+	NS_CHECK(tree.GetInt(tree.GetRoot(), "root/unquoted") == 12);
+	NS_CHECK(tree.FindKey(tree.GetRoot(), "root/sub/empty") != nullptr);
+
+	// what we write should parse back to the same text
+	std::string svWritten;
+	tree.WriteText(tree.GetRoot()->pFirstChild, svWritten);
+
+	CKeyValuesTree reparsed("file");
+	NS_CHECK(reparsed.ParseText(reparsed.GetRoot(), svWritten.data(), svWritten.size(), vBaseFiles, svError));
+
+	std::string svRewritten;
+	reparsed.WriteText(reparsed.GetRoot()->pFirstChild, svRewritten);
+	NS_CHECK(svWritten == svRewritten);
+
+	// malformed input fails instead of producing a partial tree silently
+	for (const char* pszBad : {"\"a\" {", "\"a\" }", "{", "\"a\"", "#include \"x\""})
+	{
+		CKeyValuesTree bad("file");
+		svError.clear();
+		NS_CHECK(!bad.ParseText(bad.GetRoot(), pszBad, strlen(pszBad), vBaseFiles, svError) && !svError.empty());
+	}
+}
+
+int main()
+{
+	TestPaths();
+	TestWideNodes();
+	TestTextRoundTrip();
+
+	return NS_TestResult();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "core/filesystem/pakprefetch.h"
+
+#include <chrono>
+#include <map>
+
+//-----------------------------------------------------------------------------
+// Purpose: In-memory stand in for the prefetcher's file io, files only have a size and the clock only moves when
+//          the prefetcher sleeps, so rate limiting can be checked without actually waiting
+//-----------------------------------------------------------------------------
+class SimulatedFileIo
+{
+private:
+	struct OpenFile_t
+	{
+		std::string svPath;
+		size_t iOffset = 0;
+	};
+
+	std::mutex m_Mutex;
+	double m_flTime = 0.0;
+	std::map<std::string, size_t> m_Files;
+	std::map<void*, OpenFile_t> m_OpenFiles;
+
+public:
+	void AddFile(const std::string& svPath, size_t iSize)
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		m_Files[svPath] = iSize;
+	}
+
+	double GetTime()
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		return m_flTime;
+	}
+
+	size_t GetOpenFileCount()
+	{
+		std::lock_guard<std::mutex> guard(m_Mutex);
+		return m_OpenFiles.size();
+	}
+
+	PakPrefetcher::FileIo_t GetFileIo()
+	{
+		PakPrefetcher::FileIo_t io;
+
+		io.fnOpen = [this](const std::string& svPath) -> void*
+		{
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			if (!m_Files.contains(svPath))
+				return nullptr;
+
+			void* pHandle = new char;
+			m_OpenFiles[pHandle] = {svPath};
+			return pHandle;
+		};
+		io.fnRead = [this](void* pHandle, char* pBuffer, size_t iSize) -> size_t
+		{
+			NOTE_UNUSED(pBuffer);
+
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			OpenFile_t& file = m_OpenFiles.at(pHandle);
+			const size_t iRead = std::min(iSize, m_Files[file.svPath] - file.iOffset);
+			file.iOffset += iRead;
+			return iRead;
+		};
+		io.fnClose = [this](void* pHandle)
+		{
+			std::lock_guard<std::mutex> guard(m_Mutex);
+			m_OpenFiles.erase(pHandle);
+			delete (char*)pHandle;
+		};
+		io.fnTime = [this]() { return GetTime(); };
+		io.fnSleep = [this](double flSeconds)
+		{
+			{
+				std::lock_guard<std::mutex> guard(m_Mutex);
+				m_flTime += flSeconds;
+			}
+
+			// still give the other threads a chance to run
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		};
+
+		return io;
+	}
+};
@@ -0,0 +1,29 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// stands in for libfuzzer's main when the compiler doesn't ship it, runs each file given on the command line through the
+// fuzz target once, so crashing inputs and corpora can still be replayed
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* pData, size_t iSize);
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::ifstream file(argv[i], std::ios::binary);
+		if (!file)
+		{
+			fprintf(stderr, "couldn't open %s\n", argv[i]);
+			return 1;
+		}
+
+		const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+	}
+
+	printf("ran %d inputs\n", argc - 1);
+	return 0;
+}
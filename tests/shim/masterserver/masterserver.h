@@ -0,0 +1,63 @@
+#pragma once
+
+// stand-in for masterserver.h, which needs curl, winsock and the engine
+// only the server list types are here, they have to match the real ones field for field
+
+#include <string>
+#include <vector>
+
+struct RemoteModInfo
+{
+public:
+	std::string Name;
+	std::string Version;
+};
+
+class RemoteServerInfo
+{
+public:
+	char id[33]; // 32 bytes + nullterminator
+
+	// server info
+	char name[64];
+	std::string description;
+	char map[32];
+	char playlist[16];
+	char region[32];
+	std::vector<RemoteModInfo> requiredMods;
+
+	int playerCount;
+	int maxPlayers;
+
+	// connection stuff
+	bool requiresPassword;
+
+public:
+	RemoteServerInfo(
+		const char* newId,
+		const char* newName,
+		const char* newDescription,
+		const char* newMap,
+		const char* newPlaylist,
+		const char* newRegion,
+		int newPlayerCount,
+		int newMaxPlayers,
+		bool newRequiresPassword)
+	{
+		requiresPassword = newRequiresPassword;
+
+		strncpy_s((char*)id, sizeof(id), newId, sizeof(id) - 1);
+		strncpy_s((char*)name, sizeof(name), newName, sizeof(name) - 1);
+
+		description = std::string(newDescription);
+
+		strncpy_s((char*)map, sizeof(map), newMap, sizeof(map) - 1);
+		strncpy_s((char*)playlist, sizeof(playlist), newPlaylist, sizeof(playlist) - 1);
+
+		strncpy((char*)region, newRegion, sizeof(region));
+		region[sizeof(region) - 1] = 0;
+
+		playerCount = newPlayerCount;
+		maxPlayers = newMaxPlayers;
+	}
+};
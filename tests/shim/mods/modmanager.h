@@ -0,0 +1,22 @@
+#pragma once
+
+// stand-in for modmanager.h, which needs squirrel, convars and the engine
+// Mod only has what the registry reads, with the same names as the real one
+
+#include "mods/modregistry.h"
+
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+class Mod
+{
+public:
+	bool m_bEnabled = true;
+	fs::path m_ModDirectory;
+
+	std::string Name;
+	std::string Version;
+
+	std::vector<std::string> BinkVideos;
+};
@@ -0,0 +1,50 @@
+#pragma once
+
+// tiny test/benchmark helpers, tests are plain executables that return non-zero if any check failed
+
+#include <chrono>
+#include <cstdio>
+
+inline int g_iTestFailures = 0;
+
+#define NS_CHECK(exp)                                                                                                                      \
+	do                                                                                                                                     \
+	{                                                                                                                                      \
+		if (!(exp))                                                                                                                        \
+		{                                                                                                                                  \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #exp);                                                       \
+			g_iTestFailures++;                                                                                                             \
+		}                                                                                                                                  \
+	} while (false)
+
+// call at the end of main
+inline int NS_TestResult()
+{
+	if (g_iTestFailures)
+		fprintf(stderr, "%d checks failed\n", g_iTestFailures);
+	else
+		printf("all checks passed\n");
+
+	return g_iTestFailures ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: Runs fn iIterations times and prints the average time per iteration
+// Output : average nanoseconds per iteration
+//-----------------------------------------------------------------------------
+template <typename Fn> double NS_Benchmark(const char* pszName, int iIterations, Fn&& fn)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iIterations; i++)
+		fn();
+
+	const double flNanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iIterations;
+	printf("%-48s %12.1f ns\n", pszName, flNanoseconds);
+	return flNanoseconds;
+}
+
+// keeps the optimiser from throwing away benchmarked work
+template <typename T> inline void NS_DoNotOptimise(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
@@ -0,0 +1,82 @@
+#include "shared/keyvalues.h"
+
+#include <cstdlib>
+#include <cwchar>
+
+// engine KeyValues can't exist outside of the game, these are only here so code that converts to and from them links
+
+static int StubUnicodeToUTF8(const wchar_t* pUnicode, char* pUTF8, int cubDestSizeInBytes)
+{
+	const size_t iLength = wcstombs(pUTF8, pUnicode, cubDestSizeInBytes);
+	if (iLength == (size_t)-1)
+		return 0;
+
+	if (cubDestSizeInBytes > 0)
+		pUTF8[cubDestSizeInBytes - 1] = '\0';
+
+	return (int)iLength + 1;
+}
+
+int (*V_UnicodeToUTF8)(const wchar_t* pUnicode, char* pUTF8, int cubDestSizeInBytes) = StubUnicodeToUTF8;
+
+[[noreturn]] static void EngineKeyValuesUnavailable()
+{
+	fprintf(stderr, "engine KeyValues are not available in tests\n");
+	abort();
+}
+
+KeyValues::KeyValues(const char* pszSetName)
+{
+	NOTE_UNUSED(pszSetName);
+	EngineKeyValuesUnavailable();
+}
+
+KeyValues* KeyValues::GetFirstSubKey() const
+{
+	EngineKeyValuesUnavailable();
+}
+
+KeyValues* KeyValues::GetNextKey() const
+{
+	EngineKeyValuesUnavailable();
+}
+
+const char* KeyValues::GetName() const
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetInt(const char*, int)
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetUint64(const char*, uint64_t)
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetFloat(const char*, float)
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetPtr(const char*, void*)
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetStringValue(const char*)
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetWString(const char*, const wchar_t*)
+{
+	EngineKeyValuesUnavailable();
+}
+
+void KeyValues::SetColor(const char*, Color)
+{
+	EngineKeyValuesUnavailable();
+}
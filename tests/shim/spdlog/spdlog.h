@@ -0,0 +1,41 @@
+#pragma once
+
+// minimal stand-in for spdlog, the bundled copy is configured for windows only
+// everything is printed to stdout, so test output reads in order
+
+#include "spdlog/fmt/bundled/format.h"
+
+#include <cstdio>
+
+namespace spdlog
+{
+	template <typename S, typename... Args> void log(const char* pszLevel, const S& format, Args&&... args)
+	{
+		fmt::print("[{}] {}\n", pszLevel, fmt::format(format, std::forward<Args>(args)...));
+	}
+
+	template <typename S, typename... Args> void debug(const S& format, Args&&... args)
+	{
+		log("debug", format, std::forward<Args>(args)...);
+	}
+
+	template <typename S, typename... Args> void info(const S& format, Args&&... args)
+	{
+		log("info", format, std::forward<Args>(args)...);
+	}
+
+	template <typename S, typename... Args> void warn(const S& format, Args&&... args)
+	{
+		log("warning", format, std::forward<Args>(args)...);
+	}
+
+	template <typename S, typename... Args> void error(const S& format, Args&&... args)
+	{
+		log("error", format, std::forward<Args>(args)...);
+	}
+
+	template <typename S, typename... Args> void critical(const S& format, Args&&... args)
+	{
+		log("critical", format, std::forward<Args>(args)...);
+	}
+} // namespace spdlog
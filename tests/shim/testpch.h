@@ -0,0 +1,78 @@
+#ifndef TESTPCH_H
+#define TESTPCH_H
+
+// stands in for primedev/pch.h when building the game-independent parts of primedev into tests
+// only provides what those parts need from windows and the engine, anything more means the code isn't portable
+
+#define RAPIDJSON_HAS_STDSTRING 1
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// clang-format off
+#define assert_msg(exp, msg) assert((exp, msg))
+//clang-format on
+
+#define NOTE_UNUSED(var) do { (void)var; } while(false)
+
+#ifndef _MSC_VER
+// windows.h pulls these in on msvc
+#include <xmmintrin.h>
+
+#define __fastcall
+#define __thiscall
+#define __int64 long long
+#define FORCEINLINE inline
+
+inline int strncpy_s(char* pDest, size_t iDestSize, const char* pSrc, size_t iCount)
+{
+	size_t iLength = strnlen(pSrc, iCount);
+	if (iLength >= iDestSize)
+		iLength = iDestSize - 1;
+
+	memcpy(pDest, pSrc, iLength);
+	pDest[iLength] = '\0';
+	return 0;
+}
+
+inline unsigned char _BitScanForward(unsigned long* pIndex, unsigned long iMask)
+{
+	if (!iMask)
+		return 0;
+
+	*pIndex = __builtin_ctzl(iMask);
+	return 1;
+}
+#endif
+
+#include "core/macros.h"
+
+// dll load callbacks never run in tests, this is just enough of silver-bun for their bodies to compile
+class CMemory
+{
+public:
+	template <typename T> T RCast() const { return T(); }
+};
+
+class CModule
+{
+public:
+	CMemory Offset(uintptr_t) const { return CMemory(); }
+};
+
+#define ON_DLL_LOAD(dllName, uniquestr, args) [[maybe_unused]] static void __dllLoadCallback##uniquestr args
+
+#include "spdlog/spdlog.h"
+
+#endif
@@ -0,0 +1,15 @@
+#include "util/fnv1a.h"
+#include "nstest.h"
+
+int main()
+{
+	// reference values from the fnv spec, the master server checks delta bases against these so they can't change
+	NS_CHECK(FNV1a_64("", 0) == 0xcbf29ce484222325ull);
+	NS_CHECK(FNV1a_64("a", 1) == 0xaf63dc4c8601ec8cull);
+	NS_CHECK(FNV1a_64("foobar", 6) == 0x85944171f73967e8ull);
+
+	// hashing in pieces gives the same result as hashing it all at once
+	NS_CHECK(FNV1a_64("bar", 3, FNV1a_64("foo", 3)) == FNV1a_64("foobar", 6));
+
+	return NS_TestResult();
+}
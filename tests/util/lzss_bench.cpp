@@ -0,0 +1,44 @@
+#include "util/lzss.h"
+#include "lzss_reference.h"
+#include "nstest.h"
+
+#include <random>
+
+int main()
+{
+	// text with lots of nearby repeats, roughly what netchan payloads compress like
+	std::mt19937 rng(5);
+	const char szWords[] = "the quick brown fox jumps over ";
+	std::vector<unsigned char> input(4 << 20);
+	for (size_t i = 0; i < input.size(); i++)
+		input[i] = (i < 256 || rng() % 3) ? szWords[rng() % (sizeof(szWords) - 1)] : input[i - 1 - rng() % 200];
+
+	std::vector<unsigned char> compressed(LZSS_GetMaxCompressedSize(input.size()));
+	size_t compressedSize = 0;
+	const double flCompressNs = NS_Benchmark(
+		"LZSS_Compress 4MB",
+		5,
+		[&] { compressedSize = LZSS_Compress(input.data(), (unsigned int)input.size(), compressed.data(), compressed.size()); });
+
+	std::vector<unsigned char> output(input.size() + LZSS_MAX_MATCH);
+	const double flReferenceNs = NS_Benchmark(
+		"engine decoder 4MB",
+		10,
+		[&] { NS_DoNotOptimise(ReferenceLZSS_Decompress(compressed.data(), output.data(), (unsigned int)input.size())); });
+
+	const double flDecompressNs = NS_Benchmark(
+		"LZSS_Decompress 4MB",
+		10,
+		[&]
+		{ NS_DoNotOptimise(LZSS_Decompress(compressed.data(), compressedSize, output.data(), (unsigned int)input.size())); });
+
+	const auto fnMBs = [&](double flNs) { return input.size() / 1e6 / (flNs / 1e9); };
+	printf(
+		"ratio %.2f, compress %.0f MB/s, engine decoder %.0f MB/s, ours %.0f MB/s\n",
+		double(compressedSize) / input.size(),
+		fnMBs(flCompressNs),
+		fnMBs(flReferenceNs),
+		fnMBs(flDecompressNs));
+
+	return 0;
+}
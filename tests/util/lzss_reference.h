@@ -0,0 +1,69 @@
+#pragma once
+
+#include "util/lzss.h"
+
+#include <cstring>
+
+//-----------------------------------------------------------------------------
+// Purpose: The engine's original CLZSS::SafeUncompress, kept as the reference to check our decoder against
+//          it trusts its input, so it must only be given inputs padded well past any length they claim
+//-----------------------------------------------------------------------------
+inline unsigned int ReferenceLZSS_Decompress(const unsigned char* pInput, unsigned char* pOutput, unsigned int unBufSize)
+{
+	unsigned int totalBytes = 0;
+	int getCmdByte = 0;
+	int cmdByte = 0;
+
+	lzss_header_t header;
+	memcpy(&header, pInput, sizeof(header));
+
+	if (!header.actualSize || header.id != LZSS_ID || header.actualSize > unBufSize)
+		return 0;
+
+	pInput += sizeof(lzss_header_t);
+
+	for (;;)
+	{
+		if (!getCmdByte)
+			cmdByte = *pInput++;
+
+		getCmdByte = (getCmdByte + 1) & 0x07;
+
+		if (cmdByte & 0x01)
+		{
+			int position = *pInput++ << LZSS_LOOKSHIFT;
+			position |= (*pInput >> LZSS_LOOKSHIFT);
+			position += 1;
+
+			int count = (*pInput++ & 0x0F) + 1;
+			if (count == 1)
+				break;
+
+			if ((unsigned int)position > totalBytes)
+				return 0;
+
+			totalBytes += count;
+			if (totalBytes > unBufSize)
+				return 0;
+
+			unsigned char* pSource = pOutput - position;
+			for (int i = 0; i < count; i++)
+				*pOutput++ = *pSource++;
+		}
+		else
+		{
+			totalBytes++;
+			if (totalBytes > unBufSize)
+				return 0;
+
+			*pOutput++ = *pInput++;
+		}
+
+		cmdByte = cmdByte >> 1;
+	}
+
+	if (totalBytes != header.actualSize)
+		return 0;
+
+	return totalBytes;
+}
@@ -0,0 +1,119 @@
+#include "util/lzss.h"
+#include "lzss_reference.h"
+#include "nstest.h"
+
+#include <random>
+
+// the reference decoder reads past the end of bad input, so it gets this much zero padding
+constexpr size_t REFERENCE_PADDING = 70000;
+
+static std::vector<unsigned char> MakeInput(std::mt19937& rng)
+{
+	const size_t size = 1 + rng() % 3000;
+	const unsigned int alphabet = 1 + rng() % 255;
+
+	std::vector<unsigned char> input(size);
+	for (unsigned char& c : input)
+		c = (unsigned char)(rng() % alphabet);
+
+	// half of them get lots of short repeats, so there are plenty of back references
+	if (rng() & 1)
+		for (size_t i = 16; i < size; i++)
+			if (rng() % 4)
+				input[i] = input[i - 1 - rng() % 16];
+
+	return input;
+}
+
+static void Fuzz(int iterations, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		const std::vector<unsigned char> input = MakeInput(rng);
+		const unsigned int size = (unsigned int)input.size();
+
+		std::vector<unsigned char> compressed(LZSS_GetMaxCompressedSize(size));
+		const size_t compressedSize = LZSS_Compress(input.data(), size, compressed.data(), compressed.size());
+		compressed.resize(compressedSize);
+
+		// decompressing into an exactly sized buffer, so asan catches any overrun
+		std::vector<unsigned char> output(size);
+		bool ok = compressedSize && LZSS_Decompress(compressed.data(), compressedSize, output.data(), size) == size && output == input;
+
+		// what we write has to be readable by the engine's decoder too
+		std::vector<unsigned char> padded(compressed);
+		padded.resize(compressedSize + REFERENCE_PADDING);
+		std::vector<unsigned char> referenceOutput(size);
+		ok &= ReferenceLZSS_Decompress(padded.data(), referenceOutput.data(), size) == size && referenceOutput == input;
+
+		// truncated payloads must be rejected rather than read past
+		if (compressedSize)
+		{
+			std::vector<unsigned char> truncated(compressed.begin(), compressed.begin() + rng() % compressedSize);
+			ok &= !LZSS_Decompress(truncated.data(), truncated.size(), output.data(), size);
+		}
+
+		// corrupted payloads must decode exactly like the engine does, including which ones fail
+		for (int m = 0; m < 4 && ok && compressedSize > sizeof(lzss_header_t); m++)
+		{
+			std::vector<unsigned char> mutated(padded);
+			for (int j = 1 + rng() % 4; j > 0; j--)
+				mutated[sizeof(lzss_header_t) + rng() % (compressedSize - sizeof(lzss_header_t))] = (unsigned char)rng();
+
+			if (rng() % 4 == 0)
+			{
+				const unsigned int claimedSize = rng() % (2 * size + 2);
+				memcpy(&mutated[4], &claimedSize, sizeof(claimedSize));
+			}
+
+			const unsigned int bufferSize = size + rng() % 40;
+			std::vector<unsigned char> ours(bufferSize), theirs(bufferSize + LZSS_MAX_MATCH);
+			const unsigned int ourSize = LZSS_Decompress(mutated.data(), mutated.size(), ours.data(), bufferSize);
+			const unsigned int theirSize = ReferenceLZSS_Decompress(mutated.data(), theirs.data(), bufferSize);
+			ok &= ourSize == theirSize && !memcmp(ours.data(), theirs.data(), ourSize);
+		}
+
+		if (!ok)
+		{
+			fprintf(stderr, "lzss mismatch, iteration %d, %u byte input\n", it, size);
+			failures++;
+		}
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+static void TestEdgeCases()
+{
+	unsigned char output[64];
+
+	// too small to even hold a header
+	const unsigned char tiny[4] = {'L', 'Z', 'S', 'S'};
+	NS_CHECK(!LZSS_Decompress(tiny, sizeof(tiny), output, sizeof(output)));
+	NS_CHECK(!LZSS_Decompress(nullptr, 0, output, sizeof(output)));
+
+	// output buffers smaller than the worst case are refused
+	const unsigned char input[32] = {};
+	std::vector<unsigned char> compressed(LZSS_GetMaxCompressedSize(sizeof(input)));
+	NS_CHECK(!LZSS_Compress(input, sizeof(input), compressed.data(), compressed.size() - 1));
+
+	// a back reference reaching before the start of the output
+	const size_t compressedSize = LZSS_Compress(input, sizeof(input), compressed.data(), compressed.size());
+	NS_CHECK(compressedSize != 0);
+	NS_CHECK(LZSS_Decompress(compressed.data(), compressedSize, output, sizeof(input)) == sizeof(input));
+	NS_CHECK(!LZSS_Decompress(compressed.data(), compressedSize, output, sizeof(input) - 1));
+
+	const unsigned char badReference[] = {'L', 'Z', 'S', 'S', 4, 0, 0, 0, 0x01, 0x10, 0x03, 0x00, 0x00};
+	NS_CHECK(!LZSS_Decompress(badReference, sizeof(badReference), output, sizeof(output)));
+}
+
+int main(int argc, char** argv)
+{
+	Fuzz(argc > 1 ? atoi(argv[1]) : 10000, argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 5);
+	TestEdgeCases();
+
+	return NS_TestResult();
+}
@@ -0,0 +1,46 @@
+#include "util/utils.h"
+#include "utils_reference.h"
+#include "nstest.h"
+
+#include <string>
+
+static void Bench(const char* pszName, const std::string& message, int iterations)
+{
+	std::string buffer = message;
+
+	char szName[64];
+	snprintf(szName, sizeof(szName), "%s (%zu bytes) original", pszName, message.size());
+	const double flReference = NS_Benchmark(
+		szName,
+		iterations,
+		[&]
+		{
+			ReferenceRemoveAsciiControlSequences(buffer.data(), true);
+			NS_DoNotOptimise(buffer);
+		});
+
+	snprintf(szName, sizeof(szName), "%s (%zu bytes) simd", pszName, message.size());
+	const double flOurs = NS_Benchmark(
+		szName,
+		iterations,
+		[&]
+		{
+			RemoveAsciiControlSequences(buffer.data(), buffer.size(), true);
+			NS_DoNotOptimise(buffer);
+		});
+
+	printf("%-48s %12.2fx\n", "speedup", flReference / flOurs);
+}
+
+int main()
+{
+	std::string chat;
+	while (chat.size() < (1 << 20))
+		chat += "hi \xC3\xA9 \x1B[31mred\x1B[0m ok\n";
+
+	Bench("ascii", std::string(1 << 20, 'a'), 50);
+	Bench("mixed chat", chat, 50);
+	Bench("chat message", "gg \x1B[31mwp\x1B[0m, rematch?", 1000000);
+
+	return 0;
+}
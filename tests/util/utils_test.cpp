@@ -0,0 +1,100 @@
+#include "util/utils.h"
+#include "utils_reference.h"
+#include "nstest.h"
+
+#include <random>
+
+static const char* const s_pszPieces[] = {
+	"a", "hello world ", "\n", "\r", "\t", "\x7F", "\x01", "\x80", "\xFF", "\x1B", "\x1Bx", "\x1B[", "\x1B[1;2", "\x1B[31m", "\xC3",
+	"\xC3\xA9", "\xE2\x82", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xF8\x80\x80\x80\x80", "\xFC\x80"};
+
+static std::string MakeMessage(std::mt19937& rng)
+{
+	std::string message;
+	for (int i = rng() % 10; i > 0; i--)
+		message += s_pszPieces[rng() % (sizeof(s_pszPieces) / sizeof(*s_pszPieces))];
+
+	// long printable runs, so the simd path gets used
+	if (rng() % 3 == 0)
+	{
+		std::string printable;
+		for (int i = 0; i < 40; i++)
+			printable += char(32 + rng() % 95);
+
+		message.insert(rng() % (message.size() + 1), printable);
+	}
+
+	return message;
+}
+
+static void Fuzz(int iterations, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+
+	int failures = 0;
+	for (int it = 0; it < iterations && failures < 10; it++)
+	{
+		const std::string message = MakeMessage(rng);
+		const bool allowColorCodes = rng() & 1;
+
+		// the whole message must come out exactly like the original did
+		std::string ours = message, reference = message;
+		RemoveAsciiControlSequences(ours.data(), ours.size(), allowColorCodes);
+		ReferenceRemoveAsciiControlSequences(reference.data(), allowColorCodes);
+		bool ok = ours == reference;
+
+		// cut short, it must sanitise the part it was given like the original does a message ending there,
+		// and must not touch anything past it. the last utf-8 sequence or escape can differ, since it can't see how they continue
+		const size_t cut = rng() % (message.size() + 1);
+		std::string bounded = message, truncated = message.substr(0, cut);
+		RemoveAsciiControlSequences(bounded.data(), cut, allowColorCodes);
+		ReferenceRemoveAsciiControlSequences(truncated.data(), allowColorCodes);
+		ok &= bounded.compare(cut, std::string::npos, message, cut, std::string::npos) == 0;
+
+		size_t iSame = 0;
+		while (iSame < cut && bounded[iSame] == truncated[iSame])
+			iSame++;
+
+		ok &= iSame == cut || cut - iSame <= 6;
+
+		if (!ok)
+		{
+			fprintf(stderr, "sanitiser mismatch, iteration %d, %zu byte message\n", it, message.size());
+			failures++;
+		}
+	}
+
+	NS_CHECK(failures == 0);
+}
+
+static void TestEdgeCases()
+{
+	std::string message = "red \x1B[31mtext\x1B[0m";
+	RemoveAsciiControlSequences(message.data(), message.size(), true);
+	NS_CHECK(message == "red \x1B[31mtext\x1B[0m");
+	RemoveAsciiControlSequences(message.data(), message.size(), false);
+	NS_CHECK(message == "red  [31mtext [0m");
+
+	// an invalid escape has its ESC blanked, not whatever comes after it
+	message = "\x1Bx";
+	RemoveAsciiControlSequences(message.data(), message.size(), true);
+	NS_CHECK(message == " x");
+
+	// stops at a null terminator
+	char szTerminated[] = "a\0\x01";
+	RemoveAsciiControlSequences(szTerminated, sizeof(szTerminated) - 1, false);
+	NS_CHECK(szTerminated[2] == '\x01');
+
+	// utf-8 sequences cut off by the length are blanked
+	message = "\xE2\x82\xAC";
+	RemoveAsciiControlSequences(message.data(), 2, false);
+	NS_CHECK(message == "  \xAC");
+}
+
+int main(int argc, char** argv)
+{
+	Fuzz(argc > 1 ? atoi(argv[1]) : 200000, argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 3);
+	TestEdgeCases();
+
+	return NS_TestResult();
+}
@@ -0,0 +1,93 @@
+#include "server/ainfile.h"
+#include "spdlog/fmt/fmt.h"
+
+#include <fstream>
+#include <iterator>
+
+static void PrintStats(const AinFile_t& ain, const AinFileStats_t& stats)
+{
+	fmt::print("version {}, map version {}, crc {:x}\n", ain.version, ain.mapVersion, (uint32_t)ain.crc);
+	fmt::print("{} nodes, {} links\n", stats.nodeCount, stats.linkCount);
+	for (int i = 0; i < MAX_HULLS; i++)
+		fmt::print("  {} links usable by hull {}\n", stats.linksPerHull[i], i);
+
+	fmt::print("{} isolated nodes, at most {} links on a node\n", stats.isolatedNodes, stats.maxNodeLinks);
+	fmt::print("{} self links, {} duplicate links, {} bad links\n", stats.selfLinks, stats.duplicateLinks, stats.badLinks);
+	fmt::print(
+		"nodes span ({}, {}, {}) to ({}, {}, {})\n",
+		stats.mins[0],
+		stats.mins[1],
+		stats.mins[2],
+		stats.maxs[0],
+		stats.maxs[1],
+		stats.maxs[2]);
+	fmt::print(
+		"{} unknown nodes, {} unknown links, {} script nodes, {} hints\n",
+		stats.unkNodeCount,
+		stats.unkLinkCount,
+		stats.scriptNodeCount,
+		stats.hintCount);
+}
+
+static void PrintLayout(const AinFile_t& ain)
+{
+	std::vector<char> buffer;
+	AinFileLayout_t layout;
+	WriteAinFile(ain, buffer, &layout);
+
+	fmt::print("layout:\n");
+	fmt::print("  {:08x} nodes\n", layout.nodes);
+	fmt::print("  {:08x} links\n", layout.links);
+	fmt::print("  {:08x} unknown node block\n", layout.unkNodeBlock);
+	fmt::print("  {:08x} traverse nodes\n", layout.traverseNodes);
+	fmt::print("  {:08x} unknown hull block\n", layout.unkHullBlock);
+	fmt::print("  {:08x} unknown nodes\n", layout.unkNodes);
+	fmt::print("  {:08x} unknown links\n", layout.unkLinks);
+	fmt::print("  {:08x} script nodes\n", layout.scriptNodes);
+	fmt::print("  {:08x} hints\n", layout.hints);
+	fmt::print("  {:08x} end\n", layout.size);
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fmt::print(stderr, "usage: {} <file.ain> [--layout]\n", argv[0]);
+		return 2;
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+	if (!file)
+	{
+		fmt::print(stderr, "couldn't open {}\n", argv[1]);
+		return 2;
+	}
+
+	const std::vector<char> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// read it ourselves first, so there's something to print stats for even if it fails validation
+	AinFile_t ain;
+	std::string error;
+	if (!ReadAinFile(data.data(), data.size(), ain, error))
+	{
+		fmt::print(stderr, "{}: {}\n", argv[1], error);
+		return 1;
+	}
+
+	// reads the file again, checks it writes back out identically and that every link is to a node that exists
+	AinFileStats_t stats;
+	const bool bValid = ValidateAinFile(data.data(), data.size(), stats, error);
+
+	PrintStats(ain, stats);
+	if (argc > 2 && std::string(argv[2]) == "--layout")
+		PrintLayout(ain);
+
+	if (!bValid)
+	{
+		fmt::print(stderr, "{}: {}\n", argv[1], error);
+		return 1;
+	}
+
+	fmt::print("{}: ok, {} bytes\n", argv[1], data.size());
+	return 0;
+}